@@ -330,6 +330,7 @@
 330 stdcall NtReleaseMutant(long ptr)
 331 stdcall NtReleaseSemaphore(long long ptr)
 332 stdcall NtRemoveIoCompletion(ptr ptr ptr ptr ptr)
+@ stdcall NtRemoveIoCompletionEx(ptr ptr long ptr ptr long)
 333 stdcall NtRemoveProcessDebug(ptr ptr)
 334 stdcall NtRenameKey(ptr ptr)
 335 stdcall NtReplaceKey(ptr long ptr)
@@ -776,8 +777,8 @@
 771 stdcall RtlMultiAppendUnicodeStringBuffer(ptr long ptr)
 772 stdcall RtlMultiByteToUnicodeN(ptr long ptr ptr long)
 773 stdcall RtlMultiByteToUnicodeSize(ptr str long)
-# RtlMultipleAllocateHeap
-# RtlMultipleFreeHeap
+774 stdcall RtlMultipleAllocateHeap(ptr long ptr long ptr)
+775 stdcall RtlMultipleFreeHeap(ptr long long ptr)
 776 stdcall RtlNewInstanceSecurityObject(long long ptr ptr ptr ptr ptr long ptr ptr)
 777 stdcall RtlNewSecurityGrantedAccess(long ptr ptr ptr ptr ptr)
 778 stdcall RtlNewSecurityObject(ptr ptr ptr long ptr ptr)
@@ -1175,6 +1176,7 @@
 1167 stdcall ZwReleaseMutant(long ptr) NtReleaseMutant
 1168 stdcall ZwReleaseSemaphore(long long ptr) NtReleaseSemaphore
 1169 stdcall ZwRemoveIoCompletion(ptr ptr ptr ptr ptr) NtRemoveIoCompletion
+@ stdcall ZwRemoveIoCompletionEx(ptr ptr long ptr ptr long) NtRemoveIoCompletionEx
 1170 stdcall ZwRemoveProcessDebug(ptr ptr) NtRemoveProcessDebug
 1171 stdcall ZwRenameKey(ptr ptr) NtRenameKey
 1172 stdcall ZwReplaceKey(ptr long ptr) NtReplaceKey
@@ -8,8 +8,10 @@
 
 #pragma once
 
+/* The module hash table starts out static and doubles as modules get loaded */
 #define LDR_HASH_TABLE_ENTRIES 32
-#define LDR_GET_HASH_ENTRY(x) (RtlUpcaseUnicodeChar((x)) & (LDR_HASH_TABLE_ENTRIES - 1))
+#define LDR_HASH_TABLE_MAX_ENTRIES 4096
+#define LDR_GET_HASH_ENTRY(x) ((x) & (LdrpHashTableSize - 1))
 
 /* LdrpUpdateLoadCount2 flags */
 #define LDRP_UPDATE_REFCOUNT   0x01
@@ -29,11 +31,39 @@ typedef struct _LDRP_TLS_DATA
     IMAGE_TLS_DIRECTORY TlsDirectory;
 } LDRP_TLS_DATA, *PLDRP_TLS_DATA;
 
+/* Export names of a module, hashed the first time a name misses its hint */
+#define LDRP_EXPORT_HASH_MIN_NAMES 32
+#define LDRP_EXPORT_HASH_FREE MAXULONG
+
+typedef struct _LDRP_EXPORT_HASH_SLOT
+{
+    ULONG Hash;
+    ULONG NameIndex;
+} LDRP_EXPORT_HASH_SLOT, *PLDRP_EXPORT_HASH_SLOT;
+
+typedef struct _LDRP_EXPORT_HASH
+{
+    ULONG Mask;
+    LDRP_EXPORT_HASH_SLOT Slots[ANYSIZE_ARRAY];
+} LDRP_EXPORT_HASH, *PLDRP_EXPORT_HASH;
+
+/* What the loader keeps about a module besides the public entry */
+typedef struct _LDRP_DATA_TABLE_ENTRY
+{
+    LDR_DATA_TABLE_ENTRY Entry;
+    PLDRP_EXPORT_HASH ExportHash;
+} LDRP_DATA_TABLE_ENTRY, *PLDRP_DATA_TABLE_ENTRY;
+
+#define LDRP_ENTRY(x) CONTAINING_RECORD((x), LDRP_DATA_TABLE_ENTRY, Entry)
+
 /* Global data */
 extern RTL_CRITICAL_SECTION LdrpLoaderLock;
 extern BOOLEAN LdrpInLdrInit;
 extern PVOID LdrpHeap;
-extern LIST_ENTRY LdrpHashTable[LDR_HASH_TABLE_ENTRIES];
+extern LIST_ENTRY LdrpStaticHashTable[LDR_HASH_TABLE_ENTRIES];
+extern PLIST_ENTRY LdrpHashTable;
+extern ULONG LdrpHashTableSize;
+extern ULONG LdrpHashTableCount;
 extern BOOLEAN ShowSnaps;
 extern UNICODE_STRING LdrpDefaultPath;
 extern HANDLE LdrpKnownDllObjectDirectory;
@@ -73,7 +103,7 @@ VOID NTAPI LdrpEnsureLoaderLockIsHeld(VOID);
 /* ldrpe.c */
 NTSTATUS
 NTAPI
-LdrpSnapThunk(IN PVOID ExportBase,
+LdrpSnapThunk(IN PLDR_DATA_TABLE_ENTRY ExportLdrEntry,
               IN PVOID ImportBase,
               IN PIMAGE_THUNK_DATA OriginalThunk,
               IN OUT PIMAGE_THUNK_DATA Thunk,
@@ -82,6 +112,9 @@ LdrpSnapThunk(IN PVOID ExportBase,
               IN BOOLEAN Static,
               IN LPSTR DllName);
 
+VOID NTAPI
+LdrpFreeExportHash(IN PLDR_DATA_TABLE_ENTRY LdrEntry);
+
 NTSTATUS NTAPI
 LdrpWalkImportDescriptor(IN LPWSTR DllPath OPTIONAL,
                          IN PLDR_DATA_TABLE_ENTRY LdrEntry);
@@ -98,9 +131,15 @@ LdrpGetProcedureAddress(IN PVOID BaseAddress,
 PLDR_DATA_TABLE_ENTRY NTAPI
 LdrpAllocateDataTableEntry(IN PVOID BaseAddress);
 
+ULONG NTAPI
+LdrpHashUnicodeString(IN PCUNICODE_STRING String);
+
 VOID NTAPI
 LdrpInsertMemoryTableEntry(IN PLDR_DATA_TABLE_ENTRY LdrEntry);
 
+VOID NTAPI
+LdrpRemoveHashTableEntry(IN PLDR_DATA_TABLE_ENTRY LdrEntry);
+
 NTSTATUS NTAPI
 LdrpLoadDll(IN BOOLEAN Redirected,
             IN PWSTR DllPath OPTIONAL,
@@ -57,7 +57,10 @@ PVOID NtDllBase;
 extern LARGE_INTEGER RtlpTimeout;
 BOOLEAN RtlpTimeoutDisable;
 PVOID LdrpHeap;
-LIST_ENTRY LdrpHashTable[LDR_HASH_TABLE_ENTRIES];
+LIST_ENTRY LdrpStaticHashTable[LDR_HASH_TABLE_ENTRIES];
+PLIST_ENTRY LdrpHashTable = LdrpStaticHashTable;
+ULONG LdrpHashTableSize = LDR_HASH_TABLE_ENTRIES;
+ULONG LdrpHashTableCount;
 LIST_ENTRY LdrpDllNotificationList;
 HANDLE LdrpKnownDllObjectDirectory;
 UNICODE_STRING LdrpKnownDllPath;
@@ -1884,7 +1887,7 @@ LdrpInitializeProcess(IN PCONTEXT Context,
     /* Initialize the Hash Table */
     for (i = 0; i < LDR_HASH_TABLE_ENTRIES; i++)
     {
-        InitializeListHead(&LdrpHashTable[i]);
+        InitializeListHead(&LdrpStaticHashTable[i]);
     }
 
     /* Initialize the Loader Lock */
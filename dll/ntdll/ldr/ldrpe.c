@@ -161,7 +161,7 @@ LdrpSnapIAT(IN PLDR_DATA_TABLE_ENTRY ExportLdrEntry,
             /* Snap the thunk */
             _SEH2_TRY
             {
-                Status = LdrpSnapThunk(ExportLdrEntry->DllBase,
+                Status = LdrpSnapThunk(ExportLdrEntry,
                                        ImportLdrEntry->DllBase,
                                        OriginalThunk,
                                        FirstThunk,
@@ -217,7 +217,7 @@ LdrpSnapIAT(IN PLDR_DATA_TABLE_ENTRY ExportLdrEntry,
             /* Snap the Thunk */
             _SEH2_TRY
             {
-                Status = LdrpSnapThunk(ExportLdrEntry->DllBase,
+                Status = LdrpSnapThunk(ExportLdrEntry,
                                        ImportLdrEntry->DllBase,
                                        OriginalThunk,
                                        FirstThunk,
@@ -665,6 +665,105 @@ LdrpNameToOrdinal(IN LPSTR ImportName,
     return OrdinalTable[Next];
 }
 
+static
+ULONG
+LdrpHashExportName(IN PCSTR Name)
+{
+    ULONG Hash = 0;
+
+    /* Export names are case-sensitive, so hash them as they are */
+    while (*Name) Hash = Hash * 65599 + (UCHAR)*Name++;
+
+    return Hash;
+}
+
+static
+PLDRP_EXPORT_HASH
+LdrpBuildExportHash(IN PLDR_DATA_TABLE_ENTRY LdrEntry,
+                    IN PIMAGE_EXPORT_DIRECTORY ExportEntry)
+{
+    PLDRP_EXPORT_HASH ExportHash;
+    PULONG NameTable;
+    ULONG Size, Hash, i, j;
+
+    /* Twice as many slots as names, so the probes stay short */
+    for (Size = LDRP_EXPORT_HASH_MIN_NAMES; Size < ExportEntry->NumberOfNames * 2; Size *= 2);
+
+    ExportHash = RtlAllocateHeap(LdrpHeap,
+                                 0,
+                                 FIELD_OFFSET(LDRP_EXPORT_HASH, Slots[Size]));
+    if (!ExportHash) return NULL;
+
+    ExportHash->Mask = Size - 1;
+    for (i = 0; i < Size; i++)
+    {
+        ExportHash->Slots[i].NameIndex = LDRP_EXPORT_HASH_FREE;
+    }
+
+    /* Put every name in the first free slot from its hash on */
+    NameTable = (PULONG)((ULONG_PTR)LdrEntry->DllBase +
+                         (ULONG_PTR)ExportEntry->AddressOfNames);
+    for (i = 0; i < ExportEntry->NumberOfNames; i++)
+    {
+        Hash = LdrpHashExportName((PCHAR)((ULONG_PTR)LdrEntry->DllBase + NameTable[i]));
+        for (j = Hash & ExportHash->Mask;
+             ExportHash->Slots[j].NameIndex != LDRP_EXPORT_HASH_FREE;
+             j = (j + 1) & ExportHash->Mask);
+
+        ExportHash->Slots[j].Hash = Hash;
+        ExportHash->Slots[j].NameIndex = i;
+    }
+
+    if (ShowSnaps)
+    {
+        DPRINT1("LDR: Hashed %lu exports of %wZ into %lu slots\n",
+                ExportEntry->NumberOfNames,
+                &LdrEntry->BaseDllName,
+                Size);
+    }
+
+    return ExportHash;
+}
+
+static
+USHORT
+LdrpLookupExportHash(IN PLDRP_EXPORT_HASH ExportHash,
+                     IN LPSTR ImportName,
+                     IN PVOID ExportBase,
+                     IN PULONG NameTable,
+                     IN PUSHORT OrdinalTable)
+{
+    PLDRP_EXPORT_HASH_SLOT Slot;
+    ULONG Hash, i;
+
+    /* Only compare the names of the slots with the same hash */
+    Hash = LdrpHashExportName(ImportName);
+    for (i = Hash & ExportHash->Mask; ; i = (i + 1) & ExportHash->Mask)
+    {
+        Slot = &ExportHash->Slots[i];
+        if (Slot->NameIndex == LDRP_EXPORT_HASH_FREE) return -1;
+
+        if ((Slot->Hash == Hash) &&
+            !(strcmp(ImportName, (PCHAR)((ULONG_PTR)ExportBase + NameTable[Slot->NameIndex]))))
+        {
+            return OrdinalTable[Slot->NameIndex];
+        }
+    }
+}
+
+VOID
+NTAPI
+LdrpFreeExportHash(IN PLDR_DATA_TABLE_ENTRY LdrEntry)
+{
+    PLDRP_DATA_TABLE_ENTRY Entry = LDRP_ENTRY(LdrEntry);
+
+    if (Entry->ExportHash)
+    {
+        RtlFreeHeap(LdrpHeap, 0, Entry->ExportHash);
+        Entry->ExportHash = NULL;
+    }
+}
+
 NTSTATUS
 NTAPI
 LdrpWalkImportDescriptor(IN LPWSTR DllPath OPTIONAL,
@@ -947,7 +1046,7 @@ done:
 
 NTSTATUS
 NTAPI
-LdrpSnapThunk(IN PVOID ExportBase,
+LdrpSnapThunk(IN PLDR_DATA_TABLE_ENTRY ExportLdrEntry,
               IN PVOID ImportBase,
               IN PIMAGE_THUNK_DATA OriginalThunk,
               IN OUT PIMAGE_THUNK_DATA Thunk,
@@ -976,6 +1075,8 @@ LdrpSnapThunk(IN PVOID ExportBase,
     PANSI_STRING ForwardName;
     PVOID ForwarderHandle;
     ULONG ForwardOrdinal;
+    PVOID ExportBase = ExportLdrEntry->DllBase;
+    PLDRP_DATA_TABLE_ENTRY Entry = LDRP_ENTRY(ExportLdrEntry);
 
     /* Check if the snap is by ordinal */
     if ((IsOrdinal = IMAGE_SNAP_BY_ORDINAL(OriginalThunk->u1.Ordinal)))
@@ -1012,12 +1113,30 @@ LdrpSnapThunk(IN PVOID ExportBase,
         }
         else
         {
-            /* Well bummer, hint didn't work, do it the long way */
-            Ordinal = LdrpNameToOrdinal(ImportName,
-                                        ExportEntry->NumberOfNames,
-                                        ExportBase,
-                                        NameTable,
-                                        OrdinalTable);
+            /* Hint didn't work, hash the export names if there are enough of them */
+            if ((!Entry->ExportHash) &&
+                (ExportEntry->NumberOfNames >= LDRP_EXPORT_HASH_MIN_NAMES))
+            {
+                Entry->ExportHash = LdrpBuildExportHash(ExportLdrEntry, ExportEntry);
+            }
+
+            if (Entry->ExportHash)
+            {
+                Ordinal = LdrpLookupExportHash(Entry->ExportHash,
+                                               ImportName,
+                                               ExportBase,
+                                               NameTable,
+                                               OrdinalTable);
+            }
+            else
+            {
+                /* Well bummer, do it the long way */
+                Ordinal = LdrpNameToOrdinal(ImportName,
+                                            ExportEntry->NumberOfNames,
+                                            ExportBase,
+                                            NameTable,
+                                            OrdinalTable);
+            }
         }
     }
 
@@ -1283,7 +1283,7 @@ SkipCheck:
             /* Remove the DLL from the lists */
             RemoveEntryList(&LdrEntry->InLoadOrderLinks);
             RemoveEntryList(&LdrEntry->InMemoryOrderLinks);
-            RemoveEntryList(&LdrEntry->HashLinks);
+            LdrpRemoveHashTableEntry(LdrEntry);
 
             /* Remove the LDR Entry */
             RtlFreeHeap(LdrpHeap, 0, LdrEntry );
@@ -1475,7 +1475,7 @@ FailRelocate:
                 /* Remove it from the lists */
                 RemoveEntryList(&LdrEntry->InLoadOrderLinks);
                 RemoveEntryList(&LdrEntry->InMemoryOrderLinks);
-                RemoveEntryList(&LdrEntry->HashLinks);
+                LdrpRemoveHashTableEntry(LdrEntry);
 
                 /* Unmap it, clear the entry */
                 NtUnmapViewOfSection(NtCurrentProcess(), ViewBase);
@@ -1552,10 +1552,10 @@ LdrpAllocateDataTableEntry(IN PVOID BaseAddress)
 
     if (NtHeader)
     {
-        /* Allocate an entry */
+        /* Allocate an entry, with the loader's private data behind it */
         LdrEntry = RtlAllocateHeap(LdrpHeap,
                                    HEAP_ZERO_MEMORY,
-                                   sizeof(LDR_DATA_TABLE_ENTRY));
+                                   sizeof(LDRP_DATA_TABLE_ENTRY));
 
         /* Make sure we got one */
         if (LdrEntry)
@@ -1572,6 +1572,65 @@ LdrpAllocateDataTableEntry(IN PVOID BaseAddress)
     return LdrEntry;
 }
 
+ULONG
+NTAPI
+LdrpHashUnicodeString(IN PCUNICODE_STRING String)
+{
+    ULONG Hash = 0;
+    USHORT i;
+
+    /* Hash the whole name case-insensitively, the way Windows 8 does */
+    for (i = 0; i < String->Length / sizeof(WCHAR); i++)
+    {
+        Hash = Hash * 65599 + RtlUpcaseUnicodeChar(String->Buffer[i]);
+    }
+
+    return Hash;
+}
+
+static
+VOID
+LdrpGrowHashTable(VOID)
+{
+    PLIST_ENTRY NewTable, ListHead, ListEntry;
+    PLDR_DATA_TABLE_ENTRY LdrEntry;
+    ULONG NewSize, i;
+
+    /* Nothing to allocate from before the loader heap exists */
+    if (!LdrpHeap) return;
+
+    NewSize = LdrpHashTableSize * 2;
+    NewTable = RtlAllocateHeap(LdrpHeap, 0, NewSize * sizeof(LIST_ENTRY));
+    if (!NewTable)
+    {
+        /* Keep the current table, it just has longer chains */
+        return;
+    }
+
+    for (i = 0; i < NewSize; i++)
+    {
+        InitializeListHead(&NewTable[i]);
+    }
+
+    /* Move every module over to its bucket in the new table */
+    for (i = 0; i < LdrpHashTableSize; i++)
+    {
+        ListHead = &LdrpHashTable[i];
+        while (!IsListEmpty(ListHead))
+        {
+            ListEntry = RemoveHeadList(ListHead);
+            LdrEntry = CONTAINING_RECORD(ListEntry, LDR_DATA_TABLE_ENTRY, HashLinks);
+            InsertTailList(&NewTable[LdrpHashUnicodeString(&LdrEntry->BaseDllName) & (NewSize - 1)],
+                           ListEntry);
+        }
+    }
+
+    /* Switch to it, and free the old one unless it was the static one */
+    if (LdrpHashTable != LdrpStaticHashTable) RtlFreeHeap(LdrpHeap, 0, LdrpHashTable);
+    LdrpHashTable = NewTable;
+    LdrpHashTableSize = NewSize;
+}
+
 VOID
 NTAPI
 LdrpInsertMemoryTableEntry(IN PLDR_DATA_TABLE_ENTRY LdrEntry)
@@ -1579,15 +1638,32 @@ LdrpInsertMemoryTableEntry(IN PLDR_DATA_TABLE_ENTRY LdrEntry)
     PPEB_LDR_DATA PebData = NtCurrentPeb()->Ldr;
     ULONG i;
 
+    /* Keep the chains short once there are more modules than buckets */
+    if ((LdrpHashTableCount >= LdrpHashTableSize) &&
+        (LdrpHashTableSize < LDR_HASH_TABLE_MAX_ENTRIES))
+    {
+        LdrpGrowHashTable();
+    }
+
     /* Insert into hash table */
-    i = LDR_GET_HASH_ENTRY(LdrEntry->BaseDllName.Buffer[0]);
+    i = LDR_GET_HASH_ENTRY(LdrpHashUnicodeString(&LdrEntry->BaseDllName));
     InsertTailList(&LdrpHashTable[i], &LdrEntry->HashLinks);
+    LdrpHashTableCount++;
 
     /* Insert into other lists */
     InsertTailList(&PebData->InLoadOrderModuleList, &LdrEntry->InLoadOrderLinks);
     InsertTailList(&PebData->InMemoryOrderModuleList, &LdrEntry->InMemoryOrderLinks);
 }
 
+VOID
+NTAPI
+LdrpRemoveHashTableEntry(IN PLDR_DATA_TABLE_ENTRY LdrEntry)
+{
+    /* Remove it from its hash chain */
+    RemoveEntryList(&LdrEntry->HashLinks);
+    LdrpHashTableCount--;
+}
+
 VOID
 NTAPI
 LdrpFinalizeAndDeallocateDataTableEntry(IN PLDR_DATA_TABLE_ENTRY Entry)
@@ -1607,6 +1683,9 @@ LdrpFinalizeAndDeallocateDataTableEntry(IN PLDR_DATA_TABLE_ENTRY Entry)
     /* Release the full dll name string */
     if (Entry->FullDllName.Buffer) LdrpFreeUnicodeString(&Entry->FullDllName);
 
+    /* Release the export hash if one was built */
+    LdrpFreeExportHash(Entry);
+
     /* Finally free the entry's memory */
     RtlFreeHeap(LdrpHeap, 0, Entry);
 }
@@ -2007,7 +2086,7 @@ lookinhash:
         /* FIXME: if we get redirected dll it means that we also get a full path so we need to find its filename for the hash lookup */
 
         /* Get hash index */
-        HashIndex = LDR_GET_HASH_ENTRY(DllName->Buffer[0]);
+        HashIndex = LDR_GET_HASH_ENTRY(LdrpHashUnicodeString(DllName));
 
         /* Traverse that list */
         ListHead = &LdrpHashTable[HashIndex];
@@ -2017,8 +2096,9 @@ lookinhash:
             /* Get the current entry */
             CurEntry = CONTAINING_RECORD(ListEntry, LDR_DATA_TABLE_ENTRY, HashLinks);
 
-            /* Check base name of that module */
-            if (RtlEqualUnicodeString(DllName, &CurEntry->BaseDllName, TRUE))
+            /* Check base name of that module, if it could match at all */
+            if ((CurEntry->BaseDllName.Length == DllName->Length) &&
+                (RtlEqualUnicodeString(DllName, &CurEntry->BaseDllName, TRUE)))
             {
                 /* It matches, return it */
                 *LdrEntry = CurEntry;
@@ -2353,7 +2433,7 @@ LdrpGetProcedureAddress(IN PVOID BaseAddress,
         }
 
         /* Now get the thunk */
-        Status = LdrpSnapThunk(LdrEntry->DllBase,
+        Status = LdrpSnapThunk(LdrEntry,
                                ImageBase,
                                &Thunk,
                                &Thunk,
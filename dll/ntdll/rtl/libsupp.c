@@ -55,6 +55,21 @@ RtlpGetMode(VOID)
    return UserMode;
 }
 
+ULONG
+NTAPI
+RtlpGetNumberOfProcessors(VOID)
+{
+    return NtCurrentPeb()->NumberOfProcessors;
+}
+
+BOOLEAN
+NTAPI
+RtlpQueueWorkItem(IN WORKERCALLBACKFUNC Function,
+                  IN PVOID Context)
+{
+    return NT_SUCCESS(RtlQueueWorkItem(Function, Context, WT_EXECUTEDEFAULT));
+}
+
 /*
  * @implemented
  */
@@ -15,29 +15,69 @@
 /*
  * SetFileCompletionNotificationModes is not entirely Vista-exclusive,
  * it was actually added to Windows 2003 in SP2. Headers restrict it from
- * pre-Vista though so define the flags we need for it.
+ * pre-Vista though so define the flags and the class we need for it.
  */
 #if (_WIN32_WINNT < 0x0600)
 #define FILE_SKIP_COMPLETION_PORT_ON_SUCCESS 0x1
 #define FILE_SKIP_SET_EVENT_ON_HANDLE        0x2
 #endif
+#if (NTDDI_VERSION < NTDDI_VISTA)
+#define FileIoCompletionNotificationInformation ((FILE_INFORMATION_CLASS)41)
+#endif
+
+/*
+ * GetQueuedCompletionStatusEx is Vista and higher, it is only exported
+ * there, but build it everywhere and define its entries for the older headers.
+ */
+#if (_WIN32_WINNT < 0x0600)
+typedef struct _OVERLAPPED_ENTRY {
+    ULONG_PTR lpCompletionKey;
+    LPOVERLAPPED lpOverlapped;
+    ULONG_PTR Internal;
+    DWORD dwNumberOfBytesTransferred;
+} OVERLAPPED_ENTRY, *LPOVERLAPPED_ENTRY;
+#endif
+
+/* The entries are filled in place by NtRemoveIoCompletionEx */
+C_ASSERT(sizeof(OVERLAPPED_ENTRY) == sizeof(FILE_IO_COMPLETION_INFORMATION));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, lpCompletionKey) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, KeyContext));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, lpOverlapped) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, ApcContext));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, Internal) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, IoStatusBlock.Status));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, dwNumberOfBytesTransferred) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, IoStatusBlock.Information));
 
 /*
- * @unimplemented
+ * @implemented
  */
 BOOL
 WINAPI
 SetFileCompletionNotificationModes(IN HANDLE FileHandle,
                                    IN UCHAR Flags)
 {
+    NTSTATUS Status;
+    IO_STATUS_BLOCK IoStatusBlock;
+    FILE_IO_COMPLETION_NOTIFICATION_INFORMATION FileInformation;
+
     if (Flags & ~(FILE_SKIP_COMPLETION_PORT_ON_SUCCESS | FILE_SKIP_SET_EVENT_ON_HANDLE))
     {
         SetLastError(ERROR_INVALID_PARAMETER);
         return FALSE;
     }
 
-    UNIMPLEMENTED;
-    return FALSE;
+    /* The I/O manager keeps the modes in the file object */
+    FileInformation.Flags = Flags;
+    Status = NtSetInformationFile(FileHandle,
+                                  &IoStatusBlock,
+                                  &FileInformation,
+                                  sizeof(FileInformation),
+                                  FileIoCompletionNotificationInformation);
+    if (!NT_SUCCESS(Status))
+    {
+        /* Convert the error and fail */
+        BaseSetLastNTError(Status);
+        return FALSE;
+    }
+
+    return TRUE;
 }
 
 /*
@@ -167,6 +207,68 @@ GetQueuedCompletionStatus(IN HANDLE CompletionHandle,
     return TRUE;
 }
 
+/*
+ * @implemented
+ */
+BOOL
+WINAPI
+GetQueuedCompletionStatusEx(IN HANDLE CompletionPort,
+                            OUT LPOVERLAPPED_ENTRY lpCompletionPortEntries,
+                            IN ULONG ulCount,
+                            OUT PULONG ulNumEntriesRemoved,
+                            IN DWORD dwMilliseconds,
+                            IN BOOL fAlertable)
+{
+    NTSTATUS Status;
+    LARGE_INTEGER Time;
+    PLARGE_INTEGER TimePtr;
+
+    /* There must be room for at least one entry */
+    if (!(lpCompletionPortEntries) || !(ulCount))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+
+    /* Convert the timeout and then call the native API */
+    TimePtr = BaseFormatTimeOut(&Time, dwMilliseconds);
+    Status = NtRemoveIoCompletionEx(CompletionPort,
+                                    (PFILE_IO_COMPLETION_INFORMATION)lpCompletionPortEntries,
+                                    ulCount,
+                                    ulNumEntriesRemoved,
+                                    TimePtr,
+                                    fAlertable ? TRUE : FALSE);
+    if (!(NT_SUCCESS(Status)) || (Status == STATUS_TIMEOUT) ||
+        (Status == STATUS_USER_APC) || (Status == STATUS_ALERTED))
+    {
+        /* Nothing was removed */
+        *ulNumEntriesRemoved = 0;
+
+        /* Check what kind of error we got */
+        if (Status == STATUS_TIMEOUT)
+        {
+            /* Timeout error is set directly since there's no conversion */
+            SetLastError(WAIT_TIMEOUT);
+        }
+        else if ((Status == STATUS_USER_APC) || (Status == STATUS_ALERTED))
+        {
+            /* So is the wait being broken by an APC */
+            SetLastError(WAIT_IO_COMPLETION);
+        }
+        else
+        {
+            /* Any other error gets converted */
+            BaseSetLastNTError(Status);
+        }
+
+        /* This is a failure case */
+        return FALSE;
+    }
+
+    /* The status of every packet is left in its entry, like in its overlapped */
+    return TRUE;
+}
+
 /*
  * @implemented
  */
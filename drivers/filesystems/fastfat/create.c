@@ -176,6 +176,18 @@ FindFile(
             ExFreePoolWithTag(PathNameBuffer, TAG_NAME);
             return Status;
         }
+
+        /* Large directories answer exact names from their name index */
+        if (DirContext->DirIndex == 0 &&
+            vfatLookupNameIndex(DeviceExt, Parent, FileToFindU, DirContext, &Context, &Page, &Status))
+        {
+            if (Context)
+            {
+                CcUnpinData(Context);
+            }
+            ExFreePoolWithTag(PathNameBuffer, TAG_NAME);
+            return Status;
+        }
     }
 
     /* FsRtlIsNameInExpression need the searched string to be upcase,
@@ -0,0 +1,404 @@
+/*
+ * PROJECT:     ReactOS FAT file system driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Cached name to directory entry index for large directories
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include "vfat.h"
+
+#define NDEBUG
+#include <debug.h>
+
+/* GLOBALS ******************************************************************/
+
+/* Directories smaller than this are cheaper to scan than to index */
+#define NAME_INDEX_MIN_DIR_SIZE (16 * 1024)
+#define NAME_INDEX_INITIAL_SIZE 1023
+
+/*
+ * Every entry maps the hash of a long or short name to the index of the
+ * short name entry, as returned by VfatGetNextDirEntry. Entries are chained
+ * per bucket through their array index, and there are as many buckets as
+ * entries, so the table is rebuilt when it is full. Sizes are kept odd so
+ * that the bucket depends on all bits of the hash.
+ */
+typedef struct _NAME_INDEX_ENTRY
+{
+    ULONG Hash;
+    ULONG DirIndex;
+    ULONG Next;
+} NAME_INDEX_ENTRY, *PNAME_INDEX_ENTRY;
+
+#define NAME_INDEX_NONE 0xFFFFFFFF
+
+typedef struct _VFAT_NAME_INDEX
+{
+    ULONG Size;
+    ULONG Used;
+    ULONG FreeList;
+    PULONG Buckets;
+    NAME_INDEX_ENTRY Entries[ANYSIZE_ARRAY];
+} VFAT_NAME_INDEX, *PVFAT_NAME_INDEX;
+
+/* FUNCTIONS ****************************************************************/
+
+/*
+ * The hash must agree with the case-insensitive compares done by the
+ * lookups, so it upcases the same way RtlEqualUnicodeString does.
+ */
+static
+ULONG
+vfatNameIndexHash(
+    PUNICODE_STRING NameU)
+{
+    PWCHAR curr, last;
+    ULONG hash = 0;
+    WCHAR c;
+
+    curr = NameU->Buffer;
+    last = NameU->Buffer + NameU->Length / sizeof(WCHAR);
+    while (curr < last)
+    {
+        c = RtlUpcaseUnicodeChar(*curr++);
+        hash = (hash + (c << 4) + (c >> 4)) * 11;
+    }
+    return hash;
+}
+
+static
+PVFAT_NAME_INDEX
+vfatAllocateNameIndex(
+    ULONG Size)
+{
+    PVFAT_NAME_INDEX Index;
+    ULONG i;
+
+    Index = ExAllocatePoolWithTag(PagedPool,
+                                  FIELD_OFFSET(VFAT_NAME_INDEX, Entries[Size]) + Size * sizeof(ULONG),
+                                  TAG_NAME_INDEX);
+    if (Index == NULL)
+    {
+        return NULL;
+    }
+
+    Index->Size = Size;
+    Index->Used = 0;
+    Index->FreeList = NAME_INDEX_NONE;
+    Index->Buckets = (PULONG)&Index->Entries[Size];
+    for (i = 0; i < Size; i++)
+    {
+        Index->Buckets[i] = NAME_INDEX_NONE;
+    }
+    return Index;
+}
+
+static
+VOID
+vfatInsertNameIndexEntry(
+    PVFAT_NAME_INDEX Index,
+    ULONG Hash,
+    ULONG DirIndex)
+{
+    PULONG Bucket = &Index->Buckets[Hash % Index->Size];
+    ULONG i;
+
+    if (Index->FreeList != NAME_INDEX_NONE)
+    {
+        i = Index->FreeList;
+        Index->FreeList = Index->Entries[i].Next;
+    }
+    else
+    {
+        ASSERT(Index->Used < Index->Size);
+        i = Index->Used++;
+    }
+
+    Index->Entries[i].Hash = Hash;
+    Index->Entries[i].DirIndex = DirIndex;
+    Index->Entries[i].Next = *Bucket;
+    *Bucket = i;
+}
+
+/*
+ * FUNCTION: Adds a name to the index of a directory, doubling the index when
+ *           it is full. Returns FALSE if the index had to be dropped.
+ */
+static
+BOOLEAN
+vfatAddNameToIndex(
+    PVFATFCB DirFcb,
+    ULONG Hash,
+    ULONG DirIndex)
+{
+    PVFAT_NAME_INDEX Index = DirFcb->NameIndex;
+    PVFAT_NAME_INDEX NewIndex;
+    ULONG i, j;
+
+    if (Index->FreeList == NAME_INDEX_NONE && Index->Used == Index->Size)
+    {
+        NewIndex = vfatAllocateNameIndex(Index->Size * 2 + 1);
+        if (NewIndex == NULL)
+        {
+            /* A partial index would report existing names as missing */
+            vfatDestroyNameIndex(DirFcb);
+            return FALSE;
+        }
+
+        for (i = 0; i < Index->Size; i++)
+        {
+            for (j = Index->Buckets[i]; j != NAME_INDEX_NONE; j = Index->Entries[j].Next)
+            {
+                vfatInsertNameIndexEntry(NewIndex, Index->Entries[j].Hash, Index->Entries[j].DirIndex);
+            }
+        }
+
+        ExFreePoolWithTag(Index, TAG_NAME_INDEX);
+        DirFcb->NameIndex = Index = NewIndex;
+    }
+
+    vfatInsertNameIndexEntry(Index, Hash, DirIndex);
+    return TRUE;
+}
+
+static
+VOID
+vfatRemoveNameFromIndex(
+    PVFAT_NAME_INDEX Index,
+    ULONG Hash,
+    ULONG DirIndex)
+{
+    PULONG Link = &Index->Buckets[Hash % Index->Size];
+    ULONG i;
+
+    for (i = *Link; i != NAME_INDEX_NONE; Link = &Index->Entries[i].Next, i = *Link)
+    {
+        if (Index->Entries[i].Hash == Hash && Index->Entries[i].DirIndex == DirIndex)
+        {
+            *Link = Index->Entries[i].Next;
+            Index->Entries[i].Next = Index->FreeList;
+            Index->FreeList = i;
+            return;
+        }
+    }
+}
+
+static
+BOOLEAN
+vfatIndexDirEntry(
+    PVFATFCB DirFcb,
+    PUNICODE_STRING LongNameU,
+    PUNICODE_STRING ShortNameU,
+    ULONG DirIndex)
+{
+    ULONG LongHash, ShortHash;
+
+    LongHash = vfatNameIndexHash(LongNameU);
+    if (!vfatAddNameToIndex(DirFcb, LongHash, DirIndex))
+    {
+        return FALSE;
+    }
+
+    if (ShortNameU->Length != 0)
+    {
+        ShortHash = vfatNameIndexHash(ShortNameU);
+        if (ShortHash != LongHash &&
+            !vfatAddNameToIndex(DirFcb, ShortHash, DirIndex))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/*
+ * FUNCTION: Indexes every entry a directory scan can match, skipping the same
+ *           entries vfatDirFindFile and FindFile skip
+ */
+static
+BOOLEAN
+vfatBuildNameIndex(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB DirFcb,
+    PVFAT_DIRENTRY_CONTEXT DirContext)
+{
+    PVOID Context = NULL;
+    PVOID Page;
+    NTSTATUS Status;
+    ULONG DirIndex = DirContext->DirIndex;
+    BOOLEAN First = TRUE;
+    BOOLEAN IsFatX = vfatVolumeIsFatX(DeviceExt);
+
+    DirFcb->NameIndex = vfatAllocateNameIndex(NAME_INDEX_INITIAL_SIZE);
+    if (DirFcb->NameIndex == NULL)
+    {
+        return FALSE;
+    }
+
+    DirContext->DirIndex = 0;
+    while (TRUE)
+    {
+        Status = VfatGetNextDirEntry(DeviceExt, &Context, &Page, DirFcb, DirContext, First);
+        First = FALSE;
+        if (Status == STATUS_NO_MORE_ENTRIES)
+        {
+            break;
+        }
+        if (!NT_SUCCESS(Status))
+        {
+            if (Context)
+            {
+                CcUnpinData(Context);
+            }
+            vfatDestroyNameIndex(DirFcb);
+            /* The caller scans the directory instead, from where it was */
+            DirContext->DirIndex = DirIndex;
+            return FALSE;
+        }
+
+        if (!ENTRY_VOLUME(IsFatX, &DirContext->DirEntry) &&
+            DirContext->LongNameU.Length != 0 &&
+            DirContext->ShortNameU.Length != 0)
+        {
+            if (!vfatIndexDirEntry(DirFcb, &DirContext->LongNameU, &DirContext->ShortNameU, DirContext->DirIndex))
+            {
+                if (Context)
+                {
+                    CcUnpinData(Context);
+                }
+                DirContext->DirIndex = DirIndex;
+                return FALSE;
+            }
+        }
+        DirContext->DirIndex++;
+    }
+
+    DPRINT("Indexed %u names in %wZ\n", DirFcb->NameIndex->Used, &DirFcb->PathNameU);
+    return TRUE;
+}
+
+VOID
+vfatDestroyNameIndex(
+    PVFATFCB DirFcb)
+{
+    if (DirFcb->NameIndex != NULL)
+    {
+        ExFreePoolWithTag(DirFcb->NameIndex, TAG_NAME_INDEX);
+        DirFcb->NameIndex = NULL;
+    }
+}
+
+/*
+ * FUNCTION: Looks a name up in the index of a directory, building the index
+ *           first for large directories. Returns FALSE when the directory has
+ *           no index and must be scanned. Otherwise, *pStatus is either
+ *           STATUS_SUCCESS, with DirContext describing the entry and *pContext
+ *           holding its mapped page, or STATUS_NO_MORE_ENTRIES.
+ */
+BOOLEAN
+vfatLookupNameIndex(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB DirFcb,
+    PUNICODE_STRING FileToFindU,
+    PVFAT_DIRENTRY_CONTEXT DirContext,
+    PVOID *pContext,
+    PVOID *pPage,
+    PNTSTATUS pStatus)
+{
+    PVFAT_NAME_INDEX Index;
+    NTSTATUS Status;
+    ULONG Hash, i;
+    BOOLEAN IsFatX = vfatVolumeIsFatX(DeviceExt);
+
+    ASSERT(ExIsResourceAcquiredExclusive(&DeviceExt->DirResource));
+    ASSERT(*pContext == NULL);
+
+    if (DirFcb->NameIndex == NULL)
+    {
+        if (DirFcb->RFCB.FileSize.u.LowPart < NAME_INDEX_MIN_DIR_SIZE ||
+            !vfatBuildNameIndex(DeviceExt, DirFcb, DirContext))
+        {
+            return FALSE;
+        }
+    }
+
+    Index = DirFcb->NameIndex;
+    Hash = vfatNameIndexHash(FileToFindU);
+    for (i = Index->Buckets[Hash % Index->Size]; i != NAME_INDEX_NONE; i = Index->Entries[i].Next)
+    {
+        if (Index->Entries[i].Hash != Hash)
+        {
+            continue;
+        }
+
+        /* Entries of deleted files may linger, so check the name on disk */
+        DirContext->DirIndex = Index->Entries[i].DirIndex;
+        Status = VfatGetNextDirEntry(DeviceExt, pContext, pPage, DirFcb, DirContext, TRUE);
+        if (NT_SUCCESS(Status) &&
+            !ENTRY_VOLUME(IsFatX, &DirContext->DirEntry) &&
+            DirContext->LongNameU.Length != 0 &&
+            DirContext->ShortNameU.Length != 0 &&
+            (RtlEqualUnicodeString(FileToFindU, &DirContext->LongNameU, TRUE) ||
+             RtlEqualUnicodeString(FileToFindU, &DirContext->ShortNameU, TRUE)))
+        {
+            *pStatus = STATUS_SUCCESS;
+            return TRUE;
+        }
+
+        if (*pContext != NULL)
+        {
+            CcUnpinData(*pContext);
+            *pContext = NULL;
+        }
+    }
+
+    *pStatus = STATUS_NO_MORE_ENTRIES;
+    return TRUE;
+}
+
+/*
+ * FUNCTION: Records a directory entry written by VfatAddEntry
+ */
+VOID
+vfatNameIndexAddEntry(
+    PVFATFCB DirFcb,
+    PVFAT_DIRENTRY_CONTEXT DirContext)
+{
+    if (DirFcb->NameIndex != NULL)
+    {
+        vfatIndexDirEntry(DirFcb, &DirContext->LongNameU, &DirContext->ShortNameU, DirContext->DirIndex);
+    }
+}
+
+/*
+ * FUNCTION: Forgets the directory entry of a file removed by VfatDelEntry
+ */
+VOID
+vfatNameIndexRemoveFcb(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB Fcb)
+{
+    PVFAT_NAME_INDEX Index = Fcb->parentFcb->NameIndex;
+    ULONG DirIndex;
+
+    if (Index == NULL)
+    {
+        return;
+    }
+
+    /* Undo the adjustment done by vfatInitFCBFromDirEntry */
+    DirIndex = Fcb->dirIndex;
+    if (vfatVolumeIsFatX(DeviceExt))
+    {
+        DirIndex += 2;
+    }
+
+    vfatRemoveNameFromIndex(Index, vfatNameIndexHash(&Fcb->LongNameU), DirIndex);
+    if (Fcb->ShortNameU.Length != 0)
+    {
+        vfatRemoveNameFromIndex(Index, vfatNameIndexHash(&Fcb->ShortNameU), DirIndex);
+    }
+}
@@ -237,6 +237,9 @@ vfatRenameEntry(
         CcSetDirtyPinnedData(Context, NULL);
         CcUnpinData(Context);
 
+        /* Renames in place are rare, rebuild the index on next use */
+        vfatDestroyNameIndex(pFcb->parentFcb);
+
         Status = vfatUpdateFCB(DeviceExt, pFcb, &DirContext, pFcb->parentFcb);
         if (NT_SUCCESS(Status))
         {
@@ -762,6 +765,7 @@ FATAddEntry(
     }
     CcSetDirtyPinnedData(Context, NULL);
     CcUnpinData(Context);
+    vfatNameIndexAddEntry(ParentFcb, &DirContext);
 
     if (MoveContext != NULL)
     {
@@ -936,6 +940,7 @@ FATXAddEntry(
     RtlCopyMemory(pFatXDirEntry, &DirContext.DirEntry.FatX, sizeof(FATX_DIR_ENTRY));
     CcSetDirtyPinnedData(Context, NULL);
     CcUnpinData(Context);
+    vfatNameIndexAddEntry(ParentFcb, &DirContext);
 
     if (MoveContext != NULL)
     {
@@ -1024,6 +1029,7 @@ FATDelEntry(
         CcSetDirtyPinnedData(Context, NULL);
         CcUnpinData(Context);
     }
+    vfatNameIndexRemoveFcb(DeviceExt, pFcb);
 
     /* In case of moving, don't delete data */
     if (MoveContext == NULL)
@@ -1103,6 +1109,7 @@ FATXDelEntry(
 
     CcSetDirtyPinnedData(Context, NULL);
     CcUnpinData(Context);
+    vfatNameIndexRemoveFcb(DeviceExt, pFcb);
 
     /* In case of moving, don't delete data */
     if (MoveContext == NULL)
@@ -20,6 +20,9 @@
 #define  CACHEPAGESIZE(pDeviceExt) ((pDeviceExt)->FatInfo.BytesPerCluster > PAGE_SIZE ? \
 		   (pDeviceExt)->FatInfo.BytesPerCluster : PAGE_SIZE)
 
+/* Large FAT32 volumes keep only one page of their free cluster bitmap */
+#define  FREE_CLUSTER_WINDOW (PAGE_SIZE * 8)
+
 /* FUNCTIONS ****************************************************************/
 
 /*
@@ -371,6 +374,29 @@ FAT32FindAndMarkAvailableCluster(
     return STATUS_DISK_FULL;
 }
 
+/*
+ * FUNCTION: Updates the bit of a cluster in the free cluster bitmap, if the
+ *           cluster is in the window of the volume that the bitmap holds
+ */
+static
+VOID
+SetFreeClusterBit(
+    PDEVICE_EXTENSION DeviceExt,
+    ULONG Cluster,
+    BOOLEAN Free)
+{
+    PRTL_BITMAP Bitmap = &DeviceExt->FreeClusterBitmap;
+    ULONG Index = Cluster - DeviceExt->FreeClusterWindow;
+
+    if (Bitmap->Buffer == NULL || Index >= Bitmap->SizeOfBitMap)
+        return;
+
+    if (Free)
+        RtlSetBit(Bitmap, Index);
+    else
+        RtlClearBit(Bitmap, Index);
+}
+
 /*
  * FUNCTION: Counts free cluster in a FAT12 table
  */
@@ -414,7 +440,10 @@ FAT12CountAvailableClusters(
         }
 
         if (Entry == 0)
+        {
             ulCount++;
+            SetFreeClusterBit(DeviceExt, i, TRUE);
+        }
     }
 
     CcUnpinData(Context);
@@ -465,7 +494,10 @@ FAT16CountAvailableClusters(
         while (Block < BlockEnd && i < FatLength)
         {
             if (*Block == 0)
+            {
                 ulCount++;
+                SetFreeClusterBit(DeviceExt, i, TRUE);
+            }
             Block++;
             i++;
         }
@@ -521,7 +553,10 @@ FAT32CountAvailableClusters(
         while (Block < BlockEnd && i < FatLength)
         {
             if ((*Block & 0x0fffffff) == 0)
+            {
                 ulCount++;
+                SetFreeClusterBit(DeviceExt, i, TRUE);
+            }
             Block++;
             i++;
         }
@@ -560,6 +595,229 @@ CountAvailableClusters(
     return Status;
 }
 
+/*
+ * FUNCTION: Drops the free cluster bitmap, allocation then scans the FAT
+ */
+static
+VOID
+FreeFreeClusterBitmap(
+    PDEVICE_EXTENSION DeviceExt)
+{
+    PVOID Buffer = DeviceExt->FreeClusterBitmap.Buffer;
+
+    DeviceExt->FreeClusterBitmap.Buffer = NULL;
+    ExFreePoolWithTag(Buffer, TAG_BITMAP);
+}
+
+/*
+ * FUNCTION: Fills the free cluster bitmap from the FAT32 table, for the
+ *           window of FREE_CLUSTER_WINDOW clusters that holds Cluster.
+ *           Only FAT32 volumes have more clusters than a window.
+ */
+static
+NTSTATUS
+LoadFreeClusterWindow(
+    PDEVICE_EXTENSION DeviceExt,
+    ULONG Cluster)
+{
+    PRTL_BITMAP Bitmap = &DeviceExt->FreeClusterBitmap;
+    ULONG FatLength;
+    ULONG First, Last, i;
+    PVOID BaseAddress;
+    ULONG ChunkSize;
+    PVOID Context;
+    LARGE_INTEGER Offset;
+    PULONG Block;
+    PULONG BlockEnd;
+
+    ASSERT(DeviceExt->FatInfo.FatType == FAT32 || DeviceExt->FatInfo.FatType == FATX32);
+
+    ChunkSize = CACHEPAGESIZE(DeviceExt);
+    FatLength = (DeviceExt->FatInfo.NumberOfClusters + 2);
+    First = ROUND_DOWN(Cluster, FREE_CLUSTER_WINDOW);
+    Last = min(First + FREE_CLUSTER_WINDOW, FatLength);
+
+    RtlInitializeBitMap(Bitmap, Bitmap->Buffer, Last - First);
+    RtlClearAllBits(Bitmap);
+    DeviceExt->FreeClusterWindow = First;
+
+    for (i = First; i < Last;)
+    {
+        Offset.QuadPart = ROUND_DOWN(i * 4, ChunkSize);
+        _SEH2_TRY
+        {
+            CcMapData(DeviceExt->FATFileObject, &Offset, ChunkSize, MAP_WAIT, &Context, &BaseAddress);
+        }
+        _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+        {
+            _SEH2_YIELD(return _SEH2_GetExceptionCode());
+        }
+        _SEH2_END;
+        Block = (PULONG)((ULONG_PTR)BaseAddress + (i * 4) % ChunkSize);
+        BlockEnd = (PULONG)((ULONG_PTR)BaseAddress + ChunkSize);
+
+        /* Now process the whole block */
+        while (Block < BlockEnd && i < Last)
+        {
+            if ((*Block & 0x0fffffff) == 0)
+                RtlSetBit(Bitmap, i - First);
+            Block++;
+            i++;
+        }
+
+        CcUnpinData(Context);
+    }
+
+    DPRINT("Free cluster window now at 0x%x\n", First);
+    return STATUS_SUCCESS;
+}
+
+/*
+ * FUNCTION: Builds the in-memory map of free clusters (one set bit per free
+ *           cluster) and the free cluster count, with a single pass over the FAT.
+ *           On large FAT32 volumes the map only covers a window of the volume,
+ *           starting with the first one. Without the map, allocation falls back
+ *           to scanning the FAT.
+ */
+NTSTATUS
+InitializeFreeClusterBitmap(
+    PDEVICE_EXTENSION DeviceExt)
+{
+    ULONG FatLength, BitmapLength;
+    PULONG Buffer;
+    NTSTATUS Status;
+
+    FatLength = DeviceExt->FatInfo.NumberOfClusters + 2;
+    BitmapLength = FatLength;
+    if ((DeviceExt->FatInfo.FatType == FAT32 || DeviceExt->FatInfo.FatType == FATX32) &&
+        FatLength > FREE_CLUSTER_WINDOW)
+    {
+        BitmapLength = FREE_CLUSTER_WINDOW;
+    }
+
+    DeviceExt->FreeClusterWindow = 0;
+    Buffer = ExAllocatePoolWithTag(PagedPool, ROUND_UP(BitmapLength, 32) / 8, TAG_BITMAP);
+    if (Buffer != NULL)
+    {
+        RtlInitializeBitMap(&DeviceExt->FreeClusterBitmap, Buffer, BitmapLength);
+        RtlClearAllBits(&DeviceExt->FreeClusterBitmap);
+    }
+    else
+    {
+        DPRINT1("No memory for the free cluster bitmap of %u clusters\n", BitmapLength);
+    }
+
+    DeviceExt->AvailableClustersValid = FALSE;
+    Status = CountAvailableClusters(DeviceExt, NULL);
+    if (!NT_SUCCESS(Status) && Buffer != NULL)
+    {
+        /* A partial map would hand out used clusters */
+        FreeFreeClusterBitmap(DeviceExt);
+    }
+
+    return Status;
+}
+
+/*
+ * FUNCTION: Moves the allocation cursor so that the next Count clusters
+ *           allocated, following LastCluster if it isn't 0, form a single run
+ */
+VOID
+PrepareClusterRun(
+    PDEVICE_EXTENSION DeviceExt,
+    ULONG LastCluster,
+    ULONG Count)
+{
+    PRTL_BITMAP Bitmap = &DeviceExt->FreeClusterBitmap;
+    ULONG Last, Hint, Index;
+
+    if (Count < 2)
+        return;
+
+    ExAcquireResourceExclusiveLite(&DeviceExt->FatResource, TRUE);
+    if (Bitmap->Buffer != NULL)
+    {
+        /* Only runs within the window are found, the bits are relative to it */
+        Last = LastCluster - DeviceExt->FreeClusterWindow;
+        Hint = DeviceExt->LastAvailableCluster - DeviceExt->FreeClusterWindow;
+
+        /* Grow in place when the clusters after the chain are free */
+        if (LastCluster >= 2 && Count < Bitmap->SizeOfBitMap &&
+            Last < Bitmap->SizeOfBitMap - Count &&
+            RtlAreBitsSet(Bitmap, Last + 1, Count))
+        {
+            Index = Last + 1;
+        }
+        else
+        {
+            Index = RtlFindSetBits(Bitmap, Count, Hint < Bitmap->SizeOfBitMap ? Hint : 0);
+        }
+
+        if (Index != 0xFFFFFFFF)
+            DeviceExt->LastAvailableCluster = DeviceExt->FreeClusterWindow + Index;
+    }
+    ExReleaseResourceLite(&DeviceExt->FatResource);
+}
+
+/*
+ * FUNCTION: Finds the next available cluster from the allocation cursor and
+ *           marks it as end of chain
+ */
+static
+NTSTATUS
+FindAndMarkAvailableCluster(
+    PDEVICE_EXTENSION DeviceExt,
+    PULONG Cluster)
+{
+    PRTL_BITMAP Bitmap = &DeviceExt->FreeClusterBitmap;
+    ULONG FatLength, Hint, Index, OldValue;
+    NTSTATUS Status;
+
+    if (Bitmap->Buffer == NULL)
+        return DeviceExt->FindAndMarkAvailableCluster(DeviceExt, Cluster);
+
+    *Cluster = 0;
+    FatLength = DeviceExt->FatInfo.NumberOfClusters + 2;
+    Hint = DeviceExt->LastAvailableCluster - DeviceExt->FreeClusterWindow;
+    Index = RtlFindSetBits(Bitmap, 1, Hint < Bitmap->SizeOfBitMap ? Hint : 0);
+    if (Index == 0xFFFFFFFF)
+    {
+        if (Bitmap->SizeOfBitMap == FatLength)
+            return STATUS_DISK_FULL;
+
+        /* Nothing is free in the window: scan the FAT after it, then move
+         * the window to the cluster found there */
+        DeviceExt->LastAvailableCluster = DeviceExt->FreeClusterWindow + Bitmap->SizeOfBitMap;
+        if (DeviceExt->LastAvailableCluster >= FatLength)
+            DeviceExt->LastAvailableCluster = 2;
+
+        Status = DeviceExt->FindAndMarkAvailableCluster(DeviceExt, Cluster);
+        if (!NT_SUCCESS(Status))
+            return Status;
+
+        Status = LoadFreeClusterWindow(DeviceExt, *Cluster);
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("Cannot load the free cluster window of 0x%x (0x%x)\n", *Cluster, Status);
+            FreeFreeClusterBitmap(DeviceExt);
+        }
+        return STATUS_SUCCESS;
+    }
+
+    Index += DeviceExt->FreeClusterWindow;
+    Status = DeviceExt->WriteCluster(DeviceExt, Index, 0xffffffff, &OldValue);
+    if (!NT_SUCCESS(Status))
+        return Status;
+
+    ASSERT(OldValue == 0);
+    DPRINT("Found available cluster 0x%x\n", Index);
+    SetFreeClusterBit(DeviceExt, Index, FALSE);
+    DeviceExt->LastAvailableCluster = *Cluster = Index;
+    if (DeviceExt->AvailableClustersValid)
+        InterlockedDecrement((PLONG)&DeviceExt->AvailableClusters);
+    return STATUS_SUCCESS;
+}
+
 
 /*
  * FUNCTION: Writes a cluster to the FAT12 physical and in-memory tables
@@ -710,6 +968,13 @@ WriteCluster(
 
     ExAcquireResourceExclusiveLite (&DeviceExt->FatResource, TRUE);
     Status = DeviceExt->WriteCluster(DeviceExt, ClusterToWrite, NewValue, &OldValue);
+    if (NT_SUCCESS(Status))
+    {
+        if (NewValue == 0)
+            SetFreeClusterBit(DeviceExt, ClusterToWrite, TRUE);
+        else if (OldValue == 0)
+            SetFreeClusterBit(DeviceExt, ClusterToWrite, FALSE);
+    }
     if (DeviceExt->AvailableClustersValid)
     {
         if (OldValue && NewValue == 0)
@@ -786,7 +1051,7 @@ GetNextClusterExtend(
      */
     if (CurrentCluster == 0)
     {
-        Status = DeviceExt->FindAndMarkAvailableCluster(DeviceExt, &NewCluster);
+        Status = FindAndMarkAvailableCluster(DeviceExt, &NewCluster);
         if (!NT_SUCCESS(Status))
         {
             ExReleaseResourceLite(&DeviceExt->FatResource);
@@ -805,7 +1070,7 @@ GetNextClusterExtend(
         /* We are after last existing cluster, we must add one to file */
         /* Firstly, find the next available open allocation unit and
            mark it as end of file */
-        Status = DeviceExt->FindAndMarkAvailableCluster(DeviceExt, &NewCluster);
+        Status = FindAndMarkAvailableCluster(DeviceExt, &NewCluster);
         if (!NT_SUCCESS(Status))
         {
             ExReleaseResourceLite(&DeviceExt->FatResource);
@@ -203,6 +203,7 @@ vfatDelFCBFromTable(
         entry->next = pFCB->Hash.next;
     }
 
+    pVCB->HashTableCount -= (pFCB->Hash.Hash != pFCB->ShortHash.Hash) ? 2 : 1;
     RemoveEntryList(&pFCB->FcbListEntry);
 }
 
@@ -283,6 +284,7 @@ vfatDestroyFCB(
     {
         RemoveEntryList(&pFCB->ParentListEntry);
     }
+    vfatDestroyNameIndex(pFCB);
     ExFreePool(pFCB->PathNameBuffer);
     ExDeleteResourceLite(&pFCB->PagingIoResource);
     ExDeleteResourceLite(&pFCB->MainResource);
@@ -396,6 +398,49 @@ _vfatReleaseFCB(
     }
 }
 
+/*
+ * The table starts with the size picked at mount time, and is rehashed into
+ * a table about twice as large when chains get longer than two entries on
+ * average. If that allocation fails, the current table is kept.
+ */
+static
+VOID
+vfatGrowFCBTable(
+    PDEVICE_EXTENSION pVCB)
+{
+    HASHENTRY **NewTable;
+    HASHENTRY *entry;
+    ULONG NewSize, i;
+
+    NewSize = pVCB->HashTableSize * 2 + 1;
+    NewTable = ExAllocatePoolWithTag(NonPagedPool, NewSize * sizeof(HASHENTRY*), TAG_FCB);
+    if (NewTable == NULL)
+    {
+        return;
+    }
+    RtlZeroMemory(NewTable, NewSize * sizeof(HASHENTRY*));
+
+    for (i = 0; i < pVCB->HashTableSize; i++)
+    {
+        while (pVCB->FcbHashTable[i] != NULL)
+        {
+            entry = pVCB->FcbHashTable[i];
+            pVCB->FcbHashTable[i] = entry->next;
+            entry->next = NewTable[entry->Hash % NewSize];
+            NewTable[entry->Hash % NewSize] = entry;
+        }
+    }
+
+    /* The initial table lives in the device extension */
+    if (pVCB->FcbHashTable != VCB_INITIAL_HASH_TABLE(pVCB))
+    {
+        ExFreePoolWithTag(pVCB->FcbHashTable, TAG_FCB);
+    }
+    pVCB->FcbHashTable = NewTable;
+    pVCB->HashTableSize = NewSize;
+    DPRINT("FCB table grown to %u buckets\n", NewSize);
+}
+
 static
 VOID
 vfatAddFCBToTable(
@@ -406,6 +451,11 @@ vfatAddFCBToTable(
     ULONG ShortIndex;
 
     ASSERT(pFCB->Hash.Hash == vfatNameHash(0, &pFCB->PathNameU));
+
+    if (pVCB->HashTableCount + 2 > pVCB->HashTableSize * 2)
+    {
+        vfatGrowFCBTable(pVCB);
+    }
     Index = pFCB->Hash.Hash % pVCB->HashTableSize;
     ShortIndex = pFCB->ShortHash.Hash % pVCB->HashTableSize;
 
@@ -413,10 +463,12 @@ vfatAddFCBToTable(
 
     pFCB->Hash.next = pVCB->FcbHashTable[Index];
     pVCB->FcbHashTable[Index] = &pFCB->Hash;
+    pVCB->HashTableCount++;
     if (pFCB->Hash.Hash != pFCB->ShortHash.Hash)
     {
         pFCB->ShortHash.next = pVCB->FcbHashTable[ShortIndex];
         pVCB->FcbHashTable[ShortIndex] = &pFCB->ShortHash;
+        pVCB->HashTableCount++;
     }
     if (pFCB->parentFcb)
     {
@@ -609,30 +661,34 @@ vfatGrabFCBFromTable(
     Hash = vfatNameHash(0, PathNameU);
 
     entry = pVCB->FcbHashTable[Hash % pVCB->HashTableSize];
-    if (entry)
-    {
-        vfatSplitPathName(PathNameU, &DirNameU, &FileNameU);
-    }
+    DirNameU.Buffer = NULL;
 
     while (entry)
     {
         if (entry->Hash == Hash)
         {
             rcFCB = entry->self;
-            DPRINT("'%wZ' '%wZ'\n", &DirNameU, &rcFCB->DirNameU);
-            if (RtlEqualUnicodeString(&DirNameU, &rcFCB->DirNameU, TRUE))
+            if (rcFCB->Hash.Hash == Hash)
             {
-                if (rcFCB->Hash.Hash == Hash)
+                /* The path of the FCB is its directory and long name, so
+                 * compare it in one go */
+                DPRINT("'%wZ' '%wZ'\n", PathNameU, &rcFCB->PathNameU);
+                if (RtlEqualUnicodeString(PathNameU, &rcFCB->PathNameU, TRUE))
                 {
-                    FcbNameU = &rcFCB->LongNameU;
+                    vfatGrabFCB(pVCB, rcFCB);
+                    return rcFCB;
                 }
-                else
+            }
+            else
+            {
+                if (DirNameU.Buffer == NULL)
                 {
-                    FcbNameU = &rcFCB->ShortNameU;
+                    vfatSplitPathName(PathNameU, &DirNameU, &FileNameU);
                 }
-                /* compare the file name */
-                DPRINT("'%wZ' '%wZ'\n", &FileNameU, FcbNameU);
-                if (RtlEqualUnicodeString(&FileNameU, FcbNameU, TRUE))
+                DPRINT("'%wZ' '%wZ'\n", &DirNameU, &rcFCB->DirNameU);
+                FcbNameU = &rcFCB->ShortNameU;
+                if (RtlEqualUnicodeString(&FileNameU, FcbNameU, TRUE) &&
+                    RtlEqualUnicodeString(&DirNameU, &rcFCB->DirNameU, TRUE))
                 {
                     vfatGrabFCB(pVCB, rcFCB);
                     return rcFCB;
@@ -824,6 +880,23 @@ vfatDirFindFile(
     DirContext.ShortNameU.MaximumLength = sizeof(ShortNameBuffer);
     DirContext.DeviceExt = pDeviceExt;
 
+    if (vfatLookupNameIndex(pDeviceExt, pDirectoryFCB, FileToFindU, &DirContext, &Context, &Page, &status))
+    {
+        if (status == STATUS_NO_MORE_ENTRIES)
+        {
+            return STATUS_OBJECT_NAME_NOT_FOUND;
+        }
+        status = vfatMakeFCBFromDirEntry(pDeviceExt,
+            pDirectoryFCB,
+            &DirContext,
+            pFoundFCB);
+        if (Context)
+        {
+            CcUnpinData(Context);
+        }
+        return status;
+    }
+
     while (TRUE)
     {
         status = VfatGetNextDirEntry(pDeviceExt,
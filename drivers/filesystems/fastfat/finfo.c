@@ -1245,6 +1245,7 @@ VfatSetAllocationSizeInformation(
         if (FirstCluster == 0)
         {
             Fcb->LastCluster = Fcb->LastOffset = 0;
+            PrepareClusterRun(DeviceExt, 0, (NewSize - 1) / ClusterSize + 1);
             Status = NextCluster(DeviceExt, FirstCluster, &FirstCluster, TRUE);
             if (!NT_SUCCESS(Status))
             {
@@ -1323,6 +1324,9 @@ VfatSetAllocationSizeInformation(
             Fcb->LastCluster = Cluster;
             Fcb->LastOffset = Fcb->RFCB.AllocationSize.u.LowPart - ClusterSize;
 
+            PrepareClusterRun(DeviceExt, Cluster,
+                              (NewSize - 1) / ClusterSize - Fcb->LastOffset / ClusterSize);
+
             /* FIXME: Check status */
             /* Cluster points now to the last cluster within the chain */
             Status = OffsetToCluster(DeviceExt, Cluster,
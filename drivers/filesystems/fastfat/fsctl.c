@@ -596,7 +596,7 @@ VfatMount(
 
     DeviceExt = DeviceObject->DeviceExtension;
     RtlZeroMemory(DeviceExt, ROUND_UP(sizeof(DEVICE_EXTENSION), sizeof(ULONG)) + sizeof(HASHENTRY*) * HashTableSize);
-    DeviceExt->FcbHashTable = (HASHENTRY**)((ULONG_PTR)DeviceExt + ROUND_UP(sizeof(DEVICE_EXTENSION), sizeof(ULONG)));
+    DeviceExt->FcbHashTable = VCB_INITIAL_HASH_TABLE(DeviceExt);
     DeviceExt->HashTableSize = HashTableSize;
     DeviceExt->VolumeDevice = DeviceObject;
 
@@ -733,8 +733,8 @@ VfatMount(
     _SEH2_END;
 
     DeviceExt->LastAvailableCluster = 2;
-    CountAvailableClusters(DeviceExt, NULL);
     ExInitializeResourceLite(&DeviceExt->FatResource);
+    InitializeFreeClusterBitmap(DeviceExt);
 
     InitializeListHead(&DeviceExt->FcbListHead);
 
@@ -825,6 +825,8 @@ ByeBye:
             ExFreePoolWithTag(DeviceExt->SpareVPB, TAG_VPB);
         if (DeviceExt && DeviceExt->Statistics)
             ExFreePoolWithTag(DeviceExt->Statistics, TAG_STATS);
+        if (DeviceExt && DeviceExt->FreeClusterBitmap.Buffer)
+            ExFreePoolWithTag(DeviceExt->FreeClusterBitmap.Buffer, TAG_BITMAP);
         if (DeviceObject)
             IoDeleteDevice(DeviceObject);
     }
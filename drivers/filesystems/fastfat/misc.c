@@ -578,6 +578,10 @@ VfatCheckForDismount(
 
         /* Release resources */
         ExFreePoolWithTag(DeviceExt->Statistics, TAG_STATS);
+        if (DeviceExt->FreeClusterBitmap.Buffer)
+            ExFreePoolWithTag(DeviceExt->FreeClusterBitmap.Buffer, TAG_BITMAP);
+        if (DeviceExt->FcbHashTable != VCB_INITIAL_HASH_TABLE(DeviceExt))
+            ExFreePoolWithTag(DeviceExt->FcbHashTable, TAG_FCB);
         ExDeleteResourceLite(&DeviceExt->DirResource);
         ExDeleteResourceLite(&DeviceExt->FatResource);
 
@@ -316,6 +316,7 @@ typedef struct DEVICE_EXTENSION
     KSPIN_LOCK FcbListLock;
     LIST_ENTRY FcbListHead;
     ULONG HashTableSize;
+    ULONG HashTableCount;
     struct _HASHENTRY **FcbHashTable;
 
     PDEVICE_OBJECT VolumeDevice;
@@ -325,6 +326,8 @@ typedef struct DEVICE_EXTENSION
     ULONG LastAvailableCluster;
     ULONG AvailableClusters;
     BOOLEAN AvailableClustersValid;
+    RTL_BITMAP FreeClusterBitmap;
+    ULONG FreeClusterWindow;
     ULONG Flags;
     struct _VFATFCB *VolumeFcb;
     struct _VFATFCB *RootFcb;
@@ -510,6 +513,9 @@ typedef struct _VFATFCB
     /* Entry into the hash table for the path + short name */
     HASHENTRY ShortHash;
 
+    /* Name to directory entry index, for large directories */
+    struct _VFAT_NAME_INDEX *NameIndex;
+
     /* List of byte-range locks for this file */
     FILE_LOCK FileLock;
 
@@ -537,6 +543,10 @@ typedef struct _VFATCCB
     UNICODE_STRING SearchPattern;
 } VFATCCB, *PVFATCCB;
 
+/* The FCB hash table starts out right after the device extension */
+#define VCB_INITIAL_HASH_TABLE(Vcb) \
+    ((HASHENTRY**)((ULONG_PTR)(Vcb) + ROUND_UP(sizeof(DEVICE_EXTENSION), sizeof(ULONG))))
+
 #define TAG_CCB  'CtaF'
 #define TAG_FCB  'FtaF'
 #define TAG_IRP  'ItaF'
@@ -547,6 +557,8 @@ typedef struct _VFATCCB
 #define TAG_NAME 'ntaF'
 #define TAG_SEARCH 'LtaF'
 #define TAG_DIRENT 'DtaF'
+#define TAG_BITMAP 'BtaF'
+#define TAG_NAME_INDEX 'XtaF'
 
 #define ENTRIES_PER_SECTOR (BLOCKSIZE / sizeof(FATDirEntry))
 
@@ -768,6 +780,32 @@ FsdSystemTimeToDosDateTime(
     USHORT *pDosDate,
     USHORT *pDosTime);
 
+/* dirindex.c */
+
+VOID
+vfatDestroyNameIndex(
+    PVFATFCB DirFcb);
+
+BOOLEAN
+vfatLookupNameIndex(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB DirFcb,
+    PUNICODE_STRING FileToFindU,
+    PVFAT_DIRENTRY_CONTEXT DirContext,
+    PVOID *pContext,
+    PVOID *pPage,
+    PNTSTATUS pStatus);
+
+VOID
+vfatNameIndexAddEntry(
+    PVFATFCB DirFcb,
+    PVFAT_DIRENTRY_CONTEXT DirContext);
+
+VOID
+vfatNameIndexRemoveFcb(
+    PDEVICE_EXTENSION DeviceExt,
+    PVFATFCB Fcb);
+
 /* direntry.c */
 
 ULONG
@@ -920,6 +958,16 @@ CountAvailableClusters(
     PDEVICE_EXTENSION DeviceExt,
     PLARGE_INTEGER Clusters);
 
+NTSTATUS
+InitializeFreeClusterBitmap(
+    PDEVICE_EXTENSION DeviceExt);
+
+VOID
+PrepareClusterRun(
+    PDEVICE_EXTENSION DeviceExt,
+    ULONG LastCluster,
+    ULONG Count);
+
 NTSTATUS
 WriteCluster(
     PDEVICE_EXTENSION DeviceExt,
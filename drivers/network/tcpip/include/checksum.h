@@ -15,6 +15,12 @@ ULONG ChecksumCompute(
     UINT Count,
     ULONG Seed);
 
+ULONG ChecksumCopy(
+    PVOID Destination,
+    PVOID Source,
+    UINT Count,
+    ULONG Seed);
+
 unsigned int
 csum_partial(
   const unsigned char * buff,
@@ -27,9 +33,20 @@ UDPv4ChecksumCalculate(
   PUCHAR PacketBuffer,
   ULONG DataLength);
 
+ULONG
+UDPv4ChecksumCopy(
+  PIPv4_HEADER IPHeader,
+  PUCHAR PacketBuffer,
+  ULONG HeaderLength,
+  PVOID Data,
+  ULONG DataLength);
+
 #define IPv4Checksum(Data, Count, Seed)(~ChecksumFold(ChecksumCompute(Data, Count, Seed)))
+#ifdef _M_IX86
 #define TCPv4Checksum(Data, Count, Seed)(~ChecksumFold(csum_partial(Data, Count, Seed)))
-//#define TCPv4Checksum(Data, Count, Seed)(~ChecksumFold(ChecksumCompute(Data, Count, Seed)))
+#else
+#define TCPv4Checksum(Data, Count, Seed)(~ChecksumFold(ChecksumCompute(Data, Count, Seed)))
+#endif
 
 /*
  * Macro to check for a correct checksum
@@ -18,6 +18,8 @@ typedef struct _FIB_ENTRY {
     IP_ADDRESS Netmask;           /* Netmask of network */
     PNEIGHBOR_CACHE_ENTRY Router; /* Pointer to NCE of router to use */
     UINT Metric;                  /* Cost of this route */
+    struct _FIB_NODE *Node;       /* Prefix trie node holding the route (IPv4 only) */
+    LIST_ENTRY NodeListEntry;     /* Entry on the route list of the node */
 } FIB_ENTRY, *PFIB_ENTRY;
 
 PFIB_ENTRY RouterAddRoute(
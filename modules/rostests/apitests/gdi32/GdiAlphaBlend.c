@@ -0,0 +1,344 @@
+/*
+ * PROJECT:         ReactOS api tests
+ * LICENSE:         GPLv2+ - See COPYING in the top level directory
+ * PURPOSE:         Test for GdiAlphaBlend
+ * PROGRAMMER:      ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define TEST_SIZE   256
+
+static
+HBITMAP
+CreateTestDIB(
+    _In_ HDC hdc,
+    _In_ WORD BitCount,
+    _Out_ PVOID *Bits)
+{
+    struct
+    {
+        BITMAPINFOHEADER bmiHeader;
+        DWORD Masks[3];
+    } bmi = { { 0 } };
+
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = TEST_SIZE;
+    bmi.bmiHeader.biHeight = -TEST_SIZE;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = BitCount;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    if (BitCount == 16)
+    {
+        /* 5-6-5 */
+        bmi.bmiHeader.biCompression = BI_BITFIELDS;
+        bmi.Masks[0] = 0xF800;
+        bmi.Masks[1] = 0x07E0;
+        bmi.Masks[2] = 0x001F;
+    }
+
+    return CreateDIBSection(hdc, (BITMAPINFO*)&bmi, DIB_RGB_COLORS, Bits, NULL, 0);
+}
+
+static
+ULONG
+NextRandom(
+    _Inout_ PULONG Seed)
+{
+    *Seed = *Seed * 1103515245 + 12345;
+    return (*Seed >> 8) ^ (*Seed << 16);
+}
+
+static
+VOID
+FillSource(
+    _Out_writes_(TEST_SIZE * TEST_SIZE) PULONG Bits)
+{
+    static const UCHAR Alphas[] = { 0, 1, 127, 128, 254, 255 };
+    ULONG Seed = 0x1234, i, Pixel, Alpha;
+
+    /* Premultiplied pixels, with runs of transparent and opaque ones as in real images,
+       and the partial alphas where rounding goes wrong first */
+    for (i = 0; i < TEST_SIZE * TEST_SIZE; i++)
+    {
+        Pixel = NextRandom(&Seed);
+        Alpha = Pixel >> 24;
+        if ((i / 64) % 4 == 1)
+            Alpha = 0;
+        else if ((i / 64) % 4 == 2)
+            Alpha = 255;
+        else if ((i / 64) % 4 == 3)
+            Alpha = Alphas[i % ARRAYSIZE(Alphas)];
+        Bits[i] = (Alpha << 24) |
+                  ((((Pixel >> 16) & 0xFF) * Alpha / 255) << 16) |
+                  ((((Pixel >> 8) & 0xFF) * Alpha / 255) << 8) |
+                  ((Pixel & 0xFF) * Alpha / 255);
+    }
+}
+
+static
+ULONG
+InitialDest(
+    _In_ WORD BitCount,
+    _In_ ULONG x,
+    _In_ ULONG y)
+{
+    ULONG Seed = y * TEST_SIZE + x;
+
+    NextRandom(&Seed);
+    return NextRandom(&Seed) & (BitCount == 32 ? 0xFFFFFFFF : (1UL << BitCount) - 1);
+}
+
+static
+PVOID
+PixelAddress(
+    _In_ PVOID Bits,
+    _In_ WORD BitCount,
+    _In_ ULONG x,
+    _In_ ULONG y)
+{
+    return (PUCHAR)Bits + (y * TEST_SIZE + x) * BitCount / 8;
+}
+
+static
+ULONG
+GetTestPixel(
+    _In_ PVOID Bits,
+    _In_ WORD BitCount,
+    _In_ ULONG x,
+    _In_ ULONG y)
+{
+    PUCHAR Pixel = PixelAddress(Bits, BitCount, x, y);
+
+    if (BitCount == 32)
+        return *(PULONG)Pixel;
+    else if (BitCount == 24)
+        return Pixel[0] | (Pixel[1] << 8) | (Pixel[2] << 16);
+    else
+        return *(PUSHORT)Pixel;
+}
+
+static
+VOID
+SetTestPixel(
+    _In_ PVOID Bits,
+    _In_ WORD BitCount,
+    _In_ ULONG x,
+    _In_ ULONG y,
+    _In_ ULONG Value)
+{
+    PUCHAR Pixel = PixelAddress(Bits, BitCount, x, y);
+
+    if (BitCount == 32)
+    {
+        *(PULONG)Pixel = Value;
+    }
+    else if (BitCount == 24)
+    {
+        Pixel[0] = (UCHAR)Value;
+        Pixel[1] = (UCHAR)(Value >> 8);
+        Pixel[2] = (UCHAR)(Value >> 16);
+    }
+    else
+    {
+        *(PUSHORT)Pixel = (USHORT)Value;
+    }
+}
+
+static
+ULONG
+BlendChannel(
+    _In_ ULONG Dest,
+    _In_ ULONG Source,
+    _In_ ULONG Alpha,
+    _In_ ULONG Max)
+{
+    return min(Dest * (Max - Alpha) / Max + Source, Max);
+}
+
+/* What win32k computes for one pixel, it divides by 255 and truncates at every step */
+static
+ULONG
+ExpectedPixel(
+    _In_ WORD BitCount,
+    _In_ ULONG Dest,
+    _In_ ULONG Source,
+    _In_ BLENDFUNCTION BlendFunc)
+{
+    ULONG Blue, Green, Red, SrcAlpha, Alpha;
+
+    Blue = (Source & 0xFF) * BlendFunc.SourceConstantAlpha / 255;
+    Green = ((Source >> 8) & 0xFF) * BlendFunc.SourceConstantAlpha / 255;
+    Red = ((Source >> 16) & 0xFF) * BlendFunc.SourceConstantAlpha / 255;
+    SrcAlpha = (Source >> 24) * BlendFunc.SourceConstantAlpha / 255;
+    Alpha = (BlendFunc.AlphaFormat & AC_SRC_ALPHA) ? SrcAlpha : BlendFunc.SourceConstantAlpha;
+
+    if (BitCount == 32)
+    {
+        return BlendChannel(Dest & 0xFF, Blue, Alpha, 255) |
+               (BlendChannel((Dest >> 8) & 0xFF, Green, Alpha, 255) << 8) |
+               (BlendChannel((Dest >> 16) & 0xFF, Red, Alpha, 255) << 16) |
+               (BlendChannel(Dest >> 24, SrcAlpha, Alpha, 255) << 24);
+    }
+    else if (BitCount == 24)
+    {
+        return BlendChannel(Dest & 0xFF, Blue, Alpha, 255) |
+               (BlendChannel((Dest >> 8) & 0xFF, Green, Alpha, 255) << 8) |
+               (BlendChannel((Dest >> 16) & 0xFF, Red, Alpha, 255) << 16);
+    }
+    else
+    {
+        /* 5-6-5, blended in its own bit depth */
+        return BlendChannel(Dest & 0x1F, Blue >> 3, Alpha >> 3, 31) |
+               (BlendChannel((Dest >> 5) & 0x3F, Green >> 2, Alpha >> 2, 63) << 5) |
+               (BlendChannel(Dest >> 11, Red >> 3, Alpha >> 3, 31) << 11);
+    }
+}
+
+static
+VOID
+TestBlend(
+    _In_ HDC hdc,
+    _In_ PVOID Bits,
+    _In_ HDC hdcStretch,
+    _In_ PVOID StretchBits,
+    _In_ HDC hdcSrc,
+    _In_ PULONG SrcBits,
+    _In_ WORD BitCount,
+    _In_ BLENDFUNCTION BlendFunc)
+{
+    ULONG x, y, Pixel, Expected, Errors, StretchErrors;
+    BOOL ret;
+
+    for (y = 0; y < TEST_SIZE; y++)
+    {
+        for (x = 0; x < TEST_SIZE; x++)
+        {
+            SetTestPixel(Bits, BitCount, x, y, InitialDest(BitCount, x, y));
+            SetTestPixel(StretchBits, BitCount, x, y, InitialDest(BitCount, x / 2, y));
+        }
+    }
+
+    /* The same sizes take the scanline path, a stretch takes the pixel by pixel one */
+    ret = GdiAlphaBlend(hdc, 0, 0, TEST_SIZE, TEST_SIZE, hdcSrc, 0, 0, TEST_SIZE, TEST_SIZE, BlendFunc);
+    ok(ret == TRUE, "GdiAlphaBlend failed for %u bpp\n", BitCount);
+    ret = GdiAlphaBlend(hdcStretch, 0, 0, TEST_SIZE, TEST_SIZE, hdcSrc, 0, 0, TEST_SIZE / 2, TEST_SIZE, BlendFunc);
+    ok(ret == TRUE, "Stretched GdiAlphaBlend failed for %u bpp\n", BitCount);
+
+    Errors = StretchErrors = 0;
+    for (y = 0; y < TEST_SIZE; y++)
+    {
+        for (x = 0; x < TEST_SIZE; x++)
+        {
+            Pixel = GetTestPixel(Bits, BitCount, x, y);
+            Expected = ExpectedPixel(BitCount, InitialDest(BitCount, x, y), SrcBits[y * TEST_SIZE + x], BlendFunc);
+            if (Pixel != Expected && Errors++ == 0)
+            {
+                ok(0, "%u bpp, alpha %u: pixel (%lu,%lu) of 0x%08lx over 0x%08lx is 0x%08lx, expected 0x%08lx\n",
+                   BitCount, BlendFunc.SourceConstantAlpha, x, y, SrcBits[y * TEST_SIZE + x],
+                   InitialDest(BitCount, x, y), Pixel, Expected);
+            }
+
+            /* Every stretched column must match the unstretched one it was taken from */
+            if (GetTestPixel(StretchBits, BitCount, x, y) != GetTestPixel(Bits, BitCount, x / 2, y) &&
+                StretchErrors++ == 0)
+            {
+                ok(0, "%u bpp, alpha %u: stretched pixel (%lu,%lu) is 0x%08lx, unstretched 0x%08lx\n",
+                   BitCount, BlendFunc.SourceConstantAlpha, x, y, GetTestPixel(StretchBits, BitCount, x, y),
+                   GetTestPixel(Bits, BitCount, x / 2, y));
+            }
+        }
+    }
+    ok(Errors == 0, "%u bpp, alpha %u, format %u: %lu pixels differ\n",
+       BitCount, BlendFunc.SourceConstantAlpha, BlendFunc.AlphaFormat, Errors);
+    ok(StretchErrors == 0, "%u bpp, alpha %u, format %u: %lu stretched pixels differ\n",
+       BitCount, BlendFunc.SourceConstantAlpha, BlendFunc.AlphaFormat, StretchErrors);
+}
+
+static
+VOID
+TestFormat(
+    _In_ HDC hdcSrc,
+    _In_ PULONG SrcBits,
+    _In_ WORD BitCount)
+{
+    static const BLENDFUNCTION BlendFuncs[] =
+    {
+        { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA },
+        { AC_SRC_OVER, 0, 128, AC_SRC_ALPHA },
+        { AC_SRC_OVER, 0, 77, AC_SRC_ALPHA },
+        { AC_SRC_OVER, 0, 128, 0 },
+        { AC_SRC_OVER, 0, 254, 0 },
+    };
+    BLENDFUNCTION BlendFunc = { AC_SRC_OVER, 0, 128, AC_SRC_ALPHA };
+    LARGE_INTEGER Frequency, Start, End;
+    HBITMAP hbmp, hbmpOld, hbmpStretch, hbmpStretchOld;
+    PVOID Bits, StretchBits;
+    HDC hdc, hdcStretch;
+    ULONG i;
+
+    hdc = CreateCompatibleDC(NULL);
+    hdcStretch = CreateCompatibleDC(NULL);
+    hbmp = CreateTestDIB(hdc, BitCount, &Bits);
+    hbmpStretch = CreateTestDIB(hdcStretch, BitCount, &StretchBits);
+    ok(hbmp != NULL && hbmpStretch != NULL, "Failed to create %u bpp DIB section\n", BitCount);
+    if (!hbmp || !hbmpStretch)
+    {
+        if (hbmp)
+            DeleteObject(hbmp);
+        if (hbmpStretch)
+            DeleteObject(hbmpStretch);
+        DeleteDC(hdcStretch);
+        DeleteDC(hdc);
+        return;
+    }
+    hbmpOld = SelectObject(hdc, hbmp);
+    hbmpStretchOld = SelectObject(hdcStretch, hbmpStretch);
+
+    for (i = 0; i < ARRAYSIZE(BlendFuncs); i++)
+        TestBlend(hdc, Bits, hdcStretch, StretchBits, hdcSrc, SrcBits, BitCount, BlendFuncs[i]);
+
+    /* Half transparent constant alpha over the whole surface */
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    for (i = 0; i < 16; i++)
+        GdiAlphaBlend(hdc, 0, 0, TEST_SIZE, TEST_SIZE, hdcSrc, 0, 0, TEST_SIZE, TEST_SIZE, BlendFunc);
+    QueryPerformanceCounter(&End);
+
+    trace("%u bpp: %lu megapixels per second\n", BitCount,
+          (ULONG)(16ULL * TEST_SIZE * TEST_SIZE * Frequency.QuadPart /
+                  max(End.QuadPart - Start.QuadPart, 1) / 1000000));
+
+    SelectObject(hdcStretch, hbmpStretchOld);
+    SelectObject(hdc, hbmpOld);
+    DeleteObject(hbmpStretch);
+    DeleteObject(hbmp);
+    DeleteDC(hdcStretch);
+    DeleteDC(hdc);
+}
+
+START_TEST(GdiAlphaBlend)
+{
+    HBITMAP hbmpSrc, hbmpOld;
+    PULONG SrcBits;
+    HDC hdcSrc;
+
+    hdcSrc = CreateCompatibleDC(NULL);
+    hbmpSrc = CreateTestDIB(hdcSrc, 32, (PVOID*)&SrcBits);
+    if (!hbmpSrc)
+    {
+        skip("Failed to create the source DIB section\n");
+        DeleteDC(hdcSrc);
+        return;
+    }
+    hbmpOld = SelectObject(hdcSrc, hbmpSrc);
+    FillSource(SrcBits);
+
+    TestFormat(hdcSrc, SrcBits, 32);
+    TestFormat(hdcSrc, SrcBits, 24);
+    TestFormat(hdcSrc, SrcBits, 16);
+
+    SelectObject(hdcSrc, hbmpOld);
+    DeleteObject(hbmpSrc);
+    DeleteDC(hdcSrc);
+}
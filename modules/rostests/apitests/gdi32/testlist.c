@@ -28,6 +28,7 @@ extern void func_ExcludeClipRect(void);
 extern void func_ExtCreatePen(void);
 extern void func_ExtCreateRegion(void);
 extern void func_FrameRgn(void);
+extern void func_GdiAlphaBlend(void);
 extern void func_GdiConvertBitmap(void);
 extern void func_GdiConvertBrush(void);
 extern void func_GdiConvertDC(void);
@@ -103,6 +104,7 @@ const struct test winetest_testlist[] =
     { "ExtCreatePen", func_ExtCreatePen },
     { "ExtCreateRegion", func_ExtCreateRegion },
     { "FrameRgn", func_FrameRgn },
+    { "GdiAlphaBlend", func_GdiAlphaBlend },
     { "GdiConvertBitmap", func_GdiConvertBitmap },
     { "GdiConvertBrush", func_GdiConvertBrush },
     { "GdiConvertDC", func_GdiConvertDC },
@@ -0,0 +1,229 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test and time concurrent cached reads of a large file
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define FILE_SIZE       (64 * 1024 * 1024)
+#define CHUNK_SIZE      (1024 * 1024)
+#define READ_SIZE       4096
+#define THREAD_COUNT    4
+#define RANDOM_READS    4096
+
+typedef struct _READ_THREAD
+{
+    PCWSTR FileName;
+    ULONG Index;
+    BOOL Random;
+    ULONG Errors;
+} READ_THREAD, *PREAD_THREAD;
+
+static
+ULONG
+NextRandom(
+    PULONG Seed)
+{
+    *Seed = *Seed * 1103515245 + 12345;
+    return *Seed >> 8;
+}
+
+/* Every ULONG of the file holds its own offset */
+static
+ULONG
+CheckBuffer(
+    PULONG Buffer,
+    ULONG Offset,
+    ULONG Length)
+{
+    ULONG i;
+
+    for (i = 0; i < Length / sizeof(ULONG); i++)
+    {
+        if (Buffer[i] != Offset + i * sizeof(ULONG))
+            return 1;
+    }
+    return 0;
+}
+
+static
+BOOL
+ReadAt(
+    HANDLE hFile,
+    PVOID Buffer,
+    ULONG Offset,
+    ULONG Length)
+{
+    OVERLAPPED Overlapped;
+    DWORD Read;
+
+    ZeroMemory(&Overlapped, sizeof(Overlapped));
+    Overlapped.Offset = Offset;
+    return ReadFile(hFile, Buffer, Length, &Read, &Overlapped) && Read == Length;
+}
+
+static
+DWORD
+WINAPI
+ReadThread(
+    PVOID Parameter)
+{
+    PREAD_THREAD Thread = Parameter;
+    ULONG Buffer[READ_SIZE / sizeof(ULONG)];
+    ULONG Offset, Seed, i;
+    HANDLE hFile;
+
+    hFile = CreateFileW(Thread->FileName,
+                        GENERIC_READ,
+                        FILE_SHARE_READ,
+                        NULL,
+                        OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL,
+                        NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        Thread->Errors++;
+        return 0;
+    }
+
+    if (Thread->Random)
+    {
+        Seed = Thread->Index + 1;
+        for (i = 0; i < RANDOM_READS; i++)
+        {
+            Offset = (NextRandom(&Seed) % (FILE_SIZE / READ_SIZE)) * READ_SIZE;
+            if (!ReadAt(hFile, Buffer, Offset, READ_SIZE))
+                Thread->Errors++;
+            else
+                Thread->Errors += CheckBuffer(Buffer, Offset, READ_SIZE);
+        }
+    }
+    else
+    {
+        /* Each thread reads the whole file, starting at a different place */
+        for (i = 0; i < FILE_SIZE / READ_SIZE; i++)
+        {
+            Offset = ((i + Thread->Index * (FILE_SIZE / READ_SIZE / THREAD_COUNT)) % (FILE_SIZE / READ_SIZE)) * READ_SIZE;
+            if (!ReadAt(hFile, Buffer, Offset, READ_SIZE))
+                Thread->Errors++;
+            else
+                Thread->Errors += CheckBuffer(Buffer, Offset, READ_SIZE);
+        }
+    }
+
+    CloseHandle(hFile);
+    return 0;
+}
+
+static
+DWORD
+RunReaders(
+    PCWSTR FileName,
+    BOOL Random,
+    PULONG Errors)
+{
+    READ_THREAD Threads[THREAD_COUNT];
+    HANDLE Handles[THREAD_COUNT];
+    DWORD Start;
+    ULONG i, Count;
+
+    *Errors = 0;
+    Count = 0;
+    Start = GetTickCount();
+    for (i = 0; i < THREAD_COUNT; i++)
+    {
+        Threads[i].FileName = FileName;
+        Threads[i].Index = i;
+        Threads[i].Random = Random;
+        Threads[i].Errors = 0;
+        Handles[Count] = CreateThread(NULL, 0, ReadThread, &Threads[i], 0, NULL);
+        if (Handles[Count] == NULL)
+        {
+            (*Errors)++;
+            continue;
+        }
+        Count++;
+    }
+
+    WaitForMultipleObjects(Count, Handles, TRUE, INFINITE);
+    Start = GetTickCount() - Start;
+
+    for (i = 0; i < Count; i++)
+        CloseHandle(Handles[i]);
+    for (i = 0; i < THREAD_COUNT; i++)
+        *Errors += Threads[i].Errors;
+
+    return Start;
+}
+
+START_TEST(CachedRead)
+{
+    WCHAR FileName[MAX_PATH];
+    PULONG Chunk;
+    HANDLE hFile;
+    DWORD Written, SequentialTime, RandomTime;
+    ULONG Offset, i, Errors;
+
+    if (GetTempPathW(_countof(FileName), FileName) == 0 ||
+        FAILED(StringCchCatW(FileName, _countof(FileName), L"CachedReadTest.bin")))
+    {
+        skip("No test directory available\n");
+        return;
+    }
+
+    Chunk = HeapAlloc(GetProcessHeap(), 0, CHUNK_SIZE);
+    if (Chunk == NULL)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+
+    hFile = CreateFileW(FileName,
+                        GENERIC_WRITE,
+                        0, NULL,
+                        CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL,
+                        NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        skip("Cannot create %ls (%lu)\n", FileName, GetLastError());
+        HeapFree(GetProcessHeap(), 0, Chunk);
+        return;
+    }
+
+    for (Offset = 0; Offset < FILE_SIZE; Offset += CHUNK_SIZE)
+    {
+        for (i = 0; i < CHUNK_SIZE / sizeof(ULONG); i++)
+            Chunk[i] = Offset + i * sizeof(ULONG);
+        if (!WriteFile(hFile, Chunk, CHUNK_SIZE, &Written, NULL) || Written != CHUNK_SIZE)
+            break;
+    }
+    CloseHandle(hFile);
+    HeapFree(GetProcessHeap(), 0, Chunk);
+
+    if (Offset != FILE_SIZE)
+    {
+        skip("Cannot write %ls (%lu)\n", FileName, GetLastError());
+        DeleteFileW(FileName);
+        return;
+    }
+
+    /* The first pass brings the file into the cache */
+    RunReaders(FileName, FALSE, &Errors);
+    ok(Errors == 0, "%lu errors in the first sequential pass\n", Errors);
+
+    SequentialTime = RunReaders(FileName, FALSE, &Errors);
+    ok(Errors == 0, "%lu errors in the sequential pass\n", Errors);
+
+    RandomTime = RunReaders(FileName, TRUE, &Errors);
+    ok(Errors == 0, "%lu errors in the random pass\n", Errors);
+
+    trace("%u threads over %u MB: sequential %lu ms (%u reads), random %lu ms (%u reads)\n",
+          THREAD_COUNT, FILE_SIZE / (1024 * 1024),
+          SequentialTime, THREAD_COUNT * (FILE_SIZE / READ_SIZE),
+          RandomTime, THREAD_COUNT * RANDOM_READS);
+
+    ok(DeleteFileW(FileName), "DeleteFile failed (%lu)\n", GetLastError());
+}
@@ -0,0 +1,226 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test cluster allocation and freeing across the windows of the FAT free cluster bitmap
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+/* Clusters in each window of the fastfat free cluster bitmap */
+#define BITMAP_WINDOW   32768
+/* Clusters between the ones that get a pattern written to them */
+#define SAMPLE_STEP     1024
+
+static ULONG ClusterSize;
+static ULONG SectorSize;
+static PULONG Sector;
+
+static
+ULONG
+FreeClusterCount(
+    PCWSTR Root)
+{
+    ULARGE_INTEGER FreeBytes;
+
+    if (!GetDiskFreeSpaceExW(Root, NULL, NULL, &FreeBytes))
+        return 0;
+
+    return (ULONG)(FreeBytes.QuadPart / ClusterSize);
+}
+
+static
+VOID
+FillSector(
+    ULONG Tag,
+    ULONG Cluster)
+{
+    ULONG i;
+
+    for (i = 0; i < SectorSize / sizeof(ULONG); i++)
+        Sector[i] = (Tag << 24) | Cluster;
+}
+
+static
+BOOL
+IsSampled(
+    ULONG Cluster,
+    ULONG Clusters)
+{
+    return (Cluster % SAMPLE_STEP) == 0 || Cluster == Clusters - 1;
+}
+
+/* Allocates the clusters of a file, and writes a pattern to some of them, bypassing the cache */
+static
+BOOL
+AllocateTestFile(
+    PCWSTR FileName,
+    ULONG Tag,
+    ULONG Clusters)
+{
+    LARGE_INTEGER Offset;
+    HANDLE hFile;
+    DWORD Written;
+    ULONG i;
+    BOOL Success;
+
+    hFile = CreateFileW(FileName,
+                        GENERIC_READ | GENERIC_WRITE,
+                        0, NULL,
+                        CREATE_ALWAYS,
+                        FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH,
+                        NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    Offset.QuadPart = (LONGLONG)Clusters * ClusterSize;
+    Success = SetFilePointerEx(hFile, Offset, NULL, FILE_BEGIN) && SetEndOfFile(hFile);
+
+    for (i = 0; Success && i < Clusters; i++)
+    {
+        if (!IsSampled(i, Clusters))
+            continue;
+
+        FillSector(Tag, i);
+        Offset.QuadPart = (LONGLONG)i * ClusterSize;
+        Success = SetFilePointerEx(hFile, Offset, NULL, FILE_BEGIN) &&
+                  WriteFile(hFile, Sector, SectorSize, &Written, NULL) &&
+                  Written == SectorSize;
+    }
+
+    CloseHandle(hFile);
+    return Success;
+}
+
+/* Returns how many of the patterns written by AllocateTestFile were overwritten */
+static
+ULONG
+CheckTestFile(
+    PCWSTR FileName,
+    ULONG Tag,
+    ULONG Clusters)
+{
+    LARGE_INTEGER Offset;
+    HANDLE hFile;
+    DWORD Read;
+    ULONG i, j, Errors = 0;
+
+    hFile = CreateFileW(FileName,
+                        GENERIC_READ,
+                        0, NULL,
+                        OPEN_EXISTING,
+                        FILE_FLAG_NO_BUFFERING,
+                        NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return Clusters;
+
+    for (i = 0; i < Clusters; i++)
+    {
+        if (!IsSampled(i, Clusters))
+            continue;
+
+        Offset.QuadPart = (LONGLONG)i * ClusterSize;
+        if (!SetFilePointerEx(hFile, Offset, NULL, FILE_BEGIN) ||
+            !ReadFile(hFile, Sector, SectorSize, &Read, NULL) ||
+            Read != SectorSize)
+        {
+            Errors++;
+            continue;
+        }
+
+        for (j = 0; j < SectorSize / sizeof(ULONG); j++)
+        {
+            if (Sector[j] != ((Tag << 24) | i))
+            {
+                Errors++;
+                break;
+            }
+        }
+    }
+
+    CloseHandle(hFile);
+    return Errors;
+}
+
+START_TEST(FreeClusters)
+{
+    WCHAR TestDir[MAX_PATH], Root[MAX_PATH], FsName[MAX_PATH];
+    WCHAR FileA[MAX_PATH], FileB[MAX_PATH], FileC[MAX_PATH];
+    DWORD SectorsPerCluster, BytesPerSector, FreeClusters, TotalClusters;
+    DWORD Start, AllocateTime;
+    ULONG Before;
+
+    if (GetTempPathW(_countof(TestDir), TestDir) == 0 ||
+        !GetVolumePathNameW(TestDir, Root, _countof(Root)) ||
+        FAILED(StringCchCatW(TestDir, _countof(TestDir), L"FreeClustersTest")))
+    {
+        skip("No test directory available\n");
+        return;
+    }
+
+    if (!GetVolumeInformationW(Root, NULL, 0, NULL, NULL, NULL, FsName, _countof(FsName)) ||
+        wcsncmp(FsName, L"FAT", 3) != 0)
+    {
+        skip("%ls is not a FAT volume\n", Root);
+        return;
+    }
+
+    if (!GetDiskFreeSpaceW(Root, &SectorsPerCluster, &BytesPerSector, &FreeClusters, &TotalClusters))
+    {
+        skip("GetDiskFreeSpace failed (%lu)\n", GetLastError());
+        return;
+    }
+
+    SectorSize = BytesPerSector;
+    ClusterSize = SectorsPerCluster * BytesPerSector;
+    if (FreeClusterCount(Root) < 4 * BITMAP_WINDOW)
+    {
+        skip("Not enough free clusters on %ls\n", Root);
+        return;
+    }
+
+    Sector = VirtualAlloc(NULL, SectorSize, MEM_COMMIT, PAGE_READWRITE);
+    if (Sector == NULL || !CreateDirectoryW(TestDir, NULL))
+    {
+        skip("Cannot create test directory %ls (%lu)\n", TestDir, GetLastError());
+        if (Sector != NULL)
+            VirtualFree(Sector, 0, MEM_RELEASE);
+        return;
+    }
+
+    StringCchPrintfW(FileA, _countof(FileA), L"%ls\\A.dat", TestDir);
+    StringCchPrintfW(FileB, _countof(FileB), L"%ls\\B.dat", TestDir);
+    StringCchPrintfW(FileC, _countof(FileC), L"%ls\\C.dat", TestDir);
+
+    Before = FreeClusterCount(Root);
+    Start = GetTickCount();
+
+    /* Together they take more than the window the allocation starts in */
+    ok(AllocateTestFile(FileA, 1, 3 * BITMAP_WINDOW / 2), "Cannot allocate A (%lu)\n", GetLastError());
+    ok_int(Before - FreeClusterCount(Root), 3 * BITMAP_WINDOW / 2);
+    ok(AllocateTestFile(FileB, 2, BITMAP_WINDOW), "Cannot allocate B (%lu)\n", GetLastError());
+    ok_int(Before - FreeClusterCount(Root), 5 * BITMAP_WINDOW / 2);
+
+    /* The clusters of A are free again, in windows the bitmap holds and in others */
+    ok(DeleteFileW(FileA), "Cannot delete A (%lu)\n", GetLastError());
+    ok_int(Before - FreeClusterCount(Root), BITMAP_WINDOW);
+
+    /* C takes them back, and more */
+    ok(AllocateTestFile(FileC, 3, 2 * BITMAP_WINDOW), "Cannot allocate C (%lu)\n", GetLastError());
+    ok_int(Before - FreeClusterCount(Root), 3 * BITMAP_WINDOW);
+    AllocateTime = GetTickCount() - Start;
+
+    /* No cluster was given to two files */
+    ok_int(CheckTestFile(FileB, 2, BITMAP_WINDOW), 0);
+    ok_int(CheckTestFile(FileC, 3, 2 * BITMAP_WINDOW), 0);
+
+    trace("%lu byte clusters: allocated %u clusters in %lu ms\n",
+          ClusterSize, 9 * BITMAP_WINDOW / 2, AllocateTime);
+
+    ok(DeleteFileW(FileB), "Cannot delete B (%lu)\n", GetLastError());
+    ok(DeleteFileW(FileC), "Cannot delete C (%lu)\n", GetLastError());
+    ok_int(FreeClusterCount(Root), Before);
+
+    ok(RemoveDirectoryW(TestDir), "RemoveDirectory failed (%lu)\n", GetLastError());
+    VirtualFree(Sector, 0, MEM_RELEASE);
+}
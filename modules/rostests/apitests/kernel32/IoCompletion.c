@@ -0,0 +1,574 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test batched completion port dequeues and skipped packets, and time them
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+#include <ndk/iofuncs.h>
+
+#define PIPE_COUNT      16
+#define MESSAGE_SIZE    64
+#define ROUNDS          2000
+#define BATCH_SIZE      64
+#define WAIT_TIME       10000
+#define READ_FILE_SIZE  (4 * 1024 * 1024)
+#define READ_SIZE       4096
+#define CACHED_READS    8192
+
+#ifndef FILE_SKIP_COMPLETION_PORT_ON_SUCCESS
+#define FILE_SKIP_COMPLETION_PORT_ON_SUCCESS 0x1
+#define FILE_SKIP_SET_EVENT_ON_HANDLE        0x2
+#endif
+
+/* Not in the headers before Vista */
+typedef struct _TEST_OVERLAPPED_ENTRY
+{
+    ULONG_PTR lpCompletionKey;
+    LPOVERLAPPED lpOverlapped;
+    ULONG_PTR Internal;
+    DWORD dwNumberOfBytesTransferred;
+} TEST_OVERLAPPED_ENTRY, *LPTEST_OVERLAPPED_ENTRY;
+
+typedef BOOL (WINAPI *PGET_QUEUED_COMPLETION_STATUS_EX)(HANDLE, LPTEST_OVERLAPPED_ENTRY, ULONG, PULONG, DWORD, BOOL);
+typedef BOOL (WINAPI *PSET_FILE_COMPLETION_NOTIFICATION_MODES)(HANDLE, UCHAR);
+typedef NTSTATUS (NTAPI *PNT_REMOVE_IO_COMPLETION_EX)(HANDLE, PFILE_IO_COMPLETION_INFORMATION, ULONG, PULONG, PLARGE_INTEGER, BOOLEAN);
+
+typedef struct _ECHO_PIPE
+{
+    HANDLE Server;
+    HANDLE Client;
+    OVERLAPPED ReadOverlapped;
+    OVERLAPPED WriteOverlapped;
+    UCHAR Buffer[MESSAGE_SIZE];
+} ECHO_PIPE, *PECHO_PIPE;
+
+typedef struct _ECHO_SERVER
+{
+    HANDLE Port;
+    BOOL Batched;
+    PECHO_PIPE Pipes;
+    ULONG Calls;
+    ULONG Completions;
+    ULONG Errors;
+} ECHO_SERVER, *PECHO_SERVER;
+
+static PNT_REMOVE_IO_COMPLETION_EX pNtRemoveIoCompletionEx;
+
+static
+NTSTATUS
+RemoveCompletions(
+    HANDLE Port,
+    BOOL Batched,
+    PFILE_IO_COMPLETION_INFORMATION Entries,
+    PULONG Count)
+{
+    LARGE_INTEGER Timeout;
+    NTSTATUS Status;
+
+    Timeout.QuadPart = -10000LL * WAIT_TIME;
+    if (Batched)
+        return pNtRemoveIoCompletionEx(Port, Entries, BATCH_SIZE, Count, &Timeout, FALSE);
+
+    Status = NtRemoveIoCompletion(Port,
+                                  &Entries[0].KeyContext,
+                                  &Entries[0].ApcContext,
+                                  &Entries[0].IoStatusBlock,
+                                  &Timeout);
+    *Count = 1;
+    return Status;
+}
+
+static
+BOOL
+PostRead(
+    PECHO_PIPE Pipe)
+{
+    ZeroMemory(&Pipe->ReadOverlapped, sizeof(Pipe->ReadOverlapped));
+    return ReadFile(Pipe->Server, Pipe->Buffer, MESSAGE_SIZE, NULL, &Pipe->ReadOverlapped) ||
+           GetLastError() == ERROR_IO_PENDING;
+}
+
+/* Break the pipes, so that the client doesn't wait for its echoes forever */
+static
+DWORD
+FailServer(
+    PECHO_SERVER Server)
+{
+    ULONG i;
+
+    Server->Errors++;
+    for (i = 0; i < PIPE_COUNT; i++)
+        DisconnectNamedPipe(Server->Pipes[i].Server);
+    return 0;
+}
+
+/* Reads on every pipe and writes back what it read, until all of it came back */
+static
+DWORD
+WINAPI
+EchoServer(
+    PVOID Parameter)
+{
+    PECHO_SERVER Server = Parameter;
+    FILE_IO_COMPLETION_INFORMATION Entries[BATCH_SIZE];
+    ULONGLONG Echoed = 0;
+    PECHO_PIPE Pipe;
+    NTSTATUS Status;
+    ULONG Count, i;
+
+    for (i = 0; i < PIPE_COUNT; i++)
+    {
+        if (!PostRead(&Server->Pipes[i]))
+            return FailServer(Server);
+    }
+
+    while (Echoed < (ULONGLONG)PIPE_COUNT * ROUNDS * MESSAGE_SIZE)
+    {
+        Status = RemoveCompletions(Server->Port, Server->Batched, Entries, &Count);
+        if (Status != STATUS_SUCCESS)
+            return FailServer(Server);
+
+        Server->Calls++;
+        Server->Completions += Count;
+        for (i = 0; i < Count; i++)
+        {
+            Pipe = &Server->Pipes[(ULONG_PTR)Entries[i].KeyContext];
+            if (!NT_SUCCESS(Entries[i].IoStatusBlock.Status))
+                return FailServer(Server);
+
+            if (Entries[i].ApcContext == &Pipe->ReadOverlapped)
+            {
+                /* Send back what came in, the buffer is ours until the write completes */
+                ZeroMemory(&Pipe->WriteOverlapped, sizeof(Pipe->WriteOverlapped));
+                if (!WriteFile(Pipe->Server, Pipe->Buffer, (DWORD)Entries[i].IoStatusBlock.Information,
+                               NULL, &Pipe->WriteOverlapped) &&
+                    GetLastError() != ERROR_IO_PENDING)
+                {
+                    return FailServer(Server);
+                }
+            }
+            else
+            {
+                Echoed += Entries[i].IoStatusBlock.Information;
+                if (Echoed < (ULONGLONG)PIPE_COUNT * ROUNDS * MESSAGE_SIZE && !PostRead(Pipe))
+                    return FailServer(Server);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static
+BOOL
+ReadMessage(
+    HANDLE Client,
+    PUCHAR Message)
+{
+    DWORD Read, Total = 0;
+
+    while (Total < MESSAGE_SIZE)
+    {
+        if (!ReadFile(Client, Message + Total, MESSAGE_SIZE - Total, &Read, NULL) || Read == 0)
+            return FALSE;
+        Total += Read;
+    }
+    return TRUE;
+}
+
+static
+VOID
+RunEcho(
+    BOOL Batched)
+{
+    ECHO_PIPE Pipes[PIPE_COUNT];
+    ECHO_SERVER Server;
+    WCHAR PipeName[64];
+    UCHAR Message[MESSAGE_SIZE], Reply[MESSAGE_SIZE];
+    HANDLE Thread;
+    DWORD Start, Time, Written;
+    ULONG i, Round, Errors = 0;
+
+    if (Batched && pNtRemoveIoCompletionEx == NULL)
+    {
+        skip("NtRemoveIoCompletionEx is not available\n");
+        return;
+    }
+
+    ZeroMemory(&Server, sizeof(Server));
+    ZeroMemory(Pipes, sizeof(Pipes));
+    Server.Batched = Batched;
+    Server.Pipes = Pipes;
+    Server.Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    ok(Server.Port != NULL, "CreateIoCompletionPort failed (%lu)\n", GetLastError());
+    if (Server.Port == NULL)
+        return;
+
+    for (i = 0; i < PIPE_COUNT; i++)
+    {
+        StringCchPrintfW(PipeName, _countof(PipeName), L"\\\\.\\pipe\\IoCompletionEcho%lu_%lu",
+                         GetCurrentProcessId(), i);
+        Pipes[i].Server = CreateNamedPipeW(PipeName,
+                                           PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+                                           PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                                           1,
+                                           MESSAGE_SIZE * 4,
+                                           MESSAGE_SIZE * 4,
+                                           0,
+                                           NULL);
+        Pipes[i].Client = CreateFileW(PipeName,
+                                      GENERIC_READ | GENERIC_WRITE,
+                                      0, NULL,
+                                      OPEN_EXISTING,
+                                      0,
+                                      NULL);
+        if (Pipes[i].Server == INVALID_HANDLE_VALUE || Pipes[i].Client == INVALID_HANDLE_VALUE ||
+            !CreateIoCompletionPort(Pipes[i].Server, Server.Port, i, 0))
+        {
+            skip("Cannot create pipe %lu (%lu)\n", i, GetLastError());
+            goto Cleanup;
+        }
+    }
+
+    Start = GetTickCount();
+    Thread = CreateThread(NULL, 0, EchoServer, &Server, 0, NULL);
+    ok(Thread != NULL, "CreateThread failed (%lu)\n", GetLastError());
+    if (Thread == NULL)
+        goto Cleanup;
+
+    /* Every pipe has a message in flight, so the completions queue up together */
+    for (Round = 0; Round < ROUNDS && !Errors; Round++)
+    {
+        for (i = 0; i < PIPE_COUNT; i++)
+        {
+            FillMemory(Message, sizeof(Message), (UCHAR)(Round + i));
+            if (!WriteFile(Pipes[i].Client, Message, sizeof(Message), &Written, NULL))
+                Errors++;
+        }
+        for (i = 0; i < PIPE_COUNT; i++)
+        {
+            FillMemory(Message, sizeof(Message), (UCHAR)(Round + i));
+            if (!ReadMessage(Pipes[i].Client, Reply) || memcmp(Message, Reply, sizeof(Reply)))
+                Errors++;
+        }
+    }
+
+    ok(WaitForSingleObject(Thread, WAIT_TIME * 2) == WAIT_OBJECT_0, "The echo server did not finish\n");
+    Time = GetTickCount() - Start;
+    CloseHandle(Thread);
+
+    ok(Errors == 0, "%lu messages did not come back\n", Errors);
+    ok(Server.Errors == 0, "The echo server failed\n");
+    trace("%s dequeue: %u messages of %u bytes over %u pipes in %lu ms, %lu completions in %lu calls\n",
+          Batched ? "Batched" : "Single", PIPE_COUNT * ROUNDS, MESSAGE_SIZE, PIPE_COUNT,
+          Time, Server.Completions, Server.Calls);
+
+Cleanup:
+    for (i = 0; i < PIPE_COUNT; i++)
+    {
+        if (Pipes[i].Client != NULL && Pipes[i].Client != INVALID_HANDLE_VALUE)
+            CloseHandle(Pipes[i].Client);
+        if (Pipes[i].Server != NULL && Pipes[i].Server != INVALID_HANDLE_VALUE)
+            CloseHandle(Pipes[i].Server);
+    }
+    CloseHandle(Server.Port);
+}
+
+static
+VOID
+TestRemove(VOID)
+{
+    FILE_IO_COMPLETION_INFORMATION Entries[8];
+    LARGE_INTEGER Timeout;
+    NTSTATUS Status;
+    HANDLE Port;
+    ULONG Count, i;
+
+    if (pNtRemoveIoCompletionEx == NULL)
+    {
+        skip("NtRemoveIoCompletionEx is not available\n");
+        return;
+    }
+
+    Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    ok(Port != NULL, "CreateIoCompletionPort failed (%lu)\n", GetLastError());
+    if (Port == NULL)
+        return;
+
+    Timeout.QuadPart = 0;
+    Count = 0x55555555;
+    Status = pNtRemoveIoCompletionEx(Port, Entries, _countof(Entries), &Count, &Timeout, FALSE);
+    ok(Status == STATUS_TIMEOUT, "Status = 0x%lx\n", Status);
+
+    Status = pNtRemoveIoCompletionEx(Port, Entries, 0, &Count, &Timeout, FALSE);
+    ok(Status == STATUS_INVALID_PARAMETER, "Status = 0x%lx\n", Status);
+
+    for (i = 0; i < 5; i++)
+    {
+        ok(PostQueuedCompletionStatus(Port, i * 10, i, (LPOVERLAPPED)(ULONG_PTR)(i + 100)),
+           "PostQueuedCompletionStatus failed (%lu)\n", GetLastError());
+    }
+
+    /* The packets come out in the order they were queued, no more than asked for */
+    Status = pNtRemoveIoCompletionEx(Port, Entries, 3, &Count, &Timeout, FALSE);
+    ok(Status == STATUS_SUCCESS, "Status = 0x%lx\n", Status);
+    ok(Count == 3, "Count = %lu\n", Count);
+    for (i = 0; i < 3 && i < Count; i++)
+    {
+        ok((ULONG_PTR)Entries[i].KeyContext == i, "Key %lu = %p\n", i, Entries[i].KeyContext);
+        ok((ULONG_PTR)Entries[i].ApcContext == i + 100, "Context %lu = %p\n", i, Entries[i].ApcContext);
+        ok(Entries[i].IoStatusBlock.Status == STATUS_SUCCESS, "Status %lu = 0x%lx\n", i, Entries[i].IoStatusBlock.Status);
+        ok(Entries[i].IoStatusBlock.Information == i * 10, "Information %lu = %Iu\n", i, Entries[i].IoStatusBlock.Information);
+    }
+
+    Status = pNtRemoveIoCompletionEx(Port, Entries, _countof(Entries), &Count, &Timeout, FALSE);
+    ok(Status == STATUS_SUCCESS, "Status = 0x%lx\n", Status);
+    ok(Count == 2, "Count = %lu\n", Count);
+    ok((ULONG_PTR)Entries[0].KeyContext == 3, "Key = %p\n", Entries[0].KeyContext);
+    ok((ULONG_PTR)Entries[1].KeyContext == 4, "Key = %p\n", Entries[1].KeyContext);
+
+    Status = pNtRemoveIoCompletionEx(Port, Entries, _countof(Entries), &Count, &Timeout, FALSE);
+    ok(Status == STATUS_TIMEOUT, "Status = 0x%lx\n", Status);
+
+    CloseHandle(Port);
+}
+
+static
+VOID
+TestGetQueuedCompletionStatusEx(VOID)
+{
+    PGET_QUEUED_COMPLETION_STATUS_EX pGetQueuedCompletionStatusEx;
+    TEST_OVERLAPPED_ENTRY Entries[4];
+    HANDLE Port;
+    ULONG Count;
+    BOOL Ret;
+
+    pGetQueuedCompletionStatusEx = (PGET_QUEUED_COMPLETION_STATUS_EX)
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "GetQueuedCompletionStatusEx");
+    if (pGetQueuedCompletionStatusEx == NULL)
+    {
+        skip("GetQueuedCompletionStatusEx is not available\n");
+        return;
+    }
+
+    Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    ok(Port != NULL, "CreateIoCompletionPort failed (%lu)\n", GetLastError());
+    if (Port == NULL)
+        return;
+
+    SetLastError(0xdeadbeef);
+    Count = 0x55555555;
+    Ret = pGetQueuedCompletionStatusEx(Port, Entries, _countof(Entries), &Count, 0, FALSE);
+    ok(Ret == FALSE, "Ret = %d\n", Ret);
+    ok(GetLastError() == WAIT_TIMEOUT, "Error = %lu\n", GetLastError());
+    ok(Count == 0, "Count = %lu\n", Count);
+
+    PostQueuedCompletionStatus(Port, 1, 11, (LPOVERLAPPED)(ULONG_PTR)111);
+    PostQueuedCompletionStatus(Port, 2, 22, (LPOVERLAPPED)(ULONG_PTR)222);
+    Ret = pGetQueuedCompletionStatusEx(Port, Entries, _countof(Entries), &Count, 0, FALSE);
+    ok(Ret == TRUE, "Ret = %d (%lu)\n", Ret, GetLastError());
+    ok(Count == 2, "Count = %lu\n", Count);
+    ok(Entries[0].lpCompletionKey == 11, "Key = %Iu\n", Entries[0].lpCompletionKey);
+    ok(Entries[0].lpOverlapped == (LPOVERLAPPED)(ULONG_PTR)111, "Overlapped = %p\n", Entries[0].lpOverlapped);
+    ok(Entries[0].dwNumberOfBytesTransferred == 1, "Bytes = %lu\n", Entries[0].dwNumberOfBytesTransferred);
+    ok(Entries[1].lpCompletionKey == 22, "Key = %Iu\n", Entries[1].lpCompletionKey);
+    ok(Entries[1].dwNumberOfBytesTransferred == 2, "Bytes = %lu\n", Entries[1].dwNumberOfBytesTransferred);
+
+    CloseHandle(Port);
+}
+
+/* Read a cached file through a port, with packets for the reads that didn't pend or without */
+static
+VOID
+RunCachedReads(
+    PCWSTR FileName,
+    PSET_FILE_COMPLETION_NOTIFICATION_MODES pSetFileCompletionNotificationModes)
+{
+    OVERLAPPED Overlapped, *pOverlapped;
+    LARGE_INTEGER Frequency, Start, Stop;
+    PVOID Buffer;
+    HANDLE hFile, Port;
+    ULONG_PTR Key;
+    DWORD Read;
+    ULONG i, Pass, Synchronous, Pending, Packets, Errors;
+
+    Buffer = HeapAlloc(GetProcessHeap(), 0, READ_SIZE);
+    if (Buffer == NULL)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+
+    QueryPerformanceFrequency(&Frequency);
+    for (Pass = 0; Pass < 2; Pass++)
+    {
+        hFile = CreateFileW(FileName,
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            NULL,
+                            OPEN_EXISTING,
+                            FILE_FLAG_OVERLAPPED,
+                            NULL);
+        ok(hFile != INVALID_HANDLE_VALUE, "CreateFile failed (%lu)\n", GetLastError());
+        if (hFile == INVALID_HANDLE_VALUE)
+            break;
+
+        Port = CreateIoCompletionPort(hFile, NULL, 1, 1);
+        ok(Port != NULL, "CreateIoCompletionPort failed (%lu)\n", GetLastError());
+        if (Port == NULL)
+        {
+            CloseHandle(hFile);
+            break;
+        }
+
+        if (Pass == 1)
+        {
+            ok(!pSetFileCompletionNotificationModes(hFile, 0x4), "Invalid flags were accepted\n");
+            ok(GetLastError() == ERROR_INVALID_PARAMETER, "Error = %lu\n", GetLastError());
+            ok(pSetFileCompletionNotificationModes(hFile, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS |
+                                                          FILE_SKIP_SET_EVENT_ON_HANDLE),
+               "SetFileCompletionNotificationModes failed (%lu)\n", GetLastError());
+        }
+
+        /* The first read of every page brings it into the cache, don't time it */
+        Synchronous = Pending = Packets = Errors = 0;
+        for (i = 0; i < READ_FILE_SIZE / READ_SIZE + CACHED_READS; i++)
+        {
+            if (i == READ_FILE_SIZE / READ_SIZE)
+            {
+                Synchronous = Pending = Packets = 0;
+                QueryPerformanceCounter(&Start);
+            }
+
+            ZeroMemory(&Overlapped, sizeof(Overlapped));
+            Overlapped.Offset = (i * READ_SIZE) % READ_FILE_SIZE;
+            if (ReadFile(hFile, Buffer, READ_SIZE, &Read, &Overlapped))
+            {
+                Synchronous++;
+                if (Pass == 1)
+                    continue;
+            }
+            else if (GetLastError() == ERROR_IO_PENDING)
+            {
+                Pending++;
+            }
+            else
+            {
+                Errors++;
+                continue;
+            }
+
+            if (GetQueuedCompletionStatus(Port, &Read, &Key, &pOverlapped, WAIT_TIME))
+                Packets++;
+            else
+                Errors++;
+        }
+        QueryPerformanceCounter(&Stop);
+
+        ok(Errors == 0, "%lu reads failed\n", Errors);
+        if (Pass == 0)
+        {
+            ok(Packets == Synchronous + Pending, "%lu packets for %lu reads\n", Packets, Synchronous + Pending);
+        }
+        else
+        {
+            ok(Packets == Pending, "%lu packets for %lu pending reads\n", Packets, Pending);
+
+            /* Nothing may be left behind by the reads that didn't pend */
+            SetLastError(0xdeadbeef);
+            ok(!GetQueuedCompletionStatus(Port, &Read, &Key, &pOverlapped, 0), "A packet was queued\n");
+            ok(GetLastError() == WAIT_TIMEOUT, "Error = %lu\n", GetLastError());
+        }
+
+        trace("%s: %u cached reads of %u bytes, %lu without pending, %lu packets, %lu ns per read\n",
+              Pass ? "Skip on success" : "Default", CACHED_READS, READ_SIZE, Synchronous, Packets,
+              (ULONG)((Stop.QuadPart - Start.QuadPart) * 1000000000 / Frequency.QuadPart / CACHED_READS));
+
+        CloseHandle(Port);
+        CloseHandle(hFile);
+    }
+
+    HeapFree(GetProcessHeap(), 0, Buffer);
+}
+
+static
+VOID
+TestSkipCompletionPort(VOID)
+{
+    PSET_FILE_COMPLETION_NOTIFICATION_MODES pSetFileCompletionNotificationModes;
+    WCHAR FileName[MAX_PATH];
+    PULONG Chunk;
+    HANDLE hFile;
+    DWORD Written;
+    ULONG Offset, i;
+
+    pSetFileCompletionNotificationModes = (PSET_FILE_COMPLETION_NOTIFICATION_MODES)
+        GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetFileCompletionNotificationModes");
+    if (pSetFileCompletionNotificationModes == NULL)
+    {
+        skip("SetFileCompletionNotificationModes is not available\n");
+        return;
+    }
+
+    if (GetTempPathW(_countof(FileName), FileName) == 0 ||
+        FAILED(StringCchCatW(FileName, _countof(FileName), L"IoCompletionTest.bin")))
+    {
+        skip("No test directory available\n");
+        return;
+    }
+
+    Chunk = HeapAlloc(GetProcessHeap(), 0, READ_SIZE);
+    if (Chunk == NULL)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+
+    hFile = CreateFileW(FileName,
+                        GENERIC_WRITE,
+                        0, NULL,
+                        CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL,
+                        NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        skip("Cannot create %ls (%lu)\n", FileName, GetLastError());
+        HeapFree(GetProcessHeap(), 0, Chunk);
+        return;
+    }
+
+    for (Offset = 0; Offset < READ_FILE_SIZE; Offset += READ_SIZE)
+    {
+        for (i = 0; i < READ_SIZE / sizeof(ULONG); i++)
+            Chunk[i] = Offset + i * sizeof(ULONG);
+        if (!WriteFile(hFile, Chunk, READ_SIZE, &Written, NULL) || Written != READ_SIZE)
+            break;
+    }
+    CloseHandle(hFile);
+    HeapFree(GetProcessHeap(), 0, Chunk);
+
+    if (Offset != READ_FILE_SIZE)
+        skip("Cannot write %ls (%lu)\n", FileName, GetLastError());
+    else
+        RunCachedReads(FileName, pSetFileCompletionNotificationModes);
+
+    ok(DeleteFileW(FileName), "DeleteFile failed (%lu)\n", GetLastError());
+}
+
+START_TEST(IoCompletion)
+{
+    pNtRemoveIoCompletionEx = (PNT_REMOVE_IO_COMPLETION_EX)
+        GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtRemoveIoCompletionEx");
+
+    TestRemove();
+    TestGetQueuedCompletionStatusEx();
+
+    /* Same server, one syscall per completion against one per batch of them */
+    RunEcho(FALSE);
+    RunEcho(TRUE);
+
+    /* Cached reads that don't pend, with and without their packets */
+    TestSkipCompletionPort();
+}
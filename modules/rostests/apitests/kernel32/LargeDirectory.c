@@ -0,0 +1,154 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test and time file creation and lookups in large directories
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define FILE_COUNT 3000
+
+static
+VOID
+MakeFileName(
+    PWSTR Buffer,
+    SIZE_T Size,
+    ULONG Number)
+{
+    /* Long names take several directory entries each, so the directory
+     * quickly grows past the size where lookups are indexed */
+    StringCchPrintfW(Buffer, Size, L"Large directory test file %05lu.dat", Number);
+}
+
+static
+BOOL
+OpenTestFile(
+    PCWSTR FileName,
+    DWORD Disposition)
+{
+    HANDLE hFile;
+
+    hFile = CreateFileW(FileName,
+                        GENERIC_READ | GENERIC_WRITE,
+                        0, NULL,
+                        Disposition,
+                        FILE_ATTRIBUTE_NORMAL,
+                        NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return FALSE;
+    }
+
+    CloseHandle(hFile);
+    return TRUE;
+}
+
+START_TEST(LargeDirectory)
+{
+    WCHAR OldDir[MAX_PATH], TestDir[MAX_PATH];
+    WCHAR FileName[64], ShortName[MAX_PATH];
+    DWORD Start, CreateTime, OpenTime, MissTime;
+    ULONG i, Failures;
+
+    if (GetCurrentDirectoryW(_countof(OldDir), OldDir) == 0 ||
+        GetTempPathW(_countof(TestDir), TestDir) == 0 ||
+        FAILED(StringCchCatW(TestDir, _countof(TestDir), L"LargeDirectoryTest")))
+    {
+        skip("No test directory available\n");
+        return;
+    }
+
+    if (!CreateDirectoryW(TestDir, NULL) || !SetCurrentDirectoryW(TestDir))
+    {
+        skip("Cannot create test directory %ls (%lu)\n", TestDir, GetLastError());
+        RemoveDirectoryW(TestDir);
+        return;
+    }
+
+    /* Create the files */
+    Failures = 0;
+    Start = GetTickCount();
+    for (i = 0; i < FILE_COUNT; i++)
+    {
+        MakeFileName(FileName, _countof(FileName), i);
+        if (!OpenTestFile(FileName, CREATE_NEW))
+            Failures++;
+    }
+    CreateTime = GetTickCount() - Start;
+    ok(Failures == 0, "%lu files could not be created\n", Failures);
+
+    /* Reopen all of them */
+    Failures = 0;
+    Start = GetTickCount();
+    for (i = 0; i < FILE_COUNT; i++)
+    {
+        MakeFileName(FileName, _countof(FileName), i);
+        if (!OpenTestFile(FileName, OPEN_EXISTING))
+            Failures++;
+    }
+    OpenTime = GetTickCount() - Start;
+    ok(Failures == 0, "%lu files could not be opened\n", Failures);
+
+    /* Names that do not exist must not be found */
+    Failures = 0;
+    Start = GetTickCount();
+    for (i = FILE_COUNT; i < 2 * FILE_COUNT; i++)
+    {
+        MakeFileName(FileName, _countof(FileName), i);
+        if (OpenTestFile(FileName, OPEN_EXISTING) ||
+            GetLastError() != ERROR_FILE_NOT_FOUND)
+        {
+            Failures++;
+        }
+    }
+    MissTime = GetTickCount() - Start;
+    ok(Failures == 0, "%lu missing files were found\n", Failures);
+
+    /* Lookups are case insensitive, and short names work too */
+    MakeFileName(FileName, _countof(FileName), FILE_COUNT / 2);
+    _wcsupr(FileName);
+    ok(OpenTestFile(FileName, OPEN_EXISTING), "Upcased name not found (%lu)\n", GetLastError());
+    if (GetShortPathNameW(FileName, ShortName, _countof(ShortName)) != 0)
+    {
+        ok(OpenTestFile(ShortName, OPEN_EXISTING), "Short name %ls not found (%lu)\n", ShortName, GetLastError());
+    }
+
+    /* Deleted files are gone, and their names can be reused */
+    for (i = 0; i < FILE_COUNT; i += 3)
+    {
+        MakeFileName(FileName, _countof(FileName), i);
+        DeleteFileW(FileName);
+    }
+    Failures = 0;
+    for (i = 0; i < FILE_COUNT; i++)
+    {
+        MakeFileName(FileName, _countof(FileName), i);
+        if (OpenTestFile(FileName, OPEN_EXISTING) != (i % 3 != 0))
+            Failures++;
+    }
+    ok(Failures == 0, "%lu files in the wrong state after deletion\n", Failures);
+
+    Failures = 0;
+    for (i = 0; i < FILE_COUNT; i += 3)
+    {
+        MakeFileName(FileName, _countof(FileName), i);
+        if (!OpenTestFile(FileName, CREATE_NEW) ||
+            !OpenTestFile(FileName, OPEN_EXISTING))
+        {
+            Failures++;
+        }
+    }
+    ok(Failures == 0, "%lu files could not be recreated\n", Failures);
+
+    trace("%u files: create %lu ms, open %lu ms, open missing %lu ms\n",
+          FILE_COUNT, CreateTime, OpenTime, MissTime);
+
+    for (i = 0; i < FILE_COUNT; i++)
+    {
+        MakeFileName(FileName, _countof(FileName), i);
+        DeleteFileW(FileName);
+    }
+    SetCurrentDirectoryW(OldDir);
+    ok(RemoveDirectoryW(TestDir), "RemoveDirectory failed (%lu)\n", GetLastError());
+}
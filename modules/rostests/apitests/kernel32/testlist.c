@@ -3,6 +3,7 @@
 #define STANDALONE
 #include <apitest.h>
 
+extern void func_CachedRead(void);
 extern void func_Console(void);
 extern void func_CreateProcess(void);
 extern void func_DefaultActCtx(void);
@@ -12,13 +13,16 @@ extern void func_FindActCtxSectionStringW(void);
 extern void func_FindFiles(void);
 extern void func_FLS(void);
 extern void func_FormatMessage(void);
+extern void func_FreeClusters(void);
 extern void func_GetComputerNameEx(void);
 extern void func_GetCurrentDirectory(void);
 extern void func_GetDriveType(void);
 extern void func_GetModuleFileName(void);
 extern void func_GetVolumeInformation(void);
 extern void func_interlck(void);
+extern void func_IoCompletion(void);
 extern void func_IsDBCSLeadByteEx(void);
+extern void func_LargeDirectory(void);
 extern void func_LoadLibraryExW(void);
 extern void func_lstrcpynW(void);
 extern void func_lstrlen(void);
@@ -35,6 +39,7 @@ extern void func_WideCharToMultiByte(void);
 
 const struct test winetest_testlist[] =
 {
+    { "CachedRead",                  func_CachedRead },
     { "ConsoleCP",                   func_Console },
     { "CreateProcess",               func_CreateProcess },
     { "DefaultActCtx",               func_DefaultActCtx },
@@ -44,13 +49,16 @@ const struct test winetest_testlist[] =
     { "FindFiles",                   func_FindFiles },
     { "FLS",                         func_FLS },
     { "FormatMessage",               func_FormatMessage },
+    { "FreeClusters",                func_FreeClusters },
     { "GetComputerNameEx",           func_GetComputerNameEx },
     { "GetCurrentDirectory",         func_GetCurrentDirectory },
     { "GetDriveType",                func_GetDriveType },
     { "GetModuleFileName",           func_GetModuleFileName },
     { "GetVolumeInformation",        func_GetVolumeInformation },
     { "interlck",                    func_interlck },
+    { "IoCompletion",                func_IoCompletion },
     { "IsDBCSLeadByteEx",            func_IsDBCSLeadByteEx },
+    { "LargeDirectory",              func_LargeDirectory },
     { "LoadLibraryExW",              func_LoadLibraryExW },
     { "lstrcpynW",                   func_lstrcpynW },
     { "lstrlen",                     func_lstrlen },
@@ -0,0 +1,189 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test LdrGetProcedureAddress on every export, and time import resolution
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define LOOKUP_ROUNDS   20
+#define CHILD_RUNS      10
+#define CHILD_TIMEOUT   60000
+
+static
+VOID
+TestModuleExports(
+    PCWSTR ModuleName)
+{
+    PIMAGE_EXPORT_DIRECTORY ExportDir;
+    PULONG NameTable, FunctionTable;
+    PUSHORT OrdinalTable;
+    LARGE_INTEGER Frequency, Start, Stop;
+    ANSI_STRING Name;
+    NTSTATUS Status;
+    PUCHAR Base;
+    PVOID Address;
+    ULONG ExportSize, Rva, i, Round, Errors;
+
+    Base = (PUCHAR)GetModuleHandleW(ModuleName);
+    ok(Base != NULL, "%ls is not loaded\n", ModuleName);
+    if (Base == NULL)
+        return;
+
+    ExportDir = RtlImageDirectoryEntryToData(Base, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &ExportSize);
+    ok(ExportDir != NULL, "%ls has no exports\n", ModuleName);
+    if (ExportDir == NULL)
+        return;
+
+    NameTable = (PULONG)(Base + ExportDir->AddressOfNames);
+    OrdinalTable = (PUSHORT)(Base + ExportDir->AddressOfNameOrdinals);
+    FunctionTable = (PULONG)(Base + ExportDir->AddressOfFunctions);
+
+    /* Every name must resolve to its own function, forwarders just somewhere */
+    Errors = 0;
+    for (i = 0; i < ExportDir->NumberOfNames; i++)
+    {
+        RtlInitAnsiString(&Name, (PCSTR)(Base + NameTable[i]));
+        Address = NULL;
+        Status = LdrGetProcedureAddress(Base, &Name, 0, &Address);
+        if (!NT_SUCCESS(Status))
+        {
+            ok(0, "%ls!%s failed with 0x%lx\n", ModuleName, Name.Buffer, Status);
+            Errors++;
+            continue;
+        }
+
+        Rva = FunctionTable[OrdinalTable[i]];
+        if ((Rva >= (ULONG)((PUCHAR)ExportDir - Base)) &&
+            (Rva < (ULONG)((PUCHAR)ExportDir - Base) + ExportSize))
+        {
+            continue;
+        }
+
+        if (Address != Base + Rva)
+        {
+            ok(0, "%ls!%s is %p instead of %p\n", ModuleName, Name.Buffer, Address, Base + Rva);
+            Errors++;
+        }
+    }
+    ok(Errors == 0, "%lu of %lu exports of %ls were wrong\n", Errors, ExportDir->NumberOfNames, ModuleName);
+
+    /* Names are case-sensitive, and unknown ones are not found */
+    RtlInitAnsiString(&Name, "NTCLOSE");
+    Status = LdrGetProcedureAddress(Base, &Name, 0, &Address);
+    ok_ntstatus(Status, STATUS_PROCEDURE_NOT_FOUND);
+    RtlInitAnsiString(&Name, "LdrGetProcedureAddressTestMissing");
+    Status = LdrGetProcedureAddress(Base, &Name, 0, &Address);
+    ok_ntstatus(Status, STATUS_PROCEDURE_NOT_FOUND);
+
+    /* Time the lookups, none of them has a hint */
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    for (Round = 0; Round < LOOKUP_ROUNDS; Round++)
+    {
+        for (i = 0; i < ExportDir->NumberOfNames; i++)
+        {
+            RtlInitAnsiString(&Name, (PCSTR)(Base + NameTable[i]));
+            LdrGetProcedureAddress(Base, &Name, 0, &Address);
+        }
+    }
+    QueryPerformanceCounter(&Stop);
+
+    trace("%ls: %lu names, %lu ns per LdrGetProcedureAddress\n",
+          ModuleName, ExportDir->NumberOfNames,
+          (ULONG)((Stop.QuadPart - Start.QuadPart) * 1000000000 / Frequency.QuadPart /
+                  max(ExportDir->NumberOfNames * LOOKUP_ROUNDS, 1)));
+}
+
+/* Load a module with a large import graph, and hand the time back as exit code */
+static
+VOID
+RunChild(VOID)
+{
+    LARGE_INTEGER Frequency, Start, Stop;
+    HMODULE Module;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    Module = LoadLibraryW(L"shell32.dll");
+    QueryPerformanceCounter(&Stop);
+
+    if (Module == NULL)
+        ExitProcess(MAXULONG);
+
+    ExitProcess((ULONG)((Stop.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart));
+}
+
+static
+VOID
+TestStartup(VOID)
+{
+    WCHAR FileName[MAX_PATH], CommandLine[MAX_PATH + 64];
+    LARGE_INTEGER Frequency, Start, Stop;
+    STARTUPINFOW StartupInfo;
+    PROCESS_INFORMATION ProcessInfo;
+    ULONGLONG Total = 0, Loading = 0;
+    ULONG Run, Runs = 0;
+    DWORD ExitCode;
+
+    GetModuleFileNameW(NULL, FileName, _countof(FileName));
+    StringCchPrintfW(CommandLine, _countof(CommandLine),
+                     L"\"%ls\" LdrGetProcedureAddress child", FileName);
+
+    RtlZeroMemory(&StartupInfo, sizeof(StartupInfo));
+    StartupInfo.cb = sizeof(StartupInfo);
+    StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+
+    QueryPerformanceFrequency(&Frequency);
+    for (Run = 0; Run < CHILD_RUNS; Run++)
+    {
+        QueryPerformanceCounter(&Start);
+        if (!CreateProcessW(FileName, CommandLine, NULL, NULL, FALSE, 0, NULL, NULL,
+                            &StartupInfo, &ProcessInfo))
+        {
+            skip("CreateProcess failed (%lu)\n", GetLastError());
+            return;
+        }
+
+        ok(WaitForSingleObject(ProcessInfo.hProcess, CHILD_TIMEOUT) == WAIT_OBJECT_0,
+           "The child did not exit\n");
+        QueryPerformanceCounter(&Stop);
+
+        GetExitCodeProcess(ProcessInfo.hProcess, &ExitCode);
+        CloseHandle(ProcessInfo.hThread);
+        CloseHandle(ProcessInfo.hProcess);
+
+        ok(ExitCode != MAXULONG, "The child could not load shell32.dll\n");
+        if (ExitCode == MAXULONG || ExitCode == STILL_ACTIVE)
+            continue;
+
+        Total += (Stop.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+        Loading += ExitCode;
+        Runs++;
+    }
+
+    if (Runs)
+    {
+        trace("%lu process starts, %lu us per start, %lu us to load shell32.dll and its imports\n",
+              Runs, (ULONG)(Total / Runs), (ULONG)(Loading / Runs));
+    }
+}
+
+START_TEST(LdrGetProcedureAddress)
+{
+    char **argv;
+    int argc;
+
+    argc = winetest_get_mainargs(&argv);
+    if (argc >= 3)
+    {
+        RunChild();
+        return;
+    }
+
+    TestModuleExports(L"ntdll.dll");
+    TestModuleExports(L"kernel32.dll");
+    TestModuleExports(L"advapi32.dll");
+    TestStartup();
+}
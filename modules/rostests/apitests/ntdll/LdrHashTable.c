@@ -0,0 +1,269 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test the loader module hash table with many modules, and time it
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define MODULE_COUNT    512
+#define LOOKUP_ROUNDS   20
+#define FIRST_CHAR_HASH_ENTRIES 32
+
+typedef struct _HASH_STATISTICS
+{
+    ULONG Modules;
+    ULONG Chains;
+    ULONG LongestChain;
+    ULONGLONG Compares;
+} HASH_STATISTICS, *PHASH_STATISTICS;
+
+static
+BOOLEAN
+IsModuleHashLink(
+    PLIST_ENTRY ListEntry)
+{
+    PLIST_ENTRY ListHead, NextEntry;
+    PLDR_DATA_TABLE_ENTRY LdrEntry;
+
+    ListHead = &NtCurrentPeb()->Ldr->InLoadOrderModuleList;
+    for (NextEntry = ListHead->Flink; NextEntry != ListHead; NextEntry = NextEntry->Flink)
+    {
+        LdrEntry = CONTAINING_RECORD(NextEntry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
+        if (&LdrEntry->HashLinks == ListEntry)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Finding a module walks its chain up to it, so count the entries in front of every one */
+static
+VOID
+GetHashStatistics(
+    PHASH_STATISTICS Statistics)
+{
+    PLIST_ENTRY ListHead, NextEntry, ChainEntry;
+    PLDR_DATA_TABLE_ENTRY LdrEntry;
+    ULONG Position, Length;
+    ULONG_PTR Cookie;
+
+    ZeroMemory(Statistics, sizeof(*Statistics));
+    LdrLockLoaderLock(0, NULL, &Cookie);
+
+    ListHead = &NtCurrentPeb()->Ldr->InLoadOrderModuleList;
+    for (NextEntry = ListHead->Flink; NextEntry != ListHead; NextEntry = NextEntry->Flink)
+    {
+        LdrEntry = CONTAINING_RECORD(NextEntry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
+
+        /* Walk back to the bucket, which is the only link that isn't a module */
+        Position = 1;
+        for (ChainEntry = LdrEntry->HashLinks.Blink;
+             IsModuleHashLink(ChainEntry);
+             ChainEntry = ChainEntry->Blink)
+        {
+            Position++;
+        }
+
+        /* The first module of a chain also measures how long it is */
+        if (Position == 1)
+        {
+            Length = 1;
+            for (ChainEntry = LdrEntry->HashLinks.Flink;
+                 IsModuleHashLink(ChainEntry);
+                 ChainEntry = ChainEntry->Flink)
+            {
+                Length++;
+            }
+            Statistics->Chains++;
+            Statistics->LongestChain = max(Statistics->LongestChain, Length);
+        }
+
+        Statistics->Modules++;
+        Statistics->Compares += Position;
+    }
+
+    LdrUnlockLoaderLock(0, Cookie);
+}
+
+/* The same for the old table, which only hashed the first character of the name */
+static
+VOID
+GetFirstCharStatistics(
+    PHASH_STATISTICS Statistics)
+{
+    PLIST_ENTRY ListHead, NextEntry;
+    PLDR_DATA_TABLE_ENTRY LdrEntry;
+    ULONG Buckets[FIRST_CHAR_HASH_ENTRIES] = { 0 };
+    ULONG i;
+    ULONG_PTR Cookie;
+
+    ZeroMemory(Statistics, sizeof(*Statistics));
+    LdrLockLoaderLock(0, NULL, &Cookie);
+
+    ListHead = &NtCurrentPeb()->Ldr->InLoadOrderModuleList;
+    for (NextEntry = ListHead->Flink; NextEntry != ListHead; NextEntry = NextEntry->Flink)
+    {
+        LdrEntry = CONTAINING_RECORD(NextEntry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
+        i = RtlUpcaseUnicodeChar(LdrEntry->BaseDllName.Buffer[0]) & (FIRST_CHAR_HASH_ENTRIES - 1);
+        Buckets[i]++;
+        Statistics->Modules++;
+        Statistics->Compares += Buckets[i];
+    }
+
+    LdrUnlockLoaderLock(0, Cookie);
+
+    for (i = 0; i < FIRST_CHAR_HASH_ENTRIES; i++)
+    {
+        if (Buckets[i])
+            Statistics->Chains++;
+        Statistics->LongestChain = max(Statistics->LongestChain, Buckets[i]);
+    }
+}
+
+static
+VOID
+TraceStatistics(
+    PCSTR Name,
+    PHASH_STATISTICS Statistics)
+{
+    ULONG Average = (ULONG)(Statistics->Compares * 100 / max(Statistics->Modules, 1));
+
+    trace("%s: %lu modules in %lu chains, longest %lu, %lu.%02lu compares per lookup\n",
+          Name, Statistics->Modules, Statistics->Chains, Statistics->LongestChain,
+          Average / 100, Average % 100);
+}
+
+static
+VOID
+GetModuleName(
+    PWSTR Name,
+    SIZE_T Count,
+    ULONG Index)
+{
+    /* Names that start the same, like the API sets do */
+    StringCchPrintfW(Name, Count, L"api-ms-win-core-ldrtest-l1-1-%03lu.dll", Index);
+}
+
+static
+VOID
+RunModules(
+    PCWSTR Directory)
+{
+    HMODULE *Modules;
+    HASH_STATISTICS Statistics, FirstChar;
+    LARGE_INTEGER Frequency, Start, Stop;
+    WCHAR Name[MAX_PATH], Path[MAX_PATH];
+    ULONG i, Round, Loaded, Found;
+    HMODULE Module;
+
+    Modules = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, MODULE_COUNT * sizeof(HMODULE));
+    if (Modules == NULL)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+
+    QueryPerformanceFrequency(&Frequency);
+
+    /* Every load looks the name up in the table before it maps the file */
+    Loaded = 0;
+    QueryPerformanceCounter(&Start);
+    for (i = 0; i < MODULE_COUNT; i++)
+    {
+        GetModuleName(Name, _countof(Name), i);
+        StringCchPrintfW(Path, _countof(Path), L"%s\\%s", Directory, Name);
+        Modules[i] = LoadLibraryExW(Path, NULL, DONT_RESOLVE_DLL_REFERENCES);
+        if (Modules[i] != NULL)
+            Loaded++;
+    }
+    QueryPerformanceCounter(&Stop);
+    ok(Loaded == MODULE_COUNT, "Loaded %lu of %u modules\n", Loaded, MODULE_COUNT);
+
+    trace("%lu modules loaded, %lu us per load\n", Loaded,
+          (ULONG)((Stop.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart / max(Loaded, 1)));
+
+    GetHashStatistics(&Statistics);
+    GetFirstCharStatistics(&FirstChar);
+    TraceStatistics("Module table", &Statistics);
+    TraceStatistics("First character hash", &FirstChar);
+    ok(Statistics.Compares <= FirstChar.Compares, "The table is worse than the first character\n");
+
+    /* Look every module up by its base name, in both cases */
+    Found = 0;
+    QueryPerformanceCounter(&Start);
+    for (Round = 0; Round < LOOKUP_ROUNDS; Round++)
+    {
+        for (i = 0; i < MODULE_COUNT; i++)
+        {
+            GetModuleName(Name, _countof(Name), i);
+            if (Round & 1)
+                _wcsupr(Name);
+            Module = GetModuleHandleW(Name);
+            if (Module != NULL && Module == Modules[i])
+                Found++;
+        }
+    }
+    QueryPerformanceCounter(&Stop);
+    ok(Found == Loaded * LOOKUP_ROUNDS, "Found %lu of %lu modules\n", Found, Loaded * LOOKUP_ROUNDS);
+
+    trace("%u lookups, %lu ns per GetModuleHandle\n", MODULE_COUNT * LOOKUP_ROUNDS,
+          (ULONG)((Stop.QuadPart - Start.QuadPart) * 1000000000 / Frequency.QuadPart /
+                  (MODULE_COUNT * LOOKUP_ROUNDS)));
+
+    /* Unloaded modules must be gone from the table */
+    for (i = 0; i < MODULE_COUNT; i++)
+    {
+        if (Modules[i] == NULL)
+            continue;
+
+        ok(FreeLibrary(Modules[i]), "FreeLibrary failed (%lu)\n", GetLastError());
+        GetModuleName(Name, _countof(Name), i);
+        ok(GetModuleHandleW(Name) == NULL, "%ls is still loaded\n", Name);
+    }
+
+    /* The modules of the process itself are still found */
+    ok(GetModuleHandleW(L"ntdll.dll") != NULL, "ntdll.dll was not found\n");
+    ok(GetModuleHandleW(L"KERNEL32.DLL") != NULL, "kernel32.dll was not found\n");
+
+    HeapFree(GetProcessHeap(), 0, Modules);
+}
+
+START_TEST(LdrHashTable)
+{
+    WCHAR Source[MAX_PATH], Directory[MAX_PATH], Name[MAX_PATH], Path[MAX_PATH];
+    ULONG i, Copied;
+
+    /* A small DLL, that is never initialized here */
+    if (GetSystemDirectoryW(Source, _countof(Source)) == 0 ||
+        FAILED(StringCchCatW(Source, _countof(Source), L"\\version.dll")) ||
+        GetTempPathW(_countof(Directory), Directory) == 0 ||
+        FAILED(StringCchCatW(Directory, _countof(Directory), L"LdrHashTable")))
+    {
+        skip("No test directory available\n");
+        return;
+    }
+
+    CreateDirectoryW(Directory, NULL);
+    for (Copied = 0; Copied < MODULE_COUNT; Copied++)
+    {
+        GetModuleName(Name, _countof(Name), Copied);
+        StringCchPrintfW(Path, _countof(Path), L"%s\\%s", Directory, Name);
+        if (!CopyFileW(Source, Path, FALSE))
+            break;
+    }
+
+    if (Copied != MODULE_COUNT)
+        skip("Cannot copy %ls to %ls (%lu)\n", Source, Directory, GetLastError());
+    else
+        RunModules(Directory);
+
+    for (i = 0; i < Copied; i++)
+    {
+        GetModuleName(Name, _countof(Name), i);
+        StringCchPrintfW(Path, _countof(Path), L"%s\\%s", Directory, Name);
+        DeleteFileW(Path);
+    }
+    RemoveDirectoryW(Directory);
+}
@@ -0,0 +1,202 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test NtQueryDirectoryObject and time lookups in large directories
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define OBJECT_COUNT    100000
+#define QUERY_SIZE      (64 * 1024)
+
+static
+VOID
+GetObjectName(
+    PWSTR Buffer,
+    SIZE_T Length,
+    ULONG Index,
+    BOOLEAN Upcase)
+{
+    StringCchPrintfW(Buffer, Length, Upcase ? L"DIRTESTEVENT%lu" : L"DirTestEvent%lu", Index);
+}
+
+/* Enumerate the directory and check that every object is returned once */
+static
+VOID
+CheckEnumeration(
+    HANDLE DirectoryHandle,
+    ULONG ObjectCount)
+{
+    POBJECT_DIRECTORY_INFORMATION Info;
+    PUCHAR Seen;
+    ULONG Context, ReturnLength, Index, Found, Calls, Errors;
+    BOOLEAN Restart;
+    NTSTATUS Status;
+
+    Info = RtlAllocateHeap(RtlGetProcessHeap(), 0, QUERY_SIZE);
+    Seen = RtlAllocateHeap(RtlGetProcessHeap(), HEAP_ZERO_MEMORY, ObjectCount);
+    if (!Info || !Seen)
+    {
+        skip("Out of memory\n");
+        if (Info) RtlFreeHeap(RtlGetProcessHeap(), 0, Info);
+        if (Seen) RtlFreeHeap(RtlGetProcessHeap(), 0, Seen);
+        return;
+    }
+
+    Found = 0;
+    Calls = 0;
+    Errors = 0;
+    Context = 0;
+    Restart = TRUE;
+    for (;;)
+    {
+        Status = NtQueryDirectoryObject(DirectoryHandle,
+                                        Info,
+                                        QUERY_SIZE,
+                                        FALSE,
+                                        Restart,
+                                        &Context,
+                                        &ReturnLength);
+        if (Status == STATUS_NO_MORE_ENTRIES)
+            break;
+        ok(NT_SUCCESS(Status), "NtQueryDirectoryObject returned 0x%lx\n", Status);
+        if (!NT_SUCCESS(Status))
+            break;
+
+        Restart = FALSE;
+        Calls++;
+        for (Index = 0; Info[Index].Name.Buffer; Index++)
+        {
+            ULONG Number;
+
+            if (swscanf(Info[Index].Name.Buffer, L"DirTestEvent%lu", &Number) != 1 ||
+                Number >= ObjectCount ||
+                Seen[Number])
+            {
+                Errors++;
+                continue;
+            }
+            Seen[Number] = 1;
+            Found++;
+        }
+
+        if (Status != STATUS_MORE_ENTRIES)
+            break;
+    }
+
+    ok(Found == ObjectCount, "Found %lu entries instead of %lu, in %lu calls\n",
+       Found, ObjectCount, Calls);
+    ok(Errors == 0, "%lu unexpected or duplicate entries\n", Errors);
+
+    RtlFreeHeap(RtlGetProcessHeap(), 0, Seen);
+    RtlFreeHeap(RtlGetProcessHeap(), 0, Info);
+}
+
+START_TEST(NtQueryDirectoryObject)
+{
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    UNICODE_STRING Name;
+    WCHAR NameBuffer[32];
+    HANDLE DirectoryHandle, Handle;
+    PHANDLE Events;
+    ULONG i, Count, Errors;
+    DWORD CreateTime, OpenTime, MissTime;
+    NTSTATUS Status;
+
+    InitializeObjectAttributes(&ObjectAttributes, NULL, 0, NULL, NULL);
+    Status = NtCreateDirectoryObject(&DirectoryHandle, DIRECTORY_ALL_ACCESS, &ObjectAttributes);
+    ok_ntstatus(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+        return;
+
+    Events = RtlAllocateHeap(RtlGetProcessHeap(), 0, OBJECT_COUNT * sizeof(HANDLE));
+    if (!Events)
+    {
+        skip("Out of memory\n");
+        NtClose(DirectoryHandle);
+        return;
+    }
+
+    /* Create the objects, the directory grows as they get inserted */
+    CreateTime = GetTickCount();
+    for (Count = 0; Count < OBJECT_COUNT; Count++)
+    {
+        GetObjectName(NameBuffer, _countof(NameBuffer), Count, FALSE);
+        RtlInitUnicodeString(&Name, NameBuffer);
+        InitializeObjectAttributes(&ObjectAttributes, &Name, 0, DirectoryHandle, NULL);
+        Status = NtCreateEvent(&Events[Count], EVENT_ALL_ACCESS, &ObjectAttributes,
+                               NotificationEvent, FALSE);
+        if (!NT_SUCCESS(Status))
+            break;
+    }
+    CreateTime = GetTickCount() - CreateTime;
+    ok(Count == OBJECT_COUNT, "Created %lu objects, status 0x%lx\n", Count, Status);
+
+    /* Open every object by name, case insensitively */
+    Errors = 0;
+    OpenTime = GetTickCount();
+    for (i = 0; i < Count; i++)
+    {
+        GetObjectName(NameBuffer, _countof(NameBuffer), i, TRUE);
+        RtlInitUnicodeString(&Name, NameBuffer);
+        InitializeObjectAttributes(&ObjectAttributes, &Name, OBJ_CASE_INSENSITIVE,
+                                   DirectoryHandle, NULL);
+        Status = NtOpenEvent(&Handle, EVENT_QUERY_STATE, &ObjectAttributes);
+        if (!NT_SUCCESS(Status))
+        {
+            Errors++;
+            continue;
+        }
+        NtClose(Handle);
+    }
+    OpenTime = GetTickCount() - OpenTime;
+    ok(Errors == 0, "%lu objects could not be opened\n", Errors);
+
+    /* Names that don't exist must walk a whole chain */
+    Errors = 0;
+    MissTime = GetTickCount();
+    for (i = 0; i < Count; i++)
+    {
+        GetObjectName(NameBuffer, _countof(NameBuffer), i + OBJECT_COUNT, FALSE);
+        RtlInitUnicodeString(&Name, NameBuffer);
+        InitializeObjectAttributes(&ObjectAttributes, &Name, 0, DirectoryHandle, NULL);
+        Status = NtOpenEvent(&Handle, EVENT_QUERY_STATE, &ObjectAttributes);
+        if (Status != STATUS_OBJECT_NAME_NOT_FOUND)
+        {
+            Errors++;
+            if (NT_SUCCESS(Status)) NtClose(Handle);
+        }
+    }
+    MissTime = GetTickCount() - MissTime;
+    ok(Errors == 0, "%lu lookups of missing objects did not fail as expected\n", Errors);
+
+    trace("%lu objects: create %lu ms, open %lu ms, failed open %lu ms\n",
+          Count, CreateTime, OpenTime, MissTime);
+
+    CheckEnumeration(DirectoryHandle, Count);
+
+    /* Remove half of the objects and check what is left */
+    for (i = 0; i < Count; i += 2)
+        NtClose(Events[i]);
+    Errors = 0;
+    for (i = 0; i < Count; i++)
+    {
+        GetObjectName(NameBuffer, _countof(NameBuffer), i, FALSE);
+        RtlInitUnicodeString(&Name, NameBuffer);
+        InitializeObjectAttributes(&ObjectAttributes, &Name, 0, DirectoryHandle, NULL);
+        Status = NtOpenEvent(&Handle, EVENT_QUERY_STATE, &ObjectAttributes);
+        if (NT_SUCCESS(Status))
+            NtClose(Handle);
+        if ((i % 2) ? !NT_SUCCESS(Status) : (Status != STATUS_OBJECT_NAME_NOT_FOUND))
+            Errors++;
+    }
+    ok(Errors == 0, "%lu objects were not found as expected after the removal\n", Errors);
+
+    for (i = 1; i < Count; i += 2)
+        NtClose(Events[i]);
+    CheckEnumeration(DirectoryHandle, 0);
+
+    RtlFreeHeap(RtlGetProcessHeap(), 0, Events);
+    NtClose(DirectoryHandle);
+}
@@ -0,0 +1,149 @@
+/*
+ * PROJECT:         ReactOS api tests
+ * LICENSE:         GPLv2+ - See COPYING in the top level directory
+ * PURPOSE:         Test for RtlCompressBuffer/RtlDecompressBuffer round trips
+ * PROGRAMMER:      ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define TEST_BUFFER_SIZE    (4 * 1024 * 1024)
+
+static
+VOID
+FillTestBuffer(
+    _Out_writes_bytes_(Size) PUCHAR Buffer,
+    _In_ ULONG Size)
+{
+    static const CHAR Words[][9] = { "ReactOS", "kernel", "driver", "registry", "win32k", "ntdll" };
+    ULONG Seed = 0x12345678;
+    ULONG i = 0, Length;
+    PCSTR Word;
+
+    /* Text-like data with a share of noise, so every engine has something to find */
+    while (i < Size)
+    {
+        Seed = Seed * 1103515245 + 12345;
+        if ((Seed >> 16) & 3)
+        {
+            Word = Words[(Seed >> 20) % _countof(Words)];
+            Length = min((ULONG)strlen(Word), Size - i);
+            RtlCopyMemory(Buffer + i, Word, Length);
+            i += Length;
+        }
+        else
+        {
+            Buffer[i++] = (UCHAR)(Seed >> 24);
+        }
+    }
+}
+
+static
+ULONG
+MegabytesPerSecond(
+    _In_ ULONG Size,
+    _In_ LONGLONG Ticks,
+    _In_ LONGLONG Frequency)
+{
+    return (ULONG)((ULONGLONG)Size * Frequency / max(Ticks, 1) / (1024 * 1024));
+}
+
+static
+VOID
+TestRoundTrip(
+    _In_ USHORT FormatAndEngine,
+    _In_ PUCHAR Uncompressed,
+    _In_ ULONG UncompressedSize)
+{
+    ULONG WorkSpaceSize, FragmentWorkSpaceSize;
+    ULONG CompressedBufferSize, CompressedSize, FinalSize;
+    LARGE_INTEGER Frequency, Start, Compressed, Decompressed;
+    PUCHAR CompressedBuffer, Output;
+    PVOID WorkSpace;
+    NTSTATUS Status;
+
+    Status = RtlGetCompressionWorkSpaceSize(FormatAndEngine, &WorkSpaceSize, &FragmentWorkSpaceSize);
+    ok_hex(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+        return;
+
+    /* Worst case is a flag word per 32 literals for XPRESS, and a code table per 64 KB for XPRESS Huffman */
+    CompressedBufferSize = UncompressedSize + UncompressedSize / 8 + 0x400;
+    WorkSpace = RtlAllocateHeap(RtlGetProcessHeap(), 0, WorkSpaceSize);
+    CompressedBuffer = RtlAllocateHeap(RtlGetProcessHeap(), 0, CompressedBufferSize);
+    Output = RtlAllocateHeap(RtlGetProcessHeap(), 0, UncompressedSize);
+    if (!WorkSpace || !CompressedBuffer || !Output)
+    {
+        skip("Out of memory\n");
+        goto Cleanup;
+    }
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    Status = RtlCompressBuffer(FormatAndEngine,
+                               Uncompressed,
+                               UncompressedSize,
+                               CompressedBuffer,
+                               CompressedBufferSize,
+                               4096,
+                               &CompressedSize,
+                               WorkSpace);
+    QueryPerformanceCounter(&Compressed);
+    ok_hex(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+        goto Cleanup;
+    ok(CompressedSize < UncompressedSize, "0x%04x: data was not compressed (%lu)\n", FormatAndEngine, CompressedSize);
+
+    RtlFillMemory(Output, UncompressedSize, 0x55);
+    Status = RtlDecompressBuffer(FormatAndEngine,
+                                 Output,
+                                 UncompressedSize,
+                                 CompressedBuffer,
+                                 CompressedSize,
+                                 &FinalSize);
+    QueryPerformanceCounter(&Decompressed);
+    ok_hex(Status, STATUS_SUCCESS);
+    ok_long(FinalSize, UncompressedSize);
+    ok(RtlCompareMemory(Output, Uncompressed, UncompressedSize) == UncompressedSize,
+       "0x%04x: decompressed data differs\n", FormatAndEngine);
+
+    trace("0x%04x: %lu -> %lu bytes (%lu%%), compress %lu MB/s, decompress %lu MB/s\n",
+          FormatAndEngine, UncompressedSize, CompressedSize,
+          (ULONG)((ULONGLONG)CompressedSize * 100 / UncompressedSize),
+          MegabytesPerSecond(UncompressedSize, Compressed.QuadPart - Start.QuadPart, Frequency.QuadPart),
+          MegabytesPerSecond(UncompressedSize, Decompressed.QuadPart - Compressed.QuadPart, Frequency.QuadPart));
+
+Cleanup:
+    if (Output) RtlFreeHeap(RtlGetProcessHeap(), 0, Output);
+    if (CompressedBuffer) RtlFreeHeap(RtlGetProcessHeap(), 0, CompressedBuffer);
+    if (WorkSpace) RtlFreeHeap(RtlGetProcessHeap(), 0, WorkSpace);
+}
+
+START_TEST(RtlCompressBuffer)
+{
+    PUCHAR Buffer;
+
+    Buffer = RtlAllocateHeap(RtlGetProcessHeap(), 0, TEST_BUFFER_SIZE);
+    if (!Buffer)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+
+    FillTestBuffer(Buffer, TEST_BUFFER_SIZE);
+
+    TestRoundTrip(COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_STANDARD, Buffer, TEST_BUFFER_SIZE);
+    TestRoundTrip(COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_MAXIMUM, Buffer, TEST_BUFFER_SIZE);
+    TestRoundTrip(COMPRESSION_FORMAT_XPRESS | COMPRESSION_ENGINE_STANDARD, Buffer, TEST_BUFFER_SIZE);
+    TestRoundTrip(COMPRESSION_FORMAT_XPRESS | COMPRESSION_ENGINE_MAXIMUM, Buffer, TEST_BUFFER_SIZE);
+    TestRoundTrip(COMPRESSION_FORMAT_XPRESS_HUFF | COMPRESSION_ENGINE_STANDARD, Buffer, TEST_BUFFER_SIZE);
+    TestRoundTrip(COMPRESSION_FORMAT_XPRESS_HUFF | COMPRESSION_ENGINE_MAXIMUM, Buffer, TEST_BUFFER_SIZE);
+
+    /* Short and odd-sized inputs */
+    TestRoundTrip(COMPRESSION_FORMAT_LZNT1, Buffer, 4097);
+    TestRoundTrip(COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_MAXIMUM, Buffer, 100);
+    TestRoundTrip(COMPRESSION_FORMAT_XPRESS, Buffer, 100);
+    TestRoundTrip(COMPRESSION_FORMAT_XPRESS_HUFF, Buffer, 0x10001);
+
+    RtlFreeHeap(RtlGetProcessHeap(), 0, Buffer);
+}
@@ -0,0 +1,220 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Test the low fragmentation heap, with threads sharing its slots
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define LOW_FRAG_HEAP       2
+#define THREAD_COUNT        32
+#define WINDOW_SIZE         64
+#define OPERATIONS          20000
+#define MAX_BLOCK_SIZE      1024
+#define EXCHANGE_SIZE       256
+
+typedef struct _HEAP_THREAD
+{
+    HANDLE Heap;
+    ULONG Index;
+    ULONG Errors;
+} HEAP_THREAD, *PHEAP_THREAD;
+
+/* Blocks handed from one thread to another, to be freed there */
+static PVOID volatile Exchange[EXCHANGE_SIZE];
+static HANDLE StartEvent;
+
+static
+ULONG
+NextRandom(
+    PULONG Seed)
+{
+    *Seed = *Seed * 1103515245 + 12345;
+    return *Seed >> 8;
+}
+
+/* Every block starts with its size and is filled with its low byte */
+static
+PUCHAR
+AllocateBlock(
+    HANDLE Heap,
+    SIZE_T Size)
+{
+    PUCHAR Block;
+
+    Block = RtlAllocateHeap(Heap, 0, Size);
+    if (Block == NULL)
+        return NULL;
+
+    FillMemory(Block, Size, (UCHAR)Size);
+    if (Size >= sizeof(USHORT))
+        *(PUSHORT)Block = (USHORT)Size;
+    return Block;
+}
+
+static
+BOOLEAN
+FreeBlock(
+    HANDLE Heap,
+    PUCHAR Block)
+{
+    SIZE_T Size, i;
+    BOOLEAN Valid;
+
+    Size = RtlSizeHeap(Heap, 0, Block);
+    Valid = (Size >= 1 && Size <= MAX_BLOCK_SIZE);
+    if (Valid && Size >= sizeof(USHORT))
+        Valid = (*(PUSHORT)Block == Size);
+    for (i = sizeof(USHORT); Valid && i < Size; i++)
+        Valid = (Block[i] == (UCHAR)Size);
+
+    return RtlFreeHeap(Heap, 0, Block) && Valid;
+}
+
+/* More threads than slots, so that they contend for them */
+static
+DWORD
+WINAPI
+HeapThread(
+    PVOID Parameter)
+{
+    PHEAP_THREAD Thread = Parameter;
+    PUCHAR Window[WINDOW_SIZE] = { NULL };
+    ULONG Seed = Thread->Index * 7919 + 1;
+    ULONG Operation, i;
+    PUCHAR Block;
+
+    WaitForSingleObject(StartEvent, INFINITE);
+
+    for (Operation = 0; Operation < OPERATIONS; Operation++)
+    {
+        i = NextRandom(&Seed) % WINDOW_SIZE;
+        Block = Window[i];
+
+        /* Once in a while, leave the block to another thread */
+        if (Block != NULL && NextRandom(&Seed) % 4 == 0)
+            Block = InterlockedExchangePointer(&Exchange[NextRandom(&Seed) % EXCHANGE_SIZE], Block);
+
+        if (Block != NULL && !FreeBlock(Thread->Heap, Block))
+            Thread->Errors++;
+
+        Window[i] = AllocateBlock(Thread->Heap, NextRandom(&Seed) % MAX_BLOCK_SIZE + 1);
+        if (Window[i] == NULL)
+            Thread->Errors++;
+    }
+
+    for (i = 0; i < WINDOW_SIZE; i++)
+    {
+        if (Window[i] != NULL && !FreeBlock(Thread->Heap, Window[i]))
+            Thread->Errors++;
+    }
+
+    return 0;
+}
+
+static
+VOID
+TestThreads(
+    HANDLE Heap)
+{
+    HEAP_THREAD Threads[THREAD_COUNT];
+    HANDLE Handles[THREAD_COUNT];
+    ULONG i, Started, Errors = 0;
+
+    StartEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    ok(StartEvent != NULL, "CreateEvent failed (%lu)\n", GetLastError());
+    if (StartEvent == NULL)
+        return;
+
+    for (Started = 0; Started < THREAD_COUNT; Started++)
+    {
+        Threads[Started].Heap = Heap;
+        Threads[Started].Index = Started;
+        Threads[Started].Errors = 0;
+        Handles[Started] = CreateThread(NULL, 0, HeapThread, &Threads[Started], 0, NULL);
+        if (Handles[Started] == NULL)
+        {
+            skip("CreateThread failed (%lu)\n", GetLastError());
+            break;
+        }
+    }
+
+    SetEvent(StartEvent);
+    for (i = 0; i < Started; i++)
+    {
+        ok(WaitForSingleObject(Handles[i], 60000) == WAIT_OBJECT_0, "Thread %lu did not finish\n", i);
+        CloseHandle(Handles[i]);
+        Errors += Threads[i].Errors;
+    }
+    CloseHandle(StartEvent);
+
+    for (i = 0; i < EXCHANGE_SIZE; i++)
+    {
+        if (Exchange[i] != NULL && !FreeBlock(Heap, Exchange[i]))
+            Errors++;
+        Exchange[i] = NULL;
+    }
+
+    ok(Errors == 0, "%lu blocks were lost or damaged\n", Errors);
+    ok(RtlValidateHeap(Heap, 0, NULL), "The heap is damaged\n");
+}
+
+START_TEST(RtlSetHeapInformation)
+{
+    PUCHAR Blocks[MAX_BLOCK_SIZE];
+    ULONG Information, Errors;
+    SIZE_T ReturnLength, i;
+    NTSTATUS Status;
+    HANDLE Heap;
+
+    /* Heaps without serialization can't have the front end */
+    Heap = RtlCreateHeap(HEAP_GROWABLE | HEAP_NO_SERIALIZE, NULL, 0, 0, NULL, NULL);
+    ok(Heap != NULL, "RtlCreateHeap failed\n");
+    if (Heap != NULL)
+    {
+        Information = LOW_FRAG_HEAP;
+        Status = RtlSetHeapInformation(Heap, HeapCompatibilityInformation, &Information, sizeof(Information));
+        ok(!NT_SUCCESS(Status), "Status = 0x%lx\n", Status);
+        RtlDestroyHeap(Heap);
+    }
+
+    Heap = RtlCreateHeap(HEAP_GROWABLE, NULL, 0, 0, NULL, NULL);
+    ok(Heap != NULL, "RtlCreateHeap failed\n");
+    if (Heap == NULL)
+        return;
+
+    Information = 0x55555555;
+    Status = RtlQueryHeapInformation(Heap, HeapCompatibilityInformation, &Information, sizeof(Information), &ReturnLength);
+    ok_ntstatus(Status, STATUS_SUCCESS);
+    ok(Information == 0, "Information = %lu\n", Information);
+
+    Information = LOW_FRAG_HEAP;
+    Status = RtlSetHeapInformation(Heap, HeapCompatibilityInformation, &Information, sizeof(Information));
+    ok_ntstatus(Status, STATUS_SUCCESS);
+
+    Information = 0x55555555;
+    Status = RtlQueryHeapInformation(Heap, HeapCompatibilityInformation, &Information, sizeof(Information), &ReturnLength);
+    ok_ntstatus(Status, STATUS_SUCCESS);
+    ok(Information == LOW_FRAG_HEAP, "Information = %lu\n", Information);
+
+    /* Every size keeps its own size and contents */
+    Errors = 0;
+    for (i = 0; i < MAX_BLOCK_SIZE; i++)
+    {
+        Blocks[i] = AllocateBlock(Heap, i + 1);
+        if (Blocks[i] == NULL || RtlSizeHeap(Heap, 0, Blocks[i]) != i + 1)
+            Errors++;
+    }
+    ok(RtlValidateHeap(Heap, 0, NULL), "The heap is damaged\n");
+    for (i = 0; i < MAX_BLOCK_SIZE; i++)
+    {
+        if (Blocks[i] != NULL && !FreeBlock(Heap, Blocks[i]))
+            Errors++;
+    }
+    ok(Errors == 0, "%lu blocks were lost or damaged\n", Errors);
+
+    TestThreads(Heap);
+
+    RtlDestroyHeap(Heap);
+}
@@ -0,0 +1,130 @@
+/*
+ * PROJECT:         ReactOS kernel-mode tests
+ * LICENSE:         GPLv2+ - See COPYING in the top level directory
+ * PURPOSE:         Kernel-Mode Test Suite Runtime library chunked compression test
+ * PROGRAMMER:      ReactOS Team
+ */
+
+#include <kmt_test.h>
+
+#define TAG_TEST 'CCtR'
+
+static
+VOID
+FillTestBuffer(
+    OUT PUCHAR Buffer,
+    IN ULONG Size)
+{
+    static const CHAR Text[] = "ReactOS chunked compression test ";
+    ULONG Seed = 0x9E3779B9;
+    ULONG i;
+
+    /* Mix of text, noise and whole zero chunks */
+    for (i = 0; i < Size; i++)
+    {
+        Seed = Seed * 1103515245 + 12345;
+        if ((i / 0x1000) % 7 == 3)
+            Buffer[i] = 0;
+        else if ((Seed >> 16) & 7)
+            Buffer[i] = Text[i % (sizeof(Text) - 1)];
+        else
+            Buffer[i] = (UCHAR)(Seed >> 24);
+    }
+}
+
+static
+VOID
+TestRoundTrip(
+    IN PUCHAR Uncompressed,
+    IN ULONG UncompressedSize,
+    IN ULONG TailSize)
+{
+    ULONG WorkSpaceSize, FragmentWorkSpaceSize, InfoLength, NumberOfChunks;
+    ULONG CompressedSize, SplitSize, Chunk;
+    LARGE_INTEGER Frequency, Start, End;
+    PCOMPRESSED_DATA_INFO Info = NULL;
+    PUCHAR Compressed = NULL, Output = NULL;
+    PVOID WorkSpace = NULL;
+    NTSTATUS Status;
+
+    Status = RtlGetCompressionWorkSpaceSize(COMPRESSION_FORMAT_LZNT1, &WorkSpaceSize, &FragmentWorkSpaceSize);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+
+    NumberOfChunks = (UncompressedSize + 0xFFF) / 0x1000;
+    InfoLength = FIELD_OFFSET(COMPRESSED_DATA_INFO, CompressedChunkSizes[NumberOfChunks]);
+    Info = ExAllocatePoolWithTag(PagedPool, InfoLength, TAG_TEST);
+    WorkSpace = ExAllocatePoolWithTag(PagedPool, WorkSpaceSize, TAG_TEST);
+    Compressed = ExAllocatePoolWithTag(PagedPool, UncompressedSize, TAG_TEST);
+    Output = ExAllocatePoolWithTag(PagedPool, UncompressedSize, TAG_TEST);
+    if (skip(Info && WorkSpace && Compressed && Output, "Out of memory\n"))
+        goto Cleanup;
+
+    RtlZeroMemory(Info, InfoLength);
+    Info->CompressionFormatAndEngine = COMPRESSION_FORMAT_LZNT1;
+    Info->ChunkShift = 12;
+    Info->ClusterShift = 12;
+    Status = RtlCompressChunks(Uncompressed, UncompressedSize,
+                               Compressed, UncompressedSize,
+                               Info, InfoLength, WorkSpace);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_uint(Info->NumberOfChunks, NumberOfChunks);
+    if (!NT_SUCCESS(Status))
+        goto Cleanup;
+
+    /* Zero chunks take no space, the others either shrink or are stored */
+    CompressedSize = 0;
+    for (Chunk = 0; Chunk < Info->NumberOfChunks; Chunk++)
+    {
+        if ((Chunk % 7) == 3)
+            ok_eq_ulong(Info->CompressedChunkSizes[Chunk], 0UL);
+        ok(Info->CompressedChunkSizes[Chunk] <= 0x1000, "Chunk %lu has size %lu\n", Chunk, Info->CompressedChunkSizes[Chunk]);
+        CompressedSize += Info->CompressedChunkSizes[Chunk];
+    }
+    ok(CompressedSize < UncompressedSize, "CompressedSize = %lu\n", CompressedSize);
+
+    /* Move the last chunks into the tail buffer */
+    SplitSize = CompressedSize;
+    for (Chunk = Info->NumberOfChunks; Chunk > 0 && CompressedSize - SplitSize < TailSize; Chunk--)
+        SplitSize -= Info->CompressedChunkSizes[Chunk - 1];
+
+    RtlFillMemory(Output, UncompressedSize, 0x55);
+    Start = KeQueryPerformanceCounter(&Frequency);
+    Status = RtlDecompressChunks(Output, UncompressedSize,
+                                 Compressed, SplitSize,
+                                 Compressed + SplitSize, CompressedSize - SplitSize,
+                                 Info);
+    End = KeQueryPerformanceCounter(NULL);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_size(RtlCompareMemory(Output, Uncompressed, UncompressedSize), UncompressedSize);
+
+    trace("%lu bytes in %lu chunks -> %lu bytes, decompressed in %I64d us on %u processors\n",
+          UncompressedSize, NumberOfChunks, CompressedSize,
+          (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart,
+          (ULONG)KeNumberProcessors);
+
+Cleanup:
+    if (Output) ExFreePoolWithTag(Output, TAG_TEST);
+    if (Compressed) ExFreePoolWithTag(Compressed, TAG_TEST);
+    if (WorkSpace) ExFreePoolWithTag(WorkSpace, TAG_TEST);
+    if (Info) ExFreePoolWithTag(Info, TAG_TEST);
+}
+
+START_TEST(RtlCompressChunks)
+{
+    const ULONG BufferSize = 8 * 1024 * 1024;
+    PUCHAR Buffer;
+
+    Buffer = ExAllocatePoolWithTag(PagedPool, BufferSize, TAG_TEST);
+    if (skip(Buffer != NULL, "Out of memory\n"))
+        return;
+
+    FillTestBuffer(Buffer, BufferSize);
+
+    /* Small buffers are decompressed inline, large ones use worker threads */
+    TestRoundTrip(Buffer, 0x4321, 0);
+    TestRoundTrip(Buffer, 0x10000, 0x800);
+    TestRoundTrip(Buffer, BufferSize, 0);
+    TestRoundTrip(Buffer, BufferSize, 0x10000);
+
+    ExFreePoolWithTag(Buffer, TAG_TEST);
+}
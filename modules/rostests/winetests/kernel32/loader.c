@@ -3681,7 +3681,12 @@ static ULONG hash_basename(const WCHAR *basename)
                             NtCurrentTeb()->Peb->OSMajorVersion);
     ULONG hash = 0;
 
+#ifdef __REACTOS__
+    /* ReactOS hashes the full name like Windows 8, whatever version it reports */
+    if (version >= 0x0602 || !strcmp(winetest_platform, "reactos"))
+#else
     if (version >= 0x0602)
+#endif
     {
         for (; *basename; basename++)
             hash = hash * 65599 + toupperW(*basename);
@@ -3706,6 +3711,23 @@ static void test_HashLinks(void)
     LDR_MODULE *module;
     BOOL found;
 
+#ifdef __REACTOS__
+    if (!strcmp(winetest_platform, "reactos"))
+    {
+        ULONG count = 0;
+
+        /* The table only grows past its 32 buckets once there are more modules than that */
+        mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+        for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+            count++;
+        if (count > 32)
+        {
+            skip("%lu modules are loaded, the hash table may have grown\n", count);
+            return;
+        }
+    }
+#endif
+
     entry = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
     entry = entry->Flink;
 
@@ -269,7 +269,7 @@ CcCopyData (
     ULONG BytesCopied;
     KIRQL OldIrql;
     PROS_SHARED_CACHE_MAP SharedCacheMap;
-    PLIST_ENTRY ListEntry;
+    LONGLONG ViewOffset;
     PROS_VACB Vacb;
     ULONG PartialLength;
     PVOID BaseAddress;
@@ -286,25 +286,18 @@ CcCopyData (
         /* test if the requested data is available */
         KeAcquireSpinLock(&SharedCacheMap->CacheMapLock, &OldIrql);
         /* FIXME: this loop doesn't take into account areas that don't have
-         * a VACB in the list yet */
-        ListEntry = SharedCacheMap->CacheMapVacbListHead.Flink;
-        while (ListEntry != &SharedCacheMap->CacheMapVacbListHead)
+         * a VACB yet */
+        for (ViewOffset = ROUND_DOWN(CurrentOffset, VACB_MAPPING_GRANULARITY);
+             ViewOffset < CurrentOffset + Length;
+             ViewOffset += VACB_MAPPING_GRANULARITY)
         {
-            Vacb = CONTAINING_RECORD(ListEntry,
-                                     ROS_VACB,
-                                     CacheMapVacbListEntry);
-            ListEntry = ListEntry->Flink;
-            if (!Vacb->Valid &&
-                DoRangesIntersect(Vacb->FileOffset.QuadPart,
-                                  VACB_MAPPING_GRANULARITY,
-                                  CurrentOffset, Length))
+            Vacb = CcRosLookupVacbIndex(SharedCacheMap, ViewOffset);
+            if (Vacb != NULL && !Vacb->Valid)
             {
                 KeReleaseSpinLock(&SharedCacheMap->CacheMapLock, OldIrql);
                 /* data not available */
                 return FALSE;
             }
-            if (Vacb->FileOffset.QuadPart >= CurrentOffset + Length)
-                break;
         }
         KeReleaseSpinLock(&SharedCacheMap->CacheMapLock, OldIrql);
     }
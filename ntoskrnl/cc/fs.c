@@ -220,7 +220,7 @@ CcPurgeCacheSection (
                       SharedCacheMap->SectionSize.QuadPart);
         if (ViewEnd >= EndOffset)
         {
-            break;
+            continue;
         }
 
         /* Still in use, it cannot be purged, fail
@@ -242,6 +242,7 @@ CcPurgeCacheSection (
         {
             CcRosUnmarkDirtyVacb(Vacb, FALSE);
         }
+        CcRosRemoveVacbIndex(SharedCacheMap, Vacb);
         RemoveEntryList(&Vacb->CacheMapVacbListEntry);
         InsertHeadList(&FreeList, &Vacb->CacheMapVacbListEntry);
     }
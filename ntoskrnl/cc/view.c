@@ -113,6 +113,118 @@ ULONG CcRosVacbGetRefCount_(PROS_VACB vacb, PCSTR file, INT line)
 
 /* FUNCTIONS *****************************************************************/
 
+/*
+ * The VACB index maps a view number to the VACB mapping it, so that lookups
+ * don't have to walk the VACB list of the shared cache map. The functions
+ * below must be called with the CacheMapLock held.
+ */
+PROS_VACB
+CcRosLookupVacbIndex(
+    PROS_SHARED_CACHE_MAP SharedCacheMap,
+    LONGLONG FileOffset)
+{
+    ULONGLONG View = (ULONGLONG)FileOffset / VACB_MAPPING_GRANULARITY;
+    ULONGLONG Block = View / VACB_INDEX_BLOCK_SIZE;
+
+    if (Block >= SharedCacheMap->VacbIndexSize ||
+        SharedCacheMap->VacbIndex[Block] == NULL)
+    {
+        return NULL;
+    }
+
+    return SharedCacheMap->VacbIndex[Block][View % VACB_INDEX_BLOCK_SIZE];
+}
+
+static
+BOOLEAN
+CcRosInsertVacbIndex(
+    PROS_SHARED_CACHE_MAP SharedCacheMap,
+    PROS_VACB Vacb)
+{
+    ULONGLONG View = (ULONGLONG)Vacb->FileOffset.QuadPart / VACB_MAPPING_GRANULARITY;
+    ULONGLONG Block = View / VACB_INDEX_BLOCK_SIZE;
+    PROS_VACB **NewIndex;
+    ULONG NewSize;
+
+    if (Block >= SharedCacheMap->VacbIndexSize)
+    {
+        if (Block >= MAXULONG / 2)
+        {
+            return FALSE;
+        }
+
+        NewSize = max((ULONG)Block + 1, SharedCacheMap->VacbIndexSize * 2);
+
+        NewIndex = ExAllocatePoolWithTag(NonPagedPool, NewSize * sizeof(PROS_VACB*), TAG_VACB_INDEX);
+        if (NewIndex == NULL)
+        {
+            return FALSE;
+        }
+
+        RtlZeroMemory(NewIndex, NewSize * sizeof(PROS_VACB*));
+        if (SharedCacheMap->VacbIndex != NULL)
+        {
+            RtlCopyMemory(NewIndex, SharedCacheMap->VacbIndex, SharedCacheMap->VacbIndexSize * sizeof(PROS_VACB*));
+            ExFreePoolWithTag(SharedCacheMap->VacbIndex, TAG_VACB_INDEX);
+        }
+        SharedCacheMap->VacbIndex = NewIndex;
+        SharedCacheMap->VacbIndexSize = NewSize;
+    }
+
+    if (SharedCacheMap->VacbIndex[Block] == NULL)
+    {
+        SharedCacheMap->VacbIndex[Block] = ExAllocatePoolWithTag(NonPagedPool,
+                                                                 VACB_INDEX_BLOCK_SIZE * sizeof(PROS_VACB),
+                                                                 TAG_VACB_INDEX);
+        if (SharedCacheMap->VacbIndex[Block] == NULL)
+        {
+            return FALSE;
+        }
+        RtlZeroMemory(SharedCacheMap->VacbIndex[Block], VACB_INDEX_BLOCK_SIZE * sizeof(PROS_VACB));
+    }
+
+    ASSERT(SharedCacheMap->VacbIndex[Block][View % VACB_INDEX_BLOCK_SIZE] == NULL);
+    SharedCacheMap->VacbIndex[Block][View % VACB_INDEX_BLOCK_SIZE] = Vacb;
+    return TRUE;
+}
+
+VOID
+CcRosRemoveVacbIndex(
+    PROS_SHARED_CACHE_MAP SharedCacheMap,
+    PROS_VACB Vacb)
+{
+    ULONGLONG View = (ULONGLONG)Vacb->FileOffset.QuadPart / VACB_MAPPING_GRANULARITY;
+    ULONGLONG Block = View / VACB_INDEX_BLOCK_SIZE;
+
+    ASSERT(Block < SharedCacheMap->VacbIndexSize);
+    ASSERT(SharedCacheMap->VacbIndex[Block][View % VACB_INDEX_BLOCK_SIZE] == Vacb);
+    SharedCacheMap->VacbIndex[Block][View % VACB_INDEX_BLOCK_SIZE] = NULL;
+}
+
+static
+VOID
+CcRosFreeVacbIndex(
+    PROS_SHARED_CACHE_MAP SharedCacheMap)
+{
+    ULONG i;
+
+    if (SharedCacheMap->VacbIndex == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < SharedCacheMap->VacbIndexSize; i++)
+    {
+        if (SharedCacheMap->VacbIndex[i] != NULL)
+        {
+            ExFreePoolWithTag(SharedCacheMap->VacbIndex[i], TAG_VACB_INDEX);
+        }
+    }
+    ExFreePoolWithTag(SharedCacheMap->VacbIndex, TAG_VACB_INDEX);
+    SharedCacheMap->VacbIndex = NULL;
+    SharedCacheMap->VacbIndexSize = 0;
+}
+
 VOID
 NTAPI
 CcRosTraceCacheMap (
@@ -363,6 +475,7 @@ retry:
             ASSERT(!current->MappedCount);
             ASSERT(Refs == 1);
 
+            CcRosRemoveVacbIndex(current->SharedCacheMap, current);
             RemoveEntryList(&current->CacheMapVacbListEntry);
             RemoveEntryList(&current->VacbLruListEntry);
             InitializeListHead(&current->VacbLruListEntry);
@@ -459,7 +572,6 @@ CcRosLookupVacb (
     PROS_SHARED_CACHE_MAP SharedCacheMap,
     LONGLONG FileOffset)
 {
-    PLIST_ENTRY current_entry;
     PROS_VACB current;
     KIRQL oldIrql;
 
@@ -468,33 +580,19 @@ CcRosLookupVacb (
     DPRINT("CcRosLookupVacb(SharedCacheMap 0x%p, FileOffset %I64u)\n",
            SharedCacheMap, FileOffset);
 
-    oldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-    KeAcquireSpinLockAtDpcLevel(&SharedCacheMap->CacheMapLock);
+    /* VACBs are only unlinked from the index with the CacheMapLock held,
+     * so it is enough to reference one safely */
+    KeAcquireSpinLock(&SharedCacheMap->CacheMapLock, &oldIrql);
 
-    current_entry = SharedCacheMap->CacheMapVacbListHead.Flink;
-    while (current_entry != &SharedCacheMap->CacheMapVacbListHead)
+    current = CcRosLookupVacbIndex(SharedCacheMap, FileOffset);
+    if (current != NULL)
     {
-        current = CONTAINING_RECORD(current_entry,
-                                    ROS_VACB,
-                                    CacheMapVacbListEntry);
-        if (IsPointInRange(current->FileOffset.QuadPart,
-                           VACB_MAPPING_GRANULARITY,
-                           FileOffset))
-        {
-            CcRosVacbIncRefCount(current);
-            KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
-            KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
-            return current;
-        }
-        if (current->FileOffset.QuadPart > FileOffset)
-            break;
-        current_entry = current_entry->Flink;
+        CcRosVacbIncRefCount(current);
     }
 
-    KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
-    KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+    KeReleaseSpinLock(&SharedCacheMap->CacheMapLock, oldIrql);
 
-    return NULL;
+    return current;
 }
 
 VOID
@@ -733,6 +831,7 @@ CcRosFreeUnusedVacb (
             ASSERT(Refs == 1);
 
             /* Reset and move to free list */
+            CcRosRemoveVacbIndex(current->SharedCacheMap, current);
             RemoveEntryList(&current->CacheMapVacbListEntry);
             RemoveEntryList(&current->VacbLruListEntry);
             InitializeListHead(&current->VacbLruListEntry);
@@ -783,8 +882,6 @@ CcRosCreateVacb (
     PROS_VACB *Vacb)
 {
     PROS_VACB current;
-    PROS_VACB previous;
-    PLIST_ENTRY current_entry;
     NTSTATUS Status;
     KIRQL oldIrql;
     ULONG Refs;
@@ -853,56 +950,43 @@ Retry:
      * our newly created VACB and return the existing one.
      */
     KeAcquireSpinLockAtDpcLevel(&SharedCacheMap->CacheMapLock);
-    current_entry = SharedCacheMap->CacheMapVacbListHead.Flink;
-    previous = NULL;
-    while (current_entry != &SharedCacheMap->CacheMapVacbListHead)
+    current = CcRosLookupVacbIndex(SharedCacheMap, FileOffset);
+    if (current != NULL)
     {
-        current = CONTAINING_RECORD(current_entry,
-                                    ROS_VACB,
-                                    CacheMapVacbListEntry);
-        if (IsPointInRange(current->FileOffset.QuadPart,
-                           VACB_MAPPING_GRANULARITY,
-                           FileOffset))
-        {
-            CcRosVacbIncRefCount(current);
-            KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
+        CcRosVacbIncRefCount(current);
+        KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
 #if DBG
-            if (SharedCacheMap->Trace)
-            {
-                DPRINT1("CacheMap 0x%p: deleting newly created VACB 0x%p ( found existing one 0x%p )\n",
-                        SharedCacheMap,
-                        (*Vacb),
-                        current);
-            }
+        if (SharedCacheMap->Trace)
+        {
+            DPRINT1("CacheMap 0x%p: deleting newly created VACB 0x%p ( found existing one 0x%p )\n",
+                    SharedCacheMap,
+                    (*Vacb),
+                    current);
+        }
 #endif
-            KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+        KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
 
-            Refs = CcRosVacbDecRefCount(*Vacb);
-            ASSERT(Refs == 0);
+        Refs = CcRosVacbDecRefCount(*Vacb);
+        ASSERT(Refs == 0);
 
-            *Vacb = current;
-            return STATUS_SUCCESS;
-        }
-        if (current->FileOffset.QuadPart < FileOffset)
-        {
-            ASSERT(previous == NULL ||
-                   previous->FileOffset.QuadPart < current->FileOffset.QuadPart);
-            previous = current;
-        }
-        if (current->FileOffset.QuadPart > FileOffset)
-            break;
-        current_entry = current_entry->Flink;
+        *Vacb = current;
+        return STATUS_SUCCESS;
     }
     /* There was no existing VACB. */
     current = *Vacb;
-    if (previous)
-    {
-        InsertHeadList(&previous->CacheMapVacbListEntry, &current->CacheMapVacbListEntry);
-    }
-    else
+    if (!CcRosInsertVacbIndex(SharedCacheMap, current))
     {
-        InsertHeadList(&SharedCacheMap->CacheMapVacbListHead, &current->CacheMapVacbListEntry);
+        KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
+        KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+
+        Refs = CcRosVacbDecRefCount(current);
+        ASSERT(Refs == 0);
+
+        *Vacb = NULL;
+        return STATUS_INSUFFICIENT_RESOURCES;
     }
+    /* The list is not sorted, the index is used to find VACBs by offset */
+    InsertTailList(&SharedCacheMap->CacheMapVacbListHead, &current->CacheMapVacbListEntry);
     KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
     InsertTailList(&VacbLruListHead, &current->VacbLruListEntry);
     KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
@@ -1189,9 +1273,10 @@ CcRosDeleteFileCache (
         while (!IsListEmpty(&SharedCacheMap->CacheMapVacbListHead))
         {
             current_entry = RemoveTailList(&SharedCacheMap->CacheMapVacbListHead);
+            current = CONTAINING_RECORD(current_entry, ROS_VACB, CacheMapVacbListEntry);
+            CcRosRemoveVacbIndex(SharedCacheMap, current);
             KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
 
-            current = CONTAINING_RECORD(current_entry, ROS_VACB, CacheMapVacbListEntry);
             RemoveEntryList(&current->VacbLruListEntry);
             InitializeListHead(&current->VacbLruListEntry);
             if (current->Dirty)
@@ -1259,6 +1344,7 @@ CcRosDeleteFileCache (
         RemoveEntryList(&SharedCacheMap->SharedCacheMapLinks);
         KeReleaseQueuedSpinLock(LockQueueMasterLock, *OldIrql);
 
+        CcRosFreeVacbIndex(SharedCacheMap);
         ExFreeToNPagedLookasideList(&SharedCacheMapLookasideList, SharedCacheMap);
         *OldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
     }
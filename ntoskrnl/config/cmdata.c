@@ -402,6 +402,14 @@ INIT_SECTION CM_SYSTEM_CONTROL_VECTOR CmControlVector[] =
         NULL
     },
 
+    {
+        L"Session Manager\\Memory Management",
+        L"ZeroPageThreadPerProcessor",
+        &MmZeroPageThreadPerProcessor,
+        NULL,
+        NULL
+    },
+
     {
         L"Session Manager\\Memory Management",
         L"PoolTagSmallTableSize",
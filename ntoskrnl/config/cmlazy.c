@@ -27,18 +27,47 @@ static ULONG CmpLazyFlushHiveCount = 7;
 ULONG CmpLazyFlushCount = 1;
 LONG CmpFlushStarveWriters;
 
+/* Group commit: hives with a log only get their log written, and the primary
+   files are checkpointed every few lazy flush rounds, or once a log grows big */
+BOOLEAN CmpGroupCommit = TRUE;
+static ULONG CmpLazyCheckpointInterval = 6;
+static ULONG CmpMaximumLogSize = 4 * 1024 * 1024;
+
 /* FUNCTIONS ******************************************************************/
 
+BOOLEAN
+NTAPI
+CmpCommitHive(IN PCMHIVE CmHive,
+              IN BOOLEAN Checkpoint)
+{
+    /* Only log if the hive has one, and it will get checkpointed later.
+       Hives that were not loaded from their file, like the SYSTEM hive
+       that the boot loader reads without its log, need the primary file */
+    if (!Checkpoint &&
+        CmpGroupCommit &&
+        CmHive->Hive.Log &&
+        CmHive->Hive.LogReplay &&
+        CmHive->FileHandles[HFILE_TYPE_LOG] &&
+        !(CmHive->Hive.HiveFlags & HIVE_NOLAZYFLUSH) &&
+        CmHive->Hive.LogSize < CmpMaximumLogSize)
+    {
+        /* Make the changes durable with a sequential write of the log */
+        return HvLogHive(&CmHive->Hive);
+    }
+
+    /* Write the log and the primary file */
+    return HvSyncHive(&CmHive->Hive);
+}
+
 BOOLEAN
 NTAPI
 CmpDoFlushNextHive(_In_  BOOLEAN ForceFlush,
                    _Out_ PBOOLEAN Error,
                    _Out_ PULONG DirtyCount)
 {
-    NTSTATUS Status;
     PLIST_ENTRY NextEntry;
     PCMHIVE CmHive;
-    BOOLEAN Result;
+    BOOLEAN Result, Checkpoint;
     ULONG HiveCount = CmpLazyFlushHiveCount;
 
     /* Set Defaults */
@@ -51,6 +80,11 @@ CmpDoFlushNextHive(_In_  BOOLEAN ForceFlush,
     /* Make sure we have to flush at least one hive */
     if (!HiveCount) HiveCount = 1;
 
+    /* Check if the primary files get written in this round */
+    Checkpoint = ForceFlush ||
+                 !CmpLazyCheckpointInterval ||
+                 !(CmpLazyFlushCount % CmpLazyCheckpointInterval);
+
     /* Acquire the list lock and loop */
     ExAcquirePushLockShared(&CmpHiveListHeadLock);
     NextEntry = CmpHiveListHead.Flink;
@@ -64,9 +98,6 @@ CmpDoFlushNextHive(_In_  BOOLEAN ForceFlush,
             /* Great sucess! */
             Result = TRUE;
 
-            /* One less to flush */
-            HiveCount--;
-
             /* Ignore clean or volatile hives */
             if ((!CmHive->Hive.DirtyCount && !ForceFlush) ||
                 (CmHive->Hive.HiveFlags & HIVE_VOLATILE))
@@ -74,23 +105,38 @@ CmpDoFlushNextHive(_In_  BOOLEAN ForceFlush,
                 /* Don't do anything but do update the count */
                 CmHive->FlushCount = CmpLazyFlushCount;
                 DPRINT("Hive %wZ is clean.\n", &CmHive->FileFullPath);
+
+                /* One less to flush */
+                HiveCount--;
             }
             else
             {
                 /* Do the sync */
                 DPRINT("Flushing: %wZ\n", &CmHive->FileFullPath);
                 DPRINT("Handle: %p\n", CmHive->FileHandles[HFILE_TYPE_PRIMARY]);
-                Status = HvSyncHive(&CmHive->Hive);
-                if(!NT_SUCCESS(Status))
+                if (!CmpCommitHive(CmHive, Checkpoint))
                 {
                     /* Let them know we failed */
-                    DPRINT1("Failed to flush %wZ on handle %p (status 0x%08lx)\n",
-                        &CmHive->FileFullPath,  CmHive->FileHandles[HFILE_TYPE_PRIMARY], Status);
+                    DPRINT1("Failed to flush %wZ on handle %p\n",
+                        &CmHive->FileFullPath,  CmHive->FileHandles[HFILE_TYPE_PRIMARY]);
                     *Error = TRUE;
                     Result = FALSE;
                     break;
                 }
                 CmHive->FlushCount = CmpLazyFlushCount;
+
+                /* Only the hives that were checkpointed count, the logs of
+                   all the other hives are written in this same round */
+                if (!CmHive->Hive.DirtyCount)
+                {
+                    /* One less to flush */
+                    HiveCount--;
+                }
+                else
+                {
+                    /* The primary file still needs to be written */
+                    *DirtyCount += CmHive->Hive.DirtyCount;
+                }
             }
         }
         else if ((CmHive->Hive.DirtyCount) &&
@@ -222,9 +268,10 @@ CmpLazyFlushWorker(IN PVOID Parameter)
     DPRINT("Lazy flush done. More work to be done: %s. Entries still dirty: %u.\n",
         MoreWork ? "Yes" : "No", DirtyCount);
 
-    if (MoreWork)
+    if (MoreWork || DirtyCount)
     {
-        /* Relaunch the flush timer, so the remaining hives get flushed */
+        /* Relaunch the flush timer, so the remaining hives get flushed,
+           or the logged ones get checkpointed in a later round */
         CmpLazyFlush();
     }
 }
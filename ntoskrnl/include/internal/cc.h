@@ -188,6 +188,11 @@ typedef struct _ROS_SHARED_CACHE_MAP
 
     /* ROS specific */
     LIST_ENTRY CacheMapVacbListHead;
+    /* VACBs by FileOffset / VACB_MAPPING_GRANULARITY, split in blocks of
+     * VACB_INDEX_BLOCK_SIZE entries that are only allocated when used.
+     * Protected by CacheMapLock. */
+    struct _ROS_VACB ***VacbIndex;
+    ULONG VacbIndexSize;
     ULONG TimeStamp;
     BOOLEAN PinAccess;
     KSPIN_LOCK CacheMapLock;
@@ -196,6 +201,8 @@ typedef struct _ROS_SHARED_CACHE_MAP
 #endif
 } ROS_SHARED_CACHE_MAP, *PROS_SHARED_CACHE_MAP;
 
+#define VACB_INDEX_BLOCK_SIZE 128
+
 #define READAHEAD_DISABLED 0x1
 #define WRITEBEHIND_DISABLED 0x2
 
@@ -362,6 +369,16 @@ CcRosLookupVacb(
     LONGLONG FileOffset
 );
 
+PROS_VACB
+CcRosLookupVacbIndex(
+    PROS_SHARED_CACHE_MAP SharedCacheMap,
+    LONGLONG FileOffset);
+
+VOID
+CcRosRemoveVacbIndex(
+    PROS_SHARED_CACHE_MAP SharedCacheMap,
+    PROS_VACB Vacb);
+
 VOID
 NTAPI
 CcInitCacheZeroPage(VOID);
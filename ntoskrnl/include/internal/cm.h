@@ -1134,6 +1134,13 @@ CmpLazyFlush(
     VOID
 );
 
+BOOLEAN
+NTAPI
+CmpCommitHive(
+    IN PCMHIVE CmHive,
+    IN BOOLEAN Checkpoint
+);
+
 //
 // Open/Create Routines
 //
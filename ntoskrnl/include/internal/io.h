@@ -57,6 +57,14 @@
 //
 #define IO_METHOD_FROM_CTL_CODE(c)                      (c & 0x00000003)
 
+//
+// Information class of the completion notification modes. Windows Server 2003
+// has it since SP2, but the headers only define it for Vista and higher.
+//
+#if (NTDDI_VERSION < NTDDI_VISTA)
+#define FileIoCompletionNotificationInformation         ((FILE_INFORMATION_CLASS)41)
+#endif
+
 //
 // Bugcheck codes for RAM disk booting
 //
@@ -119,6 +127,24 @@ typedef struct _FILE_OBJECT_EXTENSION
         FALSE :                                         \
         FileObject->Flags & FO_SYNCHRONOUS_IO))         \
 
+//
+// Determine, as set by FileIoCompletionNotificationInformation, if a request
+// that didn't pend and completed with this status doesn't queue a completion
+// packet, if completed requests don't signal the file object, and if fast I/O
+// that succeeded doesn't signal the event of the caller
+//
+#define IopSkipCompletionPort(FileObject, Status)       \
+    (((FileObject)->Flags & FO_SKIP_COMPLETION_PORT) && \
+     (NT_SUCCESS(Status)))
+
+#define IopSkipSetEvent(FileObject)                     \
+    (((FileObject)->Flags & FO_SKIP_SET_EVENT) &&       \
+     !((FileObject)->Flags & FO_SYNCHRONOUS_IO))
+
+#define IopSkipSetFastIoEvent(FileObject, Status)       \
+    (((FileObject)->Flags & FO_SKIP_SET_FAST_IO) &&     \
+     (NT_SUCCESS(Status)))
+
 //
 // Returns the internal Device Object Extension
 //
@@ -645,6 +645,17 @@ KiInsertQueue(
     BOOLEAN Head
 );
 
+ULONG
+NTAPI
+KeRemoveQueueEx(
+    IN PKQUEUE Queue,
+    IN KPROCESSOR_MODE WaitMode,
+    IN BOOLEAN Alertable,
+    IN PLARGE_INTEGER Timeout OPTIONAL,
+    OUT PLIST_ENTRY *EntryArray,
+    IN ULONG Count
+);
+
 VOID
 NTAPI
 KiTimerExpiration(
@@ -815,6 +826,18 @@ FASTCALL
 KeZeroPages(IN PVOID Address,
             IN ULONG Size);
 
+VOID
+FASTCALL
+KeZeroPagesFromIdleThread(IN PVOID Address,
+                          IN ULONG Size);
+
+#if defined(_M_IX86) || defined(_M_AMD64)
+VOID
+FASTCALL
+KiZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size);
+#endif
+
 BOOLEAN
 FASTCALL
 KeInvalidAccessAllowed(IN PVOID TrapInformation OPTIONAL);
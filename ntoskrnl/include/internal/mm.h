@@ -1012,7 +1012,8 @@ MiUnmapPageInHyperSpace(IN PEPROCESS Process,
 
 PVOID
 NTAPI
-MiMapPagesInZeroSpace(IN PMMPFN Pfn1,
+MiMapPagesInZeroSpace(IN PMMPTE ZeroingPte,
+                      IN PMMPFN Pfn1,
                       IN PFN_NUMBER NumberOfPages);
 
 VOID
@@ -181,6 +181,12 @@ ObpDeleteEntryDirectory(
     IN POBP_LOOKUP_CONTEXT Context
 );
 
+VOID
+NTAPI
+ObpDeleteDirectory(
+    IN PVOID Object
+);
+
 BOOLEAN
 NTAPI
 ObpInsertEntryDirectory(
@@ -13,6 +13,9 @@
 #define NDEBUG
 #include <debug.h>
 
+/* Entries NtRemoveIoCompletionEx can take off the queue in a single call */
+#define IOP_MAX_REMOVE_COUNT 64
+
 POBJECT_TYPE IoCompletionType;
 
 GENERAL_LOOKASIDE IoCompletionPacketLookaside;
@@ -95,6 +98,53 @@ IopFreeMiniPacket(PIOP_MINI_COMPLETION_PACKET Packet)
     InterlockedPushEntrySList(&List->L.ListHead, (PSLIST_ENTRY)Packet);
 }
 
+/*
+ * Gets the values of a completion packet removed from the queue, then frees
+ * the packet, or the IRP it was piggybacked on
+ */
+static
+VOID
+IopCaptureCompletionPacket(IN PLIST_ENTRY ListEntry,
+                           OUT PFILE_IO_COMPLETION_INFORMATION Information)
+{
+    PIOP_MINI_COMPLETION_PACKET Packet;
+    PIRP Irp;
+
+    /* Get the Packet Data */
+    Packet = CONTAINING_RECORD(ListEntry,
+                               IOP_MINI_COMPLETION_PACKET,
+                               ListEntry);
+
+    /* Check if this is piggybacked on an IRP */
+    if (Packet->PacketType == IopCompletionPacketIrp)
+    {
+        /* Get the IRP */
+        Irp = CONTAINING_RECORD(ListEntry,
+                                IRP,
+                                Tail.Overlay.ListEntry);
+
+        /* Save values */
+        Information->KeyContext = Irp->Tail.CompletionKey;
+        Information->ApcContext = Irp->Overlay.AsynchronousParameters.UserApcContext;
+        Information->IoStatusBlock = Irp->IoStatus;
+
+        /* Free the IRP */
+        IoFreeIrp(Irp);
+    }
+    else
+    {
+        /* Save values, without leaving stack garbage next to the status */
+        Information->KeyContext = Packet->KeyContext;
+        Information->ApcContext = Packet->ApcContext;
+        Information->IoStatusBlock.Pointer = NULL;
+        Information->IoStatusBlock.Status = Packet->IoStatus;
+        Information->IoStatusBlock.Information = Packet->IoStatusInformation;
+
+        /* Free the packet */
+        IopFreeMiniPacket(Packet);
+    }
+}
+
 VOID
 NTAPI
 IopDeleteIoCompletion(PVOID ObjectBody)
@@ -449,13 +499,10 @@ NtRemoveIoCompletion(IN HANDLE IoCompletionHandle,
 {
     LARGE_INTEGER SafeTimeout;
     PKQUEUE Queue;
-    PIOP_MINI_COMPLETION_PACKET Packet;
     PLIST_ENTRY ListEntry;
     KPROCESSOR_MODE PreviousMode = ExGetPreviousMode();
     NTSTATUS Status;
-    PIRP Irp;
-    PVOID Apc, Key;
-    IO_STATUS_BLOCK IoStatus;
+    FILE_IO_COMPLETION_INFORMATION Information;
     PAGED_CODE();
 
     /* Check if the call was from user mode */
@@ -507,45 +554,134 @@ NtRemoveIoCompletion(IN HANDLE IoCompletionHandle,
         else
         {
             /* Get the Packet Data */
-            Packet = CONTAINING_RECORD(ListEntry,
-                                       IOP_MINI_COMPLETION_PACKET,
-                                       ListEntry);
+            IopCaptureCompletionPacket(ListEntry, &Information);
 
-            /* Check if this is piggybacked on an IRP */
-            if (Packet->PacketType == IopCompletionPacketIrp)
+            /* Enter SEH to write back the values */
+            _SEH2_TRY
             {
-                /* Get the IRP */
-                Irp = CONTAINING_RECORD(ListEntry,
-                                        IRP,
-                                        Tail.Overlay.ListEntry);
+                /* Write the values to caller */
+                *ApcContext = Information.ApcContext;
+                *KeyContext = Information.KeyContext;
+                *IoStatusBlock = Information.IoStatusBlock;
+            }
+            _SEH2_EXCEPT(ExSystemExceptionFilter())
+            {
+                /* Get the exception code */
+                Status = _SEH2_GetExceptionCode();
+            }
+            _SEH2_END;
+        }
+
+        /* Dereference the Object */
+        ObDereferenceObject(Queue);
+    }
 
-                /* Save values */
-                Key = Irp->Tail.CompletionKey;
-                Apc = Irp->Overlay.AsynchronousParameters.UserApcContext;
-                IoStatus = Irp->IoStatus;
+    /* Return status */
+    return Status;
+}
 
-                /* Free the IRP */
-                IoFreeIrp(Irp);
-            }
-            else
+NTSTATUS
+NTAPI
+NtRemoveIoCompletionEx(IN HANDLE IoCompletionHandle,
+                       OUT PFILE_IO_COMPLETION_INFORMATION IoCompletionInformation,
+                       IN ULONG Count,
+                       OUT PULONG NumEntriesRemoved,
+                       IN PLARGE_INTEGER Timeout OPTIONAL,
+                       IN BOOLEAN Alertable)
+{
+    LARGE_INTEGER SafeTimeout;
+    PKQUEUE Queue;
+    PLIST_ENTRY ListEntries[IOP_MAX_REMOVE_COUNT];
+    KPROCESSOR_MODE PreviousMode = ExGetPreviousMode();
+    NTSTATUS Status;
+    FILE_IO_COMPLETION_INFORMATION Information;
+    ULONG Removed, i;
+    PAGED_CODE();
+
+    /* Fail if there is no room for any entry */
+    if (!Count) return STATUS_INVALID_PARAMETER;
+
+    /* Don't take more than we can hold, the caller will come back for the rest */
+    if (Count > IOP_MAX_REMOVE_COUNT) Count = IOP_MAX_REMOVE_COUNT;
+
+    /* Check if the call was from user mode */
+    if (PreviousMode != KernelMode)
+    {
+        /* Protect probes in SEH */
+        _SEH2_TRY
+        {
+            /* Probe the array, and the count of entries written to it */
+            ProbeForWrite(IoCompletionInformation,
+                          Count * sizeof(FILE_IO_COMPLETION_INFORMATION),
+                          sizeof(PVOID));
+            ProbeForWriteUlong(NumEntriesRemoved);
+            if (Timeout)
             {
-                /* Save values */
-                Key = Packet->KeyContext;
-                Apc = Packet->ApcContext;
-                IoStatus.Status = Packet->IoStatus;
-                IoStatus.Information = Packet->IoStatusInformation;
+                /* Probe and capture the timeout */
+                SafeTimeout = ProbeForReadLargeInteger(Timeout);
+                Timeout = &SafeTimeout;
+            }
+        }
+        _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+        {
+            /* Return the exception code */
+            _SEH2_YIELD(return _SEH2_GetExceptionCode());
+        }
+        _SEH2_END;
+    }
 
-                /* Free the packet */
-                IopFreeMiniPacket(Packet);
+    /* Open the Object */
+    Status = ObReferenceObjectByHandle(IoCompletionHandle,
+                                       IO_COMPLETION_MODIFY_STATE,
+                                       IoCompletionType,
+                                       PreviousMode,
+                                       (PVOID*)&Queue,
+                                       NULL);
+    if (NT_SUCCESS(Status))
+    {
+        /* Remove as many entries as are queued, waiting only for the first */
+        Removed = KeRemoveQueueEx(Queue,
+                                  PreviousMode,
+                                  Alertable,
+                                  Timeout,
+                                  ListEntries,
+                                  Count);
+
+        /* If we got a timeout, an alert or a user_apc back, return the status */
+        if ((Removed == 1) &&
+            (((NTSTATUS)(ULONG_PTR)ListEntries[0] == STATUS_TIMEOUT) ||
+             ((NTSTATUS)(ULONG_PTR)ListEntries[0] == STATUS_USER_APC) ||
+             ((NTSTATUS)(ULONG_PTR)ListEntries[0] == STATUS_ALERTED)))
+        {
+            /* Set this as the status */
+            Status = (NTSTATUS)(ULONG_PTR)ListEntries[0];
+        }
+        else
+        {
+            /* Return every packet, they are all freed even if writing fails */
+            for (i = 0; i < Removed; i++)
+            {
+                /* Get the Packet Data */
+                IopCaptureCompletionPacket(ListEntries[i], &Information);
+
+                /* Enter SEH to write back the values */
+                _SEH2_TRY
+                {
+                    /* Write the values to caller */
+                    IoCompletionInformation[i] = Information;
+                }
+                _SEH2_EXCEPT(ExSystemExceptionFilter())
+                {
+                    /* Get the exception code */
+                    Status = _SEH2_GetExceptionCode();
+                }
+                _SEH2_END;
             }
 
-            /* Enter SEH to write back the values */
+            /* Enter SEH to write back the count */
             _SEH2_TRY
             {
-                /* Write the values to caller */
-                *ApcContext = Apc;
-                *KeyContext = Key;
-                *IoStatusBlock = IoStatus;
+                *NumEntriesRemoved = Removed;
             }
             _SEH2_EXCEPT(ExSystemExceptionFilter())
             {
@@ -431,10 +431,13 @@ IopDeviceFsIoControl(IN HANDLE DeviceHandle,
                     CompletionInfo = *(FileObject->CompletionContext);
                 }
 
-                /* If we had an event, signal it */
+                /* If we had an event, signal it, unless the caller asked not to */
                 if (Event)
                 {
-                    KeSetEvent(EventObject, IO_NO_INCREMENT, FALSE);
+                    if (!IopSkipSetFastIoEvent(FileObject, KernelIosb.Status))
+                    {
+                        KeSetEvent(EventObject, IO_NO_INCREMENT, FALSE);
+                    }
                     ObDereferenceObject(EventObject);
                 }
 
@@ -444,8 +447,9 @@ IopDeviceFsIoControl(IN HANDLE DeviceHandle,
                     IopUnlockFileObject(FileObject);
                 }
 
-                /* Set completion if required */
-                if (CompletionInfo.Port != NULL && UserApcContext != NULL)
+                /* Set completion if required, fast I/O never pends */
+                if (CompletionInfo.Port != NULL && UserApcContext != NULL &&
+                    !IopSkipCompletionPort(FileObject, KernelIosb.Status))
                 {
                     if (!NT_SUCCESS(IoSetIoCompletion(CompletionInfo.Port,
                                                       CompletionInfo.Key,
@@ -1026,6 +1030,91 @@ IopGetFileMode(IN PFILE_OBJECT FileObject)
     return Mode;
 }
 
+/*
+ * Sets the completion notification modes of a file object. They are only
+ * looked at by the I/O manager, so the driver isn't called, and once set
+ * they stay set for the lifetime of the file object.
+ */
+NTSTATUS
+NTAPI
+IopSetCompletionNotificationModes(IN HANDLE FileHandle,
+                                  OUT PIO_STATUS_BLOCK IoStatusBlock,
+                                  IN PVOID FileInformation,
+                                  IN ULONG Length,
+                                  IN KPROCESSOR_MODE PreviousMode)
+{
+    PFILE_OBJECT FileObject;
+    ULONG Flags, FileObjectFlags = 0;
+    NTSTATUS Status;
+    PAGED_CODE();
+
+    /* Validate the length */
+    if (Length < sizeof(FILE_IO_COMPLETION_NOTIFICATION_INFORMATION))
+    {
+        /* Invalid length */
+        return STATUS_INFO_LENGTH_MISMATCH;
+    }
+
+    /* Enter SEH for probing and capturing the flags */
+    _SEH2_TRY
+    {
+        if (PreviousMode != KernelMode)
+        {
+            /* Probe the I/O Status block and the information */
+            ProbeForWriteIoStatusBlock(IoStatusBlock);
+            ProbeForRead(FileInformation, Length, sizeof(ULONG));
+        }
+
+        Flags = ((PFILE_IO_COMPLETION_NOTIFICATION_INFORMATION)FileInformation)->Flags;
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        /* Return the exception code */
+        _SEH2_YIELD(return _SEH2_GetExceptionCode());
+    }
+    _SEH2_END;
+
+    /* Validate the flags */
+    if (Flags & ~(FILE_SKIP_COMPLETION_PORT_ON_SUCCESS |
+                  FILE_SKIP_SET_EVENT_ON_HANDLE |
+                  FILE_SKIP_SET_USER_EVENT_ON_FAST_IO))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Convert them to file object flags */
+    if (Flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS) FileObjectFlags |= FO_SKIP_COMPLETION_PORT;
+    if (Flags & FILE_SKIP_SET_EVENT_ON_HANDLE) FileObjectFlags |= FO_SKIP_SET_EVENT;
+    if (Flags & FILE_SKIP_SET_USER_EVENT_ON_FAST_IO) FileObjectFlags |= FO_SKIP_SET_FAST_IO;
+
+    /* Reference the Handle */
+    Status = ObReferenceObjectByHandle(FileHandle,
+                                       0,
+                                       IoFileObjectType,
+                                       PreviousMode,
+                                       (PVOID *)&FileObject,
+                                       NULL);
+    if (!NT_SUCCESS(Status)) return Status;
+
+    /* Requests in flight look at the flags without a lock */
+    InterlockedOr((PLONG)&FileObject->Flags, FileObjectFlags);
+    ObDereferenceObject(FileObject);
+
+    /* Enter SEH to write back the I/O Status block */
+    _SEH2_TRY
+    {
+        IoStatusBlock->Status = STATUS_SUCCESS;
+        IoStatusBlock->Information = 0;
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        /* Nothing to undo */
+    }
+    _SEH2_END;
+
+    return STATUS_SUCCESS;
+}
+
 /* PUBLIC FUNCTIONS **********************************************************/
 
 /*
@@ -1760,15 +1849,19 @@ NtLockFile(IN HANDLE FileHandle,
             }
             _SEH2_END;
 
-            /* If we had an event, signal it */
+            /* If we had an event, signal it, unless the caller asked not to */
             if (EventHandle)
             {
-                KeSetEvent(Event, IO_NO_INCREMENT, FALSE);
+                if (!IopSkipSetFastIoEvent(FileObject, KernelIosb.Status))
+                {
+                    KeSetEvent(Event, IO_NO_INCREMENT, FALSE);
+                }
                 ObDereferenceObject(Event);
             }
 
-            /* Set completion if required */
-            if (FileObject->CompletionContext != NULL && ApcContext != NULL)
+            /* Set completion if required, fast I/O never pends */
+            if (FileObject->CompletionContext != NULL && ApcContext != NULL &&
+                !IopSkipCompletionPort(FileObject, KernelIosb.Status))
             {
                 if (!NT_SUCCESS(IoSetIoCompletion(FileObject->CompletionContext->Port,
                                                   FileObject->CompletionContext->Key,
@@ -2957,6 +3050,16 @@ NtSetInformationFile(IN HANDLE FileHandle,
     PAGED_CODE();
     IOTRACE(IO_API_DEBUG, "FileHandle: %p\n", FileHandle);
 
+    /* The completion notification modes are handled here, without an IRP */
+    if (FileInformationClass == FileIoCompletionNotificationInformation)
+    {
+        return IopSetCompletionNotificationModes(FileHandle,
+                                                 IoStatusBlock,
+                                                 FileInformation,
+                                                 Length,
+                                                 PreviousMode);
+    }
+
     /* Check if we're called from user mode */
     if (PreviousMode != KernelMode)
     {
@@ -332,8 +332,13 @@ IopCompleteRequest(IN PKAPC Apc,
         (Irp->PendingReturned &&
          !IsIrpSynchronous(Irp, FileObject)))
     {
-        /* Get any information we need from the FO before we kill it */
-        if ((FileObject) && (FileObject->CompletionContext))
+        /*
+         * Get any information we need from the FO before we kill it. A
+         * request that didn't pend may have been asked not to queue a packet.
+         */
+        if ((FileObject) && (FileObject->CompletionContext) &&
+            ((Irp->PendingReturned) ||
+             !(IopSkipCompletionPort(FileObject, Irp->IoStatus.Status))))
         {
             /* Save Completion Data */
             Port = FileObject->CompletionContext->Port;
@@ -399,8 +404,11 @@ IopCompleteRequest(IN PKAPC Apc,
         }
         else if (FileObject)
         {
-            /* Signal the file object and set the status */
-            KeSetEvent(&FileObject->Event, 0, FALSE);
+            /* Signal the file object, unless it was asked not to, and set the status */
+            if (!IopSkipSetEvent(FileObject))
+            {
+                KeSetEvent(&FileObject->Event, 0, FALSE);
+            }
             FileObject->FinalStatus = Irp->IoStatus.Status;
 
             /*
@@ -86,6 +86,15 @@ KeZeroPages(IN PVOID Address,
     RtlZeroMemory(Address, Size);
 }
 
+VOID
+FASTCALL
+KeZeroPagesFromIdleThread(IN PVOID Address,
+                          IN ULONG Size)
+{
+    /* Nobody reads these pages soon, so keep them out of the caches */
+    KiZeroPagesNonTemporal(Address, Size);
+}
+
 PVOID
 NTAPI
 KeSwitchKernelStack(PVOID StackBase, PVOID StackLimit)
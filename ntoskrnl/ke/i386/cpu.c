@@ -1138,6 +1138,22 @@ KeZeroPages(IN PVOID Address,
     RtlZeroMemory(Address, Size);
 }
 
+VOID
+FASTCALL
+KeZeroPagesFromIdleThread(IN PVOID Address,
+                          IN ULONG Size)
+{
+    /* Nobody reads these pages soon, so keep them out of the caches */
+    if (KeFeatureBits & KF_XMMI64)
+    {
+        KiZeroPagesNonTemporal(Address, Size);
+    }
+    else
+    {
+        RtlZeroMemory(Address, Size);
+    }
+}
+
 VOID
 NTAPI
 KiSaveProcessorState(IN PKTRAP_FRAME TrapFrame,
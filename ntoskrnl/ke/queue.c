@@ -138,6 +138,15 @@ KiInsertQueue(IN PKQUEUE Queue,
     return InitialState;
 }
 
+static
+ULONG
+KiRemoveQueue(IN PKQUEUE Queue,
+              IN KPROCESSOR_MODE WaitMode,
+              IN BOOLEAN Alertable,
+              IN PLARGE_INTEGER Timeout OPTIONAL,
+              OUT PLIST_ENTRY *EntryArray,
+              IN ULONG Count);
+
 /* PUBLIC FUNCTIONS **********************************************************/
 
 /*
@@ -231,13 +240,20 @@ KeReadStateQueue(IN PKQUEUE Queue)
 }
 
 /*
- * @implemented
+ * Removes up to Count entries from the queue, waiting for the first one.
+ * The thread is charged once against the concurrency of the queue, however
+ * many entries it takes. If no entry could be removed, the first element of
+ * the array receives the wait status and 1 is returned, so callers handle it
+ * as they would the result of KeRemoveQueue.
  */
-PLIST_ENTRY
-NTAPI
-KeRemoveQueue(IN PKQUEUE Queue,
+static
+ULONG
+KiRemoveQueue(IN PKQUEUE Queue,
               IN KPROCESSOR_MODE WaitMode,
-              IN PLARGE_INTEGER Timeout OPTIONAL)
+              IN BOOLEAN Alertable,
+              IN PLARGE_INTEGER Timeout OPTIONAL,
+              OUT PLIST_ENTRY *EntryArray,
+              IN ULONG Count)
 {
     PLIST_ENTRY QueueEntry;
     LONG_PTR Status;
@@ -249,9 +265,9 @@ KeRemoveQueue(IN PKQUEUE Queue,
     BOOLEAN Swappable;
     PLARGE_INTEGER OriginalDueTime = Timeout;
     LARGE_INTEGER DueTime = {{0}}, NewDueTime, InterruptTime;
-    ULONG Hand = 0;
+    ULONG Hand = 0, Removed = 0;
     ASSERT_QUEUE(Queue);
-    ASSERT_IRQL_LESS_OR_EQUAL(DISPATCH_LEVEL);
+    ASSERT(Count != 0);
 
     /* Check if the Lock is already held */
     if (Thread->WaitNext)
@@ -267,6 +283,7 @@ KeRemoveQueue(IN PKQUEUE Queue,
         KxQueueThreadWait();
         KiAcquireDispatcherLockAtDpcLevel();
     }
+    Thread->Alertable = Alertable;
 
     /*
      * This is needed so that we can set the new queue right here,
@@ -306,27 +323,35 @@ KeRemoveQueue(IN PKQUEUE Queue,
         if ((Queue->CurrentCount < Queue->MaximumCount) &&
             (QueueEntry != &Queue->EntryListHead))
         {
-            /* Decrease the number of entries */
-            Queue->Header.SignalState--;
-
             /* Increase numbef of running threads */
             Queue->CurrentCount++;
 
-            /* Check if the entry is valid. If not, bugcheck */
-            if (!(QueueEntry->Flink) || !(QueueEntry->Blink))
+            /* Take as many entries as we were asked for, without waiting again */
+            do
             {
-                /* Invalid item */
-                KeBugCheckEx(INVALID_WORK_QUEUE_ITEM,
-                             (ULONG_PTR)QueueEntry,
-                             (ULONG_PTR)Queue,
-                             (ULONG_PTR)NULL,
-                             (ULONG_PTR)((PWORK_QUEUE_ITEM)QueueEntry)->
-                                         WorkerRoutine);
-            }
+                /* Decrease the number of entries */
+                Queue->Header.SignalState--;
 
-            /* Remove the Entry */
-            RemoveEntryList(QueueEntry);
-            QueueEntry->Flink = NULL;
+                /* Check if the entry is valid. If not, bugcheck */
+                if (!(QueueEntry->Flink) || !(QueueEntry->Blink))
+                {
+                    /* Invalid item */
+                    KeBugCheckEx(INVALID_WORK_QUEUE_ITEM,
+                                 (ULONG_PTR)QueueEntry,
+                                 (ULONG_PTR)Queue,
+                                 (ULONG_PTR)NULL,
+                                 (ULONG_PTR)((PWORK_QUEUE_ITEM)QueueEntry)->
+                                             WorkerRoutine);
+                }
+
+                /* Remove the Entry */
+                RemoveEntryList(QueueEntry);
+                QueueEntry->Flink = NULL;
+                EntryArray[Removed++] = QueueEntry;
+
+                /* Get the next one */
+                QueueEntry = Queue->EntryListHead.Flink;
+            } while ((Removed < Count) && (QueueEntry != &Queue->EntryListHead));
 
             /* Nothing to wait on */
             break;
@@ -344,12 +369,12 @@ KeRemoveQueue(IN PKQUEUE Queue,
             }
             else
             {
-                /* Fail if there's a User APC Pending */
-                if ((WaitMode != KernelMode) &&
-                    (Thread->ApcState.UserApcPending))
+                /* Fail if we were alerted or if there's a User APC Pending */
+                Status = KiCheckAlertability(Thread, Alertable, WaitMode);
+                if (Status != STATUS_WAIT_0)
                 {
                     /* Return the status and increase the pending threads */
-                    QueueEntry = (PLIST_ENTRY)STATUS_USER_APC;
+                    EntryArray[Removed++] = (PLIST_ENTRY)Status;
                     Queue->CurrentCount++;
                     break;
                 }
@@ -362,7 +387,7 @@ KeRemoveQueue(IN PKQUEUE Queue,
                     if ((ULONG64)InterruptTime.QuadPart >= Timer->DueTime.QuadPart)
                     {
                         /* It did, so we don't need to wait */
-                        QueueEntry = (PLIST_ENTRY)STATUS_TIMEOUT;
+                        EntryArray[Removed++] = (PLIST_ENTRY)STATUS_TIMEOUT;
                         Queue->CurrentCount++;
                         break;
                     }
@@ -403,8 +428,15 @@ KeRemoveQueue(IN PKQUEUE Queue,
                 /* Reset the wait reason */
                 Thread->WaitReason = 0;
 
-                /* Check if we were executing an APC */
-                if (Status != STATUS_KERNEL_APC) return (PLIST_ENTRY)Status;
+                /*
+                 * Check if we were executing an APC. If not, we were either
+                 * handed an entry by KiInsertQueue, or the wait failed.
+                 */
+                if (Status != STATUS_KERNEL_APC)
+                {
+                    EntryArray[0] = (PLIST_ENTRY)Status;
+                    return 1;
+                }
 
                 /* Check if we had a timeout */
                 if (Timeout)
@@ -419,6 +451,7 @@ KeRemoveQueue(IN PKQUEUE Queue,
             /* Start another wait */
             Thread->WaitIrql = KeRaiseIrqlToSynchLevel();
             KxQueueThreadWait();
+            Thread->Alertable = Alertable;
             KiAcquireDispatcherLockAtDpcLevel();
             Queue->CurrentCount--;
         }
@@ -427,9 +460,44 @@ KeRemoveQueue(IN PKQUEUE Queue,
     /* Unlock Database and return */
     KiReleaseDispatcherLockFromDpcLevel();
     KiExitDispatcher(Thread->WaitIrql);
+    return Removed;
+}
+
+/*
+ * @implemented
+ */
+PLIST_ENTRY
+NTAPI
+KeRemoveQueue(IN PKQUEUE Queue,
+              IN KPROCESSOR_MODE WaitMode,
+              IN PLARGE_INTEGER Timeout OPTIONAL)
+{
+    PLIST_ENTRY QueueEntry;
+    ASSERT_IRQL_LESS_OR_EQUAL(DISPATCH_LEVEL);
+
+    /* Take a single entry, the wait can only be broken by user APCs */
+    KiRemoveQueue(Queue, WaitMode, FALSE, Timeout, &QueueEntry, 1);
     return QueueEntry;
 }
 
+/*
+ * @implemented
+ *
+ * Returns the number of entries written to EntryArray
+ */
+ULONG
+NTAPI
+KeRemoveQueueEx(IN PKQUEUE Queue,
+                IN KPROCESSOR_MODE WaitMode,
+                IN BOOLEAN Alertable,
+                IN PLARGE_INTEGER Timeout OPTIONAL,
+                OUT PLIST_ENTRY *EntryArray,
+                IN ULONG Count)
+{
+    ASSERT_IRQL_LESS_OR_EQUAL(DISPATCH_LEVEL);
+    return KiRemoveQueue(Queue, WaitMode, Alertable, Timeout, EntryArray, Count);
+}
+
 /*
  * @implemented
  */
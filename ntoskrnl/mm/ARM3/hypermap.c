@@ -110,7 +110,8 @@ MiUnmapPageInHyperSpace(IN PEPROCESS Process,
 
 PVOID
 NTAPI
-MiMapPagesInZeroSpace(IN PMMPFN Pfn1,
+MiMapPagesInZeroSpace(IN PMMPTE ZeroingPte,
+                      IN PMMPFN Pfn1,
                       IN PFN_NUMBER NumberOfPages)
 {
     MMPTE TempPte;
@@ -125,9 +126,9 @@ MiMapPagesInZeroSpace(IN PMMPFN Pfn1,
     ASSERT(NumberOfPages <= (MI_ZERO_PTES - 1));
 
     //
-    // Pick the first zeroing PTE
+    // Pick the first zeroing PTE of the calling zero page thread
     //
-    PointerPte = MiFirstReservedZeroingPte;
+    PointerPte = ZeroingPte;
 
     //
     // Now get the first free PTE
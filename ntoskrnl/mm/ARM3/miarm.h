@@ -649,6 +649,11 @@ extern PMMPTE MmSharedUserDataPte;
 extern LIST_ENTRY MmProcessList;
 extern BOOLEAN MmZeroingPageThreadActive;
 extern KEVENT MmZeroingPageEvent;
+extern ULONG MmZeroPageThreadPerProcessor;
+extern ULONG MmZeroPageThreadPages;
+extern ULONGLONG MmZeroPageThreadTime;
+extern ULONG MmZeroPageDemandHits;
+extern ULONG MmZeroPageDemandMisses;
 extern ULONG MmSystemPageColor;
 extern ULONG MmProcessColorSeed;
 extern PMMWSL MmWorkingSetList;
@@ -1575,6 +1575,10 @@ MmDumpArmPfnDatabase(IN BOOLEAN StatusOnly)
     DbgPrint("Free:                 %5d pages\t[%6d KB]\n", FreePages,    (FreePages      << PAGE_SHIFT) / 1024);
     DbgPrint("Other:                %5d pages\t[%6d KB]\n", OtherPages,   (OtherPages     << PAGE_SHIFT) / 1024);
     DbgPrint("-----------------------------------------\n");
+    DbgPrint("Zeroed by thread:     %5d pages\t[%6I64u pages/s]\n", MmZeroPageThreadPages,
+             MmZeroPageThreadTime ? MmZeroPageThreadPages * 10000000ULL / MmZeroPageThreadTime : 0);
+    DbgPrint("Zero page demand:     %5d hits\t[%6d zeroed on demand]\n", MmZeroPageDemandHits, MmZeroPageDemandMisses);
+    DbgPrint("-----------------------------------------\n");
 #if MI_TRACE_PFNS
     OtherPages = UsageBucket[MI_USAGE_BOOT_DRIVER];
     DbgPrint("Boot Images:          %5d pages\t[%6d KB]\n", OtherPages,   (OtherPages     << PAGE_SHIFT) / 1024);
@@ -17,8 +17,18 @@
 
 /* GLOBALS ********************************************************************/
 
+/* Pages taken off the free list and zeroed together, two batches per TB flush */
+#define MI_ZERO_PAGE_BATCH  ((MI_ZERO_PTES - 1) / 2)
+
 BOOLEAN MmZeroingPageThreadActive;
 KEVENT MmZeroingPageEvent;
+ULONG MmZeroPageThreadPerProcessor;
+
+/* Statistics, all protected by the PFN lock */
+ULONG MmZeroPageThreadPages;
+ULONGLONG MmZeroPageThreadTime;
+ULONG MmZeroPageDemandHits;
+ULONG MmZeroPageDemandMisses;
 
 /* PRIVATE FUNCTIONS **********************************************************/
 
@@ -32,26 +42,16 @@ NTAPI
 MiFreeInitializationCode(IN PVOID StartVa,
 IN PVOID EndVa);
 
+static
 VOID
-NTAPI
-MmZeroPageThread(VOID)
+MiZeroPageLoop(IN PMMPTE ZeroingPte)
 {
-    PKTHREAD Thread = KeGetCurrentThread();
-    PVOID StartAddress, EndAddress;
     PVOID WaitObjects[2];
     KIRQL OldIrql;
     PVOID ZeroAddress;
-    PFN_NUMBER PageIndex, FreePage;
-    PMMPFN Pfn1;
-
-    /* Get the discardable sections to free them */
-    MiFindInitializationCode(&StartAddress, &EndAddress);
-    if (StartAddress) MiFreeInitializationCode(StartAddress, EndAddress);
-    DPRINT("Free non-cache pages: %lx\n", MmAvailablePages + MiMemoryConsumers[MC_CACHE].PagesUsed);
-
-    /* Set our priority to 0 */
-    Thread->BasePriority = 0;
-    KeSetPriorityThread(Thread, 0);
+    PFN_NUMBER PageIndex, FreePage, PageCount;
+    PMMPFN Pfn1, FirstPfn, NextPfn;
+    ULONGLONG StartTime;
 
     /* Setup the wait objects */
     WaitObjects[0] = &MmZeroingPageEvent;
@@ -79,36 +79,148 @@ MmZeroPageThread(VOID)
                 break;
             }
 
-            PageIndex = MmFreePageListHead.Flink;
-            ASSERT(PageIndex != LIST_HEAD);
-            Pfn1 = MiGetPfnEntry(PageIndex);
-            MI_SET_USAGE(MI_USAGE_ZERO_LOOP);
-            MI_SET_PROCESS2("Kernel 0 Loop");
-            FreePage = MiRemoveAnyPage(MI_GET_PAGE_COLOR(PageIndex));
+            /* Take a batch of pages, chained through their Flink for the mapping */
+            FirstPfn = (PMMPFN)LIST_HEAD;
+            for (PageCount = 0;
+                 (PageCount < MI_ZERO_PAGE_BATCH) && (MmFreePageListHead.Total);
+                 PageCount++)
+            {
+                PageIndex = MmFreePageListHead.Flink;
+                ASSERT(PageIndex != LIST_HEAD);
+                Pfn1 = MiGetPfnEntry(PageIndex);
+                MI_SET_USAGE(MI_USAGE_ZERO_LOOP);
+                MI_SET_PROCESS2("Kernel 0 Loop");
+                FreePage = MiRemoveAnyPage(MI_GET_PAGE_COLOR(PageIndex));
+
+                /* The first global free page should also be the first on its own list */
+                if (FreePage != PageIndex)
+                {
+                    KeBugCheckEx(PFN_LIST_CORRUPT,
+                                 0x8F,
+                                 FreePage,
+                                 PageIndex,
+                                 0);
+                }
+
+                Pfn1->u1.Flink = (ULONG_PTR)FirstPfn;
+                FirstPfn = Pfn1;
+            }
 
-            /* The first global free page should also be the first on its own list */
-            if (FreePage != PageIndex)
+            /* Let another zero page thread take the next batch, if there is one */
+            if ((MmFreePageListHead.Total >= MI_ZERO_PAGE_BATCH) &&
+                (MmZeroPageThreadPerProcessor))
             {
-                KeBugCheckEx(PFN_LIST_CORRUPT,
-                             0x8F,
-                             FreePage,
-                             PageIndex,
-                             0);
+                KeSetEvent(&MmZeroingPageEvent, IO_NO_INCREMENT, FALSE);
             }
 
-            Pfn1->u1.Flink = LIST_HEAD;
             MiReleasePfnLock(OldIrql);
 
-            ZeroAddress = MiMapPagesInZeroSpace(Pfn1, 1);
+            StartTime = KeQueryInterruptTime();
+            ZeroAddress = MiMapPagesInZeroSpace(ZeroingPte, FirstPfn, PageCount);
             ASSERT(ZeroAddress);
-            RtlZeroMemory(ZeroAddress, PAGE_SIZE);
-            MiUnmapPagesInZeroSpace(ZeroAddress, 1);
+            KeZeroPagesFromIdleThread(ZeroAddress, (ULONG)(PageCount << PAGE_SHIFT));
+            MiUnmapPagesInZeroSpace(ZeroAddress, PageCount);
 
             OldIrql = MiAcquirePfnLock();
 
-            MiInsertPageInList(&MmZeroedPageListHead, PageIndex);
+            MmZeroPageThreadPages += (ULONG)PageCount;
+            MmZeroPageThreadTime += KeQueryInterruptTime() - StartTime;
+
+            while (FirstPfn != (PMMPFN)LIST_HEAD)
+            {
+                NextPfn = (PMMPFN)FirstPfn->u1.Flink;
+                MiInsertPageInList(&MmZeroedPageListHead, MiGetPfnEntryIndex(FirstPfn));
+                FirstPfn = NextPfn;
+            }
         }
     }
 }
 
+static
+VOID
+NTAPI
+MiZeroPageThreadForProcessor(IN PVOID Context)
+{
+    PKTHREAD Thread = KeGetCurrentThread();
+    CCHAR Processor = (CCHAR)(ULONG_PTR)Context;
+    PMMPTE ZeroingPte;
+
+    /* The zeroing PTEs are only flushed from the TB of this processor */
+    KeSetSystemAffinityThread(KiProcessorBlock[Processor]->SetMember);
+
+    /* Set our priority to 0 */
+    Thread->BasePriority = 0;
+    KeSetPriorityThread(Thread, 0);
+
+    /* Reserve our own zeroing PTEs, with the counter set to maximum */
+    ZeroingPte = MiReserveSystemPtes(MI_ZERO_PTES, SystemPteSpace);
+    if (!ZeroingPte)
+    {
+        DPRINT1("No zeroing PTEs for processor %d\n", Processor);
+        PsTerminateSystemThread(STATUS_INSUFFICIENT_RESOURCES);
+    }
+    RtlZeroMemory(ZeroingPte, MI_ZERO_PTES * sizeof(MMPTE));
+    ZeroingPte->u.Hard.PageFrameNumber = MI_ZERO_PTES - 1;
+
+    MiZeroPageLoop(ZeroingPte);
+}
+
+static
+VOID
+MiCreateZeroPageThreads(VOID)
+{
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    HANDLE ThreadHandle;
+    NTSTATUS Status;
+    CCHAR Processor;
+
+    /* The first thread stays on the boot processor, with the first zeroing PTEs */
+    KeSetSystemAffinityThread(KiProcessorBlock[0]->SetMember);
+
+    InitializeObjectAttributes(&ObjectAttributes, NULL, 0, NULL, NULL);
+    for (Processor = 1; Processor < KeNumberProcessors; Processor++)
+    {
+        Status = PsCreateSystemThread(&ThreadHandle,
+                                      THREAD_ALL_ACCESS,
+                                      &ObjectAttributes,
+                                      NULL,
+                                      NULL,
+                                      MiZeroPageThreadForProcessor,
+                                      (PVOID)(ULONG_PTR)Processor);
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("Failed to create the zero page thread of processor %d: 0x%lx\n",
+                    Processor, Status);
+            break;
+        }
+
+        ZwClose(ThreadHandle);
+    }
+}
+
+VOID
+NTAPI
+MmZeroPageThread(VOID)
+{
+    PKTHREAD Thread = KeGetCurrentThread();
+    PVOID StartAddress, EndAddress;
+
+    /* Get the discardable sections to free them */
+    MiFindInitializationCode(&StartAddress, &EndAddress);
+    if (StartAddress) MiFreeInitializationCode(StartAddress, EndAddress);
+    DPRINT("Free non-cache pages: %lx\n", MmAvailablePages + MiMemoryConsumers[MC_CACHE].PagesUsed);
+
+    /* Set our priority to 0 */
+    Thread->BasePriority = 0;
+    KeSetPriorityThread(Thread, 0);
+
+    /* Zero pages on every processor, if asked to */
+    if ((MmZeroPageThreadPerProcessor) && (KeNumberProcessors > 1))
+    {
+        MiCreateZeroPageThreads();
+    }
+
+    MiZeroPageLoop(MiFirstReservedZeroingPte);
+}
+
 /* EOF */
@@ -20,8 +20,78 @@
 BOOLEAN ObpLUIDDeviceMapsEnabled;
 POBJECT_TYPE ObpDirectoryObjectType = NULL;
 
+/*
+ * Directories start with the NUMBER_HASH_BUCKETS buckets embedded in them.
+ * Once they hold more than OBP_DIRECTORY_LOAD_FACTOR entries per bucket,
+ * their entries move to an allocated table of the next size.
+ */
+#define OBP_DIRECTORY_LOAD_FACTOR   4
+static const ULONG ObpDirectoryBucketCounts[] = { 149, 607, 2423, 9719, 38891 };
+
 /* PRIVATE FUNCTIONS ******************************************************/
 
+static
+POBJECT_DIRECTORY_ENTRY *
+ObpGetDirectoryBuckets(IN POBJECT_DIRECTORY Directory,
+                       OUT PULONG BucketCount)
+{
+    /* Check if the directory outgrew its own buckets */
+    if (Directory->ExtendedBuckets)
+    {
+        *BucketCount = Directory->ExtendedBucketCount;
+        return Directory->ExtendedBuckets;
+    }
+
+    *BucketCount = NUMBER_HASH_BUCKETS;
+    return Directory->HashBuckets;
+}
+
+static
+VOID
+ObpExpandDirectory(IN POBJECT_DIRECTORY Directory)
+{
+    POBJECT_DIRECTORY_ENTRY *OldBuckets, *NewBuckets;
+    POBJECT_DIRECTORY_ENTRY Entry, NextEntry;
+    ULONG OldCount, NewCount, Hash, i;
+
+    /* Find the next table size, unless the directory has the biggest one */
+    OldBuckets = ObpGetDirectoryBuckets(Directory, &OldCount);
+    for (i = 0; i < RTL_NUMBER_OF(ObpDirectoryBucketCounts); i++)
+    {
+        if (ObpDirectoryBucketCounts[i] > OldCount) break;
+    }
+    if (i == RTL_NUMBER_OF(ObpDirectoryBucketCounts)) return;
+    NewCount = ObpDirectoryBucketCounts[i];
+
+    /* Allocate the new table; if we can't, keep using the current one */
+    NewBuckets = ExAllocatePoolWithTag(PagedPool,
+                                       NewCount * sizeof(POBJECT_DIRECTORY_ENTRY),
+                                       OB_DIR_TAG);
+    if (!NewBuckets) return;
+    RtlZeroMemory(NewBuckets, NewCount * sizeof(POBJECT_DIRECTORY_ENTRY));
+
+    /* Move every entry to its new bucket */
+    for (Hash = 0; Hash < OldCount; Hash++)
+    {
+        for (Entry = OldBuckets[Hash]; Entry; Entry = NextEntry)
+        {
+            NextEntry = Entry->ChainLink;
+            Entry->ChainLink = NewBuckets[Entry->HashValue % NewCount];
+            NewBuckets[Entry->HashValue % NewCount] = Entry;
+        }
+        OldBuckets[Hash] = NULL;
+    }
+
+    /* Free the previous table, unless it was the embedded one */
+    if (Directory->ExtendedBuckets)
+    {
+        ExFreePoolWithTag(Directory->ExtendedBuckets, OB_DIR_TAG);
+    }
+
+    Directory->ExtendedBuckets = NewBuckets;
+    Directory->ExtendedBucketCount = NewCount;
+}
+
 /*++
 * @name ObpInsertEntryDirectory
 *
@@ -48,8 +118,10 @@ ObpInsertEntryDirectory(IN POBJECT_DIRECTORY Parent,
                         IN POBJECT_HEADER ObjectHeader)
 {
     POBJECT_DIRECTORY_ENTRY *AllocatedEntry;
+    POBJECT_DIRECTORY_ENTRY *Buckets;
     POBJECT_DIRECTORY_ENTRY NewEntry;
     POBJECT_HEADER_NAME_INFO HeaderNameInfo;
+    ULONG BucketCount;
 
     /* Make sure we have a name */
     ASSERT(ObjectHeader->NameInfoOffset != 0);
@@ -78,8 +150,17 @@ ObpInsertEntryDirectory(IN POBJECT_DIRECTORY Parent,
     /* Get the Object Name Information */
     HeaderNameInfo = OBJECT_HEADER_TO_NAME_INFO(ObjectHeader);
 
+    /* Grow the hash table if the directory got too crowded */
+    ObpGetDirectoryBuckets(Parent, &BucketCount);
+    if (++Parent->EntryCount > BucketCount * OBP_DIRECTORY_LOAD_FACTOR)
+    {
+        ObpExpandDirectory(Parent);
+    }
+
     /* Get the Allocated entry */
-    AllocatedEntry = &Parent->HashBuckets[Context->HashIndex];
+    Buckets = ObpGetDirectoryBuckets(Parent, &BucketCount);
+    Context->HashIndex = (USHORT)(Context->HashValue % BucketCount);
+    AllocatedEntry = &Buckets[Context->HashIndex];
 
     /* Set it */
     NewEntry->ChainLink = *AllocatedEntry;
@@ -131,8 +212,10 @@ ObpLookupEntryDirectory(IN POBJECT_DIRECTORY Directory,
     POBJECT_HEADER ObjectHeader;
     ULONG HashValue;
     ULONG HashIndex;
+    ULONG BucketCount;
     LONG TotalChars;
     WCHAR CurrentChar;
+    POBJECT_DIRECTORY_ENTRY *Buckets;
     POBJECT_DIRECTORY_ENTRY *AllocatedEntry;
     POBJECT_DIRECTORY_ENTRY *LookupBucket;
     POBJECT_DIRECTORY_ENTRY CurrentEntry;
@@ -162,8 +245,12 @@ ObpLookupEntryDirectory(IN POBJECT_DIRECTORY Directory,
         /* Go to the next Character */
         CurrentChar = *Buffer++;
 
-        /* Prepare the Hash */
-        HashValue += (HashValue << 1) + (HashValue >> 1);
+        /*
+         * Prepare the Hash. This is the X65599 hash of RtlHashUnicodeString:
+         * names that only differ by a few trailing digits, which are common
+         * in large directories, would mostly collide with a weaker one.
+         */
+        HashValue *= 65599;
 
         /* Create the rest based on the name */
         if (CurrentChar < 'a') HashValue += CurrentChar;
@@ -171,24 +258,25 @@ ObpLookupEntryDirectory(IN POBJECT_DIRECTORY Directory,
         else HashValue += (CurrentChar - ('a'-'A'));
     }
 
-    /* Merge it with our number of hash buckets */
-    HashIndex = HashValue % 37;
+    /* Check if the directory is already locked */
+    if (!Context->DirectoryLocked)
+    {
+        /* Lock it */
+        ObpAcquireDirectoryLockShared(Directory, Context);
+    }
+
+    /* Merge it with our number of hash buckets, which the lock keeps stable */
+    Buckets = ObpGetDirectoryBuckets(Directory, &BucketCount);
+    HashIndex = HashValue % BucketCount;
 
     /* Save the result */
     Context->HashValue = HashValue;
     Context->HashIndex = (USHORT)HashIndex;
 
     /* Get the root entry and set it as our lookup bucket */
-    AllocatedEntry = &Directory->HashBuckets[HashIndex];
+    AllocatedEntry = &Buckets[HashIndex];
     LookupBucket = AllocatedEntry;
 
-    /* Check if the directory is already locked */
-    if (!Context->DirectoryLocked)
-    {
-        /* Lock it */
-        ObpAcquireDirectoryLockShared(Directory, Context);
-    }
-
     /* Start looping */
     while ((CurrentEntry = *AllocatedEntry))
     {
@@ -312,18 +400,20 @@ ObpDeleteEntryDirectory(POBP_LOOKUP_CONTEXT Context)
     POBJECT_DIRECTORY Directory;
     POBJECT_DIRECTORY_ENTRY *AllocatedEntry;
     POBJECT_DIRECTORY_ENTRY CurrentEntry;
+    ULONG BucketCount;
 
     /* Get the Directory */
     Directory = Context->Directory;
     if (!Directory) return FALSE;
 
     /* Get the Entry */
-    AllocatedEntry = &Directory->HashBuckets[Context->HashIndex];
+    AllocatedEntry = &ObpGetDirectoryBuckets(Directory, &BucketCount)[Context->HashIndex];
     CurrentEntry = *AllocatedEntry;
 
     /* Unlink the Entry */
     *AllocatedEntry = CurrentEntry->ChainLink;
     CurrentEntry->ChainLink = NULL;
+    Directory->EntryCount--;
 
     /* Free it */
     ExFreePoolWithTag(CurrentEntry, OB_DIR_TAG);
@@ -332,6 +422,35 @@ ObpDeleteEntryDirectory(POBP_LOOKUP_CONTEXT Context)
     return TRUE;
 }
 
+/*++
+* @name ObpDeleteDirectory
+*
+*     The ObpDeleteDirectory routine frees the hash table that a directory
+*     allocated when it grew.
+*
+* @param Object
+*        Directory object being deleted.
+*
+* @return None.
+*
+* @remarks The directory is empty, since its entries reference it.
+*
+*--*/
+VOID
+NTAPI
+ObpDeleteDirectory(IN PVOID Object)
+{
+    POBJECT_DIRECTORY Directory = Object;
+
+    /* Free the extended hash table, if any */
+    ASSERT(Directory->EntryCount == 0);
+    if (Directory->ExtendedBuckets)
+    {
+        ExFreePoolWithTag(Directory->ExtendedBuckets, OB_DIR_TAG);
+        Directory->ExtendedBuckets = NULL;
+    }
+}
+
 /* FUNCTIONS **************************************************************/
 
 /*++
@@ -469,7 +588,8 @@ NtQueryDirectoryObject(IN HANDLE DirectoryHandle,
     POBJECT_DIRECTORY_INFORMATION DirectoryInfo;
     ULONG Length, TotalLength;
     ULONG Count, CurrentEntry;
-    ULONG Hash;
+    ULONG Hash, BucketCount;
+    POBJECT_DIRECTORY_ENTRY *Buckets;
     POBJECT_DIRECTORY_ENTRY Entry;
     POBJECT_HEADER ObjectHeader;
     POBJECT_HEADER_NAME_INFO ObjectNameInfo;
@@ -544,10 +664,11 @@ NtQueryDirectoryObject(IN HANDLE DirectoryHandle,
 
     /* Set default status and start looping */
     Status = STATUS_NO_MORE_ENTRIES;
-    for (Hash = 0; Hash < 37; Hash++)
+    Buckets = ObpGetDirectoryBuckets(Directory, &BucketCount);
+    for (Hash = 0; Hash < BucketCount; Hash++)
     {
         /* Get this entry and loop all of them */
-        Entry = Directory->HashBuckets[Hash];
+        Entry = Buckets[Hash];
         while (Entry)
         {
             /* Check if we should process this entry */
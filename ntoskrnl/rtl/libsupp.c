@@ -15,9 +15,17 @@
 
 #define TAG_ATMT 'TotA' /* Atom table */
 #define TAG_RTHL 'LHtR' /* Heap Lock */
+#define TAG_RTWI 'IWtR' /* Work Item */
 
 extern ULONG NtGlobalFlag;
 
+typedef struct _RTLP_WORK_ITEM
+{
+    WORK_QUEUE_ITEM WorkItem;
+    PWORKER_THREAD_ROUTINE Function;
+    PVOID Context;
+} RTLP_WORK_ITEM, *PRTLP_WORK_ITEM;
+
 typedef struct _RTL_RANGE_ENTRY
 {
     LIST_ENTRY Entry;
@@ -97,6 +105,42 @@ RtlpGetMode(VOID)
    return KernelMode;
 }
 
+ULONG
+NTAPI
+RtlpGetNumberOfProcessors(VOID)
+{
+    return KeNumberProcessors;
+}
+
+static
+VOID
+NTAPI
+RtlpWorkItemRoutine(IN PVOID Parameter)
+{
+    PRTLP_WORK_ITEM Item = Parameter;
+
+    Item->Function(Item->Context);
+    ExFreePoolWithTag(Item, TAG_RTWI);
+}
+
+BOOLEAN
+NTAPI
+RtlpQueueWorkItem(IN PWORKER_THREAD_ROUTINE Function,
+                  IN PVOID Context)
+{
+    PRTLP_WORK_ITEM Item;
+
+    Item = ExAllocatePoolWithTag(NonPagedPool, sizeof(RTLP_WORK_ITEM), TAG_RTWI);
+    if (!Item)
+        return FALSE;
+
+    Item->Function = Function;
+    Item->Context = Context;
+    ExInitializeWorkItem(&Item->WorkItem, RtlpWorkItemRoutine, Item);
+    ExQueueWorkItem(&Item->WorkItem, DelayedWorkQueue);
+    return TRUE;
+}
+
 PVOID
 NTAPI
 RtlpAllocateMemory(ULONG Bytes,
@@ -422,6 +422,11 @@ typedef struct _OBJECT_DIRECTORY
     USHORT Reserved;
     USHORT SymbolicLinkUsageCount;
 #endif
+#ifdef __REACTOS__
+    struct _OBJECT_DIRECTORY_ENTRY **ExtendedBuckets;
+    ULONG ExtendedBucketCount;
+    ULONG EntryCount;
+#endif
 } OBJECT_DIRECTORY, *POBJECT_DIRECTORY;
 
 //
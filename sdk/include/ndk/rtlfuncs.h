@@ -994,7 +994,7 @@ RtlLockHeap(
 
 _Must_inspect_result_
 NTSYSAPI
-NTSTATUS
+ULONG
 NTAPI
 RtlMultipleAllocateHeap (
     _In_ HANDLE HeapHandle,
@@ -1005,7 +1005,7 @@ RtlMultipleAllocateHeap (
     );
 
 NTSYSAPI
-NTSTATUS
+ULONG
 NTAPI
 RtlMultipleFreeHeap (
     _In_ HANDLE HeapHandle,
@@ -106,6 +106,9 @@
 
 #define FAST486_PAGE_SIZE 4096
 #define FAST486_CACHE_SIZE 32
+#define FAST486_TLB_ENTRIES 256
+#define FAST486_CODE_CACHE_ENTRIES 4096
+#define FAST486_CODE_CACHE_PAGES 64
 
 /*
  * These are condiciones sine quibus non that should be respected, because
@@ -116,6 +119,13 @@
 C_ASSERT((FAST486_CACHE_SIZE >= sizeof(ULONG))
          && (FAST486_CACHE_SIZE <= FAST486_PAGE_SIZE));
 
+/* The TLB is indexed with a mask */
+C_ASSERT((FAST486_TLB_ENTRIES & (FAST486_TLB_ENTRIES - 1)) == 0);
+
+/* So is the decoded instruction cache */
+C_ASSERT((FAST486_CODE_CACHE_ENTRIES & (FAST486_CODE_CACHE_ENTRIES - 1)) == 0);
+C_ASSERT((FAST486_CODE_CACHE_PAGES & (FAST486_CODE_CACHE_PAGES - 1)) == 0);
+
 struct _FAST486_STATE;
 typedef struct _FAST486_STATE FAST486_STATE, *PFAST486_STATE;
 
@@ -511,6 +521,50 @@ typedef union _FAST486_FPU_CONTROL_REG
     };
 } FAST486_FPU_CONTROL_REG, *PFAST486_FPU_CONTROL_REG;
 
+/*
+ * A TLB entry is only valid if it was filled in the current generation,
+ * so that the whole TLB can be flushed by starting a new one.
+ */
+typedef struct _FAST486_TLB_ENTRY
+{
+    ULONG Generation;
+    ULONG VirtualPage;
+    ULONG Value;
+} FAST486_TLB_ENTRY, *PFAST486_TLB_ENTRY;
+
+typedef struct _FAST486_TLB
+{
+    ULONG Generation;
+    FAST486_TLB_ENTRY Entries[FAST486_TLB_ENTRIES];
+} FAST486_TLB, *PFAST486_TLB;
+
+/*
+ * The decoded instruction cache keeps the prefixes and the opcode of the
+ * instructions executed at a linear address, so that running them again
+ * only takes a call to the opcode handler. It is only used while paging
+ * is off, when linear addresses are physical ones. As in the TLB, entries
+ * are only valid if they were filled in the current generation.
+ */
+typedef struct _FAST486_CODE_ENTRY
+{
+    ULONG Generation;
+    ULONG Address;
+    UCHAR Opcode;
+    UCHAR Length;
+    UCHAR PrefixFlags;
+    UCHAR SegmentOverride;
+} FAST486_CODE_ENTRY, *PFAST486_CODE_ENTRY;
+
+typedef struct _FAST486_CODE_CACHE
+{
+    ULONG Generation;
+
+    /* The generation in which code was last decoded in the pages of each slot */
+    ULONG Pages[FAST486_CODE_CACHE_PAGES];
+
+    FAST486_CODE_ENTRY Entries[FAST486_CODE_CACHE_ENTRIES];
+} FAST486_CODE_CACHE, *PFAST486_CODE_CACHE;
+
 struct _FAST486_STATE
 {
     FAST486_MEM_READ_PROC MemReadCallback;
@@ -537,8 +591,8 @@ struct _FAST486_STATE
     BOOLEAN Halted;
     BOOLEAN IntSignaled;
     BOOLEAN DoNotInterrupt;
-    PULONG Tlb;
-    BOOLEAN TlbEmpty;
+    PFAST486_TLB Tlb;
+    PFAST486_CODE_CACHE CodeCache;
 #ifndef FAST486_NO_PREFETCH
     BOOLEAN PrefetchValid;
     ULONG PrefetchAddress;
@@ -568,7 +622,8 @@ Fast486Initialize(PFAST486_STATE         State,
                   FAST486_BOP_PROC       BopCallback,
                   FAST486_INT_ACK_PROC   IntAckCallback,
                   FAST486_FPU_PROC       FpuCallback,
-                  PULONG                 Tlb);
+                  PFAST486_TLB           Tlb,
+                  PFAST486_CODE_CACHE    CodeCache);
 
 VOID
 NTAPI
@@ -619,6 +674,10 @@ VOID
 NTAPI
 Fast486Rewind(PFAST486_STATE State);
 
+VOID
+NTAPI
+Fast486InvalidateCodeCache(PFAST486_STATE State, ULONG Address, ULONG Size);
+
 #endif // _FAST486_H_
 
 /* EOF */
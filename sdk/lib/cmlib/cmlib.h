@@ -110,6 +110,12 @@
         IN ULONG NumberToFind,
         IN ULONG HintIndex);
 
+    ULONG NTAPI
+    RtlFindNextForwardRunSet(
+        IN PRTL_BITMAP BitMapHeader,
+        IN ULONG FromIndex,
+        OUT PULONG StartingRunIndex);
+
     VOID NTAPI
     RtlSetBits(
         IN PRTL_BITMAP BitMapHeader,
@@ -448,6 +454,10 @@ BOOLEAN CMAPI
 HvWriteHive(
    PHHIVE RegistryHive);
 
+BOOLEAN CMAPI
+HvLogHive(
+   PHHIVE RegistryHive);
+
 BOOLEAN
 CMAPI
 HvTrackCellRef(
@@ -119,6 +119,7 @@ HvMarkCellDirty(
     RtlSetBits(&RegistryHive->DirtyVector,
                CellBlock, CellLastBlock - CellBlock);
     RegistryHive->DirtyCount++;
+    RegistryHive->DirtyFlag = TRUE;
     return TRUE;
 }
 
@@ -44,12 +44,18 @@
 
 #define HV_LOG_HEADER_SIZE              FIELD_OFFSET(HBASE_BLOCK, Reserved2)
 
+//
+// Size of the dirty vector saved in a log record, for a hive of BlockCount blocks
+//
+#define HV_LOG_BITMAP_SIZE(BlockCount)  ((((BlockCount) + 31) / 32) * sizeof(ULONG))
+
 //
 // Hive structure identifiers
 //
 #define HV_HHIVE_SIGNATURE              0xbee0bee0
 #define HV_HBLOCK_SIGNATURE             0x66676572  // "regf"
 #define HV_HBIN_SIGNATURE               0x6e696268  // "hbin"
+#define HV_LOG_DIRTY_SIGNATURE          0x54524944  // "DIRT"
 
 //
 // Hive versions
@@ -253,6 +259,22 @@ typedef BOOLEAN
     ULONG Length
 );
 
+/* One piece of a gathered write, in the layout of the Windows structure */
+typedef struct _CMP_OFFSET_ARRAY
+{
+    ULONG FileOffset;
+    PVOID DataBuffer;
+    ULONG DataLength;
+} CMP_OFFSET_ARRAY, *PCMP_OFFSET_ARRAY;
+
+typedef BOOLEAN
+(CMAPI *PFILE_WRITE_GATHER_ROUTINE)(
+    struct _HHIVE *RegistryHive,
+    ULONG FileType,
+    PCMP_OFFSET_ARRAY OffsetArray,
+    ULONG OffsetArrayCount
+);
+
 typedef struct _HMAP_ENTRY
 {
     ULONG_PTR BlockAddress;
@@ -297,6 +319,9 @@ typedef struct _HHIVE
     PFILE_READ_ROUTINE FileRead;
     PFILE_FLUSH_ROUTINE FileFlush;
 
+    /* Optional, writes several pieces in one call */
+    PFILE_WRITE_GATHER_ROUTINE FileWriteGather;
+
 #if (NTDDI_VERSION >= NTDDI_WIN7)
     PVOID HiveLoadFailure; // PHIVE_LOAD_FAILURE
 #endif
@@ -310,6 +335,8 @@ typedef struct _HHIVE
     BOOLEAN ReadOnly;
 #if (NTDDI_VERSION < NTDDI_VISTA) // NTDDI_LONGHORN
     BOOLEAN Log;
+    /* Loaded by HvLoadHive, which replays the log when it is loaded again */
+    BOOLEAN LogReplay;
 #endif
     BOOLEAN DirtyFlag;
 #if (NTDDI_VERSION >= NTDDI_VISTA) // NTDDI_LONGHORN
@@ -403,7 +403,22 @@ HvpGetHiveHeader(IN PHHIVE Hive,
     if (!Result) return NotHive;
 
     /* Do validation */
-    if (!HvpVerifyHiveHeader(BaseBlock)) return NotHive;
+    if (!HvpVerifyHiveHeader(BaseBlock))
+    {
+        /* A write of the primary file that didn't complete leaves the
+           sequence numbers apart, its data may still be in the log */
+        if (Hive->Log &&
+            BaseBlock->Signature == HV_HBLOCK_SIGNATURE &&
+            BaseBlock->Sequence1 != BaseBlock->Sequence2 &&
+            HvpHiveHeaderChecksum(BaseBlock) == BaseBlock->CheckSum)
+        {
+            *HiveBaseBlock = BaseBlock;
+            *TimeStamp = BaseBlock->TimeStamp;
+            return RecoverData;
+        }
+
+        return NotHive;
+    }
 
     /* Return information */
     *HiveBaseBlock = BaseBlock;
@@ -411,6 +426,219 @@ HvpGetHiveHeader(IN PHHIVE Hive,
     return HiveSuccess;
 }
 
+/**
+ * @name HvpReadLogRecord
+ *
+ * Internal helper function to read and check the header of the log record
+ * at the given offset. The header is returned along with the dirty vector
+ * which follows it, and the size of the whole record.
+ */
+static RESULT CMAPI
+HvpReadLogRecord(
+    IN PHHIVE Hive,
+    IN ULONG Offset,
+    OUT PHBASE_BLOCK *LogRecord,
+    OUT PULONG HeaderSize,
+    OUT PULONG RecordSize)
+{
+    PHBASE_BLOCK Header;
+    RTL_BITMAP DirtyVector;
+    ULONG BlockCount;
+    ULONG FileOffset;
+    ULONG Size;
+    ULONG i;
+
+    *LogRecord = NULL;
+
+    Header = Hive->Allocate(HBLOCK_SIZE, TRUE, TAG_CM);
+    if (!Header) return NoMemory;
+
+    /* Read the first block and check the record header */
+    FileOffset = Offset;
+    if (!Hive->FileRead(Hive, HFILE_TYPE_LOG, &FileOffset, Header, HBLOCK_SIZE) ||
+        Header->Signature != HV_HBLOCK_SIGNATURE ||
+        Header->Type != HFILE_TYPE_LOG ||
+        Header->Sequence1 != Header->Sequence2 ||
+        HvpHiveHeaderChecksum(Header) != Header->CheckSum ||
+        Header->Length == 0 ||
+        (Header->Length % HBLOCK_SIZE) != 0 ||
+        *(PULONG)((PUCHAR)Header + HV_LOG_HEADER_SIZE) != HV_LOG_DIRTY_SIGNATURE)
+    {
+        Hive->Free(Header, HBLOCK_SIZE);
+        return Fail;
+    }
+
+    /* Big hives have a dirty vector that doesn't fit in the first block */
+    BlockCount = Header->Length / HBLOCK_SIZE;
+    Size = ROUND_UP(HV_LOG_HEADER_SIZE + sizeof(ULONG) + HV_LOG_BITMAP_SIZE(BlockCount),
+                    HBLOCK_SIZE);
+    if (Size > HBLOCK_SIZE)
+    {
+        Hive->Free(Header, HBLOCK_SIZE);
+        Header = Hive->Allocate(Size, TRUE, TAG_CM);
+        if (!Header) return NoMemory;
+
+        FileOffset = Offset;
+        if (!Hive->FileRead(Hive, HFILE_TYPE_LOG, &FileOffset, Header, Size))
+        {
+            Hive->Free(Header, Size);
+            return Fail;
+        }
+    }
+
+    /* Every dirty block follows the header */
+    RtlInitializeBitMap(&DirtyVector,
+                        (PULONG)((PUCHAR)Header + HV_LOG_HEADER_SIZE + sizeof(ULONG)),
+                        BlockCount);
+    *RecordSize = Size;
+    for (i = 0; i < BlockCount; i++)
+    {
+        if (RtlCheckBit(&DirtyVector, i))
+            *RecordSize += HBLOCK_SIZE;
+    }
+
+    *LogRecord = Header;
+    *HeaderSize = Size;
+    return HiveSuccess;
+}
+
+/**
+ * @name HvpRecoverFromLog
+ *
+ * Internal helper function to rebuild a hive from its primary file and the
+ * newest record of its log, if that record is more recent than the primary
+ * file. The records follow each other in the log with increasing sequence
+ * numbers, and each of them holds all the blocks that changed since the
+ * primary file was last written in full.
+ */
+static RESULT CMAPI
+HvpRecoverFromLog(
+    IN PHHIVE Hive,
+    IN PHBASE_BLOCK BaseBlock,
+    OUT PVOID *HiveData,
+    OUT PULONG HiveSize,
+    OUT PHBASE_BLOCK *LogRecord)
+{
+    PHBASE_BLOCK Record = NULL, NextRecord;
+    PHBASE_BLOCK HiveBase;
+    RTL_BITMAP DirtyVector;
+    ULONG RecordOffset = 0, HeaderSize = 0, RecordSize = 0;
+    ULONG NextHeaderSize, NextRecordSize;
+    ULONG Offset, LogOffset, FileOffset;
+    ULONG BlockCount, BlockIndex, RunLength;
+    BOOLEAN Dirty;
+    RESULT Result;
+
+    *HiveData = NULL;
+    *LogRecord = NULL;
+
+    /* Walk the records up to the first one that isn't complete */
+    Offset = 0;
+    while (TRUE)
+    {
+        Result = HvpReadLogRecord(Hive, Offset, &NextRecord, &NextHeaderSize, &NextRecordSize);
+        if (Result == NoMemory)
+        {
+            if (Record) Hive->Free(Record, HeaderSize);
+            return NoMemory;
+        }
+        if (Result != HiveSuccess)
+            break;
+
+        /* What follows an older record is left from before the last checkpoint */
+        if (Record && NextRecord->Sequence1 <= Record->Sequence1)
+        {
+            Hive->Free(NextRecord, NextHeaderSize);
+            break;
+        }
+
+        if (Record) Hive->Free(Record, HeaderSize);
+        Record = NextRecord;
+        RecordOffset = Offset;
+        HeaderSize = NextHeaderSize;
+        RecordSize = NextRecordSize;
+        Offset += RecordSize;
+    }
+
+    if (!Record)
+        return Fail;
+
+    /*
+     * The primary file is up to date if it was fully written after the
+     * record. If its last write didn't complete, the second sequence number
+     * is the one of the log record that was written just before it.
+     */
+    if (Record->Sequence1 < BaseBlock->Sequence2 ||
+        (Record->Sequence1 == BaseBlock->Sequence2 &&
+         BaseBlock->Sequence1 == BaseBlock->Sequence2))
+    {
+        Hive->Free(Record, HeaderSize);
+        return Fail;
+    }
+
+    DPRINT1("Recovering hive from log record %lu at offset 0x%lx\n",
+            Record->Sequence1, RecordOffset);
+
+    BlockCount = Record->Length / HBLOCK_SIZE;
+    *HiveSize = HBLOCK_SIZE + Record->Length;
+    *HiveData = Hive->Allocate(*HiveSize, TRUE, TAG_CM);
+    if (!*HiveData)
+    {
+        Hive->Free(Record, HeaderSize);
+        return NoMemory;
+    }
+
+    /* The base block comes from the log, as a primary one */
+    HiveBase = (PHBASE_BLOCK)*HiveData;
+    RtlZeroMemory(HiveBase, HBLOCK_SIZE);
+    RtlCopyMemory(HiveBase, Record, HV_LOG_HEADER_SIZE);
+    HiveBase->Type = HFILE_TYPE_PRIMARY;
+    HiveBase->CheckSum = HvpHiveHeaderChecksum(HiveBase);
+
+    /* Dirty blocks come from the log, the other ones from the primary file */
+    RtlInitializeBitMap(&DirtyVector,
+                        (PULONG)((PUCHAR)Record + HV_LOG_HEADER_SIZE + sizeof(ULONG)),
+                        BlockCount);
+    LogOffset = RecordOffset + HeaderSize;
+    for (BlockIndex = 0; BlockIndex < BlockCount; BlockIndex += RunLength)
+    {
+        Dirty = (BOOLEAN)RtlCheckBit(&DirtyVector, BlockIndex);
+        for (RunLength = 1; BlockIndex + RunLength < BlockCount; RunLength++)
+        {
+            if ((BOOLEAN)RtlCheckBit(&DirtyVector, BlockIndex + RunLength) != Dirty)
+                break;
+        }
+
+        if (Dirty)
+        {
+            FileOffset = LogOffset;
+            LogOffset += RunLength * HBLOCK_SIZE;
+        }
+        else
+        {
+            FileOffset = (BlockIndex + 1) * HBLOCK_SIZE;
+        }
+
+        if (!Hive->FileRead(Hive,
+                            Dirty ? HFILE_TYPE_LOG : HFILE_TYPE_PRIMARY,
+                            &FileOffset,
+                            (PUCHAR)*HiveData + (BlockIndex + 1) * HBLOCK_SIZE,
+                            RunLength * HBLOCK_SIZE))
+        {
+            Hive->Free(*HiveData, *HiveSize);
+            Hive->Free(Record, HeaderSize);
+            *HiveData = NULL;
+            return Fail;
+        }
+    }
+
+    /* New records go after this one, until the primary file is written */
+    Hive->LogSize = RecordOffset + RecordSize;
+
+    *LogRecord = Record;
+    return HiveSuccess;
+}
+
 NTSTATUS CMAPI
 HvLoadHive(IN PHHIVE Hive,
            IN PCUNICODE_STRING FileName OPTIONAL)
@@ -422,6 +650,8 @@ HvLoadHive(IN PHHIVE Hive,
     ULONG Offset = 0;
     PVOID HiveData;
     ULONG FileSize;
+    PHBASE_BLOCK LogRecord = NULL;
+    RTL_BITMAP DirtyVector;
 
     /* Get the hive header */
     Result = HvpGetHiveHeader(Hive, &BaseBlock, &TimeStamp);
@@ -440,7 +670,6 @@ HvLoadHive(IN PHHIVE Hive,
             return STATUS_NOT_REGISTRY_FILE;
 
         /* Has recovery data */
-        case RecoverData:
         case RecoverHeader:
 
             /* Fail */
@@ -454,6 +683,31 @@ HvLoadHive(IN PHHIVE Hive,
     Hive->BaseBlock = BaseBlock;
     Hive->Version = BaseBlock->Minor;
 
+    /* Replay the log if it holds data more recent than the primary file */
+    if (Hive->Log)
+    {
+        switch (HvpRecoverFromLog(Hive, BaseBlock, &HiveData, &FileSize, &LogRecord))
+        {
+            case NoMemory:
+                Hive->Free(BaseBlock, Hive->BaseBlockAlloc);
+                return STATUS_INSUFFICIENT_RESOURCES;
+
+            case HiveSuccess:
+                Hive->Free(BaseBlock, Hive->BaseBlockAlloc);
+                goto Initialize;
+
+            default:
+                break;
+        }
+    }
+
+    /* Nothing to recover from */
+    if (Result == RecoverData)
+    {
+        Hive->Free(BaseBlock, Hive->BaseBlockAlloc);
+        return STATUS_REGISTRY_CORRUPT;
+    }
+
     /* Allocate a buffer large enough to hold the hive */
     FileSize = HBLOCK_SIZE + BaseBlock->Length; // == sizeof(HBASE_BLOCK) + BaseBlock->Length;
     HiveData = Hive->Allocate(FileSize, TRUE, TAG_CM);
@@ -480,11 +734,35 @@ HvLoadHive(IN PHHIVE Hive,
     /* Free our base block... it's usless in this implementation */
     Hive->Free(BaseBlock, Hive->BaseBlockAlloc);
 
+Initialize:
     /* Initialize the hive directly from memory */
     Status = HvpInitializeMemoryHive(Hive, HiveData, FileName);
     if (!NT_SUCCESS(Status))
         Hive->Free(HiveData, FileSize);
 
+    /* Changes that only reach the log are found again by the next load */
+    if (NT_SUCCESS(Status))
+        Hive->LogReplay = Hive->Log;
+
+    if (LogRecord)
+    {
+        /* The recovered blocks still have to reach the primary file */
+        if (NT_SUCCESS(Status))
+        {
+            RtlInitializeBitMap(&DirtyVector,
+                                (PULONG)((PUCHAR)LogRecord + HV_LOG_HEADER_SIZE + sizeof(ULONG)),
+                                Hive->Storage[Stable].Length);
+            for (Offset = 0; Offset < Hive->Storage[Stable].Length; Offset++)
+            {
+                if (RtlCheckBit(&DirtyVector, Offset))
+                    RtlSetBits(&Hive->DirtyVector, Offset, 1);
+            }
+            Hive->DirtyCount++;
+        }
+
+        Hive->Free(LogRecord, 0);
+    }
+
     return Status;
 }
 
@@ -9,26 +9,120 @@
 #define NDEBUG
 #include <debug.h>
 
+/* Number of pieces gathered before they are written */
+#define HV_MAX_WRITE_ENTRIES 16
+
+typedef struct _HV_WRITE_CONTEXT
+{
+    PHHIVE RegistryHive;
+    ULONG FileType;
+    ULONG Count;
+    CMP_OFFSET_ARRAY Entries[HV_MAX_WRITE_ENTRIES];
+} HV_WRITE_CONTEXT, *PHV_WRITE_CONTEXT;
+
+static BOOLEAN CMAPI
+HvpFlushWriteContext(
+    PHV_WRITE_CONTEXT Context)
+{
+    PHHIVE RegistryHive = Context->RegistryHive;
+    ULONG FileOffset;
+    ULONG i;
+    BOOLEAN Success = TRUE;
+
+    if (Context->Count == 0)
+    {
+        return TRUE;
+    }
+
+    if (RegistryHive->FileWriteGather != NULL)
+    {
+        Success = RegistryHive->FileWriteGather(RegistryHive,
+                                                Context->FileType,
+                                                Context->Entries,
+                                                Context->Count);
+    }
+    else
+    {
+        for (i = 0; i < Context->Count && Success; i++)
+        {
+            FileOffset = Context->Entries[i].FileOffset;
+            Success = RegistryHive->FileWrite(RegistryHive,
+                                              Context->FileType,
+                                              &FileOffset,
+                                              Context->Entries[i].DataBuffer,
+                                              Context->Entries[i].DataLength);
+        }
+    }
+
+    Context->Count = 0;
+    return Success;
+}
+
+/*
+ * Queues a hive block to be written at the given file offset. Blocks which
+ * follow each other both in memory and in the file are merged into a single
+ * write, and without a gather routine each piece is one FileWrite call.
+ */
+static BOOLEAN CMAPI
+HvpQueueBlockWrite(
+    PHV_WRITE_CONTEXT Context,
+    ULONG FileOffset,
+    PVOID BlockPtr)
+{
+    PCMP_OFFSET_ARRAY Entry;
+
+    if (Context->Count != 0)
+    {
+        Entry = &Context->Entries[Context->Count - 1];
+        if (Entry->FileOffset + Entry->DataLength == FileOffset &&
+            (PUCHAR)Entry->DataBuffer + Entry->DataLength == (PUCHAR)BlockPtr)
+        {
+            Entry->DataLength += HBLOCK_SIZE;
+            return TRUE;
+        }
+
+        /* Without a gather routine a piece that can't grow anymore is written */
+        if (Context->RegistryHive->FileWriteGather == NULL ||
+            Context->Count == HV_MAX_WRITE_ENTRIES)
+        {
+            if (!HvpFlushWriteContext(Context))
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    Entry = &Context->Entries[Context->Count++];
+    Entry->FileOffset = FileOffset;
+    Entry->DataBuffer = BlockPtr;
+    Entry->DataLength = HBLOCK_SIZE;
+    return TRUE;
+}
+
+/*
+ * Appends a record to the log, made of a copy of the hive header, the dirty
+ * vector and all the blocks that are dirty since the last time the primary
+ * file was written. A record only becomes valid once both sequence numbers
+ * of its header match, which happens after its blocks reached the disk, so
+ * a write that doesn't complete leaves the previous records intact.
+ */
 static BOOLEAN CMAPI
 HvpWriteLog(
     PHHIVE RegistryHive)
 {
+    HV_WRITE_CONTEXT Context;
     ULONG FileOffset;
+    ULONG RecordOffset;
     UINT32 BufferSize;
     UINT32 BitmapSize;
     PUCHAR Buffer;
     PUCHAR Ptr;
+    PHBASE_BLOCK LogHeader;
     ULONG BlockIndex;
     ULONG LastIndex;
+    ULONG RunLength;
     PVOID BlockPtr;
     BOOLEAN Success;
-    static ULONG PrintCount = 0;
-
-    if (PrintCount++ == 0)
-    {
-        UNIMPLEMENTED;
-    }
-    return TRUE;
 
     ASSERT(RegistryHive->ReadOnly == FALSE);
     ASSERT(RegistryHive->BaseBlock->Length ==
@@ -42,7 +136,7 @@ HvpWriteLog(
         return FALSE;
     }
 
-    BitmapSize = RegistryHive->DirtyVector.SizeOfBitMap;
+    BitmapSize = HV_LOG_BITMAP_SIZE(RegistryHive->Storage[Stable].Length);
     BufferSize = HV_LOG_HEADER_SIZE + sizeof(ULONG) + BitmapSize;
     BufferSize = ROUND_UP(BufferSize, HBLOCK_SIZE);
 
@@ -54,61 +148,74 @@ HvpWriteLog(
         return FALSE;
     }
 
-    /* Update first update counter and CheckSum */
-    RegistryHive->BaseBlock->Type = HFILE_TYPE_LOG;
+    /* Update first update counter */
     RegistryHive->BaseBlock->Sequence1++;
-    RegistryHive->BaseBlock->CheckSum =
-        HvpHiveHeaderChecksum(RegistryHive->BaseBlock);
 
-    /* Copy hive header */
+    /* Copy hive header, and make it a log one */
     RtlCopyMemory(Buffer, RegistryHive->BaseBlock, HV_LOG_HEADER_SIZE);
+    LogHeader = (PHBASE_BLOCK)Buffer;
+    LogHeader->Type = HFILE_TYPE_LOG;
+    LogHeader->CheckSum = HvpHiveHeaderChecksum(LogHeader);
+
     Ptr = Buffer + HV_LOG_HEADER_SIZE;
-    RtlCopyMemory(Ptr, "DIRT", 4);
-    Ptr += 4;
+    *(PULONG)Ptr = HV_LOG_DIRTY_SIGNATURE;
+    Ptr += sizeof(ULONG);
     RtlCopyMemory(Ptr, RegistryHive->DirtyVector.Buffer, BitmapSize);
 
-    /* Write hive block and block bitmap */
-    FileOffset = 0;
+    /* Write hive block and block bitmap after the previous records */
+    RecordOffset = RegistryHive->LogSize;
+    FileOffset = RecordOffset;
     Success = RegistryHive->FileWrite(RegistryHive, HFILE_TYPE_LOG,
                                       &FileOffset, Buffer, BufferSize);
-    RegistryHive->Free(Buffer, 0);
-
     if (!Success)
     {
-        return FALSE;
+        goto Quit;
     }
 
+    Context.RegistryHive = RegistryHive;
+    Context.FileType = HFILE_TYPE_LOG;
+    Context.Count = 0;
+
     /* Write dirty blocks */
-    FileOffset = BufferSize;
+    FileOffset = RecordOffset + BufferSize;
     BlockIndex = 0;
     while (BlockIndex < RegistryHive->Storage[Stable].Length)
     {
-        LastIndex = BlockIndex;
-        BlockIndex = RtlFindSetBits(&RegistryHive->DirtyVector, 1, BlockIndex);
-        if (BlockIndex == ~0U || BlockIndex < LastIndex)
+        RunLength = RtlFindNextForwardRunSet(&RegistryHive->DirtyVector,
+                                             BlockIndex,
+                                             &BlockIndex);
+        if (RunLength == 0 ||
+            BlockIndex >= RegistryHive->Storage[Stable].Length)
         {
             break;
         }
 
-        BlockPtr = (PVOID)RegistryHive->Storage[Stable].BlockList[BlockIndex].BlockAddress;
-
-        /* Write hive block */
-        Success = RegistryHive->FileWrite(RegistryHive, HFILE_TYPE_LOG,
-                                         &FileOffset, BlockPtr, HBLOCK_SIZE);
-        if (!Success)
+        RunLength = min(RunLength, RegistryHive->Storage[Stable].Length - BlockIndex);
+        for (LastIndex = BlockIndex + RunLength; BlockIndex < LastIndex; BlockIndex++)
         {
-            return FALSE;
+            BlockPtr = (PVOID)RegistryHive->Storage[Stable].BlockList[BlockIndex].BlockAddress;
+
+            Success = HvpQueueBlockWrite(&Context, FileOffset, BlockPtr);
+            if (!Success)
+            {
+                goto Quit;
+            }
+
+            FileOffset += HBLOCK_SIZE;
         }
+    }
 
-        BlockIndex++;
-        FileOffset += HBLOCK_SIZE;
+    Success = HvpFlushWriteContext(&Context);
+    if (!Success)
+    {
+        goto Quit;
     }
 
     Success = RegistryHive->FileSetSize(RegistryHive, HFILE_TYPE_LOG, FileOffset, FileOffset);
     if (!Success)
     {
         DPRINT("FileSetSize failed\n");
-        return FALSE;
+        goto Quit;
     }
 
     /* Flush the log file */
@@ -118,19 +225,18 @@ HvpWriteLog(
         DPRINT("FileFlush failed\n");
     }
 
-    /* Update second update counter and CheckSum */
+    /* Update second update counter */
     RegistryHive->BaseBlock->Sequence2++;
-    RegistryHive->BaseBlock->CheckSum =
-        HvpHiveHeaderChecksum(RegistryHive->BaseBlock);
+    LogHeader->Sequence2 = LogHeader->Sequence1;
+    LogHeader->CheckSum = HvpHiveHeaderChecksum(LogHeader);
 
-    /* Write hive header again with updated sequence counter. */
-    FileOffset = 0;
+    /* Write record header again with updated sequence counter. */
     Success = RegistryHive->FileWrite(RegistryHive, HFILE_TYPE_LOG,
-                                      &FileOffset, RegistryHive->BaseBlock,
+                                      &RecordOffset, LogHeader,
                                       HV_LOG_HEADER_SIZE);
     if (!Success)
     {
-        return FALSE;
+        goto Quit;
     }
 
     /* Flush the log file */
@@ -140,7 +246,20 @@ HvpWriteLog(
         DPRINT("FileFlush failed\n");
     }
 
-    return TRUE;
+    /* The log now holds everything that is dirty */
+    RegistryHive->LogSize = FileOffset;
+    RegistryHive->DirtyFlag = FALSE;
+    Success = TRUE;
+
+Quit:
+    /* A record that was not completed can't be trusted, sync the counters back */
+    if (!Success)
+    {
+        RegistryHive->BaseBlock->Sequence2 = RegistryHive->BaseBlock->Sequence1;
+    }
+
+    RegistryHive->Free(Buffer, 0);
+    return Success;
 }
 
 static BOOLEAN CMAPI
@@ -148,9 +267,11 @@ HvpWriteHive(
     PHHIVE RegistryHive,
     BOOLEAN OnlyDirty)
 {
+    HV_WRITE_CONTEXT Context;
     ULONG FileOffset;
     ULONG BlockIndex;
     ULONG LastIndex;
+    ULONG RunLength;
     PVOID BlockPtr;
     BOOLEAN Success;
 
@@ -182,31 +303,46 @@ HvpWriteHive(
         return FALSE;
     }
 
+    Context.RegistryHive = RegistryHive;
+    Context.FileType = HFILE_TYPE_PRIMARY;
+    Context.Count = 0;
+
+    /* Write the dirty runs, or everything as one run */
     BlockIndex = 0;
     while (BlockIndex < RegistryHive->Storage[Stable].Length)
     {
         if (OnlyDirty)
         {
-            LastIndex = BlockIndex;
-            BlockIndex = RtlFindSetBits(&RegistryHive->DirtyVector, 1, BlockIndex);
-            if (BlockIndex == ~0U || BlockIndex < LastIndex)
+            RunLength = RtlFindNextForwardRunSet(&RegistryHive->DirtyVector,
+                                                 BlockIndex,
+                                                 &BlockIndex);
+            if (RunLength == 0 ||
+                BlockIndex >= RegistryHive->Storage[Stable].Length)
             {
                 break;
             }
         }
+        else
+        {
+            RunLength = RegistryHive->Storage[Stable].Length - BlockIndex;
+        }
 
-        BlockPtr = (PVOID)RegistryHive->Storage[Stable].BlockList[BlockIndex].BlockAddress;
-        FileOffset = (BlockIndex + 1) * HBLOCK_SIZE;
-
-        /* Write hive block */
-        Success = RegistryHive->FileWrite(RegistryHive, HFILE_TYPE_PRIMARY,
-                                          &FileOffset, BlockPtr, HBLOCK_SIZE);
-        if (!Success)
+        RunLength = min(RunLength, RegistryHive->Storage[Stable].Length - BlockIndex);
+        for (LastIndex = BlockIndex + RunLength; BlockIndex < LastIndex; BlockIndex++)
         {
-            return FALSE;
+            BlockPtr = (PVOID)RegistryHive->Storage[Stable].BlockList[BlockIndex].BlockAddress;
+            FileOffset = (BlockIndex + 1) * HBLOCK_SIZE;
+
+            if (!HvpQueueBlockWrite(&Context, FileOffset, BlockPtr))
+            {
+                return FALSE;
+            }
         }
+    }
 
-        BlockIndex++;
+    if (!HvpFlushWriteContext(&Context))
+    {
+        return FALSE;
     }
 
     Success = RegistryHive->FileFlush(RegistryHive, HFILE_TYPE_PRIMARY, NULL, 0);
@@ -250,13 +386,19 @@ HvSyncHive(
         return TRUE;
     }
 
-    /* Update hive header modification time */
-    KeQuerySystemTime(&RegistryHive->BaseBlock->TimeStamp);
-
-    /* Update log file */
-    if (!HvpWriteLog(RegistryHive))
+    /* Update the log, unless it already holds all the dirty data */
+    if (!RegistryHive->Log ||
+        RegistryHive->DirtyFlag ||
+        RegistryHive->LogSize == 0)
     {
-        return FALSE;
+        /* Update hive header modification time */
+        KeQuerySystemTime(&RegistryHive->BaseBlock->TimeStamp);
+
+        /* Update log file */
+        if (RegistryHive->Log && !HvpWriteLog(RegistryHive))
+        {
+            return FALSE;
+        }
     }
 
     /* Update hive file */
@@ -265,13 +407,43 @@ HvSyncHive(
         return FALSE;
     }
 
-    /* Clear dirty bitmap. */
+    /* Clear dirty bitmap, the log records are now obsolete */
     RtlClearAllBits(&RegistryHive->DirtyVector);
     RegistryHive->DirtyCount = 0;
+    RegistryHive->DirtyFlag = FALSE;
+    RegistryHive->LogSize = 0;
 
     return TRUE;
 }
 
+/*
+ * Makes the dirty data of a hive durable by writing it to the log only. The
+ * primary file is brought up to date by a later call to HvSyncHive, which
+ * won't need to write the log again if nothing changed in between.
+ */
+BOOLEAN CMAPI
+HvLogHive(
+    PHHIVE RegistryHive)
+{
+    ASSERT(RegistryHive->ReadOnly == FALSE);
+
+    /* Without a log, only a sync can save the hive */
+    if (!RegistryHive->Log)
+    {
+        return FALSE;
+    }
+
+    if (!RegistryHive->DirtyFlag)
+    {
+        return TRUE;
+    }
+
+    /* Update hive header modification time */
+    KeQuerySystemTime(&RegistryHive->BaseBlock->TimeStamp);
+
+    return HvpWriteLog(RegistryHive);
+}
+
 BOOLEAN
 CMAPI
 HvHiveWillShrink(IN PHHIVE RegistryHive)
@@ -24,6 +24,18 @@ ULONG ChecksumFold(
   return Sum;
 }
 
+/* Fold the 64-bit accumulator of the checksum routines to 32 bits */
+static
+ULONG
+ChecksumFold64(
+  ULONGLONG Sum)
+{
+  Sum = (Sum & 0xFFFFFFFF) + (Sum >> 32);
+  Sum = (Sum & 0xFFFFFFFF) + (Sum >> 32);
+
+  return (ULONG)Sum;
+}
+
 ULONG ChecksumCompute(
   PVOID Data,
   UINT Count,
@@ -35,71 +47,182 @@ ULONG ChecksumCompute(
  *     Count = Number of bytes in buffer
  *     Seed  = Previously calculated checksum (if any)
  * RETURNS:
- *     Checksum of buffer
+ *     Checksum of buffer, to be folded with ChecksumFold
+ * NOTES:
+ *     The one's complement sum of the 16-bit words doesn't change when they
+ *     are added as 32-bit words, so the buffer is summed 4 bytes at a time
+ *     in a 64-bit accumulator that can't overflow, and folded at the end
  */
 {
-  register ULONG Sum = Seed;
+  PUCHAR Buffer = Data;
+  ULONGLONG Sum = Seed;
+  UINT Words, i;
 
-  while (Count > 1)
+  /* Align the buffer for the 32-bit loads */
+  if (((ULONG_PTR)Buffer & 2) && Count > 1)
     {
-      Sum += *(PUSHORT)Data;
+      Sum += *(PUSHORT)Buffer;
+      Buffer += 2;
+      Count -= 2;
+    }
+
+  /* A plain loop, that compilers can unroll and vectorize */
+  Words = Count / 4;
+  for (i = 0; i < Words; i++)
+    {
+      Sum += ((PULONG)Buffer)[i];
+    }
+  Buffer += Words * 4;
+  Count -= Words * 4;
+
+  if (Count > 1)
+    {
+      Sum += *(PUSHORT)Buffer;
+      Buffer += 2;
       Count -= 2;
-      Data = (PVOID)((ULONG_PTR) Data + 2);
     }
 
   /* Add left-over byte, if any */
   if (Count > 0)
     {
-      Sum += *(PUCHAR)Data;
+      Sum += *Buffer;
     }
 
-  return Sum;
+  return ChecksumFold64(Sum);
 }
 
+ULONG ChecksumCopy(
+  PVOID Destination,
+  PVOID Source,
+  UINT Count,
+  ULONG Seed)
+/*
+ * FUNCTION: Copy a buffer and calculate its checksum in the same pass
+ * ARGUMENTS:
+ *     Destination = Pointer to the buffer to copy to
+ *     Source      = Pointer to the buffer with data
+ *     Count       = Number of bytes to copy
+ *     Seed        = Previously calculated checksum (if any)
+ * RETURNS:
+ *     Checksum of buffer, the same as ChecksumCompute(Source, Count, Seed)
+ */
+{
+  PUCHAR From = Source;
+  PUCHAR To = Destination;
+  ULONGLONG Sum = Seed;
+  ULONG Word0, Word1, Word2, Word3;
+
+  if (((ULONG_PTR)From & 2) && Count > 1)
+    {
+      *(PUSHORT)To = *(PUSHORT)From;
+      Sum += *(PUSHORT)From;
+      From += 2;
+      To += 2;
+      Count -= 2;
+    }
+
+  while (Count >= 16)
+    {
+      Word0 = ((PULONG)From)[0];
+      Word1 = ((PULONG)From)[1];
+      Word2 = ((PULONG)From)[2];
+      Word3 = ((PULONG)From)[3];
+      ((PULONG)To)[0] = Word0;
+      ((PULONG)To)[1] = Word1;
+      ((PULONG)To)[2] = Word2;
+      ((PULONG)To)[3] = Word3;
+      Sum += (ULONGLONG)Word0 + Word1 + Word2 + Word3;
+      From += 16;
+      To += 16;
+      Count -= 16;
+    }
+
+  while (Count >= 4)
+    {
+      Word0 = *(PULONG)From;
+      *(PULONG)To = Word0;
+      Sum += Word0;
+      From += 4;
+      To += 4;
+      Count -= 4;
+    }
+
+  if (Count > 1)
+    {
+      *(PUSHORT)To = *(PUSHORT)From;
+      Sum += *(PUSHORT)From;
+      From += 2;
+      To += 2;
+      Count -= 2;
+    }
+
+  if (Count > 0)
+    {
+      *To = *From;
+      Sum += *From;
+    }
+
+  return ChecksumFold64(Sum);
+}
+
+/* Add the pseudo header to the sum of a UDP datagram */
+static
 ULONG
-UDPv4ChecksumCalculate(
+UDPv4ChecksumFinish(
   PIPv4_HEADER IPHeader,
-  PUCHAR PacketBuffer,
+  ULONG Sum,
   ULONG DataLength)
 {
-  ULONG Sum = 0;
-  USHORT TmpSum;
-  ULONG i;
-  BOOLEAN Pad;
-
-  /* Pad the data if needed */
-  Pad = (DataLength & 1);
-  if (Pad)
-      DataLength++;
-
-  /* Add from the UDP header and data */
-  for (i = 0; i < DataLength; i += 2)
-  {
-       TmpSum = ((PacketBuffer[i] << 8) & 0xFF00) +
-                ((Pad && i == DataLength - 2) ? 0 : (PacketBuffer[i+1] & 0x00FF));
-       Sum += TmpSum;
-  }
-
-  /* Add the source address */
-  for (i = 0; i < sizeof(IPv4_RAW_ADDRESS); i += 2)
-  {
-       TmpSum = ((((PUCHAR)&IPHeader->SrcAddr)[i] << 8) & 0xFF00) +
-                (((PUCHAR)&IPHeader->SrcAddr)[i+1] & 0x00FF);
-       Sum += TmpSum;
-  }
-
-  /* Add the destination address */
-  for (i = 0; i < sizeof(IPv4_RAW_ADDRESS); i += 2)
-  {
-       TmpSum = ((((PUCHAR)&IPHeader->DstAddr)[i] << 8) & 0xFF00) +
-                (((PUCHAR)&IPHeader->DstAddr)[i+1] & 0x00FF);
-       Sum += TmpSum;
-  }
+  /* Add the source and destination addresses */
+  Sum = ChecksumCompute(&IPHeader->SrcAddr, sizeof(IPv4_RAW_ADDRESS), Sum);
+  Sum = ChecksumCompute(&IPHeader->DstAddr, sizeof(IPv4_RAW_ADDRESS), Sum);
+
+  /* The sum of the native words is the byte swapped sum of the network ones */
+  Sum = ChecksumFold(Sum);
+  Sum = ((Sum & 0xFF) << 8) | (Sum >> 8);
 
   /* Add the proto number and length */
-  Sum += IPPROTO_UDP + (DataLength - (Pad ? 1 : 0));
+  Sum += IPPROTO_UDP + DataLength;
 
   /* Fold the checksum and return the one's complement */
   return ~ChecksumFold(Sum);
 }
 
+ULONG
+UDPv4ChecksumCalculate(
+  PIPv4_HEADER IPHeader,
+  PUCHAR PacketBuffer,
+  ULONG DataLength)
+{
+  return UDPv4ChecksumFinish(IPHeader,
+                             ChecksumCompute(PacketBuffer, DataLength, 0),
+                             DataLength);
+}
+
+ULONG
+UDPv4ChecksumCopy(
+  PIPv4_HEADER IPHeader,
+  PUCHAR PacketBuffer,
+  ULONG HeaderLength,
+  PVOID Data,
+  ULONG DataLength)
+/*
+ * FUNCTION: Copy the payload of a UDP datagram after its header and
+ *           calculate the checksum of the datagram in the same pass
+ * ARGUMENTS:
+ *     IPHeader     = Pointer to the IPv4 header with the addresses
+ *     PacketBuffer = Pointer to the UDP header
+ *     HeaderLength = Length of the UDP header, an even number of bytes
+ *     Data         = Pointer to the payload
+ *     DataLength   = Length of the payload
+ * RETURNS:
+ *     Checksum of the datagram, like UDPv4ChecksumCalculate
+ */
+{
+  ULONG Sum;
+
+  Sum = ChecksumCompute(PacketBuffer, HeaderLength, 0);
+  Sum = ChecksumCopy(PacketBuffer + HeaderLength, Data, DataLength, Sum);
+
+  return UDPv4ChecksumFinish(IPHeader, Sum, HeaderLength + DataLength);
+}
@@ -14,8 +14,241 @@
 
 #include "precomp.h"
 
+/*
+ * The IPv4 routes are also indexed by a path compressed binary trie of
+ * their prefixes, so that the longest matching prefix is found in at most
+ * 33 steps whatever the size of the table. Every node of the trie holds
+ * the list of routes for its exact prefix; nodes without routes only exist
+ * where two prefixes branch off.
+ */
+typedef struct _FIB_NODE {
+    struct _FIB_NODE *Parent;     /* Node of the enclosing prefix */
+    struct _FIB_NODE *Child[2];   /* Nodes of the longer prefixes, by next bit */
+    ULONG Prefix;                 /* Host order, bits past PrefixLength are zero */
+    UINT PrefixLength;            /* Number of significant bits */
+    LIST_ENTRY RouteList;         /* Routes with exactly this prefix */
+} FIB_NODE, *PFIB_NODE;
+
+/*
+ * Recent destinations and the trie node they resolved to. Entries are
+ * valid while their generation is the one of the FIB, which changes
+ * whenever a route is added or removed.
+ */
+#define ROUTE_CACHE_SHIFT 8
+#define ROUTE_CACHE_SIZE (1 << ROUTE_CACHE_SHIFT)
+
+typedef struct _ROUTE_CACHE_ENTRY {
+    ULONG Destination;            /* Host order */
+    ULONG Generation;             /* FIB generation it was looked up in */
+    PFIB_NODE Node;               /* Longest matching prefix, or NULL */
+} ROUTE_CACHE_ENTRY, *PROUTE_CACHE_ENTRY;
+
 LIST_ENTRY FIBListHead;
 KSPIN_LOCK FIBLock;
+PFIB_NODE FIBRoot;
+ULONG FIBGeneration;
+ROUTE_CACHE_ENTRY RouteCache[ROUTE_CACHE_SIZE];
+
+static ULONG FIBPrefixMask(UINT PrefixLength)
+{
+    return PrefixLength ? 0xFFFFFFFF << (32 - PrefixLength) : 0;
+}
+
+static UINT FIBGetBit(ULONG Address, UINT Index)
+{
+    return (Address >> (31 - Index)) & 1;
+}
+
+static UINT FIBCommonLength(ULONG Address1, ULONG Address2, UINT MaxLength)
+{
+    ULONG Difference = Address1 ^ Address2;
+    UINT Length;
+
+    for (Length = 0; Length < MaxLength && !(Difference & 0x80000000); Length++)
+        Difference <<= 1;
+
+    return Length;
+}
+
+static PFIB_NODE FIBAllocateNode(
+    ULONG Prefix,
+    UINT PrefixLength,
+    PFIB_NODE Parent)
+{
+    PFIB_NODE Node;
+
+    Node = ExAllocatePoolWithTag(NonPagedPool, sizeof(FIB_NODE), FIB_TAG);
+    if (!Node) {
+        TI_DbgPrint(MIN_TRACE, ("Insufficient resources.\n"));
+        return NULL;
+    }
+
+    Node->Parent = Parent;
+    Node->Child[0] = Node->Child[1] = NULL;
+    Node->Prefix = Prefix;
+    Node->PrefixLength = PrefixLength;
+    InitializeListHead(&Node->RouteList);
+
+    return Node;
+}
+
+static PFIB_NODE FIBInsertNode(
+    ULONG Prefix,
+    UINT PrefixLength)
+/*
+ * FUNCTION: Finds or creates the trie node of a prefix
+ * ARGUMENTS:
+ *     Prefix       = Network address, in host order
+ *     PrefixLength = Number of significant bits of the address
+ * RETURNS:
+ *     Pointer to the node, NULL if there are not enough resources
+ * NOTES:
+ *     The forward information base lock must be held when called
+ */
+{
+    PFIB_NODE *Link = &FIBRoot;
+    PFIB_NODE Parent = NULL, Node, NewNode, Branch;
+    UINT Common = 0;
+
+    Prefix &= FIBPrefixMask(PrefixLength);
+
+    /* Walk down as long as the nodes hold a part of our prefix */
+    while ((Node = *Link)) {
+        Common = FIBCommonLength(Node->Prefix, Prefix,
+                                 min(Node->PrefixLength, PrefixLength));
+        if (Common < Node->PrefixLength)
+            break;
+
+        if (Node->PrefixLength == PrefixLength)
+            return Node;
+
+        Parent = Node;
+        Link = &Node->Child[FIBGetBit(Prefix, Node->PrefixLength)];
+    }
+
+    NewNode = FIBAllocateNode(Prefix, PrefixLength, Parent);
+    if (!NewNode)
+        return NULL;
+
+    if (!Node) {
+        /* Nothing there yet */
+        *Link = NewNode;
+    } else if (Common == PrefixLength) {
+        /* Our prefix is a part of the one of the node, insert above it */
+        NewNode->Child[FIBGetBit(Node->Prefix, PrefixLength)] = Node;
+        Node->Parent = NewNode;
+        *Link = NewNode;
+    } else {
+        /* The prefixes diverge, they need a branch at the common part */
+        Branch = FIBAllocateNode(Prefix & FIBPrefixMask(Common), Common, Parent);
+        if (!Branch) {
+            ExFreePoolWithTag(NewNode, FIB_TAG);
+            return NULL;
+        }
+
+        Branch->Child[FIBGetBit(Node->Prefix, Common)] = Node;
+        Branch->Child[FIBGetBit(Prefix, Common)] = NewNode;
+        Node->Parent = NewNode->Parent = Branch;
+        *Link = Branch;
+    }
+
+    return NewNode;
+}
+
+static VOID FIBPruneNode(
+    PFIB_NODE Node)
+/*
+ * FUNCTION: Removes the nodes that are no longer needed after a route removal
+ * ARGUMENTS:
+ *     Node = Pointer to the node that lost a route
+ * NOTES:
+ *     The forward information base lock must be held when called
+ */
+{
+    PFIB_NODE Parent, Child;
+
+    /* A node without routes is only useful if it branches */
+    while (Node && IsListEmpty(&Node->RouteList) &&
+           !(Node->Child[0] && Node->Child[1])) {
+        Child = Node->Child[0] ? Node->Child[0] : Node->Child[1];
+        Parent = Node->Parent;
+
+        if (Parent)
+            Parent->Child[FIBGetBit(Node->Prefix, Parent->PrefixLength)] = Child;
+        else
+            FIBRoot = Child;
+        if (Child)
+            Child->Parent = Parent;
+
+        ExFreePoolWithTag(Node, FIB_TAG);
+
+        /* The parent may have been a branch to this node */
+        Node = Parent;
+    }
+}
+
+static PFIB_NODE FIBLookupNode(
+    ULONG Destination)
+/*
+ * FUNCTION: Finds the longest prefix with routes that matches an address
+ * ARGUMENTS:
+ *     Destination = Address to match, in host order
+ * RETURNS:
+ *     Pointer to the node, NULL if no route matches
+ * NOTES:
+ *     The forward information base lock must be held when called
+ */
+{
+    PFIB_NODE Node = FIBRoot, Best = NULL;
+
+    while (Node &&
+           (Destination & FIBPrefixMask(Node->PrefixLength)) == Node->Prefix) {
+        if (!IsListEmpty(&Node->RouteList))
+            Best = Node;
+
+        if (Node->PrefixLength == 32)
+            break;
+
+        Node = Node->Child[FIBGetBit(Destination, Node->PrefixLength)];
+    }
+
+    return Best;
+}
+
+static PNEIGHBOR_CACHE_ENTRY FIBSelectRoute(
+    PFIB_NODE Node)
+/*
+ * FUNCTION: Chooses between the routes of a prefix
+ * ARGUMENTS:
+ *     Node = Pointer to the trie node of the prefix
+ * RETURNS:
+ *     Pointer to the NCE of the router to use
+ * NOTES:
+ *     Routers that are known to be reachable come first, then the
+ *     route with the lowest metric. The forward information base lock
+ *     must be held when called
+ */
+{
+    PLIST_ENTRY CurrentEntry;
+    PFIB_ENTRY Current, Best = NULL;
+    BOOLEAN Reachable, BestReachable = FALSE;
+
+    for (CurrentEntry = Node->RouteList.Flink;
+         CurrentEntry != &Node->RouteList;
+         CurrentEntry = CurrentEntry->Flink) {
+        Current = CONTAINING_RECORD(CurrentEntry, FIB_ENTRY, NodeListEntry);
+        Reachable = !(Current->Router->State & (NUD_STALE | NUD_INCOMPLETE));
+
+        if (!Best ||
+            (Reachable && !BestReachable) ||
+            (Reachable == BestReachable && Current->Metric < Best->Metric)) {
+            Best = Current;
+            BestReachable = Reachable;
+        }
+    }
+
+    return Best->Router;
+}
 
 void RouterDumpRoutes() {
     PLIST_ENTRY CurrentEntry;
@@ -69,6 +302,13 @@ VOID DestroyFIBE(
     /* Unlink the FIB entry from the list */
     RemoveEntryList(&FIBE->ListEntry);
 
+    /* And from the prefix trie */
+    if (FIBE->Node) {
+        RemoveEntryList(&FIBE->NodeListEntry);
+        FIBPruneNode(FIBE->Node);
+    }
+    FIBGeneration++;
+
     /* And free the FIB entry */
     FreeFIB(FIBE);
 }
@@ -206,6 +446,7 @@ PFIB_ENTRY RouterAddRoute(
  *     these references
  */
 {
+    KIRQL OldIrql;
     PFIB_ENTRY FIBE;
 
     TI_DbgPrint(DEBUG_ROUTER, ("Called. NetworkAddress (0x%X)  Netmask (0x%X) "
@@ -228,26 +469,43 @@ PFIB_ENTRY RouterAddRoute(
 		   sizeof(FIBE->Netmask) );
     FIBE->Router         = Router;
     FIBE->Metric         = Metric;
+    FIBE->Node           = NULL;
+
+    TcpipAcquireSpinLock(&FIBLock, &OldIrql);
+
+    /* Index IPv4 routes by their prefix */
+    if (NetworkAddress->Type == IP_ADDRESS_V4) {
+        FIBE->Node = FIBInsertNode(IPv4NToHl(NetworkAddress->Address.IPv4Address),
+                                   AddrCountPrefixBits(Netmask));
+        if (!FIBE->Node) {
+            TcpipReleaseSpinLock(&FIBLock, OldIrql);
+            FreeFIB(FIBE);
+            return NULL;
+        }
+        InsertTailList(&FIBE->Node->RouteList, &FIBE->NodeListEntry);
+    }
 
     /* Add FIB to the forward information base */
-    TcpipInterlockedInsertTailList(&FIBListHead, &FIBE->ListEntry, &FIBLock);
+    InsertTailList(&FIBListHead, &FIBE->ListEntry);
+    FIBGeneration++;
+
+    TcpipReleaseSpinLock(&FIBLock, OldIrql);
 
     return FIBE;
 }
 
 
-PNEIGHBOR_CACHE_ENTRY RouterGetRoute(PIP_ADDRESS Destination)
+static PNEIGHBOR_CACHE_ENTRY RouterScanRoutes(PIP_ADDRESS Destination)
 /*
- * FUNCTION: Finds a router to use to get to Destination
+ * FUNCTION: Finds a router for a destination that isn't IPv4
  * ARGUMENTS:
- *     Destination = Pointer to destination address (NULL means don't care)
+ *     Destination = Pointer to destination address
  * RETURNS:
  *     Pointer to NCE for router, NULL if none was found
  * NOTES:
- *     If found the NCE is referenced
+ *     The forward information base lock must be held when called
  */
 {
-    KIRQL OldIrql;
     PLIST_ENTRY CurrentEntry;
     PLIST_ENTRY NextEntry;
     PFIB_ENTRY Current;
@@ -255,12 +513,6 @@ PNEIGHBOR_CACHE_ENTRY RouterGetRoute(PIP_ADDRESS Destination)
     UINT Length, BestLength = 0, MaskLength;
     PNEIGHBOR_CACHE_ENTRY NCE, BestNCE = NULL;
 
-    TI_DbgPrint(DEBUG_ROUTER, ("Called. Destination (0x%X)\n", Destination));
-
-    TI_DbgPrint(DEBUG_ROUTER, ("Destination (%s)\n", A2S(Destination)));
-
-    TcpipAcquireSpinLock(&FIBLock, &OldIrql);
-
     CurrentEntry = FIBListHead.Flink;
     while (CurrentEntry != &FIBListHead) {
         NextEntry = CurrentEntry->Flink;
@@ -286,6 +538,53 @@ PNEIGHBOR_CACHE_ENTRY RouterGetRoute(PIP_ADDRESS Destination)
         CurrentEntry = NextEntry;
     }
 
+    return BestNCE;
+}
+
+PNEIGHBOR_CACHE_ENTRY RouterGetRoute(PIP_ADDRESS Destination)
+/*
+ * FUNCTION: Finds a router to use to get to Destination
+ * ARGUMENTS:
+ *     Destination = Pointer to destination address (NULL means don't care)
+ * RETURNS:
+ *     Pointer to NCE for router, NULL if none was found
+ * NOTES:
+ *     If found the NCE is referenced
+ */
+{
+    KIRQL OldIrql;
+    ULONG Address;
+    PROUTE_CACHE_ENTRY CacheEntry;
+    PFIB_NODE Node;
+    PNEIGHBOR_CACHE_ENTRY BestNCE = NULL;
+
+    TI_DbgPrint(DEBUG_ROUTER, ("Called. Destination (0x%X)\n", Destination));
+
+    TI_DbgPrint(DEBUG_ROUTER, ("Destination (%s)\n", A2S(Destination)));
+
+    TcpipAcquireSpinLock(&FIBLock, &OldIrql);
+
+    if (Destination->Type == IP_ADDRESS_V4) {
+        Address = IPv4NToHl(Destination->Address.IPv4Address);
+
+        /* Check if the destination was looked up since the last change */
+        CacheEntry = &RouteCache[(Address * 0x9E3779B1) >> (32 - ROUTE_CACHE_SHIFT)];
+        if (CacheEntry->Generation == FIBGeneration &&
+            CacheEntry->Destination == Address) {
+            Node = CacheEntry->Node;
+        } else {
+            Node = FIBLookupNode(Address);
+            CacheEntry->Destination = Address;
+            CacheEntry->Generation = FIBGeneration;
+            CacheEntry->Node = Node;
+        }
+
+        if (Node)
+            BestNCE = FIBSelectRoute(Node);
+    } else {
+        BestNCE = RouterScanRoutes(Destination);
+    }
+
     TcpipReleaseSpinLock(&FIBLock, OldIrql);
 
     if( BestNCE ) {
@@ -492,6 +791,11 @@ NTSTATUS RouterStartup(
     /* Initialize the Forward Information Base */
     InitializeListHead(&FIBListHead);
     TcpipInitializeSpinLock(&FIBLock);
+    FIBRoot = NULL;
+
+    /* Cache entries of generation 0 are never valid */
+    RtlZeroMemory(RouteCache, sizeof(RouteCache));
+    FIBGeneration = 1;
 
     return STATUS_SUCCESS;
 }
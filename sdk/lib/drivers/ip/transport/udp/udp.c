@@ -59,11 +59,13 @@ NTSTATUS AddUDPHeaderIPv4(
 			    IPPacket->Header, IPPacket->Data,
 			    (PCHAR)IPPacket->Data - (PCHAR)IPPacket->Header));
 
-    RtlCopyMemory(IPPacket->Data, Data, DataLength);
-
-    UDPHeader->Checksum = UDPv4ChecksumCalculate((PIPv4_HEADER)IPPacket->Header,
-                                                 (PUCHAR)UDPHeader,
-                                                 DataLength + sizeof(UDP_HEADER));
+    /* Copy the data and sum it in one pass, it directly follows the header */
+    ASSERT((PUCHAR)IPPacket->Data == (PUCHAR)(UDPHeader + 1));
+    UDPHeader->Checksum = UDPv4ChecksumCopy((PIPv4_HEADER)IPPacket->Header,
+                                            (PUCHAR)UDPHeader,
+                                            sizeof(UDP_HEADER),
+                                            Data,
+                                            DataLength);
     UDPHeader->Checksum = WH2N(UDPHeader->Checksum);
 
     TI_DbgPrint(MID_TRACE, ("Packet: %d ip %d udp %d payload\n",
@@ -246,6 +246,31 @@ Fast486WriteMemory(PFAST486_STATE State,
     return Fast486WriteLinearMemory(State, LinearAddress, Buffer, Size, TRUE);
 }
 
+VOID
+FASTCALL
+Fast486InvalidateDecoded(PFAST486_STATE State,
+                         ULONG FirstAddress,
+                         ULONG LastAddress)
+{
+    PFAST486_CODE_ENTRY Entry;
+    ULONG Address;
+
+    if ((LastAddress - FirstAddress) >= FAST486_CODE_CACHE_ENTRIES)
+    {
+        /* Every entry could be hit, start over */
+        Fast486FlushCodeCache(State);
+        return;
+    }
+
+    for (Address = FirstAddress; ; Address++)
+    {
+        Entry = &State->CodeCache->Entries[CODE_ENTRY_INDEX(Address)];
+        if (Entry->Address == Address) Entry->Generation = 0;
+
+        if (Address == LastAddress) break;
+    }
+}
+
 static inline BOOLEAN
 FASTCALL
 Fast486GetIntVector(PFAST486_STATE State,
@@ -68,8 +68,16 @@ if (State->PrefixFlags & FAST486_PREFIX_LOCK)\
 #define PAGE_OFFSET(x)  ((x) & 0x00000FFF)
 #define GET_ADDR_PDE(x) ((x) >> 22)
 #define GET_ADDR_PTE(x) (((x) >> 12) & 0x3FF)
-#define INVALID_TLB_FIELD 0xFFFFFFFF
-#define NUM_TLB_ENTRIES 0x100000
+
+/* TLB lookup, mixing in the upper bits so that distant pages rarely collide */
+#define TLB_INDEX(x) ((((x) >> 12) ^ ((x) >> 20)) & (FAST486_TLB_ENTRIES - 1))
+
+/* Decoded instruction cache lookup, the same offset in different pages gets different entries */
+#define CODE_ENTRY_INDEX(x) (((x) ^ ((x) >> 12) ^ ((x) >> 20)) & (FAST486_CODE_CACHE_ENTRIES - 1))
+#define CODE_PAGE_INDEX(x) (((x) >> 12) & (FAST486_CODE_CACHE_PAGES - 1))
+
+/* Longer prefixes and opcode are not stored, no instruction is longer anyway */
+#define MAX_DECODED_LENGTH 15
 
 typedef struct _FAST486_MOD_REG_RM
 {
@@ -194,6 +202,15 @@ Fast486CallGate
     BOOLEAN Call
 );
 
+VOID
+FASTCALL
+Fast486InvalidateDecoded
+(
+    PFAST486_STATE State,
+    ULONG FirstAddress,
+    ULONG LastAddress
+);
+
 /* INLINED FUNCTIONS **********************************************************/
 
 #include "common.inl"
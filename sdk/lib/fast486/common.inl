@@ -72,12 +72,21 @@ Fast486GetPageTableEntry(PFAST486_STATE State,
     FAST486_PAGE_DIR DirectoryEntry;
     FAST486_PAGE_TABLE TableEntry;
     ULONG PageDirectory = State->ControlRegisters[FAST486_REG_CR3];
+    PFAST486_TLB_ENTRY TlbEntry = NULL;
 
-    if ((State->Tlb != NULL)
-        && (State->Tlb[VirtualAddress >> 12] != INVALID_TLB_FIELD))
+    if (State->Tlb != NULL)
     {
-        /* Return the cached entry */
-        return State->Tlb[VirtualAddress >> 12];
+        TlbEntry = &State->Tlb->Entries[TLB_INDEX(VirtualAddress)];
+    }
+
+    if ((TlbEntry != NULL)
+        && (TlbEntry->Generation == State->Tlb->Generation)
+        && (TlbEntry->VirtualPage == (VirtualAddress >> 12)))
+    {
+        TableEntry.Value = TlbEntry->Value;
+
+        /* Return the cached entry, unless the page must be marked as dirty */
+        if (!MarkAsDirty || TableEntry.Dirty) return TableEntry.Value;
     }
 
     /* Read the directory entry */
@@ -134,11 +143,12 @@ Fast486GetPageTableEntry(PFAST486_STATE State,
     TableEntry.Writeable &= DirectoryEntry.Writeable;
     TableEntry.Usermode &= DirectoryEntry.Usermode;
 
-    if (State->Tlb != NULL)
+    if (TlbEntry != NULL)
     {
         /* Set the TLB entry */
-        State->Tlb[VirtualAddress >> 12] = TableEntry.Value;
-        State->TlbEmpty = FALSE;
+        TlbEntry->Generation = State->Tlb->Generation;
+        TlbEntry->VirtualPage = VirtualAddress >> 12;
+        TlbEntry->Value = TableEntry.Value;
     }
 
     /* Return the table entry */
@@ -150,9 +160,152 @@ VOID
 FASTCALL
 Fast486FlushTlb(PFAST486_STATE State)
 {
-    if (!State->Tlb || State->TlbEmpty) return;
-    RtlFillMemory(State->Tlb, NUM_TLB_ENTRIES * sizeof(ULONG), 0xFF);
-    State->TlbEmpty = TRUE;
+    if (State->Tlb == NULL) return;
+
+    /* Start a new generation, generation zero is never used */
+    if (++State->Tlb->Generation == 0)
+    {
+        /* Wrapped around, make sure no old entry matches again */
+        RtlZeroMemory(State->Tlb->Entries, sizeof(State->Tlb->Entries));
+        State->Tlb->Generation = 1;
+    }
+}
+
+FORCEINLINE
+VOID
+FASTCALL
+Fast486FlushCodeCache(PFAST486_STATE State)
+{
+    if (State->CodeCache == NULL) return;
+
+    /* Start a new generation, generation zero is never used */
+    if (++State->CodeCache->Generation == 0)
+    {
+        /* Wrapped around, make sure no old entry or page matches again */
+        RtlZeroMemory(State->CodeCache, sizeof(*State->CodeCache));
+        State->CodeCache->Generation = 1;
+    }
+}
+
+FORCEINLINE
+VOID
+FASTCALL
+Fast486InvalidateCode(PFAST486_STATE State,
+                      ULONG Address,
+                      ULONG Size)
+{
+    PFAST486_CODE_CACHE CodeCache = State->CodeCache;
+    ULONG FirstAddress, LastAddress;
+
+    if ((CodeCache == NULL) || (Size == 0)) return;
+
+    /* An instruction that starts a bit earlier may also overlap */
+    FirstAddress = (Address > MAX_DECODED_LENGTH - 1) ? (Address - (MAX_DECODED_LENGTH - 1)) : 0;
+    LastAddress = Address + Size - 1;
+
+    /* Most writes go to pages without any code */
+    if (((LastAddress >> 12) - (FirstAddress >> 12) <= 1)
+        && (CodeCache->Pages[CODE_PAGE_INDEX(FirstAddress)] != CodeCache->Generation)
+        && (CodeCache->Pages[CODE_PAGE_INDEX(LastAddress)] != CodeCache->Generation))
+    {
+        return;
+    }
+
+    Fast486InvalidateDecoded(State, FirstAddress, LastAddress);
+}
+
+FORCEINLINE
+PFAST486_CODE_ENTRY
+FASTCALL
+Fast486GetCodeEntry(PFAST486_STATE State)
+{
+    PFAST486_SEG_REG CachedDescriptor = &State->SegmentRegs[FAST486_REG_CS];
+    ULONG Offset = CachedDescriptor->Size ? State->InstPtr.Long : State->InstPtr.LowWord;
+
+    /* With paging, the same linear address could be different code */
+    if ((State->CodeCache == NULL)
+        || (State->ControlRegisters[FAST486_REG_CR0] & FAST486_CR0_PG))
+    {
+        return NULL;
+    }
+
+    return &State->CodeCache->Entries[CODE_ENTRY_INDEX(CachedDescriptor->Base + Offset)];
+}
+
+FORCEINLINE
+BOOLEAN
+FASTCALL
+Fast486LoadCodeEntry(PFAST486_STATE State,
+                     PFAST486_CODE_ENTRY Entry,
+                     PUCHAR Opcode)
+{
+    PFAST486_SEG_REG CachedDescriptor = &State->SegmentRegs[FAST486_REG_CS];
+    ULONG Offset = CachedDescriptor->Size ? State->InstPtr.Long : State->InstPtr.LowWord;
+
+    if ((Entry->Generation != State->CodeCache->Generation)
+        || (Entry->Address != CachedDescriptor->Base + Offset))
+    {
+        /* Not decoded yet */
+        return FALSE;
+    }
+
+    /* Leave the checks of Fast486ReadMemory and their exceptions to a real fetch */
+    if ((Offset + Entry->Length - 1) > CachedDescriptor->Limit) return FALSE;
+
+    if ((State->ControlRegisters[FAST486_REG_CR0] & FAST486_CR0_PE) && !State->Flags.Vm
+        && (!CachedDescriptor->Present
+            || !CachedDescriptor->Executable
+            || (Fast486GetCurrentPrivLevel(State) > CachedDescriptor->Dpl)))
+    {
+        return FALSE;
+    }
+
+    State->PrefixFlags = Entry->PrefixFlags;
+    State->SegmentOverride = Entry->SegmentOverride;
+    *Opcode = Entry->Opcode;
+
+    /* Skip the prefixes and the opcode */
+    if (CachedDescriptor->Size) State->InstPtr.Long += Entry->Length;
+    else State->InstPtr.LowWord += Entry->Length;
+
+    return TRUE;
+}
+
+FORCEINLINE
+VOID
+FASTCALL
+Fast486StoreCodeEntry(PFAST486_STATE State,
+                      PFAST486_CODE_ENTRY Entry,
+                      UCHAR Opcode)
+{
+    PFAST486_CODE_CACHE CodeCache = State->CodeCache;
+    PFAST486_SEG_REG CachedDescriptor = &State->SegmentRegs[FAST486_REG_CS];
+    ULONG Offset, Length;
+
+    /* The instruction started at the saved instruction pointer */
+    if (CachedDescriptor->Size)
+    {
+        Offset = State->SavedInstPtr.Long;
+        Length = State->InstPtr.Long - Offset;
+    }
+    else
+    {
+        Offset = State->SavedInstPtr.LowWord;
+        Length = State->InstPtr.LowWord - Offset;
+    }
+
+    /* This also skips the instructions that wrap around the segment */
+    if (Length > MAX_DECODED_LENGTH) return;
+
+    Entry->Generation = CodeCache->Generation;
+    Entry->Address = CachedDescriptor->Base + Offset;
+    Entry->Opcode = Opcode;
+    Entry->Length = (UCHAR)Length;
+    Entry->PrefixFlags = (UCHAR)State->PrefixFlags;
+    Entry->SegmentOverride = (UCHAR)State->SegmentOverride;
+
+    /* Writes to this page must now look for decoded instructions */
+    CodeCache->Pages[CODE_PAGE_INDEX(Entry->Address)] = CodeCache->Generation;
 }
 
 FORCEINLINE
@@ -291,6 +444,12 @@ Fast486WriteLinearMemory(PFAST486_STATE State,
     }
     else
     {
+        /*
+         * Drop the decoded instructions that the write changes. With paging
+         * they are not used, and they are flushed when it is turned off.
+         */
+        Fast486InvalidateCode(State, LinearAddress, Size);
+
         /* Write the memory */
         State->MemWriteCallback(State, LinearAddress, Buffer, Size);
     }
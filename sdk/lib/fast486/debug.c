@@ -50,6 +50,7 @@ Fast486ExecutionControl(PFAST486_STATE State, FAST486_EXEC_CMD Command)
 {
     UCHAR Opcode;
     FAST486_OPCODE_HANDLER_PROC CurrentHandler;
+    PFAST486_CODE_ENTRY CodeEntry = NULL;
     INT ProcedureCallCount = 0;
     BOOLEAN Trap;
 
@@ -66,6 +67,15 @@ NextInst:
             {
                 State->SavedInstPtr = State->InstPtr;
                 State->SavedStackPtr = State->GeneralRegs[FAST486_REG_ESP];
+
+                /* Check if the prefixes and the opcode were decoded before */
+                CodeEntry = Fast486GetCodeEntry(State);
+                if ((CodeEntry != NULL) && Fast486LoadCodeEntry(State, CodeEntry, &Opcode))
+                {
+                    Fast486OpcodeHandlers[Opcode](State, Opcode);
+                    State->PrefixFlags = 0;
+                    goto InstDone;
+                }
             }
 
             /* Perform an instruction fetch */
@@ -80,6 +90,13 @@ NextInst:
 
             /* Call the opcode handler */
             CurrentHandler = Fast486OpcodeHandlers[Opcode];
+
+            /* Remember the prefixes and the opcode for the next time */
+            if ((CodeEntry != NULL) && (CurrentHandler != Fast486OpcodePrefix))
+            {
+                Fast486StoreCodeEntry(State, CodeEntry, Opcode);
+            }
+
             CurrentHandler(State, Opcode);
 
             /* If this is a prefix, go to the next instruction immediately */
@@ -89,6 +106,7 @@ NextInst:
             State->PrefixFlags = 0;
         }
 
+InstDone:
         /*
          * Check if there is an interrupt to execute, or a hardware interrupt signal
          * while interrupts are enabled.
@@ -640,12 +640,19 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeLoadControlReg)
     State->PrefetchValid = FALSE;
 #endif
 
-    if (ModRegRm.Register == (INT)FAST486_REG_CR3)
+    if ((ModRegRm.Register == (INT)FAST486_REG_CR0)
+        || (ModRegRm.Register == (INT)FAST486_REG_CR3))
     {
-        /* Flush the TLB */
+        /* Flush the TLB, turning paging on or off also invalidates it */
         Fast486FlushTlb(State);
     }
 
+    if (ModRegRm.Register == (INT)FAST486_REG_CR0)
+    {
+        /* The decoded instructions are only valid for the addresses without paging */
+        Fast486FlushCodeCache(State);
+    }
+
     /* Load a value to the control register */
     State->ControlRegisters[ModRegRm.Register] = Value;
 }
@@ -108,7 +108,8 @@ Fast486Initialize(PFAST486_STATE         State,
                   FAST486_BOP_PROC       BopCallback,
                   FAST486_INT_ACK_PROC   IntAckCallback,
                   FAST486_FPU_PROC       FpuCallback,
-                  PULONG                 Tlb)
+                  PFAST486_TLB           Tlb,
+                  PFAST486_CODE_CACHE    CodeCache)
 {
     /* Set the callbacks (or use default ones if some are NULL) */
     State->MemReadCallback  = (MemReadCallback  ? MemReadCallback  : Fast486MemReadCallback );
@@ -119,8 +120,13 @@ Fast486Initialize(PFAST486_STATE         State,
     State->IntAckCallback   = (IntAckCallback   ? IntAckCallback   : Fast486IntAckCallback  );
     State->FpuCallback      = (FpuCallback      ? FpuCallback      : Fast486FpuCallback     );
 
-    /* Set the TLB (if given) */
+    /* Set the TLB (if given), none of its entries is valid yet */
     State->Tlb = Tlb;
+    if (Tlb != NULL) RtlZeroMemory(Tlb, sizeof(*Tlb));
+
+    /* The same for the decoded instruction cache */
+    State->CodeCache = CodeCache;
+    if (CodeCache != NULL) RtlZeroMemory(CodeCache, sizeof(*CodeCache));
 
     /* Reset the CPU */
     Fast486Reset(State);
@@ -132,7 +138,7 @@ Fast486Reset(PFAST486_STATE State)
 {
     FAST486_SEG_REGS i;
 
-    /* Save the callbacks and TLB */
+    /* Save the callbacks and caches */
     FAST486_MEM_READ_PROC  MemReadCallback  = State->MemReadCallback;
     FAST486_MEM_WRITE_PROC MemWriteCallback = State->MemWriteCallback;
     FAST486_IO_READ_PROC   IoReadCallback   = State->IoReadCallback;
@@ -140,7 +146,8 @@ Fast486Reset(PFAST486_STATE State)
     FAST486_BOP_PROC       BopCallback      = State->BopCallback;
     FAST486_INT_ACK_PROC   IntAckCallback   = State->IntAckCallback;
     FAST486_FPU_PROC       FpuCallback      = State->FpuCallback;
-    PULONG                 Tlb              = State->Tlb;
+    PFAST486_TLB           Tlb              = State->Tlb;
+    PFAST486_CODE_CACHE    CodeCache        = State->CodeCache;
 
     /* Clear the entire structure */
     RtlZeroMemory(State, sizeof(*State));
@@ -186,7 +193,7 @@ Fast486Reset(PFAST486_STATE State)
     State->FpuTag = 0xFFFF;
 #endif
 
-    /* Restore the callbacks and TLB */
+    /* Restore the callbacks and caches */
     State->MemReadCallback  = MemReadCallback;
     State->MemWriteCallback = MemWriteCallback;
     State->IoReadCallback   = IoReadCallback;
@@ -195,9 +202,11 @@ Fast486Reset(PFAST486_STATE State)
     State->IntAckCallback   = IntAckCallback;
     State->FpuCallback      = FpuCallback;
     State->Tlb              = Tlb;
+    State->CodeCache        = CodeCache;
 
-    /* Flush the TLB */
+    /* Flush the TLB and the decoded instructions */
     Fast486FlushTlb(State);
+    Fast486FlushCodeCache(State);
 }
 
 VOID
@@ -260,4 +269,12 @@ Fast486Rewind(PFAST486_STATE State)
 #endif
 }
 
+VOID
+NTAPI
+Fast486InvalidateCodeCache(PFAST486_STATE State, ULONG Address, ULONG Size)
+{
+    /* The host changed the memory, or how it is mapped, behind the back of the CPU */
+    Fast486InvalidateCode(State, Address, Size);
+}
+
 /* EOF */
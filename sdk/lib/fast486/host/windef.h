@@ -0,0 +1,59 @@
+/*
+ * Fast486 386/486 CPU Emulation Library
+ * windef.h
+ *
+ * Minimal definitions needed to build the library with the host compiler.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _FAST486_HOST_WINDEF_H_
+#define _FAST486_HOST_WINDEF_H_
+
+#pragma once
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#define FORCEINLINE __forceinline
+#else
+#define FASTCALL
+#define FORCEINLINE static __inline __attribute__((always_inline))
+#endif
+
+#ifndef C_ASSERT
+#define C_ASSERT(expr) extern char (*c_assert(void)) [(expr) ? 1 : -1]
+#endif
+
+#define UNREFERENCED_PARAMETER(P) ((void)(P))
+#define UlongToPtr(ul) ((PVOID)(ULONG_PTR)(ul))
+
+#define RtlFillMemory(Destination, Length, Fill) memset(Destination, Fill, Length)
+#define DbgPrint printf
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+typedef ULONGLONG *PULONGLONG;
+typedef LONGLONG *PLONGLONG;
+
+#endif // _FAST486_HOST_WINDEF_H_
@@ -4148,6 +4148,9 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeLdsLes)
             /* Call the BOP handler */
             State->BopCallback(State, BopCode);
 
+            /* The code may have changed as well */
+            Fast486FlushCodeCache(State);
+
             /*
              * If an interrupt should occur at this time, delay it.
              * We must do this because if an interrupt begins and the BOP callback
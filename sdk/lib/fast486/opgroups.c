@@ -2280,8 +2280,10 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeGroup0F01)
 
             if (State->Tlb != NULL)
             {
-                /* Clear the TLB entry */
-                State->Tlb[ModRegRm.MemoryAddress >> 12] = INVALID_TLB_FIELD;
+                /* Clear the TLB entry of the linear address */
+                State->Tlb->Entries[TLB_INDEX(State->SegmentRegs[(State->PrefixFlags & FAST486_PREFIX_SEG)
+                                                                 ? State->SegmentOverride : FAST486_REG_DS].Base
+                                              + ModRegRm.MemoryAddress)].Generation = 0;
             }
 
             break;
@@ -20,7 +20,35 @@
 #define COMPRESSION_FORMAT_MASK  0x00FF
 #define COMPRESSION_ENGINE_MASK  0xFF00
 
-
+/* LZNT1 compression engine */
+#define LZNT1_CHUNK_SIZE        0x1000
+#define LZNT1_MIN_MATCH         3
+#define LZNT1_HASH_BITS         12
+#define LZNT1_HASH_SIZE         (1 << LZNT1_HASH_BITS)
+#define LZNT1_NIL               0xFFFF
+
+/* chain depth searched per position by the standard and maximum engines */
+#define LZNT1_STANDARD_DEPTH    16
+#define LZNT1_MAXIMUM_DEPTH     LZNT1_CHUNK_SIZE
+
+/* XPRESS compression engine */
+#define XPRESS_MIN_MATCH            3
+#define XPRESS_MAX_MATCH            (0xFFFF + XPRESS_MIN_MATCH)
+#define XPRESS_WINDOW_SIZE          0x2000
+#define XPRESS_HUFF_WINDOW_SIZE     0xFFFF
+#define XPRESS_HUFF_BLOCK_SIZE      0x10000
+#define XPRESS_HUFF_SYMBOLS         512
+#define XPRESS_HUFF_MAX_BITS        15
+#define XPRESS_HUFF_TABLE_BITS      10
+#define XPRESS_HASH_BITS            14
+#define XPRESS_STANDARD_DEPTH       8
+#define XPRESS_MAXIMUM_DEPTH        256
+
+#define TAG_COMPRESS 'pmoC'
+
+/* RtlDecompressChunks uses worker threads only for buffers this large */
+#define RTLP_PARALLEL_CHUNKS_MIN_SIZE       (1024 * 1024)
+#define RTLP_PARALLEL_CHUNKS_PER_WORKER     16
 
 
 /* FUNCTIONS ****************************************************************/
@@ -216,28 +244,199 @@ out:
 }
 
 
+/* LZNT1 compression engine: LZ77 over 4 KB chunks with a hash-chained match finder */
+
+typedef struct _LZNT1_WORKSPACE
+{
+    USHORT HashHead[LZNT1_HASH_SIZE];
+    USHORT HashPrev[LZNT1_CHUNK_SIZE];
+} LZNT1_WORKSPACE, *PLZNT1_WORKSPACE;
+
+C_ASSERT(sizeof(LZNT1_WORKSPACE) <= 0x8010);
+
+static __inline ULONG lznt1_hash(const UCHAR *src)
+{
+    ULONG value = src[0] | (src[1] << 8) | (src[2] << 16);
+    return (value * 2654435761U) >> (32 - LZNT1_HASH_BITS);
+}
+
+/* number of displacement bits used by a back reference at the given chunk position,
+ * must match the decision made by lznt1_decompress_chunk */
+static __inline ULONG lznt1_displacement_bits(ULONG pos)
+{
+    ULONG displacement_bits;
+
+    for (displacement_bits = 12; displacement_bits > 4; displacement_bits--)
+        if ((1U << (displacement_bits - 1)) < pos) break;
+
+    return displacement_bits;
+}
+
+/* insert all positions up to (but excluding) end into the hash chains */
+static void lznt1_insert(PLZNT1_WORKSPACE ws, const UCHAR *src, ULONG src_size,
+                         ULONG *inserted, ULONG end)
+{
+    ULONG pos, hash;
+
+    for (pos = *inserted; pos < end; pos++)
+    {
+        if (pos + LZNT1_MIN_MATCH > src_size) break;
+        hash = lznt1_hash(src + pos);
+        ws->HashPrev[pos] = ws->HashHead[hash];
+        ws->HashHead[hash] = (USHORT)pos;
+    }
+
+    *inserted = end;
+}
+
+/* find the longest match for the given position, all earlier positions must be inserted */
+static ULONG lznt1_find_match(PLZNT1_WORKSPACE ws, const UCHAR *src, ULONG src_size,
+                              ULONG pos, ULONG max_depth, ULONG *displacement)
+{
+    ULONG displacement_bits, max_length, max_displacement;
+    ULONG best_length = 0, length, candidate;
+
+    if (pos == 0 || pos + LZNT1_MIN_MATCH > src_size)
+        return 0;
+
+    displacement_bits = lznt1_displacement_bits(pos);
+    max_displacement  = min(1U << displacement_bits, pos);
+    max_length        = min((1U << (16 - displacement_bits)) + 2, src_size - pos);
+
+    candidate = ws->HashHead[lznt1_hash(src + pos)];
+    while (candidate != LZNT1_NIL && max_depth--)
+    {
+        /* chains are ordered from the nearest to the farthest position */
+        if (pos - candidate > max_displacement)
+            break;
+
+        if (src[candidate + best_length] == src[pos + best_length] &&
+            src[candidate] == src[pos])
+        {
+            for (length = 1; length < max_length; length++)
+                if (src[candidate + length] != src[pos + length]) break;
+
+            if (length > best_length)
+            {
+                best_length   = length;
+                *displacement = pos - candidate;
+                if (length == max_length) break;
+            }
+        }
+
+        candidate = ws->HashPrev[candidate];
+    }
+
+    return (best_length >= LZNT1_MIN_MATCH) ? best_length : 0;
+}
+
+/* compress a single LZNT1 chunk, returns 0 if the result does not fit into dst */
+static ULONG lznt1_compress_chunk(UCHAR *dst, ULONG dst_size, const UCHAR *src, ULONG src_size,
+                                  USHORT engine, PLZNT1_WORKSPACE ws)
+{
+    UCHAR *dst_cur = dst, *dst_end = dst + dst_size;
+    UCHAR *flags = NULL;
+    ULONG flag_bit = 8, pos = 0, inserted = 0;
+    ULONG length, displacement, next_length, next_displacement;
+    ULONG max_depth;
+    WORD code;
+
+    max_depth = (engine == COMPRESSION_ENGINE_MAXIMUM) ? LZNT1_MAXIMUM_DEPTH : LZNT1_STANDARD_DEPTH;
+    memset(ws->HashHead, 0xFF, sizeof(ws->HashHead));
+
+    while (pos < src_size)
+    {
+        lznt1_insert(ws, src, src_size, &inserted, pos);
+        length = lznt1_find_match(ws, src, src_size, pos, max_depth, &displacement);
+
+        /* the maximum engine defers a match by one byte if that yields a longer one */
+        if (length && engine == COMPRESSION_ENGINE_MAXIMUM)
+        {
+            lznt1_insert(ws, src, src_size, &inserted, pos + 1);
+            next_length = lznt1_find_match(ws, src, src_size, pos + 1, max_depth, &next_displacement);
+            if (next_length > length)
+                length = 0;
+        }
+
+        /* start a new group of 8 entities */
+        if (flag_bit == 8)
+        {
+            if (dst_cur >= dst_end) return 0;
+            flags = dst_cur++;
+            *flags = 0;
+            flag_bit = 0;
+        }
+
+        if (length)
+        {
+            /* backwards reference */
+            if (dst_cur + sizeof(WORD) > dst_end) return 0;
+            code = (WORD)(((displacement - 1) << (16 - lznt1_displacement_bits(pos))) |
+                          (length - LZNT1_MIN_MATCH));
+            dst_cur[0] = (UCHAR)code;
+            dst_cur[1] = (UCHAR)(code >> 8);
+            dst_cur += sizeof(WORD);
+            *flags |= 1 << flag_bit;
+            pos += length;
+        }
+        else
+        {
+            /* uncompressed data */
+            if (dst_cur >= dst_end) return 0;
+            *dst_cur++ = src[pos++];
+        }
+        flag_bit++;
+    }
+
+    return dst_cur - dst;
+}
+
 static NTSTATUS
 RtlpCompressBufferLZNT1(UCHAR *src, ULONG src_size, UCHAR *dst, ULONG dst_size,
-                        ULONG chunk_size, ULONG *final_size, UCHAR *workspace)
+                        ULONG chunk_size, ULONG *final_size, UCHAR *workspace,
+                        USHORT engine)
 {
         UCHAR *src_cur = src, *src_end = src + src_size;
         UCHAR *dst_cur = dst, *dst_end = dst + dst_size;
-        ULONG block_size;
+        ULONG block_size, compressed_size;
 
         while (src_cur < src_end)
         {
             /* determine size of current chunk */
-            block_size = min(0x1000, src_end - src_cur);
-            if (dst_cur + sizeof(WORD) + block_size > dst_end)
+            block_size = min(LZNT1_CHUNK_SIZE, src_end - src_cur);
+            if (dst_cur + sizeof(WORD) > dst_end)
                 return STATUS_BUFFER_TOO_SMALL;
 
-            /* write (uncompressed) chunk header */
-            *(WORD *)dst_cur = 0x3000 | (block_size - 1);
-            dst_cur += sizeof(WORD);
+            /* a compressed chunk is only kept when it is smaller than the plain data */
+            compressed_size = 0;
+            if (workspace)
+            {
+                compressed_size = lznt1_compress_chunk(dst_cur + sizeof(WORD),
+                                                       min(dst_end - dst_cur - sizeof(WORD), block_size - 1),
+                                                       src_cur, block_size, engine,
+                                                       (PLZNT1_WORKSPACE)workspace);
+            }
+
+            if (compressed_size)
+            {
+                /* write compressed chunk header */
+                *(WORD *)dst_cur = 0xB000 | (compressed_size - 1);
+                dst_cur += sizeof(WORD) + compressed_size;
+            }
+            else
+            {
+                if (dst_cur + sizeof(WORD) + block_size > dst_end)
+                    return STATUS_BUFFER_TOO_SMALL;
+
+                /* write (uncompressed) chunk header */
+                *(WORD *)dst_cur = 0x3000 | (block_size - 1);
+                dst_cur += sizeof(WORD);
+
+                /* write chunk content */
+                memcpy(dst_cur, src_cur, block_size);
+                dst_cur += block_size;
+            }
 
-            /* write chunk content */
-            memcpy(dst_cur, src_cur, block_size);
-            dst_cur += block_size;
             src_cur += block_size;
         }
 
@@ -261,7 +460,7 @@ RtlpWorkSpaceSizeLZNT1(USHORT Engine,
    }
    else if (Engine == COMPRESSION_ENGINE_MAXIMUM)
    {
-      *BufferAndWorkSpaceSize = 0x10;
+      *BufferAndWorkSpaceSize = 0x8010;
       *FragmentWorkSpaceSize = 0x1000;
       return(STATUS_SUCCESS);
    }
@@ -270,6 +469,912 @@ RtlpWorkSpaceSizeLZNT1(USHORT Engine,
 }
 
 
+/* XPRESS compression engine, plain LZ77 and LZ77+Huffman as described in [MS-XCA] */
+
+typedef struct _XPRESS_ITEM
+{
+    USHORT Offset;  /* 0 for a literal */
+    USHORT Value;   /* literal byte or match length - 3 */
+} XPRESS_ITEM, *PXPRESS_ITEM;
+
+typedef struct _XPRESS_WORKSPACE
+{
+    /* match finder, positions are stored + 1 and the chains as distances */
+    ULONG HashHead[1 << XPRESS_HASH_BITS];
+    USHORT HashPrev[0x10000];
+
+    /* only used by the Huffman variant */
+    XPRESS_ITEM Items[XPRESS_HUFF_BLOCK_SIZE];
+    ULONG Frequencies[XPRESS_HUFF_SYMBOLS];
+    ULONG NodeWeights[2 * XPRESS_HUFF_SYMBOLS];
+    USHORT NodeParents[2 * XPRESS_HUFF_SYMBOLS];
+    UCHAR NodeDepths[2 * XPRESS_HUFF_SYMBOLS];
+    USHORT Symbols[XPRESS_HUFF_SYMBOLS];
+    USHORT Codes[XPRESS_HUFF_SYMBOLS];
+    UCHAR Lengths[XPRESS_HUFF_SYMBOLS];
+} XPRESS_WORKSPACE, *PXPRESS_WORKSPACE;
+
+/* canonical Huffman decoding tables, codes up to XPRESS_HUFF_TABLE_BITS are resolved at once */
+typedef struct _XPRESS_HUFF_DECODER
+{
+    USHORT Table[1 << XPRESS_HUFF_TABLE_BITS];
+    USHORT Count[XPRESS_HUFF_MAX_BITS + 1];
+    USHORT FirstCode[XPRESS_HUFF_MAX_BITS + 1];
+    USHORT FirstIndex[XPRESS_HUFF_MAX_BITS + 1];
+    USHORT Symbols[XPRESS_HUFF_SYMBOLS];
+} XPRESS_HUFF_DECODER, *PXPRESS_HUFF_DECODER;
+
+typedef struct _XPRESS_BIT_WRITER
+{
+    UCHAR *Slot1;
+    UCHAR *Slot2;
+    UCHAR *Output;
+    UCHAR *OutputEnd;
+    ULONG Bits;
+    ULONG FreeBits;
+    BOOLEAN Overflow;
+} XPRESS_BIT_WRITER, *PXPRESS_BIT_WRITER;
+
+static __inline void xpress_write16(UCHAR *dst, ULONG value)
+{
+    dst[0] = (UCHAR)value;
+    dst[1] = (UCHAR)(value >> 8);
+}
+
+static __inline void xpress_write32(UCHAR *dst, ULONG value)
+{
+    xpress_write16(dst, value);
+    xpress_write16(dst + 2, value >> 16);
+}
+
+static __inline ULONG xpress_read16(const UCHAR *src)
+{
+    return src[0] | (src[1] << 8);
+}
+
+static __inline ULONG xpress_read32(const UCHAR *src)
+{
+    return xpress_read16(src) | (xpress_read16(src + 2) << 16);
+}
+
+static __inline ULONG xpress_hash(const UCHAR *src)
+{
+    ULONG value = src[0] | (src[1] << 8) | (src[2] << 16);
+    return (value * 2654435761U) >> (32 - XPRESS_HASH_BITS);
+}
+
+/* insert all positions up to (but excluding) end into the hash chains */
+static void xpress_insert(PXPRESS_WORKSPACE ws, const UCHAR *src, ULONG src_size,
+                          ULONG *inserted, ULONG end)
+{
+    ULONG pos, hash, distance;
+
+    for (pos = *inserted; pos < end; pos++)
+    {
+        if (pos + XPRESS_MIN_MATCH > src_size) break;
+        hash = xpress_hash(src + pos);
+        distance = ws->HashHead[hash] ? pos + 1 - ws->HashHead[hash] : 0;
+        ws->HashPrev[pos & 0xFFFF] = (distance > 0xFFFF) ? 0 : (USHORT)distance;
+        ws->HashHead[hash] = pos + 1;
+    }
+
+    if (end > *inserted)
+        *inserted = end;
+}
+
+/* find the longest match for the given position, all earlier positions must be inserted */
+static ULONG xpress_find_match(PXPRESS_WORKSPACE ws, const UCHAR *src, ULONG pos,
+                               ULONG max_length, ULONG window, ULONG max_depth,
+                               ULONG *offset)
+{
+    ULONG best_length = 0, length, candidate, head, step;
+
+    if (max_length < XPRESS_MIN_MATCH)
+        return 0;
+
+    head = ws->HashHead[xpress_hash(src + pos)];
+    if (!head)
+        return 0;
+
+    candidate = head - 1;
+    while (max_depth--)
+    {
+        if (pos - candidate > window)
+            break;
+
+        if (src[candidate + best_length] == src[pos + best_length] &&
+            src[candidate] == src[pos])
+        {
+            for (length = 1; length < max_length; length++)
+                if (src[candidate + length] != src[pos + length]) break;
+
+            if (length > best_length)
+            {
+                best_length = length;
+                *offset     = pos - candidate;
+                if (length == max_length) break;
+            }
+        }
+
+        step = ws->HashPrev[candidate & 0xFFFF];
+        if (!step || step > candidate)
+            break;
+        candidate -= step;
+    }
+
+    return (best_length >= XPRESS_MIN_MATCH) ? best_length : 0;
+}
+
+/* run the match finder on one position, the maximum engine looks one byte ahead */
+static ULONG xpress_next_match(PXPRESS_WORKSPACE ws, const UCHAR *src, ULONG src_size,
+                               ULONG pos, ULONG end, ULONG window, USHORT engine,
+                               ULONG *inserted, ULONG *offset)
+{
+    ULONG length, next_length, next_offset, max_depth;
+
+    max_depth = (engine == COMPRESSION_ENGINE_MAXIMUM) ? XPRESS_MAXIMUM_DEPTH : XPRESS_STANDARD_DEPTH;
+
+    xpress_insert(ws, src, src_size, inserted, pos);
+    length = xpress_find_match(ws, src, pos, min(end - pos, XPRESS_MAX_MATCH),
+                               window, max_depth, offset);
+
+    if (length && engine == COMPRESSION_ENGINE_MAXIMUM && pos + 1 < end)
+    {
+        xpress_insert(ws, src, src_size, inserted, pos + 1);
+        next_length = xpress_find_match(ws, src, pos + 1, min(end - pos - 1, XPRESS_MAX_MATCH),
+                                        window, max_depth, &next_offset);
+        if (next_length > length)
+            length = 0;
+    }
+
+    return length;
+}
+
+static NTSTATUS xpress_compress(UCHAR *src, ULONG src_size, UCHAR *dst, ULONG dst_size,
+                                ULONG *final_size, USHORT engine, PXPRESS_WORKSPACE ws)
+{
+    UCHAR *dst_cur = dst, *dst_end = dst + dst_size;
+    UCHAR *flags_ptr, *half_byte = NULL;
+    ULONG pos = 0, inserted = 0, flags = 0, flag_count = 0;
+    ULONG length, offset, code;
+
+    memset(ws->HashHead, 0, sizeof(ws->HashHead));
+
+    if (dst_size < sizeof(ULONG))
+        return STATUS_BUFFER_TOO_SMALL;
+    flags_ptr = dst_cur;
+    dst_cur += sizeof(ULONG);
+
+    while (pos < src_size)
+    {
+        length = xpress_next_match(ws, src, src_size, pos, src_size, XPRESS_WINDOW_SIZE,
+                                   engine, &inserted, &offset);
+        if (length)
+        {
+            /* back reference: 13 bits offset, 3 bits length, longer lengths in nibbles and bytes */
+            if (dst_cur + sizeof(USHORT) > dst_end) return STATUS_BUFFER_TOO_SMALL;
+            code = (offset - 1) << 3;
+            length -= XPRESS_MIN_MATCH;
+            xpress_write16(dst_cur, code | min(length, 7));
+            dst_cur += sizeof(USHORT);
+
+            if (length >= 7)
+            {
+                length -= 7;
+                if (!half_byte)
+                {
+                    if (dst_cur >= dst_end) return STATUS_BUFFER_TOO_SMALL;
+                    half_byte = dst_cur++;
+                    *half_byte = (UCHAR)min(length, 15);
+                }
+                else
+                {
+                    *half_byte |= (UCHAR)(min(length, 15) << 4);
+                    half_byte = NULL;
+                }
+
+                if (length >= 15)
+                {
+                    length -= 15;
+                    if (length < 255)
+                    {
+                        if (dst_cur >= dst_end) return STATUS_BUFFER_TOO_SMALL;
+                        *dst_cur++ = (UCHAR)length;
+                    }
+                    else
+                    {
+                        if (dst_cur + 3 > dst_end) return STATUS_BUFFER_TOO_SMALL;
+                        *dst_cur++ = 255;
+                        xpress_write16(dst_cur, length + 15 + 7);
+                        dst_cur += sizeof(USHORT);
+                    }
+                    length += 15;
+                }
+                length += 7;
+            }
+
+            flags = (flags << 1) | 1;
+            pos += length + XPRESS_MIN_MATCH;
+        }
+        else
+        {
+            /* literal */
+            if (dst_cur >= dst_end) return STATUS_BUFFER_TOO_SMALL;
+            *dst_cur++ = src[pos++];
+            flags <<= 1;
+        }
+
+        if (++flag_count == 32)
+        {
+            xpress_write32(flags_ptr, flags);
+            if (dst_cur + sizeof(ULONG) > dst_end) return STATUS_BUFFER_TOO_SMALL;
+            flags_ptr = dst_cur;
+            dst_cur += sizeof(ULONG);
+            flags = flag_count = 0;
+        }
+    }
+
+    /* pad with match flags, the decoder stops at a match once the input is consumed */
+    if (flag_count)
+        flags = (flags << (32 - flag_count)) | ((1U << (32 - flag_count)) - 1);
+    else
+        flags = 0xFFFFFFFF;
+    xpress_write32(flags_ptr, flags);
+
+    if (final_size)
+        *final_size = dst_cur - dst;
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS xpress_decompress(UCHAR *dst, ULONG dst_size, UCHAR *src, ULONG src_size,
+                                  ULONG *final_size)
+{
+    UCHAR *src_cur = src, *src_end = src + src_size;
+    UCHAR *dst_cur = dst, *dst_end = dst + dst_size;
+    UCHAR *half_byte = NULL;
+    ULONG flags = 0, flag_count = 0;
+    ULONG code, length, offset;
+
+    if (src_size < sizeof(ULONG))
+        return STATUS_BAD_COMPRESSION_BUFFER;
+
+    while (dst_cur < dst_end)
+    {
+        if (!flag_count)
+        {
+            if (src_cur + sizeof(ULONG) > src_end)
+                return STATUS_BAD_COMPRESSION_BUFFER;
+            flags = xpress_read32(src_cur);
+            src_cur += sizeof(ULONG);
+            flag_count = 32;
+        }
+        flag_count--;
+
+        /* the stream ends once all input is consumed */
+        if (src_cur >= src_end)
+            break;
+
+        if (!(flags & (1U << flag_count)))
+        {
+            /* literal */
+            *dst_cur++ = *src_cur++;
+            continue;
+        }
+
+        /* back reference */
+        if (src_cur + sizeof(USHORT) > src_end)
+            return STATUS_BAD_COMPRESSION_BUFFER;
+        code = xpress_read16(src_cur);
+        src_cur += sizeof(USHORT);
+        length = code & 7;
+        offset = (code >> 3) + 1;
+
+        if (length == 7)
+        {
+            if (!half_byte)
+            {
+                if (src_cur >= src_end)
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                half_byte = src_cur++;
+                length = *half_byte & 15;
+            }
+            else
+            {
+                length = *half_byte >> 4;
+                half_byte = NULL;
+            }
+
+            if (length == 15)
+            {
+                if (src_cur >= src_end)
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                length = *src_cur++;
+                if (length == 255)
+                {
+                    if (src_cur + sizeof(USHORT) > src_end)
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    length = xpress_read16(src_cur);
+                    src_cur += sizeof(USHORT);
+                    if (length == 0)
+                    {
+                        if (src_cur + sizeof(ULONG) > src_end)
+                            return STATUS_BAD_COMPRESSION_BUFFER;
+                        length = xpress_read32(src_cur);
+                        src_cur += sizeof(ULONG);
+                    }
+                    if (length < 15 + 7)
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    length -= 15 + 7;
+                }
+                length += 15;
+            }
+            length += 7;
+        }
+        length += XPRESS_MIN_MATCH;
+
+        /* ensure reference is valid */
+        if (offset > (ULONG)(dst_cur - dst))
+            return STATUS_BAD_COMPRESSION_BUFFER;
+
+        /* source and destination may overlap */
+        length = min(length, (ULONG)(dst_end - dst_cur));
+        while (length--)
+        {
+            *dst_cur = *(dst_cur - offset);
+            dst_cur++;
+        }
+    }
+
+    if (final_size)
+        *final_size = dst_cur - dst;
+
+    return STATUS_SUCCESS;
+}
+
+/* compute code lengths of at most XPRESS_HUFF_MAX_BITS bits for the symbol frequencies */
+static void xpress_huff_build_lengths(PXPRESS_WORKSPACE ws)
+{
+    ULONG count[XPRESS_HUFF_MAX_BITS + 1];
+    ULONG symbols = 0, leaf, node, next, i, j, picked[2], depth, bits, kraft;
+    USHORT symbol;
+
+    memset(ws->Lengths, 0, sizeof(ws->Lengths));
+    for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+        if (ws->Frequencies[i]) ws->Symbols[symbols++] = (USHORT)i;
+
+    if (symbols == 0)
+        return;
+    if (symbols == 1)
+    {
+        ws->Lengths[ws->Symbols[0]] = 1;
+        return;
+    }
+
+    /* sort by ascending frequency */
+    for (i = 1; i < symbols; i++)
+    {
+        symbol = ws->Symbols[i];
+        for (j = i; j > 0 && ws->Frequencies[ws->Symbols[j - 1]] > ws->Frequencies[symbol]; j--)
+            ws->Symbols[j] = ws->Symbols[j - 1];
+        ws->Symbols[j] = symbol;
+    }
+
+    /* two queue Huffman construction: leaves are 0..symbols-1, inner nodes follow */
+    for (i = 0; i < symbols; i++)
+        ws->NodeWeights[i] = ws->Frequencies[ws->Symbols[i]];
+
+    leaf = 0;
+    node = symbols;
+    for (next = symbols; next < 2 * symbols - 1; next++)
+    {
+        for (i = 0; i < 2; i++)
+        {
+            if (leaf < symbols && (node >= next || ws->NodeWeights[leaf] <= ws->NodeWeights[node]))
+                picked[i] = leaf++;
+            else
+                picked[i] = node++;
+        }
+        ws->NodeWeights[next] = ws->NodeWeights[picked[0]] + ws->NodeWeights[picked[1]];
+        ws->NodeParents[picked[0]] = ws->NodeParents[picked[1]] = (USHORT)next;
+    }
+
+    /* parents always have higher indices than their children */
+    memset(count, 0, sizeof(count));
+    ws->NodeDepths[2 * symbols - 2] = 0;
+    for (i = 2 * symbols - 2; i-- > 0;)
+    {
+        depth = ws->NodeDepths[ws->NodeParents[i]] + 1;
+        ws->NodeDepths[i] = (UCHAR)min(depth, 255);
+        if (i < symbols)
+            count[min(depth, XPRESS_HUFF_MAX_BITS)]++;
+    }
+
+    /* clamped codes oversubscribe the code space, lengthen the shortest possible ones */
+    kraft = 0;
+    for (bits = 1; bits <= XPRESS_HUFF_MAX_BITS; bits++)
+        kraft += count[bits] << (XPRESS_HUFF_MAX_BITS - bits);
+
+    while (kraft > (1U << XPRESS_HUFF_MAX_BITS))
+    {
+        for (bits = XPRESS_HUFF_MAX_BITS - 1; !count[bits]; bits--);
+        count[bits]--;
+        count[bits + 1]++;
+        kraft -= 1U << (XPRESS_HUFF_MAX_BITS - bits - 1);
+    }
+
+    /* the least frequent symbols get the longest codes */
+    i = 0;
+    for (bits = XPRESS_HUFF_MAX_BITS; bits > 0; bits--)
+        for (j = 0; j < count[bits]; j++)
+            ws->Lengths[ws->Symbols[i++]] = (UCHAR)bits;
+}
+
+/* assign canonical codes, ordered by length and then by symbol value */
+static void xpress_huff_build_codes(PXPRESS_WORKSPACE ws)
+{
+    USHORT next_code[XPRESS_HUFF_MAX_BITS + 1];
+    ULONG count[XPRESS_HUFF_MAX_BITS + 1];
+    ULONG i, code = 0;
+
+    memset(count, 0, sizeof(count));
+    for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+        count[ws->Lengths[i]]++;
+
+    count[0] = 0;
+    for (i = 1; i <= XPRESS_HUFF_MAX_BITS; i++)
+    {
+        code = (code + count[i - 1]) << 1;
+        next_code[i] = (USHORT)code;
+    }
+
+    for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+        if (ws->Lengths[i]) ws->Codes[i] = next_code[ws->Lengths[i]]++;
+}
+
+/* bits are packed into 16-bit words which are reserved two words ahead of the byte stream */
+static void xpress_bits_init(PXPRESS_BIT_WRITER writer, UCHAR *dst, UCHAR *dst_end)
+{
+    writer->Slot1 = dst;
+    writer->Slot2 = dst + sizeof(USHORT);
+    writer->Output = dst + 2 * sizeof(USHORT);
+    writer->OutputEnd = dst_end;
+    writer->Bits = 0;
+    writer->FreeBits = 16;
+    writer->Overflow = (writer->Output > dst_end);
+}
+
+static void xpress_bits_write(PXPRESS_BIT_WRITER writer, ULONG value, ULONG count)
+{
+    if (count <= writer->FreeBits)
+    {
+        writer->Bits = (writer->Bits << count) | value;
+        writer->FreeBits -= count;
+        return;
+    }
+
+    count -= writer->FreeBits;
+    writer->Bits = (writer->Bits << writer->FreeBits) | (value >> count);
+    xpress_write16(writer->Slot1, writer->Bits);
+
+    writer->Slot1 = writer->Slot2;
+    if (writer->Output + sizeof(USHORT) > writer->OutputEnd)
+    {
+        /* keep writing into the last slot, the caller only checks for overflow at the end */
+        writer->Overflow = TRUE;
+        writer->Output = writer->Slot1;
+    }
+    writer->Slot2 = writer->Output;
+    writer->Output += sizeof(USHORT);
+
+    writer->Bits = value & ((1U << count) - 1);
+    writer->FreeBits = 16 - count;
+}
+
+static void xpress_bits_write_byte(PXPRESS_BIT_WRITER writer, UCHAR value)
+{
+    if (writer->Output >= writer->OutputEnd)
+    {
+        writer->Overflow = TRUE;
+        return;
+    }
+    *writer->Output++ = value;
+}
+
+static void xpress_bits_flush(PXPRESS_BIT_WRITER writer)
+{
+    xpress_write16(writer->Slot1, writer->Bits << writer->FreeBits);
+    xpress_write16(writer->Slot2, 0);
+}
+
+static NTSTATUS xpress_huff_compress(UCHAR *src, ULONG src_size, UCHAR *dst, ULONG dst_size,
+                                     ULONG *final_size, USHORT engine, PXPRESS_WORKSPACE ws)
+{
+    UCHAR *dst_cur = dst, *dst_end = dst + dst_size;
+    ULONG block_start = 0, block_end, pos, inserted = 0, items, i;
+    ULONG length, offset, offset_bits, symbol;
+    XPRESS_BIT_WRITER writer;
+    PXPRESS_ITEM item;
+    BOOLEAN last;
+
+    memset(ws->HashHead, 0, sizeof(ws->HashHead));
+
+    do
+    {
+        block_end = block_start + min(src_size - block_start, XPRESS_HUFF_BLOCK_SIZE);
+        last = (block_end == src_size);
+
+        /* parse the block first, its Huffman table depends on the symbol frequencies */
+        memset(ws->Frequencies, 0, sizeof(ws->Frequencies));
+        items = 0;
+        for (pos = block_start; pos < block_end;)
+        {
+            item = &ws->Items[items++];
+            length = xpress_next_match(ws, src, src_size, pos, block_end, XPRESS_HUFF_WINDOW_SIZE,
+                                       engine, &inserted, &offset);
+
+            /* symbol 256 is reserved for the end of the stream */
+            if (length == XPRESS_MIN_MATCH && offset == 1)
+                length = 0;
+
+            if (length)
+            {
+                for (offset_bits = 0; (offset >> offset_bits) > 1; offset_bits++);
+                item->Offset = (USHORT)offset;
+                item->Value = (USHORT)(length - XPRESS_MIN_MATCH);
+                ws->Frequencies[256 + (offset_bits << 4) + min(item->Value, 15)]++;
+                pos += length;
+            }
+            else
+            {
+                item->Offset = 0;
+                item->Value = src[pos++];
+                ws->Frequencies[item->Value]++;
+            }
+        }
+        if (last)
+            ws->Frequencies[256]++;
+
+        xpress_huff_build_lengths(ws);
+        xpress_huff_build_codes(ws);
+
+        /* 512 code lengths of 4 bits each */
+        if ((ULONG)(dst_end - dst_cur) < XPRESS_HUFF_SYMBOLS / 2)
+            return STATUS_BUFFER_TOO_SMALL;
+        for (i = 0; i < XPRESS_HUFF_SYMBOLS / 2; i++)
+            dst_cur[i] = ws->Lengths[2 * i] | (ws->Lengths[2 * i + 1] << 4);
+        dst_cur += XPRESS_HUFF_SYMBOLS / 2;
+
+        xpress_bits_init(&writer, dst_cur, dst_end);
+        for (i = 0; i < items && !writer.Overflow; i++)
+        {
+            item = &ws->Items[i];
+            if (!item->Offset)
+            {
+                xpress_bits_write(&writer, ws->Codes[item->Value], ws->Lengths[item->Value]);
+                continue;
+            }
+
+            for (offset_bits = 0; (item->Offset >> offset_bits) > 1; offset_bits++);
+            symbol = 256 + (offset_bits << 4) + min(item->Value, 15);
+            xpress_bits_write(&writer, ws->Codes[symbol], ws->Lengths[symbol]);
+
+            if (item->Value >= 15)
+            {
+                if (item->Value - 15 < 255)
+                {
+                    xpress_bits_write_byte(&writer, (UCHAR)(item->Value - 15));
+                }
+                else
+                {
+                    xpress_bits_write_byte(&writer, 255);
+                    xpress_bits_write_byte(&writer, (UCHAR)item->Value);
+                    xpress_bits_write_byte(&writer, (UCHAR)(item->Value >> 8));
+                }
+            }
+
+            xpress_bits_write(&writer, item->Offset & ((1U << offset_bits) - 1), offset_bits);
+        }
+        if (last)
+            xpress_bits_write(&writer, ws->Codes[256], ws->Lengths[256]);
+
+        if (writer.Overflow)
+            return STATUS_BUFFER_TOO_SMALL;
+
+        xpress_bits_flush(&writer);
+        dst_cur = writer.Output;
+        block_start = block_end;
+    }
+    while (!last);
+
+    if (final_size)
+        *final_size = dst_cur - dst;
+
+    return STATUS_SUCCESS;
+}
+
+static BOOLEAN xpress_huff_build_decoder(PXPRESS_HUFF_DECODER decoder, const UCHAR *lengths)
+{
+    USHORT next_index[XPRESS_HUFF_MAX_BITS + 1];
+    ULONG i, bits, code, index, fill, symbol;
+    LONG left;
+
+    memset(decoder->Count, 0, sizeof(decoder->Count));
+    for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+        decoder->Count[(lengths[i / 2] >> (4 * (i & 1))) & 15]++;
+    decoder->Count[0] = 0;
+
+    /* reject oversubscribed code spaces */
+    left = 1;
+    for (bits = 1; bits <= XPRESS_HUFF_MAX_BITS; bits++)
+    {
+        left = (left << 1) - decoder->Count[bits];
+        if (left < 0)
+            return FALSE;
+    }
+
+    code = index = 0;
+    for (bits = 1; bits <= XPRESS_HUFF_MAX_BITS; bits++)
+    {
+        code = (code + decoder->Count[bits - 1]) << 1;
+        decoder->FirstCode[bits] = (USHORT)code;
+        decoder->FirstIndex[bits] = next_index[bits] = (USHORT)index;
+        index += decoder->Count[bits];
+    }
+
+    for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+    {
+        bits = (lengths[i / 2] >> (4 * (i & 1))) & 15;
+        if (bits) decoder->Symbols[next_index[bits]++] = (USHORT)i;
+    }
+
+    memset(decoder->Table, 0, sizeof(decoder->Table));
+    for (bits = 1; bits <= XPRESS_HUFF_TABLE_BITS; bits++)
+    {
+        for (i = 0; i < decoder->Count[bits]; i++)
+        {
+            symbol = decoder->Symbols[decoder->FirstIndex[bits] + i];
+            code = (decoder->FirstCode[bits] + i) << (XPRESS_HUFF_TABLE_BITS - bits);
+            for (fill = 0; fill < (1U << (XPRESS_HUFF_TABLE_BITS - bits)); fill++)
+                decoder->Table[code + fill] = (USHORT)((symbol << 4) | bits);
+        }
+    }
+
+    return TRUE;
+}
+
+/* decode the next symbol from the top bits, returns its length or 0 for an invalid code */
+static __inline ULONG xpress_huff_decode(PXPRESS_HUFF_DECODER decoder, ULONG next_bits, ULONG *symbol)
+{
+    ULONG entry, bits, code;
+
+    entry = decoder->Table[next_bits >> (32 - XPRESS_HUFF_TABLE_BITS)];
+    if (entry)
+    {
+        *symbol = entry >> 4;
+        return entry & 15;
+    }
+
+    for (bits = XPRESS_HUFF_TABLE_BITS + 1; bits <= XPRESS_HUFF_MAX_BITS; bits++)
+    {
+        code = (next_bits >> (32 - bits)) - decoder->FirstCode[bits];
+        if (code < decoder->Count[bits])
+        {
+            *symbol = decoder->Symbols[decoder->FirstIndex[bits] + code];
+            return bits;
+        }
+    }
+
+    return 0;
+}
+
+static NTSTATUS xpress_huff_decompress(UCHAR *dst, ULONG dst_size, UCHAR *src, ULONG src_size,
+                                       ULONG *final_size, PXPRESS_HUFF_DECODER decoder)
+{
+    UCHAR *src_cur = src, *src_end = src + src_size;
+    UCHAR *dst_cur = dst, *dst_end = dst + dst_size;
+    ULONG next_bits, block_left, symbol, bits, length, offset, offset_bits;
+    LONG extra_bits;
+
+#define XPRESS_CONSUME_BITS(count) \
+    do { \
+        next_bits <<= (count); \
+        extra_bits -= (count); \
+        if (extra_bits < 0) \
+        { \
+            if (src_cur + sizeof(USHORT) <= src_end) \
+            { \
+                next_bits |= xpress_read16(src_cur) << -extra_bits; \
+                src_cur += sizeof(USHORT); \
+            } \
+            extra_bits += 16; \
+        } \
+    } while (0)
+
+    while (dst_cur < dst_end)
+    {
+        /* every 64 KB of output start with a new table */
+        if (src_cur + XPRESS_HUFF_SYMBOLS / 2 + sizeof(ULONG) > src_end)
+        {
+            if (dst_cur == dst)
+                return STATUS_BAD_COMPRESSION_BUFFER;
+            break;
+        }
+
+        if (!xpress_huff_build_decoder(decoder, src_cur))
+            return STATUS_BAD_COMPRESSION_BUFFER;
+        src_cur += XPRESS_HUFF_SYMBOLS / 2;
+
+        next_bits = (xpress_read16(src_cur) << 16) | xpress_read16(src_cur + sizeof(USHORT));
+        src_cur += sizeof(ULONG);
+        extra_bits = 16;
+
+        block_left = XPRESS_HUFF_BLOCK_SIZE;
+        while (block_left && dst_cur < dst_end)
+        {
+            bits = xpress_huff_decode(decoder, next_bits, &symbol);
+            if (!bits)
+                return STATUS_BAD_COMPRESSION_BUFFER;
+            XPRESS_CONSUME_BITS(bits);
+
+            if (symbol < 256)
+            {
+                *dst_cur++ = (UCHAR)symbol;
+                block_left--;
+                continue;
+            }
+
+            /* the end of stream symbol is the last one in the input */
+            if (symbol == 256 && src_cur >= src_end)
+                goto out;
+
+            symbol -= 256;
+            length = symbol & 15;
+            offset_bits = symbol >> 4;
+
+            if (length == 15)
+            {
+                if (src_cur >= src_end)
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                length = *src_cur++;
+                if (length == 255)
+                {
+                    if (src_cur + sizeof(USHORT) > src_end)
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    length = xpress_read16(src_cur);
+                    src_cur += sizeof(USHORT);
+                    if (length < 15)
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    length -= 15;
+                }
+                length += 15;
+            }
+            length += XPRESS_MIN_MATCH;
+
+            offset = (offset_bits ? next_bits >> (32 - offset_bits) : 0) + (1U << offset_bits);
+            XPRESS_CONSUME_BITS(offset_bits);
+
+            /* ensure reference is valid */
+            if (offset > (ULONG)(dst_cur - dst))
+                return STATUS_BAD_COMPRESSION_BUFFER;
+
+            /* matches may run past the block end, the next block starts where they stop */
+            length = min(length, (ULONG)(dst_end - dst_cur));
+            block_left -= min(length, block_left);
+            while (length--)
+            {
+                *dst_cur = *(dst_cur - offset);
+                dst_cur++;
+            }
+        }
+    }
+
+#undef XPRESS_CONSUME_BITS
+
+out:
+    if (final_size)
+        *final_size = dst_cur - dst;
+
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS
+RtlpCompressBufferXpress(USHORT format, UCHAR *src, ULONG src_size, UCHAR *dst, ULONG dst_size,
+                         ULONG *final_size, UCHAR *workspace, USHORT engine)
+{
+    if (!workspace)
+        return STATUS_INVALID_PARAMETER;
+
+    if (format == COMPRESSION_FORMAT_XPRESS)
+        return xpress_compress(src, src_size, dst, dst_size, final_size, engine,
+                               (PXPRESS_WORKSPACE)workspace);
+
+    return xpress_huff_compress(src, src_size, dst, dst_size, final_size, engine,
+                                (PXPRESS_WORKSPACE)workspace);
+}
+
+static NTSTATUS
+RtlpDecompressXpress(USHORT format, UCHAR *dst, ULONG dst_size, UCHAR *src, ULONG src_size,
+                     ULONG *final_size, UCHAR *workspace)
+{
+    PXPRESS_HUFF_DECODER decoder = (PXPRESS_HUFF_DECODER)workspace;
+    NTSTATUS status;
+
+    if (format == COMPRESSION_FORMAT_XPRESS)
+        return xpress_decompress(dst, dst_size, src, src_size, final_size);
+
+    /* RtlDecompressBuffer has no workspace, the decoding tables are allocated then */
+    if (!decoder)
+    {
+        decoder = RtlpAllocateMemory(sizeof(XPRESS_HUFF_DECODER), TAG_COMPRESS);
+        if (!decoder)
+            return STATUS_NO_MEMORY;
+    }
+
+    status = xpress_huff_decompress(dst, dst_size, src, src_size, final_size, decoder);
+
+    if (decoder != (PXPRESS_HUFF_DECODER)workspace)
+        RtlpFreeMemory(decoder, TAG_COMPRESS);
+
+    return status;
+}
+
+/* XPRESS streams have no chunks, so data before the offset is decoded into a scratch buffer */
+static NTSTATUS
+RtlpDecompressFragmentXpress(USHORT format, UCHAR *dst, ULONG dst_size, UCHAR *src, ULONG src_size,
+                             ULONG offset, ULONG *final_size, UCHAR *workspace)
+{
+    ULONG scratch_size;
+    UCHAR *scratch;
+    NTSTATUS status;
+
+    if (!offset)
+        return RtlpDecompressXpress(format, dst, dst_size, src, src_size, final_size, workspace);
+
+    if (dst_size > MAXULONG - offset)
+        return STATUS_INVALID_PARAMETER;
+
+    scratch = RtlpAllocateMemory(offset + dst_size, TAG_COMPRESS);
+    if (!scratch)
+        return STATUS_NO_MEMORY;
+
+    status = RtlpDecompressXpress(format, scratch, offset + dst_size, src, src_size, &scratch_size, workspace);
+    if (NT_SUCCESS(status))
+    {
+        scratch_size = (scratch_size > offset) ? scratch_size - offset : 0;
+        memcpy(dst, scratch + offset, scratch_size);
+        if (final_size)
+            *final_size = scratch_size;
+    }
+
+    RtlpFreeMemory(scratch, TAG_COMPRESS);
+    return status;
+}
+
+static NTSTATUS
+RtlpWorkSpaceSizeXpress(USHORT Format,
+                        USHORT Engine,
+                        PULONG BufferAndWorkSpaceSize,
+                        PULONG FragmentWorkSpaceSize)
+{
+   if (Engine != COMPRESSION_ENGINE_STANDARD && Engine != COMPRESSION_ENGINE_MAXIMUM)
+      return(STATUS_NOT_SUPPORTED);
+
+   if (Format == COMPRESSION_FORMAT_XPRESS)
+   {
+      *BufferAndWorkSpaceSize = FIELD_OFFSET(XPRESS_WORKSPACE, Items);
+      *FragmentWorkSpaceSize = 0;
+   }
+   else
+   {
+      *BufferAndWorkSpaceSize = sizeof(XPRESS_WORKSPACE);
+      *FragmentWorkSpaceSize = sizeof(XPRESS_HUFF_DECODER);
+   }
+
+   return(STATUS_SUCCESS);
+}
+
+
 /*
  * @implemented
  */
@@ -284,7 +1389,7 @@ RtlCompressBuffer(IN USHORT CompressionFormatAndEngine,
                   IN PVOID WorkSpace)
 {
    USHORT Format = CompressionFormatAndEngine & COMPRESSION_FORMAT_MASK;
-   /* USHORT Engine = CompressionFormatAndEngine & COMPRESSION_ENGINE_MASK; */
+   USHORT Engine = CompressionFormatAndEngine & COMPRESSION_ENGINE_MASK;
 
    if ((Format == COMPRESSION_FORMAT_NONE) ||
          (Format == COMPRESSION_FORMAT_DEFAULT))
@@ -297,14 +1402,187 @@ RtlCompressBuffer(IN USHORT CompressionFormatAndEngine,
                                      CompressedBufferSize,
                                      UncompressedChunkSize,
                                      FinalCompressedSize,
-                                     WorkSpace));
+                                     WorkSpace,
+                                     Engine));
+
+   if ((Format == COMPRESSION_FORMAT_XPRESS) ||
+         (Format == COMPRESSION_FORMAT_XPRESS_HUFF))
+      return(RtlpCompressBufferXpress(Format,
+                                      UncompressedBuffer,
+                                      UncompressedBufferSize,
+                                      CompressedBuffer,
+                                      CompressedBufferSize,
+                                      FinalCompressedSize,
+                                      WorkSpace,
+                                      Engine));
 
    return(STATUS_UNSUPPORTED_COMPRESSION);
 }
 
 
+/* Chunked (de)compression, used for compression units where every chunk stands on its own */
+
+typedef struct _RTLP_CHUNK_CONTEXT
+{
+    USHORT CompressionFormat;
+    PUCHAR UncompressedBuffer;
+    ULONG UncompressedBufferSize;
+    ULONG ChunkShift;
+    PCOMPRESSED_DATA_INFO CompressedDataInfo;
+    PUCHAR *ChunkBuffers;
+    volatile LONG NextChunk;
+    volatile LONG PendingWorkers;
+    volatile NTSTATUS Status;
+    HANDLE WorkersDone;
+} RTLP_CHUNK_CONTEXT, *PRTLP_CHUNK_CONTEXT;
+
+static BOOLEAN
+RtlpIsChunkZero(PUCHAR Buffer, ULONG Size)
+{
+    while (Size--)
+        if (*Buffer++) return FALSE;
+    return TRUE;
+}
+
+/* decompress one chunk, a size of zero means all zeros and a full size means stored data */
+static NTSTATUS
+RtlpDecompressChunk(USHORT CompressionFormat,
+                    PUCHAR UncompressedChunk,
+                    ULONG UncompressedChunkSize,
+                    PUCHAR CompressedChunk,
+                    ULONG CompressedChunkSize)
+{
+    ULONG FinalSize;
+    NTSTATUS Status;
+
+    if (CompressedChunkSize == 0)
+    {
+        RtlZeroMemory(UncompressedChunk, UncompressedChunkSize);
+        return STATUS_SUCCESS;
+    }
+
+    if (CompressedChunkSize == UncompressedChunkSize)
+    {
+        RtlCopyMemory(UncompressedChunk, CompressedChunk, UncompressedChunkSize);
+        return STATUS_SUCCESS;
+    }
+
+    Status = RtlDecompressBuffer(CompressionFormat,
+                                 UncompressedChunk,
+                                 UncompressedChunkSize,
+                                 CompressedChunk,
+                                 CompressedChunkSize,
+                                 &FinalSize);
+    if (!NT_SUCCESS(Status))
+        return Status;
+
+    /* trailing zeros are not part of the compressed stream */
+    if (FinalSize < UncompressedChunkSize)
+        RtlZeroMemory(UncompressedChunk + FinalSize, UncompressedChunkSize - FinalSize);
+
+    return STATUS_SUCCESS;
+}
+
+/* grab chunks from the shared context until none is left or one of them failed */
+static VOID
+RtlpDecompressChunkRange(PRTLP_CHUNK_CONTEXT Context)
+{
+    ULONG Chunk, Offset;
+    NTSTATUS Status;
+
+    while (NT_SUCCESS(Context->Status))
+    {
+        Chunk = InterlockedIncrement(&Context->NextChunk) - 1;
+        if (Chunk >= Context->CompressedDataInfo->NumberOfChunks)
+            break;
+
+        Offset = Chunk << Context->ChunkShift;
+        Status = RtlpDecompressChunk(Context->CompressionFormat,
+                                     Context->UncompressedBuffer + Offset,
+                                     min(1UL << Context->ChunkShift, Context->UncompressedBufferSize - Offset),
+                                     Context->ChunkBuffers[Chunk],
+                                     Context->CompressedDataInfo->CompressedChunkSizes[Chunk]);
+        if (!NT_SUCCESS(Status))
+            InterlockedCompareExchange(&Context->Status, Status, STATUS_SUCCESS);
+    }
+}
+
+static VOID
+NTAPI
+RtlpDecompressChunksWorker(PVOID Parameter)
+{
+    PRTLP_CHUNK_CONTEXT Context = Parameter;
+
+    RtlpDecompressChunkRange(Context);
+
+    /* the last one out wakes up the caller, who keeps the context alive until then */
+    if (!InterlockedDecrement(&Context->PendingWorkers))
+        ZwSetEvent(Context->WorkersDone, NULL);
+}
+
+/* spread the chunks over worker threads, the calling thread takes part as well */
+static BOOLEAN
+RtlpDecompressChunksParallel(PRTLP_CHUNK_CONTEXT Context, PUCHAR CompressedBuffer, PUCHAR CompressedTail)
+{
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    ULONG Workers, i;
+    NTSTATUS Status;
+
+    if (Context->UncompressedBufferSize < RTLP_PARALLEL_CHUNKS_MIN_SIZE)
+        return FALSE;
+
+    /* kernel mode workers run in the system process and cannot see user buffers */
+    if (RtlpGetMode() == KernelMode &&
+        ((PVOID)Context->UncompressedBuffer <= MmHighestUserAddress ||
+         (PVOID)CompressedBuffer <= MmHighestUserAddress ||
+         (CompressedTail && (PVOID)CompressedTail <= MmHighestUserAddress)))
+    {
+        return FALSE;
+    }
+
+    Workers = min(RtlpGetNumberOfProcessors(),
+                  Context->CompressedDataInfo->NumberOfChunks / RTLP_PARALLEL_CHUNKS_PER_WORKER);
+    if (Workers < 2)
+        return FALSE;
+
+    /* block instead of spinning, so that a worker thread calling us lets the other workers run */
+    InitializeObjectAttributes(&ObjectAttributes,
+                               NULL,
+                               RtlpGetMode() == KernelMode ? OBJ_KERNEL_HANDLE : 0,
+                               NULL,
+                               NULL);
+    Status = ZwCreateEvent(&Context->WorkersDone,
+                           EVENT_ALL_ACCESS,
+                           &ObjectAttributes,
+                           NotificationEvent,
+                           FALSE);
+    if (!NT_SUCCESS(Status))
+        return FALSE;
+
+    /* the calling thread holds a reference of its own until its share is done */
+    Context->PendingWorkers = 1;
+    for (i = 1; i < Workers; i++)
+    {
+        InterlockedIncrement(&Context->PendingWorkers);
+        if (!RtlpQueueWorkItem(RtlpDecompressChunksWorker, Context))
+        {
+            InterlockedDecrement(&Context->PendingWorkers);
+            break;
+        }
+    }
+
+    RtlpDecompressChunkRange(Context);
+
+    /* the context lives on our stack, wait for the workers to drop it */
+    if (InterlockedDecrement(&Context->PendingWorkers))
+        ZwWaitForSingleObject(Context->WorkersDone, FALSE, NULL);
+
+    ZwClose(Context->WorkersDone);
+    return TRUE;
+}
+
 /*
- * @unimplemented
+ * @implemented
  */
 NTSTATUS NTAPI
 RtlCompressChunks(IN PUCHAR UncompressedBuffer,
@@ -315,12 +1593,80 @@ RtlCompressChunks(IN PUCHAR UncompressedBuffer,
                   IN ULONG CompressedDataInfoLength,
                   IN PVOID WorkSpace)
 {
-    UNIMPLEMENTED;
-    return STATUS_NOT_IMPLEMENTED;
+    PUCHAR Source = UncompressedBuffer, SourceEnd = UncompressedBuffer + UncompressedBufferSize;
+    PUCHAR Destination = CompressedBuffer, DestinationEnd = CompressedBuffer + CompressedBufferSize;
+    ULONG ChunkSize, NumberOfChunks, ThisChunkSize, FinalSize, Chunk;
+    ULONG ClusterMask;
+    NTSTATUS Status;
+
+    if (CompressedDataInfo->ChunkShift < 9 || CompressedDataInfo->ChunkShift > 16)
+        return STATUS_INVALID_PARAMETER;
+
+    ChunkSize = 1 << CompressedDataInfo->ChunkShift;
+    NumberOfChunks = (UncompressedBufferSize + ChunkSize - 1) >> CompressedDataInfo->ChunkShift;
+    if (NumberOfChunks > MAXUSHORT)
+        return STATUS_INVALID_PARAMETER;
+
+    if (CompressedDataInfoLength < FIELD_OFFSET(COMPRESSED_DATA_INFO, CompressedChunkSizes[NumberOfChunks]))
+        return STATUS_BUFFER_TOO_SMALL;
+
+    CompressedDataInfo->NumberOfChunks = (USHORT)NumberOfChunks;
+
+    for (Chunk = 0; Chunk < NumberOfChunks; Chunk++)
+    {
+        ThisChunkSize = min(ChunkSize, SourceEnd - Source);
+
+        if (RtlpIsChunkZero(Source, ThisChunkSize))
+        {
+            /* all-zero chunks take no space at all */
+            FinalSize = 0;
+        }
+        else
+        {
+            /* only keep compressed data when it is smaller than the chunk itself */
+            Status = RtlCompressBuffer(CompressedDataInfo->CompressionFormatAndEngine,
+                                       Source,
+                                       ThisChunkSize,
+                                       Destination,
+                                       min(ThisChunkSize - 1, DestinationEnd - Destination),
+                                       0x1000,
+                                       &FinalSize,
+                                       WorkSpace);
+            if (Status == STATUS_BUFFER_TOO_SMALL)
+            {
+                if (Destination + ThisChunkSize > DestinationEnd)
+                    return STATUS_BUFFER_TOO_SMALL;
+
+                RtlCopyMemory(Destination, Source, ThisChunkSize);
+                FinalSize = ThisChunkSize;
+            }
+            else if (!NT_SUCCESS(Status))
+            {
+                return Status;
+            }
+        }
+
+        CompressedDataInfo->CompressedChunkSizes[Chunk] = FinalSize;
+        Destination += FinalSize;
+        Source += ThisChunkSize;
+    }
+
+    /* compression that does not save at least one cluster is pointless for the caller */
+    if (CompressedDataInfo->ClusterShift)
+    {
+        ClusterMask = (1 << CompressedDataInfo->ClusterShift) - 1;
+        if (((Destination - CompressedBuffer + ClusterMask) & ~ClusterMask) >=
+            ((UncompressedBufferSize + ClusterMask) & ~ClusterMask))
+        {
+            return STATUS_BUFFER_TOO_SMALL;
+        }
+    }
+
+    return STATUS_SUCCESS;
 }
 
 /*
- * @unimplemented
+ * @implemented
  */
 NTSTATUS NTAPI
 RtlDecompressChunks(OUT PUCHAR UncompressedBuffer,
@@ -331,8 +1677,79 @@ RtlDecompressChunks(OUT PUCHAR UncompressedBuffer,
                     IN ULONG CompressedTailSize,
                     IN PCOMPRESSED_DATA_INFO CompressedDataInfo)
 {
-    UNIMPLEMENTED;
-    return STATUS_NOT_IMPLEMENTED;
+    PUCHAR Source = CompressedBuffer, SourceEnd = CompressedBuffer + CompressedBufferSize;
+    RTLP_CHUNK_CONTEXT Context;
+    ULONG ChunkSize, Chunk, CompressedChunkSize;
+    BOOLEAN InTail = FALSE;
+    PUCHAR *ChunkBuffers;
+    NTSTATUS Status;
+
+    if (CompressedDataInfo->ChunkShift < 9 || CompressedDataInfo->ChunkShift > 16)
+        return STATUS_INVALID_PARAMETER;
+
+    ChunkSize = 1 << CompressedDataInfo->ChunkShift;
+    if ((ULONG)CompressedDataInfo->NumberOfChunks << CompressedDataInfo->ChunkShift >=
+        UncompressedBufferSize + ChunkSize)
+    {
+        return STATUS_BAD_COMPRESSION_BUFFER;
+    }
+
+    Context.CompressionFormat = CompressedDataInfo->CompressionFormatAndEngine;
+    Context.UncompressedBuffer = UncompressedBuffer;
+    Context.UncompressedBufferSize = UncompressedBufferSize;
+    Context.ChunkShift = CompressedDataInfo->ChunkShift;
+    Context.CompressedDataInfo = CompressedDataInfo;
+    Context.NextChunk = 0;
+    Context.Status = STATUS_SUCCESS;
+
+    ChunkBuffers = RtlpAllocateMemory(max(CompressedDataInfo->NumberOfChunks, 1) * sizeof(PUCHAR), TAG_COMPRESS);
+    if (!ChunkBuffers)
+        return STATUS_NO_MEMORY;
+    Context.ChunkBuffers = ChunkBuffers;
+
+    /* locate every chunk first, the ones which do not fit into the buffer live in the tail */
+    for (Chunk = 0; Chunk < CompressedDataInfo->NumberOfChunks; Chunk++)
+    {
+        CompressedChunkSize = CompressedDataInfo->CompressedChunkSizes[Chunk];
+        if (CompressedChunkSize > ChunkSize)
+        {
+            Status = STATUS_BAD_COMPRESSION_BUFFER;
+            goto done;
+        }
+
+        if (CompressedChunkSize > (ULONG)(SourceEnd - Source))
+        {
+            if (InTail || CompressedChunkSize > CompressedTailSize)
+            {
+                Status = STATUS_BAD_COMPRESSION_BUFFER;
+                goto done;
+            }
+
+            InTail = TRUE;
+            Source = CompressedTail;
+            SourceEnd = CompressedTail + CompressedTailSize;
+        }
+
+        ChunkBuffers[Chunk] = Source;
+        Source += CompressedChunkSize;
+    }
+
+    if (!RtlpDecompressChunksParallel(&Context, CompressedBuffer, CompressedTail))
+        RtlpDecompressChunkRange(&Context);
+
+    Status = Context.Status;
+
+    /* whatever is not covered by a chunk is zero */
+    if (NT_SUCCESS(Status) &&
+        ((ULONG)CompressedDataInfo->NumberOfChunks << CompressedDataInfo->ChunkShift) < UncompressedBufferSize)
+    {
+        Chunk = (ULONG)CompressedDataInfo->NumberOfChunks << CompressedDataInfo->ChunkShift;
+        RtlZeroMemory(UncompressedBuffer + Chunk, UncompressedBufferSize - Chunk);
+    }
+
+done:
+    RtlpFreeMemory(ChunkBuffers, TAG_COMPRESS);
+    return Status;
 }
 
 /*
@@ -357,6 +1774,12 @@ RtlDecompressFragment(IN USHORT format,
             return lznt1_decompress(uncompressed, uncompressed_size, compressed,
                                     compressed_size, offset, final_size, workspace);
 
+        case COMPRESSION_FORMAT_XPRESS:
+        case COMPRESSION_FORMAT_XPRESS_HUFF:
+            return RtlpDecompressFragmentXpress(format & COMPRESSION_FORMAT_MASK, uncompressed,
+                                                uncompressed_size, compressed, compressed_size,
+                                                offset, final_size, workspace);
+
         case COMPRESSION_FORMAT_NONE:
         case COMPRESSION_FORMAT_DEFAULT:
             return STATUS_INVALID_PARAMETER;
@@ -417,6 +1840,13 @@ RtlGetCompressionWorkSpaceSize(IN USHORT CompressionFormatAndEngine,
                                     CompressBufferAndWorkSpaceSize,
                                     CompressFragmentWorkSpaceSize));
 
+   if ((Format == COMPRESSION_FORMAT_XPRESS) ||
+         (Format == COMPRESSION_FORMAT_XPRESS_HUFF))
+      return(RtlpWorkSpaceSizeXpress(Format,
+                                     Engine,
+                                     CompressBufferAndWorkSpaceSize,
+                                     CompressFragmentWorkSpaceSize));
+
    return(STATUS_UNSUPPORTED_COMPRESSION);
 }
 
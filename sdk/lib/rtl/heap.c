@@ -1584,6 +1584,9 @@ RtlDestroyHeap(HANDLE HeapPtr) /* [in] Handle of heap */
         RtlpRemoveHeapFromProcessList(Heap);
     }
 
+    /* Free the front end, its user blocks are freed with the segments */
+    RtlpDestroyLowFragmentationHeap(Heap);
+
     /* Delete the heap lock */
     if (!(Heap->Flags & HEAP_NO_SERIALIZE))
     {
@@ -1977,6 +1980,27 @@ RtlAllocateHeap(IN PVOID HeapPtr,
 
     Index = AllocationSize >> HEAP_ENTRY_SHIFT;
 
+    /* Small blocks may be served by the front end, without taking the lock */
+    if (Heap->FrontEndHeap &&
+        Index < HEAP_FRONT_END_BUCKETS &&
+        !(EntryFlags & HEAP_ENTRY_EXTRA_PRESENT))
+    {
+        InUseEntry = RtlpLowFragHeapAlloc(Heap, Index);
+        if (InUseEntry)
+        {
+            ASSERT(InUseEntry->Size == Index);
+
+            InUseEntry->Flags = EntryFlags;
+            InUseEntry->UnusedBytes = (UCHAR)(AllocationSize - Size);
+            InUseEntry->SmallTagIndex = 0;
+
+            if (Flags & HEAP_ZERO_MEMORY)
+                RtlZeroMemory(InUseEntry + 1, Size);
+
+            return InUseEntry + 1;
+        }
+    }
+
     /* Acquire the lock if necessary */
     if (!(Flags & HEAP_NO_SERIALIZE))
     {
@@ -2189,7 +2213,8 @@ BOOLEAN NTAPI RtlFreeHeap(
         /* Check this entry, fail if it's invalid */
         if (!(HeapEntry->Flags & HEAP_ENTRY_BUSY) ||
             (((ULONG_PTR)Ptr & 0x7) != 0) ||
-            (HeapEntry->SegmentOffset >= HEAP_SEGMENTS))
+            (HeapEntry->SegmentOffset >= HEAP_SEGMENTS &&
+             (HeapEntry->SegmentOffset != HEAP_FRONT_END_SEGMENT || !Heap->FrontEndHeap)))
         {
             /* This is an invalid block */
             DPRINT1("HEAP: Trying to free an invalid address %p!\n", Ptr);
@@ -2206,6 +2231,13 @@ BOOLEAN NTAPI RtlFreeHeap(
     }
     _SEH2_END;
 
+    /* Blocks of the front end go back to it, without taking the lock */
+    if (HeapEntry->SegmentOffset == HEAP_FRONT_END_SEGMENT)
+    {
+        RtlpLowFragHeapFree(Heap, HeapEntry);
+        return TRUE;
+    }
+
     /* Lock if necessary */
     if (!(Flags & HEAP_NO_SERIALIZE))
     {
@@ -2660,7 +2692,49 @@ RtlReAllocateHeap(HANDLE HeapPtr,
     Index = AllocationSize >> HEAP_ENTRY_SHIFT;
 
     /* Check for 4 different scenarios (old size, new size, old index, new index) */
-    if (Index <= OldIndex)
+    if (InUseEntry->SegmentOffset == HEAP_FRONT_END_SEGMENT)
+    {
+        /* Blocks of the front end are never split, they stay in place only
+           if the new size fits, and is not too small for their size class */
+        if (Index <= OldIndex &&
+            (OldIndex << HEAP_ENTRY_SHIFT) - Size <= MAXUCHAR)
+        {
+            InUseEntry->UnusedBytes = (UCHAR)((OldIndex << HEAP_ENTRY_SHIFT) - Size);
+
+            /* Zero the new part if required */
+            if (Size > OldSize &&
+                (Flags & HEAP_ZERO_MEMORY))
+            {
+                RtlZeroMemory((PCHAR)Ptr + OldSize, Size - OldSize);
+            }
+        }
+        else if (Flags & HEAP_REALLOC_IN_PLACE_ONLY)
+        {
+            Ptr = NULL;
+        }
+        else
+        {
+            /* Move it to a new block */
+            NewBaseAddress = RtlAllocateHeap(HeapPtr,
+                                             Flags & ~(HEAP_ZERO_MEMORY | HEAP_TAG_MASK),
+                                             Size);
+            if (NewBaseAddress)
+            {
+                RtlMoveMemory(NewBaseAddress, Ptr, min(Size, OldSize));
+
+                if (Size > OldSize &&
+                    (Flags & HEAP_ZERO_MEMORY))
+                {
+                    RtlZeroMemory((PCHAR)NewBaseAddress + OldSize, Size - OldSize);
+                }
+
+                RtlFreeHeap(HeapPtr, Flags, Ptr);
+            }
+
+            Ptr = NewBaseAddress;
+        }
+    }
+    else if (Index <= OldIndex)
     {
         /* Difference must be greater than 1, adjust if it's not so */
         if (Index + 1 == OldIndex)
@@ -3163,6 +3237,13 @@ RtlpValidateHeapEntry(
     if ((ULONG_PTR)HeapEntry & (HEAP_ENTRY_SIZE - 1)) goto invalid_entry;
     if (!(HeapEntry->Flags & HEAP_ENTRY_BUSY)) goto invalid_entry;
 
+    /* Blocks of the front end are checked by it */
+    if (HeapEntry->SegmentOffset == HEAP_FRONT_END_SEGMENT)
+    {
+        if (!RtlpValidateLowFragHeapEntry(Heap, HeapEntry)) goto invalid_entry;
+        return TRUE;
+    }
+
     BigAllocation = HeapEntry->Flags & HEAP_ENTRY_VIRTUAL_ALLOC;
     Segment = Heap->Segments[HeapEntry->SegmentOffset];
 
@@ -3916,6 +3997,8 @@ RtlSetHeapInformation(IN HANDLE HeapHandle OPTIONAL,
                       IN PVOID HeapInformation,
                       IN SIZE_T HeapInformationLength)
 {
+    PHEAP Heap = (PHEAP)HeapHandle;
+
     /* Setting heap information is not really supported except for enabling LFH */
     if (HeapInformationClass == HeapCompatibilityInformation)
     {
@@ -3927,13 +4010,20 @@ RtlSetHeapInformation(IN HANDLE HeapHandle OPTIONAL,
         }
 
         /* Check for a special magic value for enabling LFH */
-        if (*(PULONG)HeapInformation != 2)
+        if (*(PULONG)HeapInformation != HEAP_FRONT_END_LOW_FRAG)
         {
             return STATUS_UNSUCCESSFUL;
         }
 
-        DPRINT1("RtlSetHeapInformation() needs to enable LFH\n");
-        return STATUS_SUCCESS;
+        /* Page heaps don't have a front end */
+        if (!Heap ||
+            (Heap->ForceFlags & HEAP_FLAG_PAGE_ALLOCS) ||
+            Heap->Signature != HEAP_SIGNATURE)
+        {
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        return RtlpActivateLowFragmentationHeap(Heap);
     }
 
     return STATUS_SUCCESS;
@@ -3972,7 +4062,52 @@ RtlQueryHeapInformation(HANDLE HeapHandle,
     return STATUS_UNSUCCESSFUL;
 }
 
-NTSTATUS
+/* Finds a free block for a batch of blocks of Index heap entries, preferably
+   one that can hold Needed entries. The heap must be locked. */
+static
+PHEAP_FREE_ENTRY
+RtlpFindBatchFreeBlock(PHEAP Heap,
+                       SIZE_T Index,
+                       SIZE_T Needed)
+{
+    PLIST_ENTRY FreeListHead, Next;
+    PHEAP_FREE_ENTRY FreeBlock = NULL;
+    SIZE_T ListIndex;
+
+    /* A dedicated list with blocks big enough for all of them */
+    for (ListIndex = Needed; ListIndex < HEAP_FREELISTS; ListIndex++)
+    {
+        if (!IsListEmpty(&Heap->FreeLists[ListIndex]))
+            return CONTAINING_RECORD(Heap->FreeLists[ListIndex].Blink, HEAP_FREE_ENTRY, FreeList);
+    }
+
+    /* The non-dedicated list is sorted, take the first block that fits */
+    FreeListHead = &Heap->FreeLists[0];
+    for (Next = FreeListHead->Flink; Next != FreeListHead; Next = Next->Flink)
+    {
+        FreeBlock = CONTAINING_RECORD(Next, HEAP_FREE_ENTRY, FreeList);
+        if (FreeBlock->Size >= Needed)
+            return FreeBlock;
+    }
+
+    /* Nothing fits all of them, take the biggest block, which holds some */
+    if (FreeBlock != NULL)
+        return FreeBlock;
+
+    for (ListIndex = min(Needed, HEAP_FREELISTS) - 1; ListIndex >= Index; ListIndex--)
+    {
+        if (!IsListEmpty(&Heap->FreeLists[ListIndex]))
+            return CONTAINING_RECORD(Heap->FreeLists[ListIndex].Blink, HEAP_FREE_ENTRY, FreeList);
+    }
+
+    /* Grow the heap */
+    return RtlpExtendHeap(Heap, Needed << HEAP_ENTRY_SHIFT);
+}
+
+/*
+ * @implemented
+ */
+ULONG
 NTAPI
 RtlMultipleAllocateHeap(IN PVOID HeapHandle,
                         IN ULONG Flags,
@@ -3980,19 +4115,169 @@ RtlMultipleAllocateHeap(IN PVOID HeapHandle,
                         IN ULONG Count,
                         OUT PVOID *Array)
 {
-    UNIMPLEMENTED;
-    return 0;
+    PHEAP Heap = (PHEAP)HeapHandle;
+    PHEAP_FREE_ENTRY FreeBlock;
+    PHEAP_ENTRY InUseEntry, LastEntry;
+    SIZE_T AllocationSize, Index, Needed, BlockCount, BatchSize, i;
+    EXCEPTION_RECORD ExceptionRecord;
+    BOOLEAN HeapLocked = FALSE;
+    UCHAR LastFlags, SegmentOffset;
+    ULONG Allocated;
+
+    /* Force flags */
+    Flags |= Heap->ForceFlags;
+
+    /* Check for the maximum size */
+    if (Size >= 0x80000000)
+    {
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus(STATUS_NO_MEMORY);
+        DPRINT1("HEAP: Allocation failed!\n");
+        return 0;
+    }
+
+    /* Calculate allocation size and index */
+    AllocationSize = (max(Size, 1) + Heap->AlignRound) & Heap->AlignMask;
+    Index = AllocationSize >> HEAP_ENTRY_SHIFT;
+
+    /* Only plain small blocks of the back end are carved here, anything
+       else takes the usual way. The front end doesn't need the heap lock */
+    if (RtlpHeapIsSpecial(Flags) ||
+        (Flags & HEAP_EXTRA_FLAGS_MASK) ||
+        Heap->PseudoTagEntries ||
+        (Heap->Flags & (HEAP_FREE_CHECKING_ENABLED | HEAP_TAIL_CHECKING_ENABLED)) ||
+        Index >= HEAP_FREELISTS ||
+        (Heap->FrontEndHeap && Index < HEAP_FRONT_END_BUCKETS))
+    {
+        for (Allocated = 0; Allocated < Count; Allocated++)
+        {
+            Array[Allocated] = RtlAllocateHeap(Heap, Flags, Size);
+            if (Array[Allocated] == NULL) break;
+        }
+
+        return Allocated;
+    }
+
+    /* Acquire the lock once for all the blocks */
+    if (!(Flags & HEAP_NO_SERIALIZE))
+    {
+        RtlEnterHeapLock(Heap->LockVariable, TRUE);
+        HeapLocked = TRUE;
+    }
+
+    Allocated = 0;
+    while (Allocated < Count)
+    {
+        /* Try to get room for all the remaining blocks at once */
+        Needed = min((Count - Allocated) * Index, HEAP_MAX_BLOCK_SIZE - HEAP_MAX_BLOCK_SIZE % Index);
+
+        FreeBlock = RtlpFindBatchFreeBlock(Heap, Index, Needed);
+        if (FreeBlock == NULL) break;
+
+        BlockCount = min(FreeBlock->Size / Index, Count - Allocated);
+        BatchSize = BlockCount * Index;
+        ASSERT(BlockCount > 0);
+
+        /* Take one block for the whole batch */
+        RtlpRemoveFreeBlock(Heap, FreeBlock, FALSE, FALSE);
+        InUseEntry = RtlpSplitEntry(Heap,
+                                    Flags,
+                                    FreeBlock,
+                                    BatchSize << HEAP_ENTRY_SHIFT,
+                                    BatchSize,
+                                    BatchSize << HEAP_ENTRY_SHIFT);
+
+        /* And cut it into blocks of the right size. The last one gets what
+           the split may have left over */
+        LastFlags = InUseEntry->Flags;
+        SegmentOffset = InUseEntry->SegmentOffset;
+        LastEntry = InUseEntry + (BlockCount - 1) * Index;
+        LastEntry->Size = (USHORT)(InUseEntry->Size - (BlockCount - 1) * Index);
+
+        for (i = 0; i < BlockCount; i++, InUseEntry += Index)
+        {
+            if (i != BlockCount - 1)
+                InUseEntry->Size = (USHORT)Index;
+            if (i != 0)
+                InUseEntry->PreviousSize = (USHORT)Index;
+
+            InUseEntry->Flags = LastFlags & ~HEAP_ENTRY_LAST_ENTRY;
+            InUseEntry->SmallTagIndex = 0;
+            InUseEntry->SegmentOffset = SegmentOffset;
+            InUseEntry->UnusedBytes = (UCHAR)((InUseEntry->Size << HEAP_ENTRY_SHIFT) - Size);
+
+            Array[Allocated++] = InUseEntry + 1;
+        }
+
+        /* Fix the links to the entry after the batch */
+        LastEntry->Flags |= LastFlags & HEAP_ENTRY_LAST_ENTRY;
+        if (!(LastFlags & HEAP_ENTRY_LAST_ENTRY))
+            (LastEntry + LastEntry->Size)->PreviousSize = LastEntry->Size;
+    }
+
+    if (HeapLocked) RtlLeaveHeapLock(Heap->LockVariable);
+
+    /* Zero memory if that was requested */
+    if (Flags & HEAP_ZERO_MEMORY)
+    {
+        for (i = 0; i < Allocated; i++)
+            RtlZeroMemory(Array[i], Size);
+    }
+
+    if (Allocated < Count)
+    {
+        /* Out of memory */
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus(STATUS_NO_MEMORY);
+        DPRINT1("HEAP: Batch allocation failed after %lu blocks!\n", Allocated);
+
+        if (Flags & HEAP_GENERATE_EXCEPTIONS)
+        {
+            ExceptionRecord.ExceptionCode = STATUS_NO_MEMORY;
+            ExceptionRecord.ExceptionRecord = NULL;
+            ExceptionRecord.NumberParameters = 1;
+            ExceptionRecord.ExceptionFlags = 0;
+            ExceptionRecord.ExceptionInformation[0] = AllocationSize;
+
+            RtlRaiseException(&ExceptionRecord);
+        }
+    }
+
+    return Allocated;
 }
 
-NTSTATUS
+/*
+ * @implemented
+ */
+ULONG
 NTAPI
 RtlMultipleFreeHeap(IN PVOID HeapHandle,
                     IN ULONG Flags,
                     IN ULONG Count,
-                    OUT PVOID *Array)
+                    IN PVOID *Array)
 {
-    UNIMPLEMENTED;
-    return 0;
+    PHEAP Heap = (PHEAP)HeapHandle;
+    BOOLEAN HeapLocked = FALSE;
+    ULONG Freed;
+
+    /* Force flags */
+    Flags |= Heap->ForceFlags;
+
+    /* Acquire the lock once for all the blocks */
+    if (!(Flags & HEAP_NO_SERIALIZE) && !RtlpHeapIsSpecial(Flags))
+    {
+        RtlEnterHeapLock(Heap->LockVariable, TRUE);
+        HeapLocked = TRUE;
+        Flags |= HEAP_NO_SERIALIZE;
+    }
+
+    /* Stop at the first block that can't be freed */
+    for (Freed = 0; Freed < Count; Freed++)
+    {
+        if (!RtlFreeHeap(Heap, Flags, Array[Freed])) break;
+    }
+
+    if (HeapLocked) RtlLeaveHeapLock(Heap->LockVariable);
+
+    return Freed;
 }
 
 /* EOF */
@@ -55,6 +55,15 @@
 /* Segment flags */
 #define HEAP_USER_ALLOCATED    0x1
 
+/* Front end heap types */
+#define HEAP_FRONT_END_LOW_FRAG 2
+
+/* Size classes, in heap entries, served by the front end */
+#define HEAP_FRONT_END_BUCKETS HEAP_FREELISTS
+
+/* SegmentOffset of the blocks carved by the front end */
+#define HEAP_FRONT_END_SEGMENT 0xFF
+
 /* A handy inline to distinguis normal heap, special "debug heap" and special "page heap" */
 FORCEINLINE BOOLEAN
 RtlpHeapIsSpecial(ULONG Flags)
@@ -352,6 +361,25 @@ RtlpValidateHeapEntry(PHEAP Heap, PHEAP_ENTRY HeapEntry);
 BOOLEAN NTAPI
 RtlpValidateHeapHeaders(PHEAP Heap, BOOLEAN Recalculate);
 
+/* heaplfh.c */
+NTSTATUS NTAPI
+RtlpActivateLowFragmentationHeap(PHEAP Heap);
+
+VOID NTAPI
+RtlpDestroyLowFragmentationHeap(PHEAP Heap);
+
+PHEAP_ENTRY NTAPI
+RtlpLowFragHeapAlloc(PHEAP Heap,
+                     SIZE_T Index);
+
+VOID NTAPI
+RtlpLowFragHeapFree(PHEAP Heap,
+                    PHEAP_ENTRY HeapEntry);
+
+BOOLEAN NTAPI
+RtlpValidateLowFragHeapEntry(PHEAP Heap,
+                             PHEAP_ENTRY HeapEntry);
+
 /* heapdbg.c */
 HANDLE NTAPI
 RtlDebugCreateHeap(ULONG Flags,
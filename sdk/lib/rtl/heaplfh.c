@@ -0,0 +1,378 @@
+/*
+ * COPYRIGHT:       See COPYING in the top level directory
+ * PROJECT:         ReactOS system libraries
+ * FILE:            lib/rtl/heaplfh.c
+ * PURPOSE:         RTL Heap low fragmentation front end
+ * PROGRAMMERS:     ReactOS Team
+ */
+
+/* Small blocks of a heap with the front end enabled are not allocated from
+   the free lists. The front end takes larger "user blocks" from the back end
+   instead, and carves each of them into blocks of a single size class.
+   Freeing such a block puts it back into its user block, and a user block
+   goes back to the back end once all of its blocks are free. Since blocks
+   of different sizes don't mix, small blocks don't fragment the back end.
+
+   User blocks are kept in affinity slots, and each thread uses the slot its
+   id hashes to, so threads of a busy process rarely share a lock, and never
+   take the heap lock for small blocks. Every slot has a lock of its own,
+   which is a heap lock like the one of the back end, so that threads that
+   hash to the same slot wait for each other instead of spinning.
+
+   Blocks of the front end have a regular busy header, so RtlSizeHeap works
+   on them as it is. They are told apart by their SegmentOffset, and their
+   PreviousSize is the distance back to the start of their user block. */
+
+/* INCLUDES *****************************************************************/
+
+#include <rtl.h>
+#include <heap.h>
+
+#define NDEBUG
+#include <debug.h>
+
+/* How many bytes a user block is carved out of, and how many blocks it has at least */
+#define HEAP_FRONT_END_USER_BLOCK_BYTES 4096
+#define HEAP_FRONT_END_MIN_BLOCKS       8
+
+#define HEAP_FRONT_END_MAX_SLOTS        16
+
+struct _HEAP_FRONT_END_SLOT;
+
+typedef struct _HEAP_FRONT_END_USER_BLOCK
+{
+    LIST_ENTRY ListEntry;
+    struct _HEAP_FRONT_END_SLOT *Slot;
+    PSINGLE_LIST_ENTRY FreeList;
+    USHORT BlockSize;
+    USHORT BlockCount;
+    USHORT FreeCount;
+} HEAP_FRONT_END_USER_BLOCK, *PHEAP_FRONT_END_USER_BLOCK;
+
+/* Size of the user block header, in heap entries */
+#define HEAP_FRONT_END_USER_BLOCK_ENTRIES \
+    ((sizeof(HEAP_FRONT_END_USER_BLOCK) + HEAP_ENTRY_SIZE - 1) >> HEAP_ENTRY_SHIFT)
+
+typedef struct _HEAP_FRONT_END_SLOT
+{
+    HEAP_LOCK Lock;
+
+    /* User blocks with free blocks, one list per size class */
+    LIST_ENTRY UserBlocks[HEAP_FRONT_END_BUCKETS];
+} HEAP_FRONT_END_SLOT, *PHEAP_FRONT_END_SLOT;
+
+typedef struct _HEAP_FRONT_END
+{
+    ULONG SlotMask;
+    HEAP_FRONT_END_SLOT Slots[ANYSIZE_ARRAY];
+} HEAP_FRONT_END, *PHEAP_FRONT_END;
+
+/* FUNCTIONS *****************************************************************/
+
+FORCEINLINE
+PHEAP_FRONT_END_SLOT
+RtlpGetFrontEndSlot(PHEAP_FRONT_END FrontEnd)
+{
+    ULONG_PTR ThreadId = (ULONG_PTR)NtCurrentTeb()->ClientId.UniqueThread;
+
+    /* Thread ids are multiples of 4 */
+    return &FrontEnd->Slots[(ThreadId >> 2) & FrontEnd->SlotMask];
+}
+
+FORCEINLINE
+VOID
+RtlpAcquireFrontEndSlot(PHEAP_FRONT_END_SLOT Slot)
+{
+    RtlEnterHeapLock(&Slot->Lock, TRUE);
+}
+
+FORCEINLINE
+VOID
+RtlpReleaseFrontEndSlot(PHEAP_FRONT_END_SLOT Slot)
+{
+    RtlLeaveHeapLock(&Slot->Lock);
+}
+
+static
+VOID
+RtlpFreeFrontEnd(PHEAP_FRONT_END FrontEnd,
+                 ULONG Slots)
+{
+    SIZE_T Size = 0;
+    ULONG Slot;
+
+    for (Slot = 0; Slot < Slots; Slot++)
+        RtlDeleteHeapLock(&FrontEnd->Slots[Slot].Lock);
+
+    ZwFreeVirtualMemory(NtCurrentProcess(), (PVOID *)&FrontEnd, &Size, MEM_RELEASE);
+}
+
+FORCEINLINE
+PHEAP_FRONT_END_USER_BLOCK
+RtlpGetFrontEndUserBlock(PHEAP_ENTRY HeapEntry)
+{
+    return (PHEAP_FRONT_END_USER_BLOCK)(HeapEntry - HeapEntry->PreviousSize);
+}
+
+NTSTATUS
+NTAPI
+RtlpActivateLowFragmentationHeap(PHEAP Heap)
+{
+    PHEAP_FRONT_END FrontEnd = NULL;
+    PHEAP_LOCK Lock;
+    SIZE_T Size;
+    ULONG Slots, Slot, Index;
+    NTSTATUS Status;
+
+    /* Nothing to do if it's already active */
+    if (Heap->FrontEndHeapType == HEAP_FRONT_END_LOW_FRAG)
+        return STATUS_SUCCESS;
+
+    /* The front end relies on the back end being serialized, and it
+       would defeat the checks of debug heaps */
+    if (RtlpGetMode() == KernelMode ||
+        (Heap->Flags & (HEAP_NO_SERIALIZE |
+                        HEAP_CREATE_ALIGN_16 |
+                        HEAP_FREE_CHECKING_ENABLED |
+                        HEAP_TAIL_CHECKING_ENABLED)) ||
+        RtlpHeapIsSpecial(Heap->Flags | Heap->ForceFlags))
+    {
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    /* Two slots per processor, which must be a power of two */
+    for (Slots = 2;
+         Slots < NtCurrentPeb()->NumberOfProcessors * 2 && Slots < HEAP_FRONT_END_MAX_SLOTS;
+         Slots <<= 1);
+
+    Size = FIELD_OFFSET(HEAP_FRONT_END, Slots[Slots]);
+    Status = ZwAllocateVirtualMemory(NtCurrentProcess(),
+                                     (PVOID *)&FrontEnd,
+                                     0,
+                                     &Size,
+                                     MEM_COMMIT,
+                                     PAGE_READWRITE);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("HEAP: Failed to allocate the front end of heap %p (Status 0x%08X)\n", Heap, Status);
+        return Status;
+    }
+
+    FrontEnd->SlotMask = Slots - 1;
+    for (Slot = 0; Slot < Slots; Slot++)
+    {
+        Lock = &FrontEnd->Slots[Slot].Lock;
+        Status = RtlInitializeHeapLock(&Lock);
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("HEAP: Failed to initialize the front end lock of heap %p (Status 0x%08X)\n", Heap, Status);
+            RtlpFreeFrontEnd(FrontEnd, Slot);
+            return Status;
+        }
+
+        for (Index = 0; Index < HEAP_FRONT_END_BUCKETS; Index++)
+            InitializeListHead(&FrontEnd->Slots[Slot].UserBlocks[Index]);
+    }
+
+    /* Publish it under the heap lock, in case another thread raced us */
+    RtlEnterHeapLock(Heap->LockVariable, TRUE);
+    if (Heap->FrontEndHeap == NULL)
+    {
+        Heap->FrontEndHeap = FrontEnd;
+        Heap->FrontEndHeapType = HEAP_FRONT_END_LOW_FRAG;
+        FrontEnd = NULL;
+    }
+    RtlLeaveHeapLock(Heap->LockVariable);
+
+    if (FrontEnd != NULL)
+        RtlpFreeFrontEnd(FrontEnd, Slots);
+
+    DPRINT("Low fragmentation heap enabled for heap %p with %lu slots\n", Heap, Slots);
+    return STATUS_SUCCESS;
+}
+
+VOID
+NTAPI
+RtlpDestroyLowFragmentationHeap(PHEAP Heap)
+{
+    PHEAP_FRONT_END FrontEnd = Heap->FrontEndHeap;
+
+    if (FrontEnd == NULL) return;
+
+    /* The user blocks go away with the heap segments */
+    Heap->FrontEndHeap = NULL;
+    Heap->FrontEndHeapType = 0;
+    RtlpFreeFrontEnd(FrontEnd, FrontEnd->SlotMask + 1);
+}
+
+static
+PHEAP_FRONT_END_USER_BLOCK
+RtlpCreateFrontEndUserBlock(PHEAP Heap,
+                            PHEAP_FRONT_END_SLOT Slot,
+                            SIZE_T Index)
+{
+    PHEAP_FRONT_END_USER_BLOCK UserBlock;
+    PHEAP_ENTRY HeapEntry;
+    PSINGLE_LIST_ENTRY *Link;
+    SIZE_T Count, Offset, i;
+
+    Count = (HEAP_FRONT_END_USER_BLOCK_BYTES >> HEAP_ENTRY_SHIFT) - HEAP_FRONT_END_USER_BLOCK_ENTRIES;
+    Count = max(Count / Index, HEAP_FRONT_END_MIN_BLOCKS);
+
+    /* This is big enough not to come back to the front end */
+    UserBlock = RtlAllocateHeap(Heap,
+                                0,
+                                (HEAP_FRONT_END_USER_BLOCK_ENTRIES + Count * Index) << HEAP_ENTRY_SHIFT);
+    if (UserBlock == NULL) return NULL;
+
+    UserBlock->Slot = Slot;
+    UserBlock->BlockSize = (USHORT)Index;
+    UserBlock->BlockCount = (USHORT)Count;
+    UserBlock->FreeCount = (USHORT)Count;
+
+    /* Format the blocks and chain them, in address order */
+    Link = &UserBlock->FreeList;
+    Offset = HEAP_FRONT_END_USER_BLOCK_ENTRIES;
+    for (i = 0; i < Count; i++, Offset += Index)
+    {
+        HeapEntry = (PHEAP_ENTRY)UserBlock + Offset;
+        HeapEntry->Size = (USHORT)Index;
+        HeapEntry->Flags = 0;
+        HeapEntry->SmallTagIndex = 0;
+        HeapEntry->PreviousSize = (USHORT)Offset;
+        HeapEntry->SegmentOffset = HEAP_FRONT_END_SEGMENT;
+        HeapEntry->UnusedBytes = 0;
+
+        *Link = (PSINGLE_LIST_ENTRY)(HeapEntry + 1);
+        Link = &(*Link)->Next;
+    }
+    *Link = NULL;
+
+    return UserBlock;
+}
+
+/* Returns a block of exactly Index heap entries, or NULL */
+PHEAP_ENTRY
+NTAPI
+RtlpLowFragHeapAlloc(PHEAP Heap,
+                     SIZE_T Index)
+{
+    PHEAP_FRONT_END_SLOT Slot;
+    PHEAP_FRONT_END_USER_BLOCK UserBlock, NewUserBlock = NULL;
+    PLIST_ENTRY ListHead;
+    PSINGLE_LIST_ENTRY Entry;
+
+    ASSERT(Index > 0 && Index < HEAP_FRONT_END_BUCKETS);
+
+    Slot = RtlpGetFrontEndSlot(Heap->FrontEndHeap);
+    ListHead = &Slot->UserBlocks[Index];
+
+    for (;;)
+    {
+        RtlpAcquireFrontEndSlot(Slot);
+
+        if (NewUserBlock)
+        {
+            /* Make the new user block available */
+            InsertHeadList(ListHead, &NewUserBlock->ListEntry);
+        }
+
+        if (!IsListEmpty(ListHead))
+            break;
+
+        RtlpReleaseFrontEndSlot(Slot);
+
+        /* Get a new user block without holding up the slot */
+        NewUserBlock = RtlpCreateFrontEndUserBlock(Heap, Slot, Index);
+        if (NewUserBlock == NULL) return NULL;
+    }
+
+    /* Take a block from the first user block */
+    UserBlock = CONTAINING_RECORD(ListHead->Flink, HEAP_FRONT_END_USER_BLOCK, ListEntry);
+    Entry = UserBlock->FreeList;
+    UserBlock->FreeList = Entry->Next;
+
+    /* A full user block leaves the list until one of its blocks is freed */
+    if (--UserBlock->FreeCount == 0)
+        RemoveEntryList(&UserBlock->ListEntry);
+
+    RtlpReleaseFrontEndSlot(Slot);
+
+    /* The list entry lives in the user data, right after the header */
+    return (PHEAP_ENTRY)Entry - 1;
+}
+
+/* Takes back a busy block of the front end */
+VOID
+NTAPI
+RtlpLowFragHeapFree(PHEAP Heap,
+                    PHEAP_ENTRY HeapEntry)
+{
+    PHEAP_FRONT_END_USER_BLOCK UserBlock = RtlpGetFrontEndUserBlock(HeapEntry);
+    PHEAP_FRONT_END_SLOT Slot = UserBlock->Slot;
+    PLIST_ENTRY ListHead = &Slot->UserBlocks[UserBlock->BlockSize];
+    PSINGLE_LIST_ENTRY Entry = (PSINGLE_LIST_ENTRY)(HeapEntry + 1);
+    BOOLEAN Release = FALSE;
+
+    ASSERT(HeapEntry->SegmentOffset == HEAP_FRONT_END_SEGMENT);
+    ASSERT(HeapEntry->Size == UserBlock->BlockSize);
+
+    /* The block belongs to the slot of the thread that allocated it */
+    RtlpAcquireFrontEndSlot(Slot);
+
+    HeapEntry->Flags = 0;
+    Entry->Next = UserBlock->FreeList;
+    UserBlock->FreeList = Entry;
+
+    if (++UserBlock->FreeCount == 1)
+    {
+        /* It was full, it has room again */
+        InsertTailList(ListHead, &UserBlock->ListEntry);
+    }
+    else if (UserBlock->FreeCount == UserBlock->BlockCount &&
+             ListHead->Flink != ListHead->Blink)
+    {
+        /* It's empty and not the last one of its size, give it back */
+        RemoveEntryList(&UserBlock->ListEntry);
+        Release = TRUE;
+    }
+
+    RtlpReleaseFrontEndSlot(Slot);
+
+    if (Release)
+        RtlFreeHeap(Heap, 0, UserBlock);
+}
+
+/* Checks a busy block of the front end */
+BOOLEAN
+NTAPI
+RtlpValidateLowFragHeapEntry(PHEAP Heap,
+                             PHEAP_ENTRY HeapEntry)
+{
+    PHEAP_FRONT_END_USER_BLOCK UserBlock;
+    PHEAP_ENTRY UserBlockEntry;
+    SIZE_T Offset;
+
+    if (Heap->FrontEndHeap == NULL ||
+        HeapEntry->PreviousSize < HEAP_FRONT_END_USER_BLOCK_ENTRIES)
+    {
+        return FALSE;
+    }
+
+    /* The user block itself must be a valid block of the back end */
+    UserBlock = RtlpGetFrontEndUserBlock(HeapEntry);
+    UserBlockEntry = (PHEAP_ENTRY)UserBlock - 1;
+    if (UserBlockEntry->SegmentOffset == HEAP_FRONT_END_SEGMENT ||
+        !RtlpValidateHeapEntry(Heap, UserBlockEntry))
+    {
+        return FALSE;
+    }
+
+    /* And the block must be one of its blocks */
+    Offset = HeapEntry->PreviousSize - HEAP_FRONT_END_USER_BLOCK_ENTRIES;
+    return HeapEntry->Size == UserBlock->BlockSize &&
+           Offset % UserBlock->BlockSize == 0 &&
+           Offset / UserBlock->BlockSize < UserBlock->BlockCount;
+}
+
+/* EOF */
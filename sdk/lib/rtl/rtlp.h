@@ -98,6 +98,16 @@ KPROCESSOR_MODE
 NTAPI
 RtlpGetMode(VOID);
 
+ULONG
+NTAPI
+RtlpGetNumberOfProcessors(VOID);
+
+BOOLEAN
+NTAPI
+RtlpQueueWorkItem(
+    IN WORKERCALLBACKFUNC Function,
+    IN PVOID Context);
+
 BOOLEAN
 NTAPI
 RtlpCaptureStackLimits(
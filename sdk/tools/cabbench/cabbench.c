@@ -0,0 +1,283 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Cabinet creation benchmark for cabman
+ *
+ * Writes a set of files the size of the ones that go into reactos.cab on
+ * the boot CD, along with a directive file for them, or takes the
+ * reactos.dff of a build tree instead. Then has cabman create the cabinet
+ * with 1, 2, 4 and so on up to the given number of compression threads,
+ * reports the wall time of every run, and checks that every cabinet is
+ * byte for byte the one that a single thread wrote.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define DEFAULT_FILES       1500
+#define MAX_FILE_SIZE       (512 * 1024)
+#define MAX_ARGS            32
+#define DIRECTIVE_NAME      "cabbench.dff"
+#define CABINET_NAME        "cabbench.cab"
+
+extern char **environ;
+
+static unsigned int Seed = 1;
+
+static unsigned int Random(void)
+{
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 16) | ((Seed * 1103515245 + 12345) & 0xFFFF0000);
+}
+
+static double Now(void)
+{
+    struct timespec Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+/* Something that compresses about as well as the binaries on the CD */
+static void FillFile(unsigned char *Buffer, size_t Size)
+{
+    static const char *Words[] = { "Nt", "Create", "File", "Object", "Handle", "Registry",
+                                   "Kernel", "Status", "\x8B\x45\x08", "\x55\x8B\xEC",
+                                   "\0\0\0\0", "\xFF\xFF" };
+    size_t i = 0, Length;
+    const char *Word;
+
+    while (i < Size)
+    {
+        if (Random() % 4 == 0)
+        {
+            Buffer[i++] = (unsigned char)Random();
+            continue;
+        }
+        Word = Words[Random() % (sizeof(Words) / sizeof(Words[0]))];
+        Length = Word[0] ? strlen(Word) : 4;
+        if (Length > Size - i)
+            Length = Size - i;
+        memcpy(Buffer + i, Word, Length);
+        i += Length;
+    }
+}
+
+static int WriteFiles(const char *Directory, unsigned int Files)
+{
+    unsigned char *Buffer;
+    char Path[1024];
+    unsigned int i;
+    size_t Size, Total = 0;
+    FILE *Directive, *f;
+
+    snprintf(Path, sizeof(Path), "%s/files", Directory);
+    mkdir(Path, 0755);
+
+    snprintf(Path, sizeof(Path), "%s/" DIRECTIVE_NAME, Directory);
+    Directive = fopen(Path, "w");
+    Buffer = malloc(MAX_FILE_SIZE);
+    if (!Directive || !Buffer)
+        return 1;
+
+    fprintf(Directive, ".Set DiskLabelTemplate=\"ReactOS\"\n");
+    fprintf(Directive, ".Set CabinetNameTemplate=\"" CABINET_NAME "\"\n\n");
+
+    for (i = 0; i < Files; i++)
+    {
+        /* Most files are small and a few are large, like on the CD */
+        Size = Random() % 4 ? Random() % (MAX_FILE_SIZE / 8) : Random() % MAX_FILE_SIZE;
+        FillFile(Buffer, Size);
+        Total += Size;
+
+        snprintf(Path, sizeof(Path), "%s/files/file%u.dll", Directory, i);
+        f = fopen(Path, "wb");
+        if (!f)
+            return 1;
+        fwrite(Buffer, Size, 1, f);
+        if (fclose(f))
+            return 1;
+
+        fprintf(Directive, "files/file%u.dll\n", i);
+    }
+
+    free(Buffer);
+    printf("Wrote %u files with %lu MB in %s/files\n", Files,
+           (unsigned long)(Total >> 20), Directory);
+    return fclose(Directive) != 0;
+}
+
+/* Run cabman with its output thrown away and return the wall time */
+static double RunCabman(char **Arguments)
+{
+    posix_spawn_file_actions_t Actions;
+    double Start;
+    pid_t Process;
+    int Status;
+
+    posix_spawn_file_actions_init(&Actions);
+    posix_spawn_file_actions_addopen(&Actions, 1, "/dev/null", O_WRONLY, 0);
+
+    Start = Now();
+    Status = posix_spawn(&Process, Arguments[0], &Actions, NULL, Arguments, environ);
+    posix_spawn_file_actions_destroy(&Actions);
+    if (Status)
+        return -1;
+
+    if (waitpid(Process, &Status, 0) != Process || !WIFEXITED(Status) || WEXITSTATUS(Status))
+        return -1;
+    return Now() - Start;
+}
+
+static int CompareFiles(const char *Path1, const char *Path2)
+{
+    char Buffer1[65536], Buffer2[65536];
+    size_t Read1, Read2;
+    FILE *f1, *f2;
+    int Different = 1;
+
+    f1 = fopen(Path1, "rb");
+    f2 = fopen(Path2, "rb");
+    if (f1 && f2)
+    {
+        do
+        {
+            Read1 = fread(Buffer1, 1, sizeof(Buffer1), f1);
+            Read2 = fread(Buffer2, 1, sizeof(Buffer2), f2);
+            Different = Read1 != Read2 || memcmp(Buffer1, Buffer2, Read1);
+        } while (!Different && Read1 == sizeof(Buffer1));
+    }
+
+    if (f1)
+        fclose(f1);
+    if (f2)
+        fclose(f2);
+    return Different;
+}
+
+/* Every file cabman wrote with one thread must be the same with more */
+static int CompareOutput(const char *Reference, const char *Output)
+{
+    char Path1[1024], Path2[1024];
+    struct dirent *Entry;
+    int Different = 0;
+    DIR *Directory;
+
+    Directory = opendir(Reference);
+    if (!Directory)
+        return 1;
+
+    while ((Entry = readdir(Directory)))
+    {
+        if (Entry->d_name[0] == '.')
+            continue;
+        snprintf(Path1, sizeof(Path1), "%s/%s", Reference, Entry->d_name);
+        snprintf(Path2, sizeof(Path2), "%s/%s", Output, Entry->d_name);
+        Different |= CompareFiles(Path1, Path2);
+    }
+
+    closedir(Directory);
+    return Different;
+}
+
+int main(int argc, char **argv)
+{
+    const char *Directory = ".";
+    char *Arguments[MAX_ARGS];
+    char Cabman[PATH_MAX], Directive[1024], Output[1024], Reference[1024], Threads[16];
+    unsigned int Count, MaxThreads, Errors = 0, i, Extra = 0;
+    double Time, Single = 0;
+    int Different;
+
+    MaxThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (argc > 2)
+        Directory = argv[2];
+    if (argc > 3)
+        MaxThreads = strtoul(argv[3], NULL, 0);
+    if (argc > 4)
+        Extra = argc - 5;
+    if (argc < 2 || MaxThreads == 0 || Extra > MAX_ARGS - 8 || !realpath(argv[1], Cabman))
+    {
+        printf("Usage: %s <cabman> [directory] [threads] [directive file [cabman options]]\n", argv[0]);
+        printf("For the boot CD: %s native-cabman <directory> <threads> reactos.dff "
+               "-RC reactos.inf -N -P <source directory>\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 4)
+    {
+        snprintf(Directive, sizeof(Directive), "%s", argv[4]);
+    }
+    else
+    {
+        if (WriteFiles(Directory, DEFAULT_FILES))
+        {
+            printf("Cannot write the files to %s\n", Directory);
+            return 1;
+        }
+
+        /* cabman looks for the files relative to the current directory */
+        if (chdir(Directory))
+        {
+            printf("Cannot change to %s\n", Directory);
+            return 1;
+        }
+        snprintf(Directive, sizeof(Directive), DIRECTIVE_NAME);
+        Directory = ".";
+    }
+
+    printf("%-8s %10s %8s %s\n", "threads", "seconds", "speedup", "cabinet");
+    for (Count = 1; ; Count = Count * 2 < MaxThreads ? Count * 2 : MaxThreads)
+    {
+        snprintf(Output, sizeof(Output), "%s/cabbench%u", Directory, Count);
+        snprintf(Threads, sizeof(Threads), "%u", Count);
+        mkdir(Output, 0755);
+
+        i = 0;
+        Arguments[i++] = Cabman;
+        Arguments[i++] = "-C";
+        Arguments[i++] = Directive;
+        Arguments[i++] = "-L";
+        Arguments[i++] = Output;
+        Arguments[i++] = "-T";
+        Arguments[i++] = Threads;
+        memcpy(&Arguments[i], &argv[argc - Extra], Extra * sizeof(char *));
+        Arguments[i + Extra] = NULL;
+
+        Time = RunCabman(Arguments);
+        if (Time < 0)
+        {
+            printf("%s failed with %u threads\n", Cabman, Count);
+            return 1;
+        }
+
+        if (Count == 1)
+        {
+            Single = Time;
+            printf("%-8u %10.2f %7.1fx %s\n", Count, Time, 1.0, "reference");
+        }
+        else
+        {
+            snprintf(Reference, sizeof(Reference), "%s/cabbench1", Directory);
+            Different = CompareOutput(Reference, Output);
+            Errors += Different;
+            printf("%-8u %10.2f %7.1fx %s\n", Count, Time, Single / Time,
+                   Different ? "DIFFERENT" : "identical");
+        }
+
+        if (Count == MaxThreads)
+            break;
+    }
+
+    printf("%u cabinets were not the same as the one of a single thread\n", Errors);
+    return Errors != 0;
+}
@@ -23,12 +23,107 @@
 # include <sys/stat.h>
 # include <sys/types.h>
 #endif
+#ifndef CAB_READ_ONLY
+# include <condition_variable>
+# include <deque>
+# include <mutex>
+# include <thread>
+# include <vector>
+#endif
 #include "cabinet.h"
 #include "raw.h"
 #include "mszip.h"
 
+static CCABCodec* CreateCodec(LONG Id)
+/*
+ * FUNCTION: Creates a codec engine
+ * ARGUMENTS:
+ *     Id = Codec identifier
+ * RETURNS:
+ *     Pointer to the codec, or NULL if the identifier is unknown
+ */
+{
+    switch (Id)
+    {
+        case CAB_CODEC_RAW:
+            return new CRawCodec();
+
+        case CAB_CODEC_MSZIP:
+            return new CMSZipCodec();
+
+        default:
+            return NULL;
+    }
+}
+
 #ifndef CAB_READ_ONLY
 
+/*
+ * Every data block is compressed on its own, so full blocks are handed to
+ * a pool of threads and written to the scratch file in the order in which
+ * they were queued. The cabinet is the same as when compressing serially.
+ */
+
+/* A data block on its way through the compression threads */
+typedef struct _CAB_COMPRESS_JOB
+{
+    PCFFOLDER_NODE FolderNode;
+    PCFDATA_NODE DataNode;
+    void* InputBuffer;
+    void* OutputBuffer;
+    ULONG InputSize;
+    ULONG OutputSize;
+    bool Done;
+} CAB_COMPRESS_JOB, *PCAB_COMPRESS_JOB;
+
+struct _CAB_COMPRESS_POOL
+{
+    std::mutex Lock;
+    std::condition_variable WorkReady;
+    std::condition_variable JobDone;
+    std::deque<PCAB_COMPRESS_JOB> Work;     // Jobs not yet picked by a thread
+    std::deque<PCAB_COMPRESS_JOB> Pending;  // Jobs not yet written, in order
+    std::vector<PCAB_COMPRESS_JOB> FreeJobs;
+    std::vector<std::thread> Threads;
+    bool Stop;
+};
+
+static void CompressThread(struct _CAB_COMPRESS_POOL* Pool, LONG CodecId)
+/*
+ * FUNCTION: Compresses the queued data blocks
+ * ARGUMENTS:
+ *     Pool    = Pointer to the pool the thread belongs to
+ *     CodecId = Codec identifier, every thread has its own codec
+ */
+{
+    CCABCodec* Codec = CreateCodec(CodecId);
+    PCAB_COMPRESS_JOB Job;
+    std::unique_lock<std::mutex> Guard(Pool->Lock);
+
+    for (;;)
+    {
+        while (!Pool->Stop && Pool->Work.empty())
+            Pool->WorkReady.wait(Guard);
+        if (Pool->Work.empty())
+            break;
+
+        Job = Pool->Work.front();
+        Pool->Work.pop_front();
+        Guard.unlock();
+
+        Codec->Compress(Job->OutputBuffer,
+            Job->InputBuffer,
+            Job->InputSize,
+            &Job->OutputSize);
+
+        Guard.lock();
+        Job->Done = true;
+        Pool->JobDone.notify_all();
+    }
+
+    delete Codec;
+}
+
 #if 0
 #if DBG
 
@@ -100,6 +195,8 @@ CCabinet::CCabinet()
     MaxDiskSize  = 0;
     BlockIsSplit = false;
     ScratchFile  = NULL;
+    ThreadCount  = 0;
+    CompressPool = NULL;
 
     FolderUncompSize = 0;
     BytesLeftInBlock = 0;
@@ -120,6 +217,10 @@ CCabinet::~CCabinet()
         CabinetReservedFileSize = 0;
     }
 
+#ifndef CAB_READ_ONLY
+    StopCompressThreads();
+#endif /* CAB_READ_ONLY */
+
     if (CodecSelected)
         delete Codec;
 }
@@ -1121,19 +1222,9 @@ void CCabinet::SelectCodec(LONG Id)
         delete Codec;
     }
 
-    switch (Id)
-    {
-        case CAB_CODEC_RAW:
-            Codec = new CRawCodec();
-            break;
-
-        case CAB_CODEC_MSZIP:
-            Codec = new CMSZipCodec();
-            break;
-
-        default:
-            return;
-    }
+    Codec = CreateCodec(Id);
+    if (!Codec)
+        return;
 
     CodecId       = Id;
     CodecSelected = true;
@@ -1222,6 +1313,13 @@ ULONG CCabinet::NewDisk()
  *     Status of operation
  */
 {
+    ULONG Status;
+
+    /* The pending blocks belong to the previous disk */
+    Status = FlushDataBlocks();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
     // NextFolderNumber is 0-based
     NextFolderNumber = 1;
 
@@ -1496,6 +1594,11 @@ ULONG CCabinet::CommitDisk(ULONG MoreDisks)
     PCFFOLDER_NODE FolderNode;
     ULONG Status;
 
+    /* The sizes in the headers need all the blocks compressed */
+    Status = FlushDataBlocks();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
     OnCabinetName(CurrentDiskNumber, CabinetName);
 
     /* Create file, fail if it already exists */
@@ -1580,6 +1683,8 @@ ULONG CCabinet::CloseCabinet()
 {
     ULONG Status;
 
+    StopCompressThreads();
+
     DestroyFileNodes();
 
     DestroyFolderNodes();
@@ -1827,6 +1932,17 @@ cleanup2:
     return bRet;
 }
 
+void CCabinet::SetThreadCount(ULONG Count)
+/*
+ * FUNCTION: Sets the number of threads compressing data blocks
+ * ARGUMENTS:
+ *     Count = Number of threads, 1 to compress serially, 0 for one per CPU
+ */
+{
+    ThreadCount = Count;
+}
+
+
 void CCabinet::SetMaxDiskSize(ULONG Size)
 /*
  * FUNCTION: Sets the maximum size of the current disk
@@ -2984,6 +3100,14 @@ ULONG CCabinet::WriteDataBlock()
     ULONG BytesWritten;
     PCFDATA_NODE DataNode;
 
+    /* Splitting a block over disks needs the size of every block before it */
+    if (ThreadCount != 1 && MaxDiskSize == 0 && !BlockIsSplit)
+        return QueueDataBlock();
+
+    Status = FlushDataBlocks();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
     if (!BlockIsSplit)
     {
         Status = Codec->Compress(OutputBuffer,
@@ -3060,6 +3184,200 @@ ULONG CCabinet::WriteDataBlock()
     return CAB_STATUS_SUCCESS;
 }
 
+ULONG CCabinet::QueueDataBlock()
+/*
+ * FUNCTION: Hands the current data block to the compression threads
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    PCAB_COMPRESS_JOB Job;
+    void* Buffer;
+    ULONG Count;
+    ULONG Status;
+
+    if (!CompressPool)
+    {
+        CompressPool = new _CAB_COMPRESS_POOL;
+        CompressPool->Stop = false;
+
+        Count = ThreadCount ? ThreadCount : std::thread::hardware_concurrency();
+        if (Count == 0)
+            Count = 1;
+        for (; Count > 0; Count--)
+            CompressPool->Threads.push_back(std::thread(CompressThread, CompressPool, CodecId));
+    }
+
+    if (!CompressPool->FreeJobs.empty())
+    {
+        Job = CompressPool->FreeJobs.back();
+        CompressPool->FreeJobs.pop_back();
+    }
+    else
+    {
+        Job = (PCAB_COMPRESS_JOB)malloc(sizeof(CAB_COMPRESS_JOB));
+        if (!Job)
+        {
+            DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+            return CAB_STATUS_NOMEMORY;
+        }
+        Job->InputBuffer  = malloc(CAB_BLOCKSIZE + 12);
+        Job->OutputBuffer = malloc(CAB_BLOCKSIZE + 12);
+        if (!Job->InputBuffer || !Job->OutputBuffer)
+        {
+            DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+            free(Job->InputBuffer);
+            free(Job->OutputBuffer);
+            free(Job);
+            return CAB_STATUS_NOMEMORY;
+        }
+    }
+
+    /* The data node is linked now, to keep the blocks in order */
+    Job->DataNode = NewDataNode(CurrentFolderNode);
+    if (!Job->DataNode)
+    {
+        DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+        CompressPool->FreeJobs.push_back(Job);
+        return CAB_STATUS_NOMEMORY;
+    }
+    Job->DataNode->Data.UncompSize = (USHORT)CurrentIBufferSize;
+    Job->FolderNode = CurrentFolderNode;
+    Job->InputSize  = CurrentIBufferSize;
+    Job->Done       = false;
+
+    /* The job takes the input buffer, the next block goes in the one of the job */
+    Buffer           = Job->InputBuffer;
+    Job->InputBuffer = InputBuffer;
+    InputBuffer      = Buffer;
+
+    LastBlockStart += CurrentIBufferSize;
+
+    CurrentIBufferSize = 0;
+    CurrentIBuffer     = InputBuffer;
+
+    {
+        std::lock_guard<std::mutex> Guard(CompressPool->Lock);
+        CompressPool->Work.push_back(Job);
+    }
+    CompressPool->WorkReady.notify_one();
+    CompressPool->Pending.push_back(Job);
+
+    /* Keep every thread busy, but don't hold more blocks than that */
+    while (CompressPool->Pending.size() > 2 * CompressPool->Threads.size())
+    {
+        Status = RetireDataBlock();
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::RetireDataBlock()
+/*
+ * FUNCTION: Writes the oldest queued data block to the scratch file
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    PCAB_COMPRESS_JOB Job;
+    PCFDATA_NODE DataNode;
+    ULONG BytesWritten;
+    ULONG Status;
+
+    Job = CompressPool->Pending.front();
+    {
+        std::unique_lock<std::mutex> Guard(CompressPool->Lock);
+        while (!Job->Done)
+            CompressPool->JobDone.wait(Guard);
+    }
+    CompressPool->Pending.pop_front();
+
+    DPRINT(MAX_TRACE, ("Block compressed. InputSize (%u)  OutputSize(%u).\n",
+        (UINT)Job->InputSize, (UINT)Job->OutputSize));
+
+    DataNode = Job->DataNode;
+    DataNode->Data.CompSize = (USHORT)Job->OutputSize;
+    DataNode->Data.Checksum = 0;
+    DataNode->ScratchFilePosition = ScratchFile->Position();
+
+    Status = ScratchFile->WriteBlock(&DataNode->Data,
+        Job->OutputBuffer, &BytesWritten);
+    CompressPool->FreeJobs.push_back(Job);
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    DiskSize += sizeof(CFDATA) + BytesWritten;
+
+    Job->FolderNode->TotalFolderSize += (BytesWritten + sizeof(CFDATA));
+    Job->FolderNode->Folder.DataBlockCount++;
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::FlushDataBlocks()
+/*
+ * FUNCTION: Writes all queued data blocks to the scratch file
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Status;
+
+    if (!CompressPool)
+        return CAB_STATUS_SUCCESS;
+
+    while (!CompressPool->Pending.empty())
+    {
+        Status = RetireDataBlock();
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+void CCabinet::StopCompressThreads()
+/*
+ * FUNCTION: Stops the compression threads and frees the queued blocks
+ */
+{
+    size_t i;
+
+    if (!CompressPool)
+        return;
+
+    {
+        std::lock_guard<std::mutex> Guard(CompressPool->Lock);
+        CompressPool->Stop = true;
+    }
+    CompressPool->WorkReady.notify_all();
+
+    for (i = 0; i < CompressPool->Threads.size(); i++)
+        CompressPool->Threads[i].join();
+
+    /* Blocks that were never written, after an error */
+    while (!CompressPool->Pending.empty())
+    {
+        CompressPool->FreeJobs.push_back(CompressPool->Pending.front());
+        CompressPool->Pending.pop_front();
+    }
+
+    for (i = 0; i < CompressPool->FreeJobs.size(); i++)
+    {
+        free(CompressPool->FreeJobs[i]->InputBuffer);
+        free(CompressPool->FreeJobs[i]->OutputBuffer);
+        free(CompressPool->FreeJobs[i]);
+    }
+
+    delete CompressPool;
+    CompressPool = NULL;
+}
+
 #if !defined(_WIN32)
 
 void CCabinet::ConvertDateAndTime(time_t* Time,
@@ -297,6 +297,8 @@ public:
 
 #ifndef CAB_READ_ONLY
 
+struct _CAB_COMPRESS_POOL;
+
 class CCFDATAStorage
 {
 public:
@@ -395,6 +397,8 @@ public:
     ULONG AddFile(char* FileName);
     /* Sets the maximum size of the current disk */
     void SetMaxDiskSize(ULONG Size);
+    /* Sets the number of threads compressing data blocks */
+    void SetThreadCount(ULONG Count);
 #endif /* CAB_READ_ONLY */
 
     /* Default event handlers */
@@ -438,6 +442,10 @@ private:
     ULONG WriteFileEntries();
     ULONG CommitDataBlocks(PCFFOLDER_NODE FolderNode);
     ULONG WriteDataBlock();
+    ULONG QueueDataBlock();
+    ULONG RetireDataBlock();
+    ULONG FlushDataBlocks();
+    void StopCompressThreads();
     ULONG GetAttributesOnFile(PCFFILE_NODE File);
     ULONG SetAttributesOnFile(char* FileName, USHORT FileAttributes);
     ULONG GetFileTimes(FILE* FileHandle, PCFFILE_NODE File);
@@ -503,6 +511,8 @@ private:
     ULONG TotalBytesLeft;
     bool BlockIsSplit;                  // true if current data block is split
     ULONG NextFolderNumber;     // Zero based folder number
+    ULONG ThreadCount;          // Compression threads, 0 for one per CPU
+    struct _CAB_COMPRESS_POOL* CompressPool;
 #endif /* CAB_READ_ONLY */
 };
 
@@ -192,8 +192,8 @@ void CCABManager::Usage()
 {
     printf("ReactOS Cabinet Manager\n\n");
     printf("CABMAN [-D | -E] [-A] [-L dir] cabinet [filename ...]\n");
-    printf("CABMAN [-M mode] -C dirfile [-I] [-RC file] [-P dir]\n");
-    printf("CABMAN [-M mode] -S cabinet filename [...]\n");
+    printf("CABMAN [-M mode] [-T threads] -C dirfile [-I] [-RC file] [-P dir]\n");
+    printf("CABMAN [-M mode] [-T threads] -S cabinet filename [...]\n");
     printf("  cabinet   Cabinet file.\n");
     printf("  filename  Name of the file to add to or extract from the cabinet.\n");
     printf("            Wild cards and multiple filenames\n");
@@ -217,6 +217,8 @@ void CCABManager::Usage()
     printf("            (size must be less than 64KB).\n");
     printf("  -S        Create simple cabinet.\n");
     printf("  -P dir    Files in the .dff are relative to this directory.\n");
+    printf("  -T n      Number of threads compressing the cabinet\n");
+    printf("            (default is one per CPU, the cabinet is the same).\n");
     printf("  -V        Verbose mode (prints more messages).\n");
 }
 
@@ -347,6 +349,18 @@ bool CCABManager::ParseCmdline(int argc, char* argv[])
 
                     break;
 
+                case 't':
+                case 'T':
+                    if (argv[i][2] == 0)
+                    {
+                        i++;
+                        SetThreadCount(atoi(&argv[i][0]));
+                    }
+                    else
+                        SetThreadCount(atoi(&argv[i][2]));
+
+                    break;
+
                 case 'V':
                     Verbose = true;
                     break;
@@ -0,0 +1,228 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Checksum benchmark for the TCP/IP driver
+ *
+ * Times ChecksumCompute and the copy of a UDP payload with its checksum
+ * against the 16-bit word loops that the driver used before, for the
+ * packet sizes that matter on the wire, and reports the throughput in
+ * GB/s. The new routines are first checked against the old ones for
+ * every length up to a jumbo frame, at every alignment and with random
+ * seeds, down to the exact value returned by UDPv4ChecksumCalculate.
+ */
+
+#include <precomp.h>
+#include <time.h>
+
+#define DEFAULT_BYTES       (1024 * 1024 * 1024)
+#define MAX_PACKET          9000
+#define UDP_HEADER_LENGTH   8
+
+static const ULONG PacketSizes[] = { 64, 576, 1500, 9000 };
+
+static ULONG Seed = 1;
+
+static ULONG Random(VOID)
+{
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 16) | ((Seed * 1103515245 + 12345) & 0xFFFF0000);
+}
+
+static double Now(VOID)
+{
+    struct timespec Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+/* The checksum routines before the 64-bit accumulator */
+static ULONG OldChecksumCompute(PVOID Data, UINT Count, ULONG Seed)
+{
+    ULONG Sum = Seed;
+
+    while (Count > 1) {
+        Sum += *(PUSHORT)Data;
+        Count -= 2;
+        Data = (PVOID)((ULONG_PTR)Data + 2);
+    }
+
+    if (Count > 0)
+        Sum += *(PUCHAR)Data;
+
+    return Sum;
+}
+
+static ULONG OldUDPv4ChecksumCalculate(PIPv4_HEADER IPHeader, PUCHAR PacketBuffer, ULONG DataLength)
+{
+    ULONG Sum = 0;
+    USHORT TmpSum;
+    ULONG i;
+    BOOLEAN Pad;
+
+    Pad = (DataLength & 1);
+    if (Pad)
+        DataLength++;
+
+    for (i = 0; i < DataLength; i += 2) {
+        TmpSum = ((PacketBuffer[i] << 8) & 0xFF00) +
+                 ((Pad && i == DataLength - 2) ? 0 : (PacketBuffer[i + 1] & 0x00FF));
+        Sum += TmpSum;
+    }
+
+    for (i = 0; i < sizeof(IPv4_RAW_ADDRESS); i += 2) {
+        TmpSum = ((((PUCHAR)&IPHeader->SrcAddr)[i] << 8) & 0xFF00) +
+                 (((PUCHAR)&IPHeader->SrcAddr)[i + 1] & 0x00FF);
+        Sum += TmpSum;
+    }
+
+    for (i = 0; i < sizeof(IPv4_RAW_ADDRESS); i += 2) {
+        TmpSum = ((((PUCHAR)&IPHeader->DstAddr)[i] << 8) & 0xFF00) +
+                 (((PUCHAR)&IPHeader->DstAddr)[i + 1] & 0x00FF);
+        Sum += TmpSum;
+    }
+
+    Sum += IPPROTO_UDP + (DataLength - (Pad ? 1 : 0));
+
+    return ~ChecksumFold(Sum);
+}
+
+static VOID FillRandom(PUCHAR Buffer, ULONG Length)
+{
+    ULONG i;
+
+    for (i = 0; i < Length; i++)
+        Buffer[i] = (UCHAR)Random();
+}
+
+static ULONG CheckChecksums(PUCHAR Source, PUCHAR Destination)
+{
+    IPv4_HEADER Header;
+    ULONG Length, Offset, Start, Errors = 0;
+
+    for (Length = 0; Length <= MAX_PACKET; Length++) {
+        for (Offset = 0; Offset < 4; Offset++) {
+            FillRandom(Source, Length + Offset + UDP_HEADER_LENGTH);
+
+            /* Sometimes all ones, where the folding gets tricky */
+            if (Length % 97 == 0)
+                memset(Source, 0xFF, Length + Offset + UDP_HEADER_LENGTH);
+
+            Start = Random() & 0xFFFF;
+            if (ChecksumFold(ChecksumCompute(Source + Offset, Length, Start)) !=
+                ChecksumFold(OldChecksumCompute(Source + Offset, Length, Start)))
+                Errors++;
+
+            memset(Destination, 0, Length + Offset + 1);
+            if (ChecksumFold(ChecksumCopy(Destination + Offset, Source + Offset, Length, Start)) !=
+                ChecksumFold(OldChecksumCompute(Source + Offset, Length, Start)) ||
+                memcmp(Destination + Offset, Source + Offset, Length) ||
+                Destination[Offset + Length] != 0)
+                Errors++;
+
+            /* The UDP header is at an even offset in a packet */
+            if (Offset % 2)
+                continue;
+
+            Header.SrcAddr = Random();
+            Header.DstAddr = Random();
+            if (UDPv4ChecksumCalculate(&Header, Source + Offset, Length) !=
+                OldUDPv4ChecksumCalculate(&Header, Source + Offset, Length))
+                Errors++;
+
+            memcpy(Destination + Offset, Source + Offset, UDP_HEADER_LENGTH);
+            if (UDPv4ChecksumCopy(&Header, Destination + Offset, UDP_HEADER_LENGTH,
+                                  Source + Offset + UDP_HEADER_LENGTH, Length) !=
+                OldUDPv4ChecksumCalculate(&Header, Source + Offset, Length + UDP_HEADER_LENGTH) ||
+                memcmp(Destination + Offset, Source + Offset, Length + UDP_HEADER_LENGTH))
+                Errors++;
+        }
+    }
+
+    return Errors;
+}
+
+typedef enum _BENCH_KIND {
+    BenchOldChecksum,
+    BenchChecksum,
+    BenchOldCopy,
+    BenchCopy
+} BENCH_KIND;
+
+static double TimeChecksums(PUCHAR Source, PUCHAR Destination, ULONG Size,
+                            ULONGLONG Bytes, BENCH_KIND Kind)
+{
+    IPv4_HEADER Header = { 0 };
+    volatile ULONG Result;
+    ULONGLONG Done;
+    double Start;
+
+    Start = Now();
+    for (Done = 0; Done < Bytes; Done += Size) {
+        switch (Kind) {
+            case BenchOldChecksum:
+                Result = ChecksumFold(OldChecksumCompute(Source, Size, 0));
+                break;
+
+            case BenchChecksum:
+                Result = ChecksumFold(ChecksumCompute(Source, Size, 0));
+                break;
+
+            /* What udp.c did: copy the payload, then sum the datagram */
+            case BenchOldCopy:
+                memcpy(Destination + UDP_HEADER_LENGTH, Source, Size);
+                Result = OldUDPv4ChecksumCalculate(&Header, Destination, Size + UDP_HEADER_LENGTH);
+                break;
+
+            case BenchCopy:
+                Result = UDPv4ChecksumCopy(&Header, Destination, UDP_HEADER_LENGTH, Source, Size);
+                break;
+        }
+    }
+
+    (void)Result;
+    return Bytes / (Now() - Start) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    PUCHAR Source, Destination;
+    ULONGLONG Bytes = DEFAULT_BYTES;
+    ULONG Size, Errors;
+    double Old, New, OldCopy, Copy;
+
+    if (argc > 1)
+        Bytes = strtoull(argv[1], NULL, 0);
+    if (Bytes == 0) {
+        printf("Usage: %s [bytes per test]\n", argv[0]);
+        return 1;
+    }
+
+    Source = malloc(MAX_PACKET + 16);
+    Destination = malloc(MAX_PACKET + 16);
+    if (!Source || !Destination) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    Errors = CheckChecksums(Source, Destination);
+    printf("%lu checksums did not match the old routines\n\n", Errors);
+
+    printf("%-6s %12s %12s %8s %12s %12s %8s\n", "size", "old GB/s", "new GB/s", "speedup",
+           "copy+sum", "fused GB/s", "speedup");
+
+    FillRandom(Source, MAX_PACKET + 16);
+    for (Size = 0; Size < sizeof(PacketSizes) / sizeof(PacketSizes[0]); Size++) {
+        Old = TimeChecksums(Source, Destination, PacketSizes[Size], Bytes, BenchOldChecksum);
+        New = TimeChecksums(Source, Destination, PacketSizes[Size], Bytes, BenchChecksum);
+        OldCopy = TimeChecksums(Source, Destination, PacketSizes[Size], Bytes, BenchOldCopy);
+        Copy = TimeChecksums(Source, Destination, PacketSizes[Size], Bytes, BenchCopy);
+
+        printf("%-6lu %12.2f %12.2f %7.1fx %12.2f %12.2f %7.1fx\n", PacketSizes[Size],
+               Old, New, New / Old, OldCopy, Copy, Copy / OldCopy);
+    }
+
+    free(Destination);
+    free(Source);
+    return Errors != 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Minimal TCP/IP driver environment to build the checksum routines on the host
+ */
+
+#pragma once
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef ULONG IPv4_RAW_ADDRESS;
+
+typedef struct IPv4_HEADER {
+    UCHAR VerIHL;
+    UCHAR Tos;
+    USHORT TotalLength;
+    USHORT Id;
+    USHORT FlagsFragOfs;
+    UCHAR Ttl;
+    UCHAR Protocol;
+    USHORT Checksum;
+    IPv4_RAW_ADDRESS SrcAddr;
+    IPv4_RAW_ADDRESS DstAddr;
+} IPv4_HEADER, *PIPv4_HEADER;
+
+#define IPPROTO_UDP     17
+
+#include <checksum.h>
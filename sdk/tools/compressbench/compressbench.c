@@ -0,0 +1,310 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Throughput and ratio benchmark for the RTL compression engines
+ *
+ * Every format and engine compresses the same input with RtlCompressBuffer
+ * and decompresses it again with RtlDecompressBuffer. The round trip is
+ * checked, and the ratio and the speed of both directions are printed.
+ * The input is either a file given on the command line, or generated text
+ * with a share of noise, the same the RtlCompressBuffer apitest uses.
+ *
+ * The compression code runs on top of malloc and a single processor, so
+ * the parallel chunk decompression is never used here.
+ */
+
+#include <rtl.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_SIZE    (4 * 1024 * 1024)
+#define DEFAULT_RUNS    3
+
+#define ARRAYSIZE(a)    (sizeof(a) / sizeof((a)[0]))
+
+PVOID MmHighestUserAddress = (PVOID)~(ULONG_PTR)0;
+
+/* HOST ENVIRONMENT **********************************************************/
+
+PVOID NTAPI
+RtlpAllocateMemory(ULONG Bytes,
+                   ULONG Tag)
+{
+    return malloc(Bytes);
+}
+
+VOID NTAPI
+RtlpFreeMemory(PVOID Mem,
+               ULONG Tag)
+{
+    free(Mem);
+}
+
+ULONG NTAPI
+RtlpGetNumberOfProcessors(VOID)
+{
+    return 1;
+}
+
+BOOLEAN NTAPI
+RtlpQueueWorkItem(WORKERCALLBACKFUNC Function,
+                  PVOID Context)
+{
+    return FALSE;
+}
+
+NTSTATUS NTAPI
+ZwCreateEvent(PHANDLE EventHandle,
+              ULONG DesiredAccess,
+              POBJECT_ATTRIBUTES ObjectAttributes,
+              EVENT_TYPE EventType,
+              BOOLEAN InitialState)
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS NTAPI
+ZwSetEvent(HANDLE EventHandle,
+           PLONG PreviousState)
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS NTAPI
+ZwWaitForSingleObject(HANDLE Handle,
+                      BOOLEAN Alertable,
+                      PLARGE_INTEGER Timeout)
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS NTAPI
+ZwClose(HANDLE Handle)
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+/* BENCHMARK *****************************************************************/
+
+static const struct
+{
+    USHORT FormatAndEngine;
+    const char *Name;
+} Engines[] =
+{
+    { COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_STANDARD, "LZNT1" },
+    { COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_MAXIMUM, "LZNT1 maximum" },
+    { COMPRESSION_FORMAT_XPRESS | COMPRESSION_ENGINE_STANDARD, "XPRESS" },
+    { COMPRESSION_FORMAT_XPRESS | COMPRESSION_ENGINE_MAXIMUM, "XPRESS maximum" },
+    { COMPRESSION_FORMAT_XPRESS_HUFF | COMPRESSION_ENGINE_STANDARD, "XPRESS Huffman" },
+    { COMPRESSION_FORMAT_XPRESS_HUFF | COMPRESSION_ENGINE_MAXIMUM, "XPRESS Huffman maximum" },
+};
+
+static
+VOID
+FillBuffer(PUCHAR Buffer, ULONG Size)
+{
+    static const CHAR Words[][9] = { "ReactOS", "kernel", "driver", "registry", "win32k", "ntdll" };
+    ULONG Seed = 0x12345678;
+    ULONG i = 0, Length;
+    PCSTR Word;
+
+    /* Text-like data with a share of noise, so every engine has something to find */
+    while (i < Size)
+    {
+        Seed = Seed * 1103515245 + 12345;
+        if ((Seed >> 16) & 3)
+        {
+            Word = Words[(Seed >> 20) % ARRAYSIZE(Words)];
+            Length = min((ULONG)strlen(Word), Size - i);
+            memcpy(Buffer + i, Word, Length);
+            i += Length;
+        }
+        else
+        {
+            Buffer[i++] = (UCHAR)(Seed >> 24);
+        }
+    }
+}
+
+static
+PUCHAR
+ReadInput(const char *FileName, PULONG Size)
+{
+    PUCHAR Buffer;
+    FILE *File;
+    long Length;
+
+    File = fopen(FileName, "rb");
+    if (!File)
+    {
+        fprintf(stderr, "Cannot open %s\n", FileName);
+        return NULL;
+    }
+
+    fseek(File, 0, SEEK_END);
+    Length = ftell(File);
+    fseek(File, 0, SEEK_SET);
+    if (Length <= 0 || Length > 0x40000000)
+    {
+        fprintf(stderr, "%s is empty or too large\n", FileName);
+        fclose(File);
+        return NULL;
+    }
+
+    Buffer = malloc(Length);
+    if (Buffer && fread(Buffer, 1, Length, File) != (size_t)Length)
+    {
+        fprintf(stderr, "Cannot read %s\n", FileName);
+        free(Buffer);
+        Buffer = NULL;
+    }
+
+    fclose(File);
+    *Size = (ULONG)Length;
+    return Buffer;
+}
+
+static
+double
+Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static
+BOOL
+RunEngine(ULONG Index, PUCHAR Input, ULONG Size, ULONG Runs)
+{
+    ULONG WorkSpaceSize, FragmentWorkSpaceSize;
+    ULONG BufferSize, CompressedSize = 0, FinalSize = 0, Run;
+    double Start, CompressTime = 0, DecompressTime = 0;
+    PUCHAR Compressed, Output;
+    PVOID WorkSpace;
+    NTSTATUS Status;
+    BOOL Result = FALSE;
+
+    Status = RtlGetCompressionWorkSpaceSize(Engines[Index].FormatAndEngine,
+                                            &WorkSpaceSize,
+                                            &FragmentWorkSpaceSize);
+    if (!NT_SUCCESS(Status))
+    {
+        printf("%-24s RtlGetCompressionWorkSpaceSize failed with 0x%08x\n",
+               Engines[Index].Name, (unsigned)Status);
+        return FALSE;
+    }
+
+    /* Worst case is a flag word per 32 literals for XPRESS, and a code table per 64 KB for XPRESS Huffman */
+    BufferSize = Size + Size / 8 + 0x400;
+    WorkSpace = malloc(WorkSpaceSize);
+    Compressed = malloc(BufferSize);
+    Output = malloc(Size);
+    if (!WorkSpace || !Compressed || !Output)
+    {
+        fprintf(stderr, "Out of memory\n");
+        goto Cleanup;
+    }
+
+    for (Run = 0; Run < Runs; Run++)
+    {
+        Start = Now();
+        Status = RtlCompressBuffer(Engines[Index].FormatAndEngine, Input, Size,
+                                   Compressed, BufferSize, 4096, &CompressedSize, WorkSpace);
+        CompressTime += Now() - Start;
+        if (!NT_SUCCESS(Status))
+        {
+            printf("%-24s RtlCompressBuffer failed with 0x%08x\n",
+                   Engines[Index].Name, (unsigned)Status);
+            goto Cleanup;
+        }
+
+        Start = Now();
+        Status = RtlDecompressBuffer(Engines[Index].FormatAndEngine & 0xFF, Output, Size,
+                                     Compressed, CompressedSize, &FinalSize);
+        DecompressTime += Now() - Start;
+        if (!NT_SUCCESS(Status) || FinalSize != Size || memcmp(Input, Output, Size))
+        {
+            printf("%-24s round trip failed with 0x%08x, %u of %u bytes\n",
+                   Engines[Index].Name, (unsigned)Status, (unsigned)FinalSize, (unsigned)Size);
+            goto Cleanup;
+        }
+    }
+
+    printf("%-24s %6.2f%% %10.1f MB/s %10.1f MB/s\n",
+           Engines[Index].Name,
+           CompressedSize * 100.0 / Size,
+           (double)Size * Runs / CompressTime / (1024 * 1024),
+           (double)Size * Runs / DecompressTime / (1024 * 1024));
+    Result = TRUE;
+
+Cleanup:
+    free(Output);
+    free(Compressed);
+    free(WorkSpace);
+    return Result;
+}
+
+static
+void
+Usage(void)
+{
+    printf("Usage: compressbench [-r runs] [file]\n"
+           "  -r runs  Round trips per engine (default %u)\n"
+           "  file     Input to compress, instead of %u MB of generated text\n",
+           DEFAULT_RUNS, DEFAULT_SIZE / (1024 * 1024));
+}
+
+int
+main(int argc, char **argv)
+{
+    ULONG Runs = DEFAULT_RUNS, Size = DEFAULT_SIZE, i;
+    PUCHAR Input;
+    BOOL Success = TRUE;
+    int Arg;
+
+    for (Arg = 1; Arg < argc && argv[Arg][0] == '-'; Arg++)
+    {
+        if (!strcmp(argv[Arg], "-r") && Arg + 1 < argc)
+        {
+            Runs = strtoul(argv[++Arg], NULL, 0);
+            if (Runs == 0)
+                Runs = 1;
+        }
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (Arg < argc)
+    {
+        Input = ReadInput(argv[Arg], &Size);
+        if (!Input)
+            return 1;
+    }
+    else
+    {
+        Input = malloc(Size);
+        if (!Input)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        FillBuffer(Input, Size);
+    }
+
+    printf("%u bytes, %u round trips\n\n", (unsigned)Size, (unsigned)Runs);
+    printf("%-24s %7s %15s %15s\n", "Engine", "Ratio", "Compress", "Decompress");
+    for (i = 0; i < ARRAYSIZE(Engines); i++)
+    {
+        if (!RunEngine(i, Input, Size, Runs))
+            Success = FALSE;
+    }
+
+    free(Input);
+    return Success ? 0 : 1;
+}
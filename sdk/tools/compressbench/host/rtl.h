@@ -0,0 +1,120 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Minimal rtl environment to build the compression code on the host
+ */
+
+#pragma once
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <string.h>
+
+#define C_ASSERT(e) typedef char __C_ASSERT__[(e) ? 1 : -1]
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define DPRINT if (0) printf
+#define DPRINT1 printf
+
+typedef HANDLE *PHANDLE;
+typedef UCHAR KPROCESSOR_MODE;
+
+#define KernelMode 0
+#define UserMode   1
+
+/* Status codes */
+#define STATUS_SUCCESS                  ((NTSTATUS)0x00000000L)
+#define STATUS_NOT_IMPLEMENTED          ((NTSTATUS)0xC0000002L)
+#define STATUS_ACCESS_VIOLATION         ((NTSTATUS)0xC0000005L)
+#define STATUS_INVALID_PARAMETER        ((NTSTATUS)0xC000000DL)
+#define STATUS_NO_MEMORY                ((NTSTATUS)0xC0000017L)
+#define STATUS_BUFFER_TOO_SMALL         ((NTSTATUS)0xC0000023L)
+#define STATUS_NOT_SUPPORTED            ((NTSTATUS)0xC00000BBL)
+#define STATUS_BAD_COMPRESSION_BUFFER   ((NTSTATUS)0xC0000242L)
+#define STATUS_UNSUPPORTED_COMPRESSION  ((NTSTATUS)0xC000025FL)
+
+/* Compression formats and engines */
+#define COMPRESSION_FORMAT_NONE         (0x0000)
+#define COMPRESSION_FORMAT_DEFAULT      (0x0001)
+#define COMPRESSION_FORMAT_LZNT1        (0x0002)
+#define COMPRESSION_FORMAT_XPRESS       (0x0003)
+#define COMPRESSION_FORMAT_XPRESS_HUFF  (0x0004)
+#define COMPRESSION_ENGINE_STANDARD     (0x0000)
+#define COMPRESSION_ENGINE_MAXIMUM      (0x0100)
+
+typedef struct _COMPRESSED_DATA_INFO
+{
+    USHORT CompressionFormatAndEngine;
+    UCHAR CompressionUnitShift;
+    UCHAR ChunkShift;
+    UCHAR ClusterShift;
+    UCHAR Reserved;
+    USHORT NumberOfChunks;
+    ULONG CompressedChunkSizes[ANYSIZE_ARRAY];
+} COMPRESSED_DATA_INFO, *PCOMPRESSED_DATA_INFO;
+
+/* Objects, only for the parallel chunk decompression, which never runs here */
+#define OBJ_KERNEL_HANDLE   0x00000200L
+#define EVENT_ALL_ACCESS    0x001F0003
+
+typedef enum _EVENT_TYPE
+{
+    NotificationEvent,
+    SynchronizationEvent
+} EVENT_TYPE;
+
+typedef struct _OBJECT_ATTRIBUTES
+{
+    ULONG Length;
+    HANDLE RootDirectory;
+    PVOID ObjectName;
+    ULONG Attributes;
+    PVOID SecurityDescriptor;
+    PVOID SecurityQualityOfService;
+} OBJECT_ATTRIBUTES, *POBJECT_ATTRIBUTES;
+
+#define InitializeObjectAttributes(p, n, a, r, s) \
+    do { (p)->Length = sizeof(OBJECT_ATTRIBUTES); (p)->RootDirectory = (r); (p)->ObjectName = (n); \
+         (p)->Attributes = (a); (p)->SecurityDescriptor = (s); (p)->SecurityQualityOfService = NULL; } while (0)
+
+typedef VOID (NTAPI *WORKERCALLBACKFUNC)(PVOID Context);
+
+extern PVOID MmHighestUserAddress;
+
+NTSTATUS NTAPI ZwCreateEvent(PHANDLE EventHandle, ULONG DesiredAccess, POBJECT_ATTRIBUTES ObjectAttributes,
+                             EVENT_TYPE EventType, BOOLEAN InitialState);
+NTSTATUS NTAPI ZwSetEvent(HANDLE EventHandle, PLONG PreviousState);
+NTSTATUS NTAPI ZwWaitForSingleObject(HANDLE Handle, BOOLEAN Alertable, PLARGE_INTEGER Timeout);
+NTSTATUS NTAPI ZwClose(HANDLE Handle);
+
+/* Interlocked operations */
+#define InterlockedIncrement(Target) __sync_add_and_fetch(Target, 1)
+#define InterlockedDecrement(Target) __sync_sub_and_fetch(Target, 1)
+#define InterlockedCompareExchange(Target, Exchange, Comperand) \
+    __sync_val_compare_and_swap(Target, Comperand, Exchange)
+
+/* Support routines, provided by the benchmark */
+#define RtlpGetMode() UserMode
+
+PVOID NTAPI RtlpAllocateMemory(ULONG Bytes, ULONG Tag);
+VOID NTAPI RtlpFreeMemory(PVOID Mem, ULONG Tag);
+ULONG NTAPI RtlpGetNumberOfProcessors(VOID);
+BOOLEAN NTAPI RtlpQueueWorkItem(WORKERCALLBACKFUNC Function, PVOID Context);
+
+/* The public compression interface */
+NTSTATUS NTAPI RtlGetCompressionWorkSpaceSize(USHORT CompressionFormatAndEngine,
+                                              PULONG CompressBufferWorkSpaceSize,
+                                              PULONG CompressFragmentWorkSpaceSize);
+NTSTATUS NTAPI RtlCompressBuffer(USHORT CompressionFormatAndEngine, PUCHAR UncompressedBuffer,
+                                 ULONG UncompressedBufferSize, PUCHAR CompressedBuffer,
+                                 ULONG CompressedBufferSize, ULONG UncompressedChunkSize,
+                                 PULONG FinalCompressedSize, PVOID WorkSpace);
+NTSTATUS NTAPI RtlDecompressBuffer(USHORT CompressionFormat, PUCHAR UncompressedBuffer,
+                                   ULONG UncompressedBufferSize, PUCHAR CompressedBuffer,
+                                   ULONG CompressedBufferSize, PULONG FinalUncompressedSize);
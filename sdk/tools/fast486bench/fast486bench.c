@@ -0,0 +1,723 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Fast486 benchmark and conformance harness
+ * PROGRAMMER:  ReactOS Team
+ */
+
+/*
+ * Runs a few instruction-mix programs on the Fast486 library built for
+ * the host. Every program is first single-stepped, hashing the register
+ * state after each instruction, and the results are checked against the
+ * golden values recorded below. Then it runs again at full speed with
+ * Fast486Continue, which is what the MIPS figures are based on.
+ *
+ * Each iteration of a REP instruction counts as one instruction, since
+ * that is what a single step executes. Build the host tools in release
+ * mode (CMAKE_BUILD_TYPE=Release) before comparing any timings.
+ *
+ * When a change to the library is meant to alter the results, compare
+ * the output of -d against a build of the previous revision, then paste
+ * the output of -g into the table.
+ */
+
+#include <windef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <time.h>
+
+#include <fast486.h>
+
+/* DEFINES ********************************************************************/
+
+#define GUEST_MEMORY_SIZE   0x110000
+#define PROGRAM_ADDRESS     0x1000
+#define MAX_INSTRUCTIONS    100000000ULL
+
+#define ARRAYSIZE(a)        (sizeof(a) / sizeof((a)[0]))
+
+#define FNV_OFFSET_BASIS    0x811C9DC5
+#define FNV_PRIME           0x01000193
+
+typedef struct _BENCH_PROGRAM
+{
+    PCSTR Name;
+    const UCHAR *Code;
+    ULONG Size;
+
+    /* Golden results */
+    ULONGLONG Instructions;
+    ULONG Registers[FAST486_NUM_GEN_REGS];
+    ULONG Flags;
+    ULONG TraceDigest;
+    ULONG MemoryDigest;
+} BENCH_PROGRAM, *PBENCH_PROGRAM;
+
+typedef struct _BENCH_RESULT
+{
+    ULONGLONG Instructions;
+    ULONG Registers[FAST486_NUM_GEN_REGS];
+    ULONG Flags;
+    ULONG TraceDigest;
+    ULONG MemoryDigest;
+} BENCH_RESULT, *PBENCH_RESULT;
+
+/* PROGRAMS *******************************************************************/
+
+/*
+ * All programs are loaded at 0000:1000 and end with BOP 00.
+ * The segment program refers to its own data by absolute address.
+ */
+
+/* Integer arithmetic, logic and shifts on 16-bit and 32-bit registers */
+static const UCHAR AluProgram[] =
+{
+    0x31, 0xC0,                             /* xor ax,ax */
+    0x8E, 0xD0,                             /* mov ss,ax */
+    0xBC, 0x00, 0x0F,                       /* mov sp,0xf00 */
+    0x66, 0xB8, 0x78, 0x56, 0x34, 0x12,     /* mov eax,0x12345678 */
+    0x66, 0xBB, 0xF0, 0xDE, 0xBC, 0x9A,     /* mov ebx,0x9abcdef0 */
+    0x66, 0xB9, 0x00, 0x00, 0x08, 0x00,     /* mov ecx,0x80000 */
+    0x66, 0x31, 0xD2,                       /* xor edx,edx */
+    0x66, 0xBE, 0xDF, 0x9B, 0x57, 0x13,     /* mov esi,0x13579bdf */
+    0xBF, 0x11, 0x11,                       /* mov di,0x1111 */
+    /* Loop: */
+    0x66, 0x01, 0xD8,                       /* add eax,ebx */
+    0x66, 0x11, 0xCA,                       /* adc edx,ecx */
+    0x66, 0xC1, 0xC0, 0x05,                 /* rol eax,0x5 */
+    0x66, 0x31, 0xC3,                       /* xor ebx,eax */
+    0x66, 0x69, 0xF0, 0x47, 0x86, 0xC8, 0x61, /* imul esi,eax,0x61c88647 */
+    0x29, 0xF7,                             /* sub di,si */
+    0x19, 0xD5,                             /* sbb bp,dx */
+    0x66, 0xC1, 0xEE, 0x03,                 /* shr esi,0x3 */
+    0x66, 0x09, 0xF3,                       /* or ebx,esi */
+    0x80, 0xE2, 0x7F,                       /* and dl,0x7f */
+    0x47,                                   /* inc di */
+    0xF7, 0xDD,                             /* neg bp */
+    0x66, 0x39, 0xD8,                       /* cmp eax,ebx */
+    0x66, 0x49,                             /* dec ecx */
+    0x75, 0xD4,                             /* jnz Loop */
+    0xC4, 0xC4, 0x00,                       /* bop 0x00 */
+};
+
+/* REP MOVS/STOS/CMPS, LODS and port I/O */
+static const UCHAR StringProgram[] =
+{
+    0x31, 0xC0,                             /* xor ax,ax */
+    0x8E, 0xD0,                             /* mov ss,ax */
+    0xBC, 0x00, 0x0F,                       /* mov sp,0xf00 */
+    0xB8, 0x00, 0x20,                       /* mov ax,0x2000 */
+    0x8E, 0xD8,                             /* mov ds,ax */
+    0x8E, 0xC0,                             /* mov es,ax */
+    0xFC,                                   /* cld */
+    0x31, 0xFF,                             /* xor di,di */
+    0xB9, 0x00, 0x40,                       /* mov cx,0x4000 */
+    0xB8, 0x23, 0x01,                       /* mov ax,0x123 */
+    /* Fill: */
+    0xAB,                                   /* stos word es:[di],ax */
+    0x05, 0x45, 0x3B,                       /* add ax,0x3b45 */
+    0xC1, 0xC0, 0x03,                       /* rol ax,0x3 */
+    0xE2, 0xF7,                             /* loop Fill */
+    0xB8, 0x00, 0x30,                       /* mov ax,0x3000 */
+    0x8E, 0xC0,                             /* mov es,ax */
+    0xBD, 0x00, 0x02,                       /* mov bp,0x200 */
+    /* Loop: */
+    0x31, 0xF6,                             /* xor si,si */
+    0x31, 0xFF,                             /* xor di,di */
+    0xB9, 0x00, 0x10,                       /* mov cx,0x1000 */
+    0xF3, 0xA5,                             /* rep movs word es:[di],word ds:[si] */
+    0xBF, 0x00, 0x0C,                       /* mov di,0xc00 */
+    0xB0, 0x5A,                             /* mov al,0x5a */
+    0xB9, 0x00, 0x04,                       /* mov cx,0x400 */
+    0xF3, 0xAA,                             /* rep stos byte es:[di],al */
+    0x31, 0xF6,                             /* xor si,si */
+    0x31, 0xFF,                             /* xor di,di */
+    0xB9, 0x00, 0x20,                       /* mov cx,0x2000 */
+    0xF3, 0xA6,                             /* repe cmps byte ds:[si],byte es:[di] */
+    0x01, 0xCA,                             /* add dx,cx */
+    0x31, 0xFF,                             /* xor di,di */
+    0xB9, 0x00, 0x20,                       /* mov cx,0x2000 */
+    0xF2, 0xAE,                             /* repne scas al,byte es:[di] */
+    0x01, 0xCA,                             /* add dx,cx */
+    0x31, 0xF6,                             /* xor si,si */
+    0xB9, 0x80, 0x00,                       /* mov cx,0x80 */
+    /* Sum: */
+    0xAD,                                   /* lods ax,word ds:[si] */
+    0x01, 0xC3,                             /* add bx,ax */
+    0xE2, 0xFB,                             /* loop Sum */
+    0xBF, 0x00, 0xC0,                       /* mov di,0xc000 */
+    0xB9, 0x00, 0x02,                       /* mov cx,0x200 */
+    0x66, 0xF3, 0xA5,                       /* rep movs dword es:[di],dword ds:[si] */
+    0xE7, 0x80,                             /* out 0x80,ax */
+    0xE5, 0x81,                             /* in ax,0x81 */
+    0x01, 0xC3,                             /* add bx,ax */
+    0x4D,                                   /* dec bp */
+    0x75, 0xBD,                             /* jnz Loop */
+    0xC4, 0xC4, 0x00,                       /* bop 0x00 */
+};
+
+/* x87 arithmetic, loads and stores, and FPU status to flags */
+static const UCHAR FpuProgram[] =
+{
+    0x31, 0xC0,                             /* xor ax,ax */
+    0x8E, 0xD0,                             /* mov ss,ax */
+    0x8E, 0xD8,                             /* mov ds,ax */
+    0xBC, 0x00, 0x0F,                       /* mov sp,0xf00 */
+    0xDB, 0xE3,                             /* fninit */
+    0xD9, 0xE8,                             /* fld1 */
+    0xD9, 0xEE,                             /* fldz */
+    0xC7, 0x06, 0x00, 0x0F, 0x03, 0x00,     /* mov word [0xf00],0x3 */
+    0x66, 0xB9, 0x00, 0x00, 0x02, 0x00,     /* mov ecx,0x20000 */
+    /* Loop: */
+    0xD8, 0xC1,                             /* fadd st,st(1) */
+    0xD9, 0xC0,                             /* fld st(0) */
+    0xD8, 0xC8,                             /* fmul st,st(0) */
+    0xD9, 0xFA,                             /* fsqrt */
+    0xDF, 0x06, 0x00, 0x0F,                 /* fild word [0xf00] */
+    0xDE, 0xC9,                             /* fmulp st(1),st */
+    0xDB, 0x1E, 0x04, 0x0F,                 /* fistp dword [0xf04] */
+    0x66, 0xA1, 0x04, 0x0F,                 /* mov eax,[0xf04] */
+    0x66, 0x01, 0xC2,                       /* add edx,eax */
+    0xD8, 0xD1,                             /* fcom st(1) */
+    0xDF, 0xE0,                             /* fnstsw ax */
+    0x9E,                                   /* sahf */
+    0xD9, 0xC0,                             /* fld st(0) */
+    0xD8, 0xF2,                             /* fdiv st,st(2) */
+    0xDD, 0x1E, 0x10, 0x0F,                 /* fstp qword [0xf10] */
+    0xDD, 0x06, 0x10, 0x0F,                 /* fld qword [0xf10] */
+    0xD9, 0xC9,                             /* fxch st(1) */
+    0xD9, 0xC9,                             /* fxch st(1) */
+    0xDD, 0xD8,                             /* fstp st(0) */
+    0x66, 0x49,                             /* dec ecx */
+    0x75, 0xCC,                             /* jnz Loop */
+    0xDF, 0xE0,                             /* fnstsw ax */
+    0x89, 0xC3,                             /* mov bx,ax */
+    0xDD, 0x1E, 0x10, 0x0F,                 /* fstp qword [0xf10] */
+    0x66, 0x8B, 0x36, 0x10, 0x0F,           /* mov esi,dword [0xf10] */
+    0x66, 0x8B, 0x3E, 0x14, 0x0F,           /* mov edi,dword [0xf14] */
+    0xC4, 0xC4, 0x00,                       /* bop 0x00 */
+};
+
+/* Protected mode segment register loads */
+static const UCHAR SegmentProgram[] =
+{
+    0xFA,                                   /* cli */
+    0x31, 0xC0,                             /* xor ax,ax */
+    0x8E, 0xD8,                             /* mov ds,ax */
+    0x66, 0x0F, 0x01, 0x16, 0x88, 0x10,     /* lgdtd [0x1088] */
+    0x0F, 0x20, 0xC0,                       /* mov eax,cr0 */
+    0x0C, 0x01,                             /* or al,0x1 */
+    0x0F, 0x22, 0xC0,                       /* mov cr0,eax */
+    0x66, 0xEA, 0x1B, 0x10, 0x00, 0x00, 0x08, 0x00, /* jmp 0x8:0x101b */
+    /* Protected: */
+    0x66, 0xB8, 0x10, 0x00,                 /* mov ax,0x10 */
+    0x8E, 0xD8,                             /* mov ds,ax */
+    0x8E, 0xD0,                             /* mov ss,ax */
+    0xBC, 0x00, 0x0F, 0x00, 0x00,           /* mov esp,0xf00 */
+    0xB9, 0x00, 0x00, 0x04, 0x00,           /* mov ecx,0x40000 */
+    0xBE, 0x8E, 0x10, 0x00, 0x00,           /* mov esi,0x108e */
+    /* Loop: */
+    0x66, 0xB8, 0x18, 0x00,                 /* mov ax,0x18 */
+    0x8E, 0xC0,                             /* mov es,ax */
+    0x66, 0xBB, 0x20, 0x00,                 /* mov bx,0x20 */
+    0x8E, 0xE3,                             /* mov fs,bx */
+    0x1E,                                   /* push ds */
+    0x0F, 0xA9,                             /* pop gs */
+    0xC4, 0x3E,                             /* les edi,fword [esi] */
+    0x26, 0x8B, 0x07,                       /* mov eax,dword es:[edi] */
+    0x01, 0xC2,                             /* add edx,eax */
+    0x66, 0x8C, 0xD0,                       /* mov ax,ss */
+    0x8E, 0xD8,                             /* mov ds,ax */
+    0x0F, 0xB4, 0x2E,                       /* lfs ebp,fword [esi] */
+    0x66, 0x8C, 0xE3,                       /* mov bx,fs */
+    0x66, 0x01, 0xDA,                       /* add dx,bx */
+    0x49,                                   /* dec ecx */
+    0x75, 0xD9,                             /* jnz Loop */
+    0x66, 0x8C, 0xC6,                       /* mov si,es */
+    0xC4, 0xC4, 0x00,                       /* bop 0x00 */
+    0x90,                                   /* nop (padding) */
+    /* Gdt: */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* null */
+    0xFF, 0xFF, 0x00, 0x00, 0x00, 0x9A, 0xCF, 0x00, /* 08: flat 32-bit code */
+    0xFF, 0xFF, 0x00, 0x00, 0x00, 0x92, 0xCF, 0x00, /* 10: flat 32-bit data */
+    0xFF, 0xFF, 0x00, 0x00, 0x00, 0x92, 0x40, 0x00, /* 18: 64 KB 32-bit data */
+    0xFF, 0xFF, 0x00, 0x00, 0x02, 0xF2, 0x00, 0x00, /* 20: 64 KB DPL 3 data at 0x20000 */
+    /* Gdtr: */
+    0x27, 0x00, 0x60, 0x10, 0x00, 0x00,
+    /* FarPointer: */
+    0x00, 0x10, 0x00, 0x00, 0x18, 0x00,
+};
+
+/* Paging with a CR3 reload and an INVLPG after touching every 16 pages */
+static const UCHAR PagingProgram[] =
+{
+    0xFA,                                   /* cli */
+    0x31, 0xC0,                             /* xor ax,ax */
+    0x8E, 0xD8,                             /* mov ds,ax */
+    0x66, 0x0F, 0x01, 0x16, 0xC8, 0x10,     /* lgdtd [0x10c8] */
+    0x0F, 0x20, 0xC0,                       /* mov eax,cr0 */
+    0x0C, 0x01,                             /* or al,0x1 */
+    0x0F, 0x22, 0xC0,                       /* mov cr0,eax */
+    0x66, 0xEA, 0x1B, 0x10, 0x00, 0x00, 0x08, 0x00, /* jmp 0x8:0x101b */
+    /* Protected: */
+    0x66, 0xB8, 0x10, 0x00,                 /* mov ax,0x10 */
+    0x8E, 0xD8,                             /* mov ds,ax */
+    0x8E, 0xC0,                             /* mov es,ax */
+    0x8E, 0xD0,                             /* mov ss,ax */
+    0xBC, 0x00, 0x0F, 0x00, 0x00,           /* mov esp,0xf00 */
+    0xFC,                                   /* cld */
+    0xBF, 0x00, 0x10, 0x01, 0x00,           /* mov edi,0x11000 */
+    0xB8, 0x03, 0x00, 0x00, 0x00,           /* mov eax,0x3 */
+    0xB9, 0x00, 0x04, 0x00, 0x00,           /* mov ecx,0x400 */
+    /* Fill: */
+    0xAB,                                   /* stos dword es:[edi],eax */
+    0x05, 0x00, 0x10, 0x00, 0x00,           /* add eax,0x1000 */
+    0xE2, 0xF8,                             /* loop Fill */
+    0xC7, 0x05, 0x00, 0x00, 0x01, 0x00, 0x03, 0x10, 0x01, 0x00, /* mov dword [0x10000],0x11003 */
+    0xC7, 0x05, 0x00, 0x20, 0x01, 0x00, 0x03, 0x10, 0x01, 0x00, /* mov dword [0x12000],0x11003 */
+    0xB8, 0x00, 0x00, 0x01, 0x00,           /* mov eax,0x10000 */
+    0x0F, 0x22, 0xD8,                       /* mov cr3,eax */
+    0x0F, 0x20, 0xC0,                       /* mov eax,cr0 */
+    0x0D, 0x00, 0x00, 0x00, 0x80,           /* or eax,0x80000000 */
+    0x0F, 0x22, 0xC0,                       /* mov cr0,eax */
+    0xB9, 0x00, 0x80, 0x00, 0x00,           /* mov ecx,0x8000 */
+    /* Loop: */
+    0xBE, 0x00, 0x00, 0x02, 0x00,           /* mov esi,0x20000 */
+    0xBB, 0x10, 0x00, 0x00, 0x00,           /* mov ebx,0x10 */
+    /* Touch: */
+    0x03, 0x16,                             /* add edx,dword [esi] */
+    0x89, 0x0E,                             /* mov dword [esi],ecx */
+    0x81, 0xC6, 0x00, 0x10, 0x00, 0x00,     /* add esi,0x1000 */
+    0x4B,                                   /* dec ebx */
+    0x75, 0xF3,                             /* jnz Touch */
+    0x0F, 0x20, 0xD8,                       /* mov eax,cr3 */
+    0x35, 0x00, 0x20, 0x00, 0x00,           /* xor eax,0x2000 */
+    0x0F, 0x22, 0xD8,                       /* mov cr3,eax */
+    0x0F, 0x01, 0x3D, 0x00, 0x00, 0x02, 0x00, /* invlpg [0x20000] */
+    0x49,                                   /* dec ecx */
+    0x75, 0xD4,                             /* jnz Loop */
+    0x0F, 0x20, 0xC0,                       /* mov eax,cr0 */
+    0x25, 0xFF, 0xFF, 0xFF, 0x7F,           /* and eax,0x7fffffff */
+    0x0F, 0x22, 0xC0,                       /* mov cr0,eax */
+    0x8B, 0x35, 0x00, 0x00, 0x02, 0x00,     /* mov esi,dword [0x20000] */
+    0xC4, 0xC4, 0x00,                       /* bop 0x00 */
+    0x66, 0x90,                             /* nop (padding) */
+    /* Gdt: */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* null */
+    0xFF, 0xFF, 0x00, 0x00, 0x00, 0x9A, 0xCF, 0x00, /* 08: flat 32-bit code */
+    0xFF, 0xFF, 0x00, 0x00, 0x00, 0x92, 0xCF, 0x00, /* 10: flat 32-bit data */
+    /* Gdtr: */
+    0x17, 0x00, 0xB0, 0x10, 0x00, 0x00,
+};
+
+static BENCH_PROGRAM Programs[] =
+{
+    /* Name, code, size, then the golden results */
+    { "alu", AluProgram, sizeof(AluProgram),
+      7864330ULL, { 0xFF480AFA, 0x00000000, 0xFE07B331, 0x5B3F7DEF, 0x00000F00, 0x00008E56, 0x1A013CEA, 0x0000F981 },
+      0x00000046, 0x63AB2BC9, 0x6D870785 },
+    { "string", StringProgram, sizeof(StringProgram),
+      4354062ULL, { 0x0000807F, 0x00000000, 0x0000BE00, 0x00005800, 0x00000F00, 0x00000000, 0x00000900, 0x0000C800 },
+      0x00000047, 0x9C16579A, 0x8DA82C2F },
+    { "fpu", FpuProgram, sizeof(FpuProgram),
+      2752527ULL, { 0x00063000, 0x00000000, 0x00030000, 0x00003000, 0x00000F00, 0x00000000, 0x00000000, 0x41000000 },
+      0x00000046, 0x8541783B, 0xA9990727 },
+    { "segment", SegmentProgram, sizeof(SegmentProgram),
+      4194320ULL, { 0x8EC00010, 0x00000000, 0xC7E80000, 0x00000018, 0x00000F00, 0x00001000, 0x00000018, 0x00001000 },
+      0x00000047, 0xC8BD33D9, 0xC1F221D8 },
+    { "paging", PagingProgram, sizeof(PagingProgram),
+      2886686ULL, { 0x00000011, 0x00000000, 0x0003FFF0, 0x00000000, 0x00000F00, 0x00000000, 0x00000001, 0x00012000 },
+      0x00000006, 0x113467F1, 0x0FA0E440 },
+};
+
+/* GLOBALS ********************************************************************/
+
+static UCHAR GuestMemory[GUEST_MEMORY_SIZE];
+static FAST486_STATE Cpu;
+static FAST486_TLB Tlb;
+static FAST486_CODE_CACHE CodeCache;
+
+static jmp_buf StopContext;
+static BOOLEAN StopArmed;
+static BOOLEAN Stopped;
+
+static ULONG IoDigest;
+static UCHAR IoCounter;
+
+/* PRIVATE FUNCTIONS **********************************************************/
+
+static ULONG
+HashBytes(ULONG Digest, const VOID *Buffer, ULONG Size)
+{
+    const UCHAR *Bytes = Buffer;
+    ULONG i;
+
+    for (i = 0; i < Size; i++)
+    {
+        Digest ^= Bytes[i];
+        Digest *= FNV_PRIME;
+    }
+
+    return Digest;
+}
+
+static ULONG
+HashState(ULONG Digest)
+{
+    ULONG Values[FAST486_NUM_GEN_REGS + FAST486_NUM_SEG_REGS + 2];
+    ULONG i;
+
+    for (i = 0; i < FAST486_NUM_GEN_REGS; i++) Values[i] = Cpu.GeneralRegs[i].Long;
+    for (i = 0; i < FAST486_NUM_SEG_REGS; i++) Values[FAST486_NUM_GEN_REGS + i] = Cpu.SegmentRegs[i].Selector;
+    Values[FAST486_NUM_GEN_REGS + FAST486_NUM_SEG_REGS] = Cpu.InstPtr.Long;
+    Values[FAST486_NUM_GEN_REGS + FAST486_NUM_SEG_REGS + 1] = Cpu.Flags.Long;
+
+    return HashBytes(Digest, Values, sizeof(Values));
+}
+
+static VOID
+FASTCALL
+BenchMemRead(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    PUCHAR Bytes = Buffer;
+    ULONG i;
+
+    UNREFERENCED_PARAMETER(State);
+
+    if ((Address < GUEST_MEMORY_SIZE) && (Size <= GUEST_MEMORY_SIZE - Address))
+    {
+        memcpy(Buffer, &GuestMemory[Address], Size);
+        return;
+    }
+
+    /* Open bus */
+    for (i = 0; i < Size; i++)
+    {
+        Bytes[i] = ((Address + i) < GUEST_MEMORY_SIZE) ? GuestMemory[Address + i] : 0xFF;
+    }
+}
+
+static VOID
+FASTCALL
+BenchMemWrite(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    PUCHAR Bytes = Buffer;
+    ULONG i;
+
+    UNREFERENCED_PARAMETER(State);
+
+    if ((Address < GUEST_MEMORY_SIZE) && (Size <= GUEST_MEMORY_SIZE - Address))
+    {
+        memcpy(&GuestMemory[Address], Buffer, Size);
+        return;
+    }
+
+    for (i = 0; i < Size; i++)
+    {
+        if ((Address + i) < GUEST_MEMORY_SIZE) GuestMemory[Address + i] = Bytes[i];
+    }
+}
+
+static VOID
+FASTCALL
+BenchIoRead(PFAST486_STATE State, USHORT Port, PVOID Buffer, ULONG DataCount, UCHAR DataSize)
+{
+    PUCHAR Bytes = Buffer;
+    ULONG i;
+
+    UNREFERENCED_PARAMETER(State);
+
+    /* Every port reads as a running counter */
+    for (i = 0; i < DataCount * DataSize; i++) Bytes[i] = (UCHAR)(IoCounter++ + Port);
+}
+
+static VOID
+FASTCALL
+BenchIoWrite(PFAST486_STATE State, USHORT Port, PVOID Buffer, ULONG DataCount, UCHAR DataSize)
+{
+    UNREFERENCED_PARAMETER(State);
+
+    IoDigest = HashBytes(IoDigest, &Port, sizeof(Port));
+    IoDigest = HashBytes(IoDigest, Buffer, DataCount * DataSize);
+}
+
+static VOID
+FASTCALL
+BenchBop(PFAST486_STATE State, UCHAR BopCode)
+{
+    UNREFERENCED_PARAMETER(State);
+    UNREFERENCED_PARAMETER(BopCode);
+
+    /* The program is done */
+    Stopped = TRUE;
+    if (StopArmed) longjmp(StopContext, 1);
+}
+
+static UCHAR
+FASTCALL
+BenchIntAck(PFAST486_STATE State)
+{
+    UNREFERENCED_PARAMETER(State);
+
+    /* No interrupt controller, this should not be called */
+    return 0x08;
+}
+
+static VOID
+LoadProgram(PBENCH_PROGRAM Program)
+{
+    memset(GuestMemory, 0, sizeof(GuestMemory));
+    memcpy(&GuestMemory[PROGRAM_ADDRESS], Program->Code, Program->Size);
+
+    IoDigest = FNV_OFFSET_BASIS;
+    IoCounter = 0;
+    Stopped = FALSE;
+
+    Fast486Reset(&Cpu);
+    Fast486ExecuteAt(&Cpu, 0x0000, PROGRAM_ADDRESS);
+}
+
+static VOID
+SaveResult(PBENCH_RESULT Result)
+{
+    ULONG i;
+
+    for (i = 0; i < FAST486_NUM_GEN_REGS; i++) Result->Registers[i] = Cpu.GeneralRegs[i].Long;
+    Result->Flags = Cpu.Flags.Long;
+    Result->MemoryDigest = HashBytes(IoDigest, GuestMemory, sizeof(GuestMemory));
+}
+
+static BOOLEAN
+TraceProgram(PBENCH_PROGRAM Program, PBENCH_RESULT Result, BOOLEAN Dump)
+{
+    ULONG i;
+
+    LoadProgram(Program);
+
+    Result->Instructions = 0;
+    Result->TraceDigest = FNV_OFFSET_BASIS;
+
+    while (!Stopped && (Result->Instructions < MAX_INSTRUCTIONS))
+    {
+        Fast486StepInto(&Cpu);
+        Result->Instructions++;
+        Result->TraceDigest = HashState(Result->TraceDigest);
+
+        if (Dump)
+        {
+            printf("%04X:%08X", Cpu.SegmentRegs[FAST486_REG_CS].Selector, Cpu.InstPtr.Long);
+            for (i = 0; i < FAST486_NUM_GEN_REGS; i++) printf(" %08X", Cpu.GeneralRegs[i].Long);
+            printf(" %08X\n", Cpu.Flags.Long);
+        }
+    }
+
+    SaveResult(Result);
+    return Stopped;
+}
+
+static BOOLEAN
+RunProgram(PBENCH_PROGRAM Program, PBENCH_RESULT Result, clock_t *Time)
+{
+    clock_t Start;
+
+    LoadProgram(Program);
+
+    /* The BOP handler jumps back here */
+    StopArmed = TRUE;
+    Start = clock();
+    if (!setjmp(StopContext)) Fast486Continue(&Cpu);
+    *Time = clock() - Start;
+    StopArmed = FALSE;
+
+    SaveResult(Result);
+    return Stopped;
+}
+
+static BOOLEAN
+CompareResult(PCSTR Name, PBENCH_RESULT Result, PBENCH_RESULT Expected, BOOLEAN CheckTrace)
+{
+    BOOLEAN Success = TRUE;
+    ULONG i;
+
+    if (CheckTrace && (Result->Instructions != Expected->Instructions))
+    {
+        printf("%s: %llu instructions, expected %llu\n", Name,
+               (unsigned long long)Result->Instructions, (unsigned long long)Expected->Instructions);
+        Success = FALSE;
+    }
+
+    for (i = 0; i < FAST486_NUM_GEN_REGS; i++)
+    {
+        if (Result->Registers[i] != Expected->Registers[i])
+        {
+            printf("%s: register %u is %08X, expected %08X\n", Name, i, Result->Registers[i], Expected->Registers[i]);
+            Success = FALSE;
+        }
+    }
+
+    if (Result->Flags != Expected->Flags)
+    {
+        printf("%s: flags are %08X, expected %08X\n", Name, Result->Flags, Expected->Flags);
+        Success = FALSE;
+    }
+
+    if (CheckTrace && (Result->TraceDigest != Expected->TraceDigest))
+    {
+        printf("%s: trace digest is %08X, expected %08X\n", Name, Result->TraceDigest, Expected->TraceDigest);
+        Success = FALSE;
+    }
+
+    if (Result->MemoryDigest != Expected->MemoryDigest)
+    {
+        printf("%s: memory digest is %08X, expected %08X\n", Name, Result->MemoryDigest, Expected->MemoryDigest);
+        Success = FALSE;
+    }
+
+    return Success;
+}
+
+static VOID
+PrintGolden(PBENCH_PROGRAM Program, PBENCH_RESULT Result)
+{
+    ULONG i;
+
+    printf("    /* %s */\n", Program->Name);
+    printf("      %lluULL, {", (unsigned long long)Result->Instructions);
+    for (i = 0; i < FAST486_NUM_GEN_REGS; i++) printf(" 0x%08X%s", Result->Registers[i], (i < FAST486_NUM_GEN_REGS - 1) ? "," : "");
+    printf(" },\n      0x%08X, 0x%08X, 0x%08X },\n", Result->Flags, Result->TraceDigest, Result->MemoryDigest);
+}
+
+static VOID
+Usage(VOID)
+{
+    printf("Usage: fast486bench [-g] [-t] [-c] [-r runs] [-d program] [program ...]\n"
+           "  -g          Print the golden results of this build\n"
+           "  -t          Use a TLB\n"
+           "  -c          Use a decoded instruction cache\n"
+           "  -r runs     Number of timed runs, the best one is reported (default 3)\n"
+           "  -d program  Dump the register state after each instruction\n");
+}
+
+/* PUBLIC FUNCTIONS ***********************************************************/
+
+int main(int argc, char *argv[])
+{
+    BOOLEAN Golden = FALSE, UseTlb = FALSE, UseCodeCache = FALSE, Selected, Passed, Success = TRUE;
+    PCSTR DumpName = NULL;
+    ULONG Runs = 3, Run, i;
+    int Arg, FirstName;
+    BENCH_RESULT Expected, Traced, Timed;
+    clock_t Time, BestTime;
+    double Seconds;
+
+    for (Arg = 1; (Arg < argc) && (argv[Arg][0] == '-'); Arg++)
+    {
+        if (!strcmp(argv[Arg], "-g"))
+            Golden = TRUE;
+        else if (!strcmp(argv[Arg], "-t"))
+            UseTlb = TRUE;
+        else if (!strcmp(argv[Arg], "-c"))
+            UseCodeCache = TRUE;
+        else if (!strcmp(argv[Arg], "-r") && (Arg + 1 < argc))
+        {
+            Runs = strtoul(argv[++Arg], NULL, 0);
+            if (Runs == 0) Runs = 1;
+        }
+        else if (!strcmp(argv[Arg], "-d") && (Arg + 1 < argc))
+            DumpName = argv[++Arg];
+        else
+        {
+            Usage();
+            return 2;
+        }
+    }
+    FirstName = Arg;
+
+    Fast486Initialize(&Cpu,
+                      BenchMemRead,
+                      BenchMemWrite,
+                      BenchIoRead,
+                      BenchIoWrite,
+                      BenchBop,
+                      BenchIntAck,
+                      NULL,
+                      UseTlb ? &Tlb : NULL,
+                      UseCodeCache ? &CodeCache : NULL);
+
+    if (DumpName)
+    {
+        for (i = 0; i < ARRAYSIZE(Programs); i++)
+        {
+            if (!strcmp(Programs[i].Name, DumpName))
+            {
+                return TraceProgram(&Programs[i], &Traced, TRUE) ? 0 : 1;
+            }
+        }
+
+        printf("Unknown program %s\n", DumpName);
+        return 2;
+    }
+
+    if (!Golden) printf("%-10s %12s %10s %10s  %s\n", "Program", "Instructions", "Time (ms)", "MIPS", "Result");
+
+    for (i = 0; i < ARRAYSIZE(Programs); i++)
+    {
+        PBENCH_PROGRAM Program = &Programs[i];
+
+        /* Check if the program was selected */
+        Selected = (FirstName == argc);
+        for (Arg = FirstName; Arg < argc; Arg++)
+        {
+            if (!strcmp(Program->Name, argv[Arg])) Selected = TRUE;
+        }
+        if (!Selected) continue;
+
+        Expected.Instructions = Program->Instructions;
+        memcpy(Expected.Registers, Program->Registers, sizeof(Expected.Registers));
+        Expected.Flags = Program->Flags;
+        Expected.TraceDigest = Program->TraceDigest;
+        Expected.MemoryDigest = Program->MemoryDigest;
+
+        /* Step through the program and check the trace */
+        if (!TraceProgram(Program, &Traced, FALSE))
+        {
+            printf("%s: did not finish after %llu instructions\n", Program->Name, (unsigned long long)Traced.Instructions);
+            Success = FALSE;
+            continue;
+        }
+
+        if (Golden)
+        {
+            PrintGolden(Program, &Traced);
+            continue;
+        }
+
+        Passed = CompareResult(Program->Name, &Traced, &Expected, TRUE);
+
+        /* Run it at full speed, it must end up in the same state */
+        BestTime = 0;
+        for (Run = 0; Run < Runs; Run++)
+        {
+            RunProgram(Program, &Timed, &Time);
+            if (!CompareResult(Program->Name, &Timed, &Traced, FALSE))
+            {
+                Passed = FALSE;
+                break;
+            }
+
+            if ((Run == 0) || (Time < BestTime)) BestTime = Time;
+        }
+
+        Seconds = (double)max(BestTime, 1) / CLOCKS_PER_SEC;
+        printf("%-10s %12llu %10.1f %10.2f  %s\n",
+               Program->Name,
+               (unsigned long long)Traced.Instructions,
+               Seconds * 1000.0,
+               Traced.Instructions / Seconds / 1000000.0,
+               Passed ? "PASS" : "FAIL");
+
+        if (!Passed) Success = FALSE;
+    }
+
+    return Success ? 0 : 1;
+}
@@ -0,0 +1,634 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Multithreaded allocation benchmark for the RTL heap
+ *
+ * Every thread keeps a window of live blocks of random small sizes and
+ * keeps replacing a random one of them: the block is checked and freed,
+ * and a block of a new size is allocated and filled in its place, or
+ * once in a while the block is resized to the new size instead. This
+ * runs once against a plain heap and once against a heap with the low
+ * fragmentation front end enabled, for 1 to 16 threads, and the
+ * throughput of both is printed side by side.
+ *
+ * A second run times batches of list node sized blocks on a single
+ * thread, allocated and freed either one by one or with
+ * RtlMultipleAllocateHeap and RtlMultipleFreeHeap, and prints the cost
+ * per node of both.
+ *
+ * The heap code runs on top of a small emulation of the ntdll services
+ * it uses: virtual memory maps to mmap, heap locks to pthread mutexes.
+ */
+
+#include <rtl.h>
+#include <heap.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_THREADS         16
+#define WINDOW_SIZE         512
+#define DEFAULT_OPERATIONS  1000000
+#define MAX_RESERVATIONS    1024
+#define MAX_BATCH           256
+#define NODE_SIZE           32
+
+#define ALLOCATION_GRANULARITY 0x10000
+
+typedef struct _BENCH_THREAD
+{
+    pthread_t Thread;
+    HANDLE Heap;
+    ULONG Index;
+    ULONG Operations;
+    ULONG MaximumSize;
+    ULONG Errors;
+} BENCH_THREAD, *PBENCH_THREAD;
+
+typedef struct _RESERVATION
+{
+    PVOID Base;
+    SIZE_T Size;
+} RESERVATION, *PRESERVATION;
+
+PEB HostPeb;
+__thread TEB HostTeb;
+BOOLEAN RtlpPageHeapEnabled = FALSE;
+
+static RESERVATION Reservations[MAX_RESERVATIONS];
+static pthread_mutex_t ReservationLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_barrier_t StartBarrier;
+
+/* HOST ENVIRONMENT **********************************************************/
+
+NTSTATUS NTAPI
+ZwAllocateVirtualMemory(HANDLE ProcessHandle,
+                        PVOID *BaseAddress,
+                        ULONG_PTR ZeroBits,
+                        PSIZE_T RegionSize,
+                        ULONG AllocationType,
+                        ULONG Protect)
+{
+    ULONG_PTR Start, End;
+    PVOID Base;
+    SIZE_T Size;
+    ULONG i;
+
+    if (*BaseAddress != NULL)
+    {
+        /* Commit pages of an existing reservation */
+        if (!(AllocationType & MEM_COMMIT))
+            return STATUS_NOT_IMPLEMENTED;
+
+        Start = ROUND_DOWN(*BaseAddress, PAGE_SIZE);
+        End = ROUND_UP((ULONG_PTR)*BaseAddress + *RegionSize, PAGE_SIZE);
+        if (mprotect((PVOID)Start, End - Start, PROT_READ | PROT_WRITE) != 0)
+            return STATUS_NO_MEMORY;
+
+        *BaseAddress = (PVOID)Start;
+        *RegionSize = End - Start;
+        return STATUS_SUCCESS;
+    }
+
+    Size = ROUND_UP(*RegionSize, ALLOCATION_GRANULARITY);
+    Base = mmap(NULL,
+                Size,
+                (AllocationType & MEM_COMMIT) ? PROT_READ | PROT_WRITE : PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                -1, 0);
+    if (Base == MAP_FAILED)
+        return STATUS_NO_MEMORY;
+
+    /* Remember the size, it's needed to release it */
+    pthread_mutex_lock(&ReservationLock);
+    for (i = 0; i < MAX_RESERVATIONS; i++)
+    {
+        if (Reservations[i].Base == NULL)
+        {
+            Reservations[i].Base = Base;
+            Reservations[i].Size = Size;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ReservationLock);
+
+    if (i == MAX_RESERVATIONS)
+    {
+        munmap(Base, Size);
+        return STATUS_NO_MEMORY;
+    }
+
+    *BaseAddress = Base;
+    *RegionSize = Size;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS NTAPI
+ZwFreeVirtualMemory(HANDLE ProcessHandle,
+                    PVOID *BaseAddress,
+                    PSIZE_T RegionSize,
+                    ULONG FreeType)
+{
+    ULONG_PTR Start, End;
+    ULONG i;
+
+    if (FreeType & MEM_DECOMMIT)
+    {
+        Start = ROUND_DOWN(*BaseAddress, PAGE_SIZE);
+        End = ROUND_UP((ULONG_PTR)*BaseAddress + *RegionSize, PAGE_SIZE);
+        madvise((PVOID)Start, End - Start, MADV_DONTNEED);
+        mprotect((PVOID)Start, End - Start, PROT_NONE);
+        return STATUS_SUCCESS;
+    }
+
+    /* Releases always cover a whole reservation */
+    pthread_mutex_lock(&ReservationLock);
+    for (i = 0; i < MAX_RESERVATIONS; i++)
+    {
+        if (Reservations[i].Base == *BaseAddress)
+        {
+            munmap(Reservations[i].Base, Reservations[i].Size);
+            *RegionSize = Reservations[i].Size;
+            Reservations[i].Base = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ReservationLock);
+
+    return (i == MAX_RESERVATIONS) ? STATUS_INVALID_PARAMETER : STATUS_SUCCESS;
+}
+
+NTSTATUS NTAPI
+ZwQueryVirtualMemory(HANDLE ProcessHandle,
+                     PVOID BaseAddress,
+                     MEMORY_INFORMATION_CLASS MemoryInformationClass,
+                     PVOID MemoryInformation,
+                     SIZE_T MemoryInformationLength,
+                     PSIZE_T ReturnLength)
+{
+    /* Only needed for heaps in caller supplied memory */
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+NTSTATUS NTAPI
+ZwQuerySystemInformation(SYSTEM_INFORMATION_CLASS SystemInformationClass,
+                         PVOID SystemInformation,
+                         ULONG Length,
+                         PULONG ResultLength)
+{
+    PSYSTEM_BASIC_INFORMATION BasicInformation = SystemInformation;
+
+    if (SystemInformationClass != SystemBasicInformation ||
+        Length < sizeof(SYSTEM_BASIC_INFORMATION))
+    {
+        return STATUS_INFO_LENGTH_MISMATCH;
+    }
+
+    memset(BasicInformation, 0, sizeof(*BasicInformation));
+    BasicInformation->PageSize = PAGE_SIZE;
+    BasicInformation->AllocationGranularity = ALLOCATION_GRANULARITY;
+    BasicInformation->MinimumUserModeAddress = ALLOCATION_GRANULARITY;
+    BasicInformation->MaximumUserModeAddress = MAXLONG_PTR;
+    BasicInformation->NumberOfProcessors = (CCHAR)HostPeb.NumberOfProcessors;
+    if (ResultLength)
+        *ResultLength = sizeof(SYSTEM_BASIC_INFORMATION);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS NTAPI
+ZwYieldExecution(VOID)
+{
+    sched_yield();
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS NTAPI
+RtlInitializeHeapLock(IN OUT PHEAP_LOCK *Lock)
+{
+    pthread_mutexattr_t Attributes;
+    int Result;
+
+    /* Like critical sections, heap locks can be entered recursively */
+    pthread_mutexattr_init(&Attributes);
+    pthread_mutexattr_settype(&Attributes, PTHREAD_MUTEX_RECURSIVE);
+    Result = pthread_mutex_init(&(*Lock)->Mutex, &Attributes);
+    pthread_mutexattr_destroy(&Attributes);
+
+    return Result ? STATUS_NO_MEMORY : STATUS_SUCCESS;
+}
+
+NTSTATUS NTAPI
+RtlDeleteHeapLock(IN OUT PHEAP_LOCK Lock)
+{
+    pthread_mutex_destroy(&Lock->Mutex);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS NTAPI
+RtlEnterHeapLock(IN OUT PHEAP_LOCK Lock, IN BOOLEAN Exclusive)
+{
+    pthread_mutex_lock(&Lock->Mutex);
+    return STATUS_SUCCESS;
+}
+
+BOOLEAN NTAPI
+RtlTryEnterHeapLock(IN OUT PHEAP_LOCK Lock, IN BOOLEAN Exclusive)
+{
+    return pthread_mutex_trylock(&Lock->Mutex) == 0;
+}
+
+NTSTATUS NTAPI
+RtlLeaveHeapLock(IN OUT PHEAP_LOCK Lock)
+{
+    pthread_mutex_unlock(&Lock->Mutex);
+    return STATUS_SUCCESS;
+}
+
+VOID NTAPI
+RtlRaiseException(PEXCEPTION_RECORD ExceptionRecord)
+{
+    fprintf(stderr, "Heap raised exception 0x%08x\n", (unsigned)ExceptionRecord->ExceptionCode);
+    abort();
+}
+
+VOID NTAPI
+RtlSetLastWin32ErrorAndNtStatusFromNtStatus(NTSTATUS Status)
+{
+}
+
+VOID NTAPI
+RtlpSetHeapParameters(IN PRTL_HEAP_PARAMETERS Parameters)
+{
+}
+
+VOID NTAPI
+RtlpAddHeapToProcessList(PHEAP Heap)
+{
+}
+
+VOID NTAPI
+RtlpRemoveHeapFromProcessList(PHEAP Heap)
+{
+}
+
+/* Debug and page heaps are never enabled here */
+#define NO_SPECIAL_HEAP { fprintf(stderr, "%s called\n", __FUNCTION__); abort(); }
+
+HANDLE NTAPI RtlDebugCreateHeap(ULONG Flags, PVOID Addr, SIZE_T TotalSize, SIZE_T CommitSize,
+                                PVOID Lock, PRTL_HEAP_PARAMETERS Parameters) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlDebugDestroyHeap(HANDLE HeapPtr) NO_SPECIAL_HEAP
+PVOID NTAPI RtlDebugAllocateHeap(PVOID HeapPtr, ULONG Flags, SIZE_T Size) NO_SPECIAL_HEAP
+PVOID NTAPI RtlDebugReAllocateHeap(HANDLE HeapPtr, ULONG Flags, PVOID Ptr, SIZE_T Size) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlDebugFreeHeap(HANDLE HeapPtr, ULONG Flags, PVOID Ptr) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlDebugGetUserInfoHeap(PVOID HeapHandle, ULONG Flags, PVOID BaseAddress,
+                                      PVOID *UserValue, PULONG UserFlags) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlDebugSetUserValueHeap(PVOID HeapHandle, ULONG Flags, PVOID BaseAddress,
+                                       PVOID UserValue) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlDebugSetUserFlagsHeap(PVOID HeapHandle, ULONG Flags, PVOID BaseAddress,
+                                       ULONG UserFlagsReset, ULONG UserFlagsSet) NO_SPECIAL_HEAP
+SIZE_T NTAPI RtlDebugSizeHeap(HANDLE HeapPtr, ULONG Flags, PVOID Ptr) NO_SPECIAL_HEAP
+HANDLE NTAPI RtlpPageHeapCreate(ULONG Flags, PVOID Addr, SIZE_T TotalSize, SIZE_T CommitSize,
+                                PVOID Lock, PRTL_HEAP_PARAMETERS Parameters) NO_SPECIAL_HEAP
+PVOID NTAPI RtlpPageHeapDestroy(HANDLE HeapPtr) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlpPageHeapLock(HANDLE HeapPtr) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlpPageHeapUnlock(HANDLE HeapPtr) NO_SPECIAL_HEAP
+BOOLEAN NTAPI RtlpDebugPageHeapValidate(PVOID HeapPtr, ULONG Flags, PVOID Block) NO_SPECIAL_HEAP
+
+/* BENCHMARK *****************************************************************/
+
+static
+ULONG
+NextRandom(PULONG Seed)
+{
+    *Seed = *Seed * 1103515245 + 12345;
+    return *Seed >> 8;
+}
+
+static
+double
+GetSeconds(VOID)
+{
+    struct timespec Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+/* The first and last byte of each block hold its slot number */
+static
+ULONG
+CheckBlock(PUCHAR Block, ULONG Slot, SIZE_T Size)
+{
+    if (Block[0] != (UCHAR)Slot || Block[Size - 1] != (UCHAR)Slot)
+        return 1;
+    return 0;
+}
+
+static
+void *
+BenchThread(void *Parameter)
+{
+    PBENCH_THREAD Thread = Parameter;
+    PUCHAR Blocks[WINDOW_SIZE], NewBlock;
+    SIZE_T Sizes[WINDOW_SIZE], NewSize;
+    ULONG Seed, Slot, i;
+
+    /* Thread ids are multiples of 4, like on Windows */
+    HostTeb.ClientId.UniqueThread = (HANDLE)(ULONG_PTR)((Thread->Index + 1) * 4);
+
+    Seed = Thread->Index * 7919 + 1;
+    memset(Blocks, 0, sizeof(Blocks));
+
+    pthread_barrier_wait(&StartBarrier);
+
+    for (i = 0; i < Thread->Operations; i++)
+    {
+        Slot = NextRandom(&Seed) % WINDOW_SIZE;
+
+        /* Mostly tiny blocks, like strings and list nodes */
+        NewSize = 1 + NextRandom(&Seed) % ((NextRandom(&Seed) & 3) ? 64 : Thread->MaximumSize);
+
+        if (Blocks[Slot] != NULL)
+        {
+            Thread->Errors += CheckBlock(Blocks[Slot], Slot, Sizes[Slot]);
+
+            /* Some blocks are resized instead */
+            if ((i & 7) == 0)
+            {
+                NewBlock = RtlReAllocateHeap(Thread->Heap, 0, Blocks[Slot], NewSize);
+                if (NewBlock == NULL)
+                {
+                    Thread->Errors++;
+                    continue;
+                }
+                if (NewBlock[0] != (UCHAR)Slot)
+                    Thread->Errors++;
+
+                Blocks[Slot] = NewBlock;
+                Sizes[Slot] = NewSize;
+                Blocks[Slot][0] = Blocks[Slot][Sizes[Slot] - 1] = (UCHAR)Slot;
+                continue;
+            }
+
+            if (!RtlFreeHeap(Thread->Heap, 0, Blocks[Slot]))
+                Thread->Errors++;
+        }
+
+        Sizes[Slot] = NewSize;
+        Blocks[Slot] = RtlAllocateHeap(Thread->Heap, 0, Sizes[Slot]);
+        if (Blocks[Slot] == NULL)
+        {
+            Thread->Errors++;
+            continue;
+        }
+        Blocks[Slot][0] = Blocks[Slot][Sizes[Slot] - 1] = (UCHAR)Slot;
+    }
+
+    pthread_barrier_wait(&StartBarrier);
+
+    for (Slot = 0; Slot < WINDOW_SIZE; Slot++)
+    {
+        if (Blocks[Slot] == NULL)
+            continue;
+
+        Thread->Errors += CheckBlock(Blocks[Slot], Slot, Sizes[Slot]);
+        if (RtlSizeHeap(Thread->Heap, 0, Blocks[Slot]) != Sizes[Slot] ||
+            !RtlValidateHeap(Thread->Heap, 0, Blocks[Slot]))
+        {
+            Thread->Errors++;
+        }
+        RtlFreeHeap(Thread->Heap, 0, Blocks[Slot]);
+    }
+
+    return NULL;
+}
+
+static
+double
+RunBenchmark(ULONG ThreadCount,
+             ULONG Operations,
+             ULONG MaximumSize,
+             BOOLEAN FrontEnd,
+             PULONG Errors)
+{
+    BENCH_THREAD Threads[MAX_THREADS];
+    HANDLE Heap;
+    ULONG HeapType, i;
+    double Start, Elapsed;
+
+    *Errors = 0;
+
+    Heap = RtlCreateHeap(HEAP_GROWABLE, NULL, 0, 0, NULL, NULL);
+    if (Heap == NULL)
+    {
+        fprintf(stderr, "RtlCreateHeap failed\n");
+        exit(1);
+    }
+
+    if (FrontEnd)
+    {
+        HeapType = HEAP_FRONT_END_LOW_FRAG;
+        if (!NT_SUCCESS(RtlSetHeapInformation(Heap, HeapCompatibilityInformation, &HeapType, sizeof(HeapType))))
+            (*Errors)++;
+    }
+
+    HeapType = ~0;
+    RtlQueryHeapInformation(Heap, HeapCompatibilityInformation, &HeapType, sizeof(HeapType), NULL);
+    if (HeapType != (FrontEnd ? HEAP_FRONT_END_LOW_FRAG : 0))
+        (*Errors)++;
+
+    pthread_barrier_init(&StartBarrier, NULL, ThreadCount + 1);
+    for (i = 0; i < ThreadCount; i++)
+    {
+        Threads[i].Heap = Heap;
+        Threads[i].Index = i;
+        Threads[i].Operations = Operations;
+        Threads[i].MaximumSize = MaximumSize;
+        Threads[i].Errors = 0;
+        if (pthread_create(&Threads[i].Thread, NULL, BenchThread, &Threads[i]) != 0)
+        {
+            fprintf(stderr, "Cannot create thread %u\n", i);
+            exit(1);
+        }
+    }
+
+    pthread_barrier_wait(&StartBarrier);
+    Start = GetSeconds();
+    pthread_barrier_wait(&StartBarrier);
+    Elapsed = GetSeconds() - Start;
+
+    for (i = 0; i < ThreadCount; i++)
+    {
+        pthread_join(Threads[i].Thread, NULL);
+        *Errors += Threads[i].Errors;
+    }
+    pthread_barrier_destroy(&StartBarrier);
+
+    if (!RtlValidateHeap(Heap, 0, NULL))
+        (*Errors)++;
+    RtlDestroyHeap(Heap);
+
+    return (double)ThreadCount * Operations / Elapsed;
+}
+
+static
+double
+RunBatchBenchmark(ULONG BatchSize,
+                  ULONG Operations,
+                  BOOLEAN Batched,
+                  PULONG Errors)
+{
+    PUCHAR Blocks[MAX_BATCH];
+    HANDLE Heap;
+    ULONG Rounds, Count, i, j;
+    double Start, Elapsed;
+
+    *Errors = 0;
+
+    Heap = RtlCreateHeap(HEAP_GROWABLE, NULL, 0, 0, NULL, NULL);
+    if (Heap == NULL)
+    {
+        fprintf(stderr, "RtlCreateHeap failed\n");
+        exit(1);
+    }
+
+    Rounds = max(Operations / BatchSize, 1);
+
+    Start = GetSeconds();
+    for (i = 0; i < Rounds; i++)
+    {
+        if (Batched)
+        {
+            Count = RtlMultipleAllocateHeap(Heap, 0, NODE_SIZE, BatchSize, (PVOID *)Blocks);
+        }
+        else
+        {
+            for (Count = 0; Count < BatchSize; Count++)
+            {
+                Blocks[Count] = RtlAllocateHeap(Heap, 0, NODE_SIZE);
+                if (Blocks[Count] == NULL)
+                    break;
+            }
+        }
+
+        if (Count != BatchSize)
+            (*Errors)++;
+
+        for (j = 0; j < Count; j++)
+            Blocks[j][0] = Blocks[j][NODE_SIZE - 1] = (UCHAR)j;
+
+        /* Look closer at the blocks of the first round */
+        for (j = 0; j < Count && i == 0; j++)
+        {
+            if (RtlSizeHeap(Heap, 0, Blocks[j]) != NODE_SIZE ||
+                !RtlValidateHeap(Heap, 0, Blocks[j]))
+            {
+                (*Errors)++;
+            }
+        }
+
+        for (j = 0; j < Count; j++)
+            *Errors += CheckBlock(Blocks[j], j, NODE_SIZE);
+
+        if (Batched)
+        {
+            if (RtlMultipleFreeHeap(Heap, 0, Count, (PVOID *)Blocks) != Count)
+                (*Errors)++;
+        }
+        else
+        {
+            for (j = 0; j < Count; j++)
+            {
+                if (!RtlFreeHeap(Heap, 0, Blocks[j]))
+                    (*Errors)++;
+            }
+        }
+    }
+    Elapsed = GetSeconds() - Start;
+
+    if (!RtlValidateHeap(Heap, 0, NULL))
+        (*Errors)++;
+    RtlDestroyHeap(Heap);
+
+    return Elapsed * 1e9 / ((double)Rounds * BatchSize);
+}
+
+static
+void
+Usage(const char *Name)
+{
+    printf("Usage: %s [-t max threads] [-n operations per thread] [-s maximum block size]\n", Name);
+}
+
+int main(int argc, char **argv)
+{
+    ULONG MaximumThreads = MAX_THREADS;
+    ULONG Operations = DEFAULT_OPERATIONS;
+    ULONG MaximumSize = 1024;
+    ULONG ThreadCount, BatchSize, Errors, TotalErrors = 0;
+    double Plain, LowFrag, Single, Batched;
+    int Option;
+
+    while ((Option = getopt(argc, argv, "t:n:s:h")) != -1)
+    {
+        switch (Option)
+        {
+            case 't':
+                MaximumThreads = strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                Operations = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                MaximumSize = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (MaximumThreads < 1 || MaximumThreads > MAX_THREADS || Operations == 0 ||
+        MaximumSize < 64)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    HostPeb.NumberOfProcessors = (ULONG)sysconf(_SC_NPROCESSORS_ONLN);
+    HostTeb.ClientId.UniqueThread = (HANDLE)(ULONG_PTR)0x100;
+
+    printf("%u operations per thread, blocks of 1 to %u bytes, %u processors\n",
+           Operations, MaximumSize, HostPeb.NumberOfProcessors);
+    printf("threads      plain (ops/s)   front end (ops/s)   speedup\n");
+
+    for (ThreadCount = 1; ThreadCount <= MaximumThreads; ThreadCount *= 2)
+    {
+        Plain = RunBenchmark(ThreadCount, Operations, MaximumSize, FALSE, &Errors);
+        TotalErrors += Errors;
+        LowFrag = RunBenchmark(ThreadCount, Operations, MaximumSize, TRUE, &Errors);
+        TotalErrors += Errors;
+
+        printf("%7u %18.0f %19.0f %9.2fx\n", ThreadCount, Plain, LowFrag, LowFrag / Plain);
+    }
+
+    printf("\nbatches of %u byte blocks on a plain heap\n", NODE_SIZE);
+    printf("  batch   one by one (ns/node)   batched (ns/node)   speedup\n");
+
+    for (BatchSize = 16; BatchSize <= MAX_BATCH; BatchSize *= 4)
+    {
+        Single = RunBatchBenchmark(BatchSize, Operations, FALSE, &Errors);
+        TotalErrors += Errors;
+        Batched = RunBatchBenchmark(BatchSize, Operations, TRUE, &Errors);
+        TotalErrors += Errors;
+
+        printf("%7u %22.1f %19.1f %9.2fx\n", BatchSize, Single, Batched, Single / Batched);
+    }
+
+    if (TotalErrors != 0)
+    {
+        printf("%u errors\n", TotalErrors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,394 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Minimal ntdll environment to build the RTL heap on the host
+ */
+
+#pragma once
+
+#if defined(_LP64) && !defined(_WIN64)
+/* The heap structures are laid out for the target pointer size */
+#define _WIN64
+#define _M_AMD64
+#endif
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+/* The heap sources define it themselves */
+#undef NDEBUG
+
+#define FORCEINLINE static __inline
+#define CONST const
+#define UNREFERENCED_PARAMETER(x) ((void)(x))
+#define C_ASSERT(e) typedef char __C_ASSERT__[(e) ? 1 : -1]
+
+#define _SEH2_TRY {
+#define _SEH2_EXCEPT(x) } if (0) {
+#define _SEH2_END }
+#define _SEH2_YIELD(x) x
+#define EXCEPTION_EXECUTE_HANDLER 1
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define ROUND_DOWN(n, align) (((ULONG_PTR)(n)) & ~((align) - 1l))
+#define ROUND_UP(n, align) ROUND_DOWN(((ULONG_PTR)(n)) + (align) - 1, (align))
+
+#define PAGE_SIZE   0x1000
+#define PAGE_SHIFT  12
+
+#define MAXULONG_PTR (~(ULONG_PTR)0)
+#define MAXLONG_PTR ((LONG_PTR)(MAXULONG_PTR >> 1))
+#define MAXDWORD 0xffffffff
+#define MAXUCHAR 0xff
+
+typedef ULONG_PTR KAFFINITY;
+typedef UCHAR KPROCESSOR_MODE;
+typedef UINT64 *PUINT64;
+
+#define KernelMode 0
+#define UserMode   1
+
+/* Status codes */
+#define STATUS_SUCCESS              ((NTSTATUS)0x00000000L)
+#define STATUS_UNSUCCESSFUL         ((NTSTATUS)0xC0000001L)
+#define STATUS_NOT_IMPLEMENTED      ((NTSTATUS)0xC0000002L)
+#define STATUS_INVALID_PARAMETER    ((NTSTATUS)0xC000000DL)
+#define STATUS_NO_MEMORY            ((NTSTATUS)0xC0000017L)
+#define STATUS_ACCESS_VIOLATION     ((NTSTATUS)0xC0000005L)
+#define STATUS_BUFFER_TOO_SMALL     ((NTSTATUS)0xC0000023L)
+#define STATUS_INFO_LENGTH_MISMATCH ((NTSTATUS)0xC0000004L)
+#define STATUS_INVALID_HANDLE       ((NTSTATUS)0xC0000008L)
+
+/* Global flags */
+#define FLG_HEAP_ENABLE_TAIL_CHECK   0x00000010
+#define FLG_HEAP_ENABLE_FREE_CHECK   0x00000020
+#define FLG_HEAP_VALIDATE_PARAMETERS 0x00000040
+#define FLG_HEAP_VALIDATE_ALL        0x00000080
+#define FLG_USER_STACK_TRACE_DB      0x00001000
+#define FLG_HEAP_ENABLE_TAGGING      0x00000800
+#define FLG_HEAP_ENABLE_TAG_BY_DLL   0x00008000
+#define FLG_HEAP_DISABLE_COALESCING  0x00200000
+#define FLG_HEAP_PAGE_ALLOCS         0x02000000
+
+/* Heap flags */
+#define HEAP_NO_SERIALIZE               0x00000001
+#define HEAP_GROWABLE                   0x00000002
+#define HEAP_GENERATE_EXCEPTIONS        0x00000004
+#define HEAP_ZERO_MEMORY                0x00000008
+#define HEAP_REALLOC_IN_PLACE_ONLY      0x00000010
+#define HEAP_TAIL_CHECKING_ENABLED      0x00000020
+#define HEAP_FREE_CHECKING_ENABLED      0x00000040
+#define HEAP_DISABLE_COALESCE_ON_FREE   0x00000080
+#define HEAP_SETTABLE_USER_VALUE        0x00000100
+#define HEAP_SETTABLE_USER_FLAG1        0x00000200
+#define HEAP_SETTABLE_USER_FLAG2        0x00000400
+#define HEAP_SETTABLE_USER_FLAG3        0x00000800
+#define HEAP_SETTABLE_USER_FLAGS        0x00000E00
+#define HEAP_CLASS_MASK                 0x0000F000
+#define HEAP_CREATE_ALIGN_16            0x00010000
+#define HEAP_CREATE_ENABLE_TRACING      0x00020000
+#define HEAP_CREATE_ENABLE_EXECUTE      0x00040000
+#define HEAP_MAXIMUM_TAG                0x0FFF
+#define HEAP_TAG_SHIFT                  18
+#define HEAP_FLAG_PAGE_ALLOCS           0x01000000
+#define HEAP_PROTECTION_ENABLED         0x02000000
+#define HEAP_BREAK_WHEN_OUT_OF_VM       0x04000000
+#define HEAP_NO_ALIGNMENT               0x08000000
+#define HEAP_CAPTURE_STACK_BACKTRACES   0x08000000
+#define HEAP_SKIP_VALIDATION_CHECKS     0x10000000
+#define HEAP_VALIDATE_ALL_ENABLED       0x20000000
+#define HEAP_VALIDATE_PARAMETERS_ENABLED 0x40000000
+#define HEAP_LOCK_USER_ALLOCATED        0x80000000
+
+#define HEAP_CREATE_VALID_MASK (HEAP_NO_SERIALIZE | HEAP_GROWABLE | \
+                                HEAP_GENERATE_EXCEPTIONS | HEAP_ZERO_MEMORY | \
+                                HEAP_REALLOC_IN_PLACE_ONLY | \
+                                HEAP_TAIL_CHECKING_ENABLED | \
+                                HEAP_FREE_CHECKING_ENABLED | \
+                                HEAP_DISABLE_COALESCE_ON_FREE | \
+                                HEAP_CLASS_MASK | HEAP_CREATE_ALIGN_16 | \
+                                HEAP_CREATE_ENABLE_TRACING | \
+                                HEAP_CREATE_ENABLE_EXECUTE)
+
+/* Virtual memory */
+#define MEM_COMMIT      0x00001000
+#define MEM_RESERVE     0x00002000
+#define MEM_DECOMMIT    0x00004000
+#define MEM_RELEASE     0x00008000
+#define MEM_FREE        0x00010000
+#define PAGE_NOACCESS   0x01
+#define PAGE_READWRITE  0x04
+#define PAGE_EXECUTE_READWRITE 0x40
+
+typedef enum _MEMORY_INFORMATION_CLASS
+{
+    MemoryBasicInformation
+} MEMORY_INFORMATION_CLASS;
+
+typedef struct _MEMORY_BASIC_INFORMATION
+{
+    PVOID BaseAddress;
+    PVOID AllocationBase;
+    ULONG AllocationProtect;
+    SIZE_T RegionSize;
+    ULONG State;
+    ULONG Protect;
+    ULONG Type;
+} MEMORY_BASIC_INFORMATION, *PMEMORY_BASIC_INFORMATION;
+
+typedef enum _SYSTEM_INFORMATION_CLASS
+{
+    SystemBasicInformation
+} SYSTEM_INFORMATION_CLASS;
+
+typedef struct _SYSTEM_BASIC_INFORMATION
+{
+    ULONG Reserved;
+    ULONG TimerResolution;
+    ULONG PageSize;
+    ULONG NumberOfPhysicalPages;
+    ULONG LowestPhysicalPageNumber;
+    ULONG HighestPhysicalPageNumber;
+    ULONG AllocationGranularity;
+    ULONG_PTR MinimumUserModeAddress;
+    ULONG_PTR MaximumUserModeAddress;
+    KAFFINITY ActiveProcessorsAffinityMask;
+    CCHAR NumberOfProcessors;
+} SYSTEM_BASIC_INFORMATION, *PSYSTEM_BASIC_INFORMATION;
+
+/* Heap interface types */
+typedef NTSTATUS
+(NTAPI *PRTL_HEAP_COMMIT_ROUTINE)(
+    IN PVOID Base,
+    IN OUT PVOID *CommitAddress,
+    IN OUT PSIZE_T CommitSize);
+
+typedef struct _RTL_HEAP_PARAMETERS
+{
+    ULONG Length;
+    SIZE_T SegmentReserve;
+    SIZE_T SegmentCommit;
+    SIZE_T DeCommitFreeBlockThreshold;
+    SIZE_T DeCommitTotalFreeThreshold;
+    SIZE_T MaximumAllocationSize;
+    SIZE_T VirtualMemoryThreshold;
+    SIZE_T InitialCommit;
+    SIZE_T InitialReserve;
+    PRTL_HEAP_COMMIT_ROUTINE CommitRoutine;
+    SIZE_T Reserved[2];
+} RTL_HEAP_PARAMETERS, *PRTL_HEAP_PARAMETERS;
+
+typedef enum _HEAP_INFORMATION_CLASS
+{
+    HeapCompatibilityInformation,
+    HeapEnableTerminationOnCorruption
+} HEAP_INFORMATION_CLASS;
+
+typedef struct _RTL_HEAP_WALK_ENTRY
+{
+    PVOID DataAddress;
+    SIZE_T DataSize;
+    UCHAR OverheadBytes;
+    UCHAR SegmentIndex;
+    USHORT Flags;
+    union
+    {
+        struct
+        {
+            SIZE_T Settable;
+            USHORT TagIndex;
+            USHORT AllocatorBackTraceIndex;
+            ULONG Reserved[2];
+        } Block;
+        struct
+        {
+            ULONG_PTR CommittedSize;
+            ULONG_PTR UnCommittedSize;
+            PVOID FirstEntry;
+            PVOID LastEntry;
+        } Segment;
+    };
+} RTL_HEAP_WALK_ENTRY, *PRTL_HEAP_WALK_ENTRY;
+
+typedef struct _RTL_HEAP_USAGE *PRTL_HEAP_USAGE;
+typedef struct _RTL_HEAP_TAG_INFO *PRTL_HEAP_TAG_INFO;
+typedef NTSTATUS (NTAPI *PHEAP_ENUMERATION_ROUTINE)(IN PVOID HeapHandle, IN PVOID UserParam);
+
+/* Exceptions */
+#define EXCEPTION_MAXIMUM_PARAMETERS 15
+#define EXCEPTION_NONCONTINUABLE 0x01
+
+typedef struct _EXCEPTION_RECORD
+{
+    NTSTATUS ExceptionCode;
+    ULONG ExceptionFlags;
+    struct _EXCEPTION_RECORD *ExceptionRecord;
+    PVOID ExceptionAddress;
+    ULONG NumberParameters;
+    ULONG_PTR ExceptionInformation[EXCEPTION_MAXIMUM_PARAMETERS];
+} EXCEPTION_RECORD, *PEXCEPTION_RECORD;
+
+/* Lists */
+typedef struct _SINGLE_LIST_ENTRY
+{
+    struct _SINGLE_LIST_ENTRY *Next;
+} SINGLE_LIST_ENTRY, *PSINGLE_LIST_ENTRY;
+
+/* Memory helpers */
+#define RtlFillMemory(Destination, Length, Fill) memset(Destination, Fill, Length)
+
+FORCEINLINE
+VOID
+RtlFillMemoryUlong(PVOID Destination, SIZE_T Length, ULONG Pattern)
+{
+    PULONG Address = Destination;
+    SIZE_T i;
+
+    for (i = 0; i < Length / sizeof(ULONG); i++)
+        Address[i] = Pattern;
+}
+
+FORCEINLINE
+SIZE_T
+RtlCompareMemoryUlong(PVOID Source, SIZE_T Length, ULONG Pattern)
+{
+    PULONG Address = Source;
+    SIZE_T i;
+
+    for (i = 0; i < Length / sizeof(ULONG); i++)
+    {
+        if (Address[i] != Pattern)
+            break;
+    }
+    return i * sizeof(ULONG);
+}
+
+FORCEINLINE
+SIZE_T
+RtlCompareMemory(const VOID *Source1, const VOID *Source2, SIZE_T Length)
+{
+    const UCHAR *Left = Source1, *Right = Source2;
+    SIZE_T i;
+
+    for (i = 0; i < Length && Left[i] == Right[i]; i++);
+    return i;
+}
+
+/* Interlocked operations */
+#define InterlockedExchange(Target, Value) __sync_lock_test_and_set(Target, Value)
+#define InterlockedIncrement(Target) __sync_add_and_fetch(Target, 1)
+#define InterlockedDecrement(Target) __sync_sub_and_fetch(Target, 1)
+
+#if defined(__i386__) || defined(__x86_64__)
+#define YieldProcessor() __builtin_ia32_pause()
+#else
+#define YieldProcessor() __sync_synchronize()
+#endif
+
+/* Process and thread environment */
+typedef struct _CLIENT_ID
+{
+    HANDLE UniqueProcess;
+    HANDLE UniqueThread;
+} CLIENT_ID, *PCLIENT_ID;
+
+typedef struct _TEB
+{
+    CLIENT_ID ClientId;
+} TEB, *PTEB;
+
+typedef struct _PEB
+{
+    PVOID ProcessHeap;
+    ULONG NumberOfProcessors;
+    ULONG NtGlobalFlag;
+} PEB, *PPEB;
+
+extern PEB HostPeb;
+extern __thread TEB HostTeb;
+
+#define NtCurrentPeb() (&HostPeb)
+#define NtCurrentTeb() (&HostTeb)
+#define NtCurrentProcess() ((HANDLE)(LONG_PTR)-1)
+#define RtlpGetMode() UserMode
+#define RtlGetNtGlobalFlags() (HostPeb.NtGlobalFlag)
+
+/* Heap locks */
+typedef struct _HEAP_LOCK
+{
+    pthread_mutex_t Mutex;
+} HEAP_LOCK, *PHEAP_LOCK, RTL_CRITICAL_SECTION;
+
+NTSTATUS NTAPI RtlInitializeHeapLock(IN OUT PHEAP_LOCK *Lock);
+NTSTATUS NTAPI RtlDeleteHeapLock(IN OUT PHEAP_LOCK Lock);
+NTSTATUS NTAPI RtlEnterHeapLock(IN OUT PHEAP_LOCK Lock, IN BOOLEAN Exclusive);
+BOOLEAN NTAPI RtlTryEnterHeapLock(IN OUT PHEAP_LOCK Lock, IN BOOLEAN Exclusive);
+NTSTATUS NTAPI RtlLeaveHeapLock(IN OUT PHEAP_LOCK Lock);
+
+/* System services */
+NTSTATUS NTAPI
+ZwAllocateVirtualMemory(HANDLE ProcessHandle,
+                        PVOID *BaseAddress,
+                        ULONG_PTR ZeroBits,
+                        PSIZE_T RegionSize,
+                        ULONG AllocationType,
+                        ULONG Protect);
+
+NTSTATUS NTAPI
+ZwFreeVirtualMemory(HANDLE ProcessHandle,
+                    PVOID *BaseAddress,
+                    PSIZE_T RegionSize,
+                    ULONG FreeType);
+
+NTSTATUS NTAPI
+ZwQueryVirtualMemory(HANDLE ProcessHandle,
+                     PVOID BaseAddress,
+                     MEMORY_INFORMATION_CLASS MemoryInformationClass,
+                     PVOID MemoryInformation,
+                     SIZE_T MemoryInformationLength,
+                     PSIZE_T ReturnLength);
+
+NTSTATUS NTAPI
+ZwQuerySystemInformation(SYSTEM_INFORMATION_CLASS SystemInformationClass,
+                         PVOID SystemInformation,
+                         ULONG Length,
+                         PULONG ResultLength);
+
+NTSTATUS NTAPI ZwYieldExecution(VOID);
+
+VOID NTAPI RtlRaiseException(PEXCEPTION_RECORD ExceptionRecord);
+VOID NTAPI RtlSetLastWin32ErrorAndNtStatusFromNtStatus(NTSTATUS Status);
+
+/* Heap tunables */
+VOID NTAPI RtlpSetHeapParameters(IN PRTL_HEAP_PARAMETERS Parameters);
+
+/* The public heap interface */
+HANDLE NTAPI RtlCreateHeap(ULONG Flags, PVOID Addr, SIZE_T TotalSize, SIZE_T CommitSize,
+                           PVOID Lock, PRTL_HEAP_PARAMETERS Parameters);
+HANDLE NTAPI RtlDestroyHeap(HANDLE HeapPtr);
+PVOID NTAPI RtlAllocateHeap(IN PVOID HeapPtr, IN ULONG Flags, IN SIZE_T Size);
+BOOLEAN NTAPI RtlFreeHeap(HANDLE HeapPtr, ULONG Flags, PVOID Ptr);
+PVOID NTAPI RtlReAllocateHeap(HANDLE HeapPtr, ULONG Flags, PVOID Ptr, SIZE_T Size);
+ULONG NTAPI RtlMultipleAllocateHeap(IN PVOID HeapHandle, IN ULONG Flags, IN SIZE_T Size,
+                                    IN ULONG Count, OUT PVOID *Array);
+ULONG NTAPI RtlMultipleFreeHeap(IN PVOID HeapHandle, IN ULONG Flags, IN ULONG Count,
+                                IN PVOID *Array);
+SIZE_T NTAPI RtlSizeHeap(HANDLE HeapPtr, ULONG Flags, PVOID Ptr);
+BOOLEAN NTAPI RtlValidateHeap(HANDLE HeapPtr, ULONG Flags, PVOID Block);
+NTSTATUS NTAPI RtlSetHeapInformation(IN HANDLE HeapHandle OPTIONAL,
+                                     IN HEAP_INFORMATION_CLASS HeapInformationClass,
+                                     IN PVOID HeapInformation,
+                                     IN SIZE_T HeapInformationLength OPTIONAL);
+NTSTATUS NTAPI RtlQueryHeapInformation(HANDLE HeapHandle,
+                                       HEAP_INFORMATION_CLASS HeapInformationClass,
+                                       PVOID HeapInformation OPTIONAL,
+                                       SIZE_T HeapInformationLength OPTIONAL,
+                                       PSIZE_T ReturnLength OPTIONAL);
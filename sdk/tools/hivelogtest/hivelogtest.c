@@ -0,0 +1,309 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Crash recovery test for the hive log
+ *
+ * A hive with a log is created in two temporary files, and its cells are
+ * changed and committed in the ways the configuration manager does it:
+ * through the log only with HvLogHive, or to the log and the primary file
+ * with HvSyncHive. After every commit the hive in memory is dropped, as if
+ * the machine crashed, and the files are loaded again with HvLoadHive. The
+ * cells must then hold what was last committed, also when a log record or
+ * a write of the primary file was torn.
+ */
+
+#include "mkhive.h"
+#include <unistd.h>
+
+#define CELL_COUNT  400
+#define CELL_SIZE   100
+
+static FILE *Files[2];
+static LONG PrimaryWritesLeft = -1;
+
+static HCELL_INDEX Cells[CELL_COUNT];
+static ULONG Written[CELL_COUNT];
+static ULONG Expected[CELL_COUNT];
+static ULONG Failures;
+
+/* HOST ENVIRONMENT **********************************************************/
+
+PVOID
+NTAPI
+CmpAllocate(
+    IN SIZE_T Size,
+    IN BOOLEAN Paged,
+    IN ULONG Tag)
+{
+    return malloc(Size);
+}
+
+VOID
+NTAPI
+CmpFree(
+    IN PVOID Ptr,
+    IN ULONG Quota)
+{
+    free(Ptr);
+}
+
+static BOOLEAN
+NTAPI
+TestFileRead(
+    IN PHHIVE RegistryHive,
+    IN ULONG FileType,
+    IN PULONG FileOffset,
+    OUT PVOID Buffer,
+    IN SIZE_T BufferLength)
+{
+    if (fseek(Files[FileType], *FileOffset, SEEK_SET) != 0)
+        return FALSE;
+
+    return fread(Buffer, 1, BufferLength, Files[FileType]) == BufferLength;
+}
+
+static BOOLEAN
+NTAPI
+TestFileWrite(
+    IN PHHIVE RegistryHive,
+    IN ULONG FileType,
+    IN PULONG FileOffset,
+    IN PVOID Buffer,
+    IN SIZE_T BufferLength)
+{
+    /* Simulate a crash in the middle of writing the primary file */
+    if (FileType == HFILE_TYPE_PRIMARY && PrimaryWritesLeft >= 0 && PrimaryWritesLeft-- == 0)
+        return FALSE;
+
+    if (fseek(Files[FileType], *FileOffset, SEEK_SET) != 0)
+        return FALSE;
+
+    return fwrite(Buffer, 1, BufferLength, Files[FileType]) == BufferLength;
+}
+
+static BOOLEAN
+NTAPI
+TestFileSetSize(
+    IN PHHIVE RegistryHive,
+    IN ULONG FileType,
+    IN ULONG FileSize,
+    IN ULONG OldFileSize)
+{
+    fflush(Files[FileType]);
+    return ftruncate(fileno(Files[FileType]), FileSize) == 0;
+}
+
+static BOOLEAN
+NTAPI
+TestFileFlush(
+    IN PHHIVE RegistryHive,
+    IN ULONG FileType,
+    PLARGE_INTEGER FileOffset,
+    ULONG Length)
+{
+    return fflush(Files[FileType]) == 0;
+}
+
+/* TEST **********************************************************************/
+
+static
+VOID
+Check(BOOLEAN Condition, const char *Description)
+{
+    printf("%-60s %s\n", Description, Condition ? "ok" : "FAILED");
+    if (!Condition)
+        Failures++;
+}
+
+/* Changes every Step-th cell, until the next commit they are only in memory */
+static
+VOID
+ChangeCells(PHHIVE Hive, ULONG Generation, ULONG Step)
+{
+    PULONG Data;
+    ULONG i;
+
+    for (i = 0; i < CELL_COUNT; i += Step)
+    {
+        Data = HvGetCell(Hive, Cells[i]);
+        Data[0] = Generation;
+        Data[1] = i;
+        HvMarkCellDirty(Hive, Cells[i], FALSE);
+        Written[i] = Generation;
+    }
+}
+
+/* The changes so far must survive a crash from now on */
+static
+VOID
+Committed(VOID)
+{
+    memcpy(Expected, Written, sizeof(Expected));
+}
+
+/* The changes since the last commit are allowed to get lost */
+static
+VOID
+Lost(VOID)
+{
+    memcpy(Written, Expected, sizeof(Written));
+}
+
+static
+BOOLEAN
+CellsAsExpected(PHHIVE Hive)
+{
+    PULONG Data;
+    ULONG i;
+
+    for (i = 0; i < CELL_COUNT; i++)
+    {
+        Data = HvGetCell(Hive, Cells[i]);
+        if (Data[0] != Expected[i] || Data[1] != i)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Drops the hive in memory without writing anything, and loads the files again */
+static
+BOOLEAN
+Crash(PCMHIVE CmHive)
+{
+    NTSTATUS Status;
+
+    HvFree(&CmHive->Hive);
+    fflush(Files[HFILE_TYPE_PRIMARY]);
+    fflush(Files[HFILE_TYPE_LOG]);
+
+    Status = HvInitialize(&CmHive->Hive,
+                          HINIT_FILE,
+                          0,
+                          HFILE_TYPE_LOG,
+                          NULL,
+                          CmpAllocate,
+                          CmpFree,
+                          TestFileSetSize,
+                          TestFileWrite,
+                          TestFileRead,
+                          TestFileFlush,
+                          1,
+                          NULL);
+    if (!NT_SUCCESS(Status))
+    {
+        printf("HvInitialize failed with 0x%08x\n", (unsigned)Status);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Makes the header of the first log record look like a torn write */
+static
+VOID
+TearFirstLogRecord(VOID)
+{
+    HBASE_BLOCK Header;
+
+    fseek(Files[HFILE_TYPE_LOG], 0, SEEK_SET);
+    fread(&Header, FIELD_OFFSET(HBASE_BLOCK, Reserved2), 1, Files[HFILE_TYPE_LOG]);
+    Header.Sequence2--;
+    fseek(Files[HFILE_TYPE_LOG], 0, SEEK_SET);
+    fwrite(&Header, FIELD_OFFSET(HBASE_BLOCK, Reserved2), 1, Files[HFILE_TYPE_LOG]);
+}
+
+int
+main(int argc, char **argv)
+{
+    static CMHIVE CmHive;
+    PHHIVE Hive = &CmHive.Hive;
+    NTSTATUS Status;
+    ULONG i;
+
+    Files[HFILE_TYPE_PRIMARY] = tmpfile();
+    Files[HFILE_TYPE_LOG] = tmpfile();
+    if (!Files[HFILE_TYPE_PRIMARY] || !Files[HFILE_TYPE_LOG])
+    {
+        fprintf(stderr, "Cannot create the hive files\n");
+        return 1;
+    }
+
+    Status = HvInitialize(Hive,
+                          HINIT_CREATE,
+                          0,
+                          HFILE_TYPE_LOG,
+                          NULL,
+                          CmpAllocate,
+                          CmpFree,
+                          TestFileSetSize,
+                          TestFileWrite,
+                          TestFileRead,
+                          TestFileFlush,
+                          1,
+                          NULL);
+    if (!NT_SUCCESS(Status) || !CmCreateRootNode(Hive, L"HIVELOGTEST"))
+    {
+        fprintf(stderr, "Cannot create the hive (0x%08x)\n", (unsigned)Status);
+        return 1;
+    }
+
+    for (i = 0; i < CELL_COUNT; i++)
+    {
+        Cells[i] = HvAllocateCell(Hive, CELL_SIZE, Stable, HCELL_NIL);
+        if (Cells[i] == HCELL_NIL)
+        {
+            fprintf(stderr, "Cannot allocate the cells\n");
+            return 1;
+        }
+    }
+
+    /* Only hives loaded from their files may commit to the log alone */
+    Check(!Hive->LogReplay, "A created hive is not replayed from its log");
+
+    ChangeCells(Hive, 1, 1);
+    Check(HvSyncHive(Hive), "HvSyncHive writes a new hive");
+    Committed();
+
+    ChangeCells(Hive, 2, 3);
+    Check(HvLogHive(Hive), "HvLogHive commits to the log");
+    Committed();
+    Check(Crash(&CmHive) && CellsAsExpected(Hive), "Changes in the log only are recovered");
+    Check(Hive->LogReplay, "A loaded hive is replayed from its log");
+
+    ChangeCells(Hive, 3, 5);
+    Check(HvLogHive(Hive), "HvLogHive appends to a recovered log");
+    Committed();
+    Check(Crash(&CmHive) && CellsAsExpected(Hive), "Every record of the log is recovered");
+
+    Check(HvSyncHive(Hive), "HvSyncHive writes the recovered blocks back");
+    ChangeCells(Hive, 4, 1);
+    Check(HvSyncHive(Hive), "HvSyncHive writes the primary file");
+    Committed();
+
+    ChangeCells(Hive, 5, 2);
+    Check(HvLogHive(Hive), "HvLogHive starts a new log after a sync");
+    TearFirstLogRecord();
+    Lost();
+    Check(Crash(&CmHive) && CellsAsExpected(Hive), "A torn log record is ignored");
+
+    ChangeCells(Hive, 6, 4);
+    Check(HvLogHive(Hive), "HvLogHive commits to the log");
+    ChangeCells(Hive, 7, 8);
+    PrimaryWritesLeft = 3;
+    Check(!HvSyncHive(Hive), "HvSyncHive fails to write the primary file");
+    PrimaryWritesLeft = -1;
+    Committed();
+    Check(Crash(&CmHive) && CellsAsExpected(Hive), "A torn primary file is recovered from the log");
+
+    Check(HvSyncHive(Hive), "HvSyncHive writes the primary file");
+    TestFileSetSize(Hive, HFILE_TYPE_LOG, 0, 0);
+    Check(Crash(&CmHive) && CellsAsExpected(Hive), "The primary file alone holds every change");
+
+    HvFree(Hive);
+    fclose(Files[HFILE_TYPE_LOG]);
+    fclose(Files[HFILE_TYPE_PRIMARY]);
+
+    printf("\n%u failures\n", (unsigned)Failures);
+    return Failures ? 1 : 0;
+}
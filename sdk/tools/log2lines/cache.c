@@ -15,6 +15,7 @@
 #include "options.h"
 #include "help.h"
 #include "image.h"
+#include "cache.h"
 
 #include "log2lines.h"
 
@@ -22,6 +23,29 @@ static char CacheName[PATH_MAX];
 static char *cache_name = CacheName;
 static char TmpName[PATH_MAX];
 static char *tmp_name = TmpName;
+static char SymName[PATH_MAX];
+static char *sym_name = SymName;
+
+/* The symbol cache holds the path, base address and .rossym section of every
+ * image, so that a later run needs neither the images nor their directory */
+typedef struct _SYMBOLS_HEADER
+{
+    ULONG Magic;
+    ULONG Version;
+} SYMBOLS_HEADER, *PSYMBOLS_HEADER;
+
+typedef struct _SYMBOLS_RECORD
+{
+    ULONG RecordLength;
+    ULONG ImageBase;
+    ULONG PathLength;       // including the terminating zero
+    ULONG SymbolsLength;    // 0 when the image has no .rossym section
+} SYMBOLS_RECORD, *PSYMBOLS_RECORD;
+
+#define SYM_ALIGN(x)    (((x) + 3) & ~3)
+
+static void *symbols = NULL;
+static size_t symbols_size;
 
 static int
 unpack_iso(char *dir, char *iso)
@@ -76,6 +100,25 @@ cleanable(char *path)
     return 0;
 }
 
+static void
+set_cache_names(int unpacked)
+{
+    strcpy(cache_name, opt_dir);
+    if (cleanable(opt_dir))
+        strcat(cache_name, ALT_PATH_STR CACHEFILE);
+    else
+        strcat(cache_name, PATH_STR CACHEFILE);
+    strcpy(tmp_name, cache_name);
+    strcat(tmp_name, "~");
+
+    /* Keep the symbols of an ISO image next to the directory it is unpacked in */
+    strcpy(sym_name, opt_dir);
+    if (unpacked || cleanable(opt_dir))
+        strcat(sym_name, ALT_PATH_STR SYMCACHEFILE);
+    else
+        strcat(sym_name, PATH_STR SYMCACHEFILE);
+}
+
 int
 check_directory(int force)
 {
@@ -85,9 +128,23 @@ check_directory(int force)
     char compressed_7z_path[PATH_MAX];
     char *check_iso;
     char *check_dir;
+    int unpacked = 0;
 
     check_iso = strrchr(opt_dir, '.');
     l2l_dbg(1, "Checking directory: %s\n", opt_dir);
+    if (check_iso && (PATHCMP(check_iso, ".7z") == 0 || PATHCMP(check_iso, ".iso") == 0))
+    {
+        /* With the symbols of an earlier run the image isn't unpacked again */
+        *check_iso = '\0';
+        set_cache_names(1);
+        if (!force && file_exists(sym_name))
+        {
+            l2l_dbg(1, "Using symbol cache %s\n", sym_name);
+            return 0;
+        }
+        *check_iso = '.';
+    }
+
     if (check_iso && PATHCMP(check_iso, ".7z") == 0)
     {
         l2l_dbg(1, "Checking 7z image: %s\n", opt_dir);
@@ -127,6 +184,7 @@ check_directory(int force)
             l2l_dbg(2, "ISO image exists: %s\n", opt_dir);
             strcpy(iso_path, opt_dir);
             *check_iso = '\0';
+            unpacked = 1;
             sprintf(freeldr_path, "%s" PATH_STR "freeldr.ini", opt_dir);
             if (!file_exists(freeldr_path) || force)
             {
@@ -143,13 +201,67 @@ check_directory(int force)
             return 1;
         }
     }
-    strcpy(cache_name, opt_dir);
-    if (cleanable(opt_dir))
-        strcat(cache_name, ALT_PATH_STR CACHEFILE);
-    else
-        strcat(cache_name, PATH_STR CACHEFILE);
-    strcpy(tmp_name, cache_name);
-    strcat(tmp_name, "~");
+    set_cache_names(unpacked);
+    return 0;
+}
+
+static int
+read_symbols(void)
+{
+    PSYMBOLS_HEADER Header;
+    PSYMBOLS_RECORD Record;
+    LIST_MEMBER *pentry;
+    char Line[LINESIZE + 1];
+    char *Path, *Fname;
+    size_t pos;
+
+    symbols = map_file(sym_name, &symbols_size);
+    if (!symbols)
+    {
+        l2l_dbg(1, "Open %s failed\n", sym_name);
+        return 2;
+    }
+
+    Header = (PSYMBOLS_HEADER)symbols;
+    if (symbols_size < sizeof(SYMBOLS_HEADER) || Header->Magic != MAGIC_SYM || Header->Version != VERSION_SYM)
+    {
+        l2l_dbg(0, "%s is not a symbol cache of this version (use -f)\n", sym_name);
+        close_cache();
+        return 3;
+    }
+
+    for (pos = sizeof(SYMBOLS_HEADER); pos < symbols_size; pos += Record->RecordLength)
+    {
+        Record = (PSYMBOLS_RECORD)((char *)symbols + pos);
+        Path = (char *)(Record + 1);
+        if (symbols_size - pos < sizeof(SYMBOLS_RECORD) ||
+            Record->RecordLength > symbols_size - pos ||
+            Record->PathLength == 0 || Record->PathLength > LINESIZE / 2 ||
+            Record->SymbolsLength > Record->RecordLength ||
+            Record->RecordLength != sizeof(SYMBOLS_RECORD) + SYM_ALIGN(Record->PathLength) + SYM_ALIGN(Record->SymbolsLength) ||
+            Path[Record->PathLength - 1] != '\0' ||
+            (Record->SymbolsLength && !check_rossym(Path + SYM_ALIGN(Record->PathLength), Record->SymbolsLength)))
+        {
+            l2l_dbg(0, "%s is damaged (use -f)\n", sym_name);
+            close_cache();
+            return 3;
+        }
+
+        Fname = strrchr(Path, PATH_CHAR);
+        Fname = Fname ? Fname + 1 : Path;
+        snprintf(Line, LINESIZE, "%s|%s|%0x", Fname, Path, (unsigned int)Record->ImageBase);
+        pentry = cache_entry_create(Line);
+        if (!pentry)
+        {
+            l2l_dbg(2, "** Create entry failed of: %s\n", Line);
+            continue;
+        }
+        if (Record->SymbolsLength)
+            pentry->Symbols = Path + SYM_ALIGN(Record->PathLength);
+        entry_insert(&cache, pentry);
+    }
+
+    l2l_dbg(2, "Symbols read from %s\n", sym_name);
     return 0;
 }
 
@@ -163,6 +275,9 @@ read_cache(void)
 
     Line[LINESIZE] = '\0';
 
+    if (read_symbols() == 0)
+        return 0;
+
     fr = fopen(cache_name, "r");
     if (!fr)
     {
@@ -186,19 +301,53 @@ read_cache(void)
     return result;
 }
 
+static void
+write_symbols(FILE *fw, char *path, size_t ImageBase)
+{
+    static const char Padding[4];
+    SYMBOLS_RECORD Record;
+    void *Symbols;
+    size_t SymbolsLength;
+
+    get_rossym(path, &Symbols, &SymbolsLength);
+    Record.ImageBase = (ULONG)ImageBase;
+    Record.PathLength = strlen(path) + 1;
+    Record.SymbolsLength = SymbolsLength;
+    Record.RecordLength = sizeof(SYMBOLS_RECORD) + SYM_ALIGN(Record.PathLength) + SYM_ALIGN(Record.SymbolsLength);
+
+    fwrite(&Record, sizeof(Record), 1, fw);
+    fwrite(path, Record.PathLength, 1, fw);
+    fwrite(Padding, SYM_ALIGN(Record.PathLength) - Record.PathLength, 1, fw);
+    if (Symbols)
+    {
+        fwrite(Symbols, SymbolsLength, 1, fw);
+        fwrite(Padding, SYM_ALIGN(Record.SymbolsLength) - Record.SymbolsLength, 1, fw);
+        free(Symbols);
+    }
+}
+
 int
 create_cache(int force, int skipImageBase)
 {
-    FILE *fr, *fw;
+    FILE *fr, *fw, *fs;
     char Line[LINESIZE + 1], *Fname = NULL;
+    char SymTmp[PATH_MAX];
+    SYMBOLS_HEADER Header;
     int len, err;
     size_t ImageBase;
 
+    if (!force && file_exists(sym_name))
+    {
+        l2l_dbg(3, "Symbol cache %s already exists\n", sym_name);
+        return 0;
+    }
+
     if ((fw = fopen(tmp_name, "w")) == NULL)
     {
         l2l_dbg(1, "Apparently %s is not writable (mounted ISO?), using current dir\n", tmp_name);
         cache_name = basename(cache_name);
         tmp_name = basename(tmp_name);
+        sym_name = basename(sym_name);
     }
     else
     {
@@ -211,12 +360,14 @@ create_cache(int force, int skipImageBase)
     {
         l2l_dbg(3, "Removing %s ...\n", cache_name);
         remove(cache_name);
+        remove(sym_name);
     }
     else
     {
-        if (file_exists(cache_name))
+        /* Both are written together, an old cache without symbols is rebuilt */
+        if (file_exists(sym_name))
         {
-            l2l_dbg(3, "Cache %s already exists\n", cache_name);
+            l2l_dbg(3, "Symbol cache %s already exists\n", sym_name);
             return 0;
         }
     }
@@ -236,6 +387,17 @@ create_cache(int force, int skipImageBase)
     }
     l2l_dbg(0, "Creating cache ...");
 
+    strcpy(SymTmp, sym_name);
+    strcat(SymTmp, "~");
+    if ((fs = fopen(SymTmp, "wb")) != NULL)
+    {
+        Header.Magic = MAGIC_SYM;
+        Header.Version = VERSION_SYM;
+        fwrite(&Header, sizeof(Header), 1, fs);
+    }
+    else
+        l2l_dbg(1, "Cannot create %s\n", SymTmp);
+
     if ((fr = fopen(tmp_name, "r")) != NULL)
     {
         if ((fw = fopen(cache_name, "w")) != NULL)
@@ -257,7 +419,11 @@ create_cache(int force, int skipImageBase)
                 if (*Fname && !skipImageBase)
                 {
                     if ((err = get_ImageBase(Line, &ImageBase)) == 0)
+                    {
                         fprintf(fw, "%s|%s|%0x\n", Fname, Line, (unsigned int)ImageBase);
+                        if (fs)
+                            write_symbols(fs, Line, ImageBase);
+                    }
                     else
                         l2l_dbg(3, "%s|%s|%0x, ERR=%d\n", Fname, Line, (unsigned int)ImageBase, err);
                 }
@@ -268,7 +434,27 @@ create_cache(int force, int skipImageBase)
         fclose(fr);
     }
     remove(tmp_name);
+
+    /* Only a complete symbol cache gets its name, a later run trusts it */
+    if (fs)
+    {
+        if (fclose(fs) == 0 && fr && fw)
+            rename(SymTmp, sym_name);
+        else
+            remove(SymTmp);
+    }
     return 0;
 }
 
+void
+close_cache(void)
+{
+    list_clear(&cache);
+    if (symbols)
+    {
+        unmap_file(symbols, symbols_size);
+        symbols = NULL;
+    }
+}
+
 /* EOF */
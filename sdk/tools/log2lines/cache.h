@@ -10,6 +10,7 @@
 int check_directory(int force);
 int read_cache(void);
 int create_cache(int force, int skipImageBase);
+void close_cache(void);
 int cleanable(char *path);
 
 /* EOF */
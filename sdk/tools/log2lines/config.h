@@ -12,6 +12,9 @@
 #define DEF_OPT_DIR     "output-i386"
 #define SOURCES_ENV     "_ROSBE_ROSSOURCEDIR"
 #define CACHEFILE       "log2lines.cache"
+#define SYMCACHEFILE    "log2lines.symbols"
+#define MAGIC_SYM       0x53594D5F //'SYM_'
+#define VERSION_SYM     1
 #define TRKBUILDPREFIX  "bootcd-"
 #define SVN_PREFIX      "/trunk/reactos/"
 #define PIPEREAD_CMD    "piperead -c"
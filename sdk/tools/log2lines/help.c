@@ -28,8 +28,10 @@ char *verboseUsage =
 "  - An image with base < 0x400000 MUST be relocated to a > 0x400000 address.\n"
 "  - The offset of a relocated image MUST be relative.\n\n"
 "  log2lines uses a cache in order to avoid a directory scan at each\n"
-"  image lookup, greatly increasing performance. Only image path and its\n"
-"  base address are cached.\n\n"
+"  image lookup, greatly increasing performance. The image path and its\n"
+"  base address are cached in " CACHEFILE ", and also with the symbols\n"
+"  of the image in " SYMCACHEFILE ". Later runs take the symbols from\n"
+"  there, without reading the images or unpacking an ISO image again.\n\n"
 "Options:\n"
 "  -b   Use this combined with '-l'. Enable buffering on logFile.\n"
 "       This may solve loosing output on real hardware (ymmv).\n\n"
@@ -44,6 +46,9 @@ char *verboseUsage =
 "       - The image will be unpacked to a directory with the same name.\n"
 "       - The embedded reactos.cab file will also be unpacked.\n"
 "       - Combined with -f the file will be re-unpacked.\n"
+"       - The symbol cache is kept next to the directory, as\n"
+"         <directory>" ALT_PATH_STR SYMCACHEFILE ". While it exists the image\n"
+"         is not unpacked again, so the directory may be removed.\n"
 "       - NOTE: this ISO unpack feature needs 7z to be in the PATH.\n"
 "       Default: " DEF_OPT_DIR "\n\n"
 "  -f   Force creating new cache.\n\n"
@@ -6,6 +6,7 @@
  */
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <rsym.h>
 
@@ -14,6 +15,17 @@
 #include "options.h"
 #include "log2lines.h"
 
+typedef struct image_struct
+{
+    char *path;
+    void *data;
+    size_t size;
+    struct image_struct *pnext;
+} IMAGE_MAP, *PIMAGE_MAP;
+
+/* Images stay mapped until exit, a log refers to the same few ones over and over */
+static PIMAGE_MAP images = NULL;
+
 static PIMAGE_SECTION_HEADER
 find_rossym_section(PIMAGE_FILE_HEADER PEFileHeader, PIMAGE_SECTION_HEADER PESectionHeaders)
 {
@@ -40,19 +52,23 @@ find_offset(void *data, size_t offset)
     PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)data;
     PROSSYM_ENTRY Entries = (PROSSYM_ENTRY)((char *)data + RosSymHeader->SymbolsOffset);
     size_t symbols = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
-    size_t i;
 
-    for (i = 0; i < symbols; i++)
-    {
-        if (Entries[i].Address > offset)
-        {
-            if (!i--)
-                return NULL;
-            else
-                return &Entries[i];
-        }
-    }
-    return NULL;
+    return find_rossym_entry(Entries, symbols, offset);
+}
+
+/* The symbols and strings must lie within the section */
+int
+check_rossym(const void *Symbols, size_t SymbolsLength)
+{
+    PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)Symbols;
+
+    if (SymbolsLength < sizeof(SYMBOLFILE_HEADER))
+        return 0;
+
+    return RosSymHeader->SymbolsLength <= SymbolsLength &&
+           RosSymHeader->SymbolsOffset <= SymbolsLength - RosSymHeader->SymbolsLength &&
+           RosSymHeader->StringsLength <= SymbolsLength &&
+           RosSymHeader->StringsOffset <= SymbolsLength - RosSymHeader->StringsLength;
 }
 
 PIMAGE_SECTION_HEADER
@@ -97,6 +113,60 @@ get_sectionheader(const void *FileData)
     return PERosSymSectionHeader;
 }
 
+void *
+map_image(const char *path)
+{
+    PIMAGE_MAP pprev = NULL;
+    PIMAGE_MAP pimage;
+
+    for (pimage = images; pimage; pprev = pimage, pimage = pimage->pnext)
+    {
+        if (PATHCMP(path, pimage->path) == 0)
+        {
+            if (pprev)
+            {   // move to head for faster lookup next time
+                pprev->pnext = pimage->pnext;
+                pimage->pnext = images;
+                images = pimage;
+            }
+            return pimage->data;
+        }
+    }
+
+    pimage = malloc(sizeof(IMAGE_MAP));
+    if (!pimage)
+        return NULL;
+
+    pimage->path = strdup(path);
+    pimage->data = pimage->path ? map_file(path, &pimage->size) : NULL;
+    if (!pimage->data)
+    {
+        free(pimage->path);
+        free(pimage);
+        return NULL;
+    }
+
+    l2l_dbg(2, "Mapped %s (%u bytes)\n", path, (unsigned int)pimage->size);
+    pimage->pnext = images;
+    images = pimage;
+    return pimage->data;
+}
+
+void
+unmap_images(void)
+{
+    PIMAGE_MAP pnext;
+
+    while (images)
+    {
+        pnext = images->pnext;
+        unmap_file(images->data, images->size);
+        free(images->path);
+        free(images);
+        images = pnext;
+    }
+}
+
 int
 get_ImageBase(char *fname, size_t *ImageBase)
 {
@@ -165,4 +235,62 @@ get_ImageBase(char *fname, size_t *ImageBase)
     return 0;
 }
 
+/* Reads the .rossym section of an image into a buffer to be freed by the caller */
+int
+get_rossym(char *fname, void **Symbols, size_t *SymbolsLength)
+{
+    IMAGE_DOS_HEADER PEDosHeader;
+    IMAGE_FILE_HEADER PEFileHeader;
+    IMAGE_SECTION_HEADER PESectionHeader;
+    FILE *fr;
+    size_t i;
+
+    *Symbols = NULL;
+    *SymbolsLength = 0;
+    fr = fopen(fname, "rb");
+    if (!fr)
+    {
+        l2l_dbg(3, "get_rossym, cannot open '%s' (%s)\n", fname, strerror(errno));
+        return 1;
+    }
+
+    if (1 != fread(&PEDosHeader, sizeof(IMAGE_DOS_HEADER), 1, fr) ||
+        PEDosHeader.e_magic != IMAGE_DOS_MAGIC || PEDosHeader.e_lfanew == 0L ||
+        fseek(fr, PEDosHeader.e_lfanew + sizeof(ULONG), SEEK_SET) ||
+        1 != fread(&PEFileHeader, sizeof(IMAGE_FILE_HEADER), 1, fr) ||
+        fseek(fr, PEFileHeader.SizeOfOptionalHeader, SEEK_CUR))
+    {
+        l2l_dbg(2, "get_rossym %s, not a PE image\n", fname);
+        fclose(fr);
+        return 2;
+    }
+
+    for (i = 0; i < PEFileHeader.NumberOfSections; i++)
+    {
+        if (1 != fread(&PESectionHeader, sizeof(IMAGE_SECTION_HEADER), 1, fr))
+            break;
+        if (0 == strncmp((char *)PESectionHeader.Name, ".rossym", IMAGE_SIZEOF_SHORT_NAME))
+        {
+            if (PESectionHeader.SizeOfRawData < sizeof(SYMBOLFILE_HEADER) ||
+                !(*Symbols = malloc(PESectionHeader.SizeOfRawData)))
+                break;
+            if (fseek(fr, PESectionHeader.PointerToRawData, SEEK_SET) ||
+                1 != fread(*Symbols, PESectionHeader.SizeOfRawData, 1, fr) ||
+                !check_rossym(*Symbols, PESectionHeader.SizeOfRawData))
+                break;
+
+            *SymbolsLength = PESectionHeader.SizeOfRawData;
+            fclose(fr);
+            return 0;
+        }
+    }
+
+    l2l_dbg(2, "get_rossym %s, no valid .rossym section\n", fname);
+    free(*Symbols);
+    *Symbols = NULL;
+    *SymbolsLength = 0;
+    fclose(fr);
+    return 3;
+}
+
 /* EOF */
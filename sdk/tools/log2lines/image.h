@@ -13,8 +13,16 @@ size_t fixup_offset(size_t ImageBase, size_t offset);
 
 PROSSYM_ENTRY find_offset(void *data, size_t offset);
 
+int check_rossym(const void *Symbols, size_t SymbolsLength);
+
 PIMAGE_SECTION_HEADER get_sectionheader(const void *FileData);
 
+void *map_image(const char *path);
+
+void unmap_images(void);
+
 int get_ImageBase(char *fname, size_t *ImageBase);
 
+int get_rossym(char *fname, void **Symbols, size_t *SymbolsLength);
+
 /* EOF */
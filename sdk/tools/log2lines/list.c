@@ -165,6 +165,7 @@ cache_entry_create(char *Line)
     }
     pentry->RelBase = INVALID_BASE;
     pentry->Size = 0;
+    pentry->Symbols = NULL;
     return pentry;
 }
 
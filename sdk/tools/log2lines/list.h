@@ -8,6 +8,7 @@ typedef struct entry_struct
     size_t ImageBase;
     size_t RelBase;
     size_t Size;
+    void *Symbols;
     struct entry_struct *pnext;
 } LIST_MEMBER, *PLIST_MEMBER;
 
@@ -218,15 +218,11 @@ print_offset(void *data, size_t offset, char *toString)
 }
 
 static int
-process_data(const void *FileData, size_t offset, char *toString)
+process_symbols(void *Symbols, size_t offset, char *toString)
 {
     int res;
 
-    PIMAGE_SECTION_HEADER PERosSymSectionHeader = get_sectionheader((char *)FileData);
-    if (!PERosSymSectionHeader)
-        return 2;
-
-    res = print_offset((char *)FileData + PERosSymSectionHeader->PointerToRawData, offset, toString);
+    res = print_offset(Symbols, offset, toString);
     if (res)
     {
         if (toString)
@@ -240,14 +236,23 @@ process_data(const void *FileData, size_t offset, char *toString)
     return res;
 }
 
+static int
+process_data(const void *FileData, size_t offset, char *toString)
+{
+    PIMAGE_SECTION_HEADER PERosSymSectionHeader = get_sectionheader((char *)FileData);
+    if (!PERosSymSectionHeader)
+        return 2;
+
+    return process_symbols((char *)FileData + PERosSymSectionHeader->PointerToRawData, offset, toString);
+}
+
 static int
 process_file(const char *file_name, size_t offset, char *toString)
 {
     void *FileData;
-    size_t FileSize;
     int res = 1;
 
-    FileData = load_file(file_name, &FileSize);
+    FileData = map_image(file_name);
     if (!FileData)
     {
         l2l_dbg(0, "An error occured loading '%s'\n", file_name);
@@ -255,7 +260,6 @@ process_file(const char *file_name, size_t offset, char *toString)
     else
     {
         res = process_data(FileData, offset, toString);
-        free(FileData);
     }
     return res;
 }
@@ -295,7 +299,10 @@ translate_file(const char *cpath, size_t offset, char *toString)
 
     if (!res)
     {
-        res = process_file(path, offset, toString);
+        if (pentry && pentry->Symbols)
+            res = process_symbols(pentry->Symbols, offset, toString);
+        else
+            res = process_file(path, offset, toString);
     }
 
     free(dpath);
@@ -691,7 +698,8 @@ cleanup:
     }
 
     list_clear(&sources);
-    list_clear(&cache);
+    close_cache();
+    unmap_images();
 
     return res;
 }
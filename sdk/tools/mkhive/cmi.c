@@ -85,6 +85,63 @@ CmpFileWrite(
     return (fwrite(Buffer, 1, BufferLength, File) == BufferLength);
 }
 
+static BOOLEAN
+NTAPI
+CmpFileWriteGather(
+    IN PHHIVE RegistryHive,
+    IN ULONG FileType,
+    IN PCMP_OFFSET_ARRAY OffsetArray,
+    IN ULONG OffsetArrayCount)
+{
+    PCMHIVE CmHive = (PCMHIVE)RegistryHive;
+    FILE *File = CmHive->FileHandles[HFILE_TYPE_PRIMARY];
+    PUCHAR Buffer;
+    ULONG First, Last, Length, i;
+    BOOLEAN Success;
+
+    for (First = 0; First < OffsetArrayCount; First = Last)
+    {
+        /* Find the pieces that follow each other in the file */
+        Length = OffsetArray[First].DataLength;
+        for (Last = First + 1; Last < OffsetArrayCount; Last++)
+        {
+            if (OffsetArray[Last].FileOffset != OffsetArray[First].FileOffset + Length)
+                break;
+            Length += OffsetArray[Last].DataLength;
+        }
+
+        /* And write them with a single call */
+        if (Last - First == 1)
+        {
+            if (!CmpFileWrite(RegistryHive, FileType, &OffsetArray[First].FileOffset,
+                              OffsetArray[First].DataBuffer, Length))
+            {
+                return FALSE;
+            }
+            continue;
+        }
+
+        Buffer = malloc(Length);
+        if (Buffer == NULL)
+            return FALSE;
+
+        for (Length = 0, i = First; i < Last; i++)
+        {
+            memcpy(Buffer + Length, OffsetArray[i].DataBuffer, OffsetArray[i].DataLength);
+            Length += OffsetArray[i].DataLength;
+        }
+
+        Success = (fseek(File, OffsetArray[First].FileOffset, SEEK_SET) == 0 &&
+                   fwrite(Buffer, 1, Length, File) == Length);
+        free(Buffer);
+
+        if (!Success)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
 static BOOLEAN
 NTAPI
 CmpFileSetSize(
@@ -139,6 +196,9 @@ CmiInitializeHive(
         return Status;
     }
 
+    /* Write whole runs of blocks at once */
+    Hive->Hive.FileWriteGather = CmpFileWriteGather;
+
     // HACK: See the HACK from r31253
     if (!CmCreateRootNode(&Hive->Hive, Name))
     {
@@ -0,0 +1,9 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Empty replacement for the code analysis suppression header
+ */
+
+#pragma once
+
+#define _PRAGMA_WARNING_SUPPRESS(x)
@@ -0,0 +1,261 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Minimal win32k environment to build the region code on the host
+ */
+
+#pragma once
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define FASTCALL
+#define APIENTRY
+#define __kernel_entry
+#define INIT_FUNCTION
+#define OPTIONAL
+#define FORCEINLINE static __inline
+#define _PRAGMA_WARNING_SUPPRESS(x)
+
+#define _In_
+#define _Inout_
+#define _Notnull_
+#define _Success_(expr)
+#define _Out_writes_bytes_to_opt_(size, count)
+
+#define NT_ASSERT ASSERT
+#define NT_VERIFY(exp) ((void)(exp))
+#define DbgPrint printf
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define MAXLONG 0x7fffffff
+#define MINLONG (-MAXLONG - 1)
+
+#define STATUS_SUCCESS ((NTSTATUS)0x00000000L)
+#define STATUS_INVALID_PARAMETER ((NTSTATUS)0xC000000DL)
+#define STATUS_NO_MEMORY ((NTSTATUS)0xC0000017L)
+#define ERROR_INVALID_HANDLE 6
+#define ERROR_NOT_ENOUGH_MEMORY 8
+#define ERROR_INVALID_PARAMETER 87
+
+typedef PVOID HANDLE, HGDIOBJ, HRGN;
+typedef ULONG FLONG, FIX;
+
+typedef struct _RECTL
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECTL, *PRECTL, *LPRECTL, RECT, *PRECT, *LPRECT;
+
+typedef struct _POINTL
+{
+    LONG x;
+    LONG y;
+} POINTL, *PPOINTL, POINT, *PPOINT, *LPPOINT;
+
+#define RDH_RECTANGLES 1
+
+typedef struct _RGNDATAHEADER
+{
+    ULONG dwSize;
+    ULONG iType;
+    ULONG nCount;
+    ULONG nRgnSize;
+    RECT rcBound;
+} RGNDATAHEADER;
+
+typedef struct _RGNDATA
+{
+    RGNDATAHEADER rdh;
+    char Buffer[1];
+} RGNDATA, *LPRGNDATA;
+
+#define NULLREGION 1
+#define SIMPLEREGION 2
+#define COMPLEXREGION 3
+#define ERROR 0
+
+#define RGN_AND 1
+#define RGN_OR 2
+#define RGN_XOR 3
+#define RGN_DIFF 4
+#define RGN_COPY 5
+
+#define ALTERNATE 1
+#define WINDING 2
+
+#define ATTR_RGN_VALID 0x10
+#define ATTR_RGN_DIRTY 0x20
+
+typedef struct _RGN_ATTR
+{
+    ULONG AttrFlags;
+    ULONG iComplexity;
+    RECTL Rect;
+} RGN_ATTR, *PRGN_ATTR;
+
+typedef struct _BASEOBJECT
+{
+    HGDIOBJ hHmgr;
+} BASEOBJECT, *POBJ;
+
+/* Coordinate transformations are not used by the benchmark */
+typedef struct _MATRIX
+{
+    FLONG flAccel;
+    FIX fxDx;
+    FIX fxDy;
+} MATRIX, *PMATRIX;
+
+typedef struct _XFORMOBJ
+{
+    PMATRIX pmx;
+} XFORMOBJ;
+
+typedef struct _XFORML
+{
+    float eM11, eM12, eM21, eM22, eDx, eDy;
+} XFORML, XFORM, *LPXFORM;
+
+#define XFORM_SCALE 1
+#define XFORM_UNITY 2
+#define XF_LTOL 0
+#define DDI_ERROR 0xFFFFFFFF
+
+#define XFORMOBJ_vInit(pxo, pmxInit) ((pxo)->pmx = (pmxInit))
+#define XFORMOBJ_iSetXform(pxo, pxform) DDI_ERROR
+#define XFORMOBJ_bApplyXform(pxo, iMode, cPoints, pvIn, pvOut) FALSE
+
+#define MIN_COORD (INT_MIN / 16)
+#define MAX_COORD (INT_MAX / 16)
+
+/* Pool and lookaside lists */
+#define TAG_REGION 'NGER'
+#define GDITAG_REGION 'ngrG'
+#define PagedPool 1
+#define NonPagedPool 0
+
+#define ExAllocatePoolWithTag(PoolType, NumberOfBytes, Tag) malloc(NumberOfBytes)
+#define ExFreePoolWithTag(P, Tag) free(P)
+
+typedef struct _PAGED_LOOKASIDE_LIST
+{
+    ULONG Size;
+    ULONG Depth;
+    ULONG Count;
+    PVOID ListHead;
+} PAGED_LOOKASIDE_LIST, *PPAGED_LOOKASIDE_LIST;
+
+static __inline
+VOID
+ExInitializePagedLookasideList(
+    PPAGED_LOOKASIDE_LIST Lookaside,
+    PVOID Allocate,
+    PVOID Free,
+    ULONG Flags,
+    SIZE_T Size,
+    ULONG Tag,
+    USHORT Depth)
+{
+    Lookaside->Size = (ULONG)Size;
+    Lookaside->Depth = Depth;
+    Lookaside->Count = 0;
+    Lookaside->ListHead = NULL;
+}
+
+static __inline
+PVOID
+ExAllocateFromPagedLookasideList(
+    PPAGED_LOOKASIDE_LIST Lookaside)
+{
+    PVOID Entry = Lookaside->ListHead;
+
+    if (Entry == NULL)
+        return malloc(Lookaside->Size);
+
+    Lookaside->ListHead = *(PVOID*)Entry;
+    Lookaside->Count--;
+    return Entry;
+}
+
+static __inline
+VOID
+ExFreeToPagedLookasideList(
+    PPAGED_LOOKASIDE_LIST Lookaside,
+    PVOID Entry)
+{
+    if (Lookaside->Count >= Lookaside->Depth)
+    {
+        free(Entry);
+        return;
+    }
+
+    *(PVOID*)Entry = Lookaside->ListHead;
+    Lookaside->ListHead = Entry;
+    Lookaside->Count++;
+}
+
+/* GDI objects live in the benchmark's own table */
+typedef enum _GDIOBJTYPE
+{
+    GDIObjType_RGN_TYPE = 4
+} GDIOBJTYPE;
+
+#define GDILoObjType_LO_REGION_TYPE 0x00040000
+#define BASEFLAG_LOOKASIDE 0x80
+#define GDI_OBJ_HMGR_POWNED 0
+#define GDI_OBJECT_TYPE_REGION 0x00040000
+#define GDI_HANDLE_GET_TYPE(h) GDI_OBJECT_TYPE_REGION
+
+PVOID GDIOBJ_AllocateObject(UCHAR objt, ULONG cjSize, FLONG fl);
+HGDIOBJ GDIOBJ_hInsertObject(POBJ pobj, ULONG ulOwner);
+VOID GDIOBJ_vFreeObject(POBJ pobj);
+VOID GDIOBJ_vDeleteObject(POBJ pobj);
+PVOID GDIOBJ_LockObject(HGDIOBJ hobj, UCHAR objt);
+VOID GDIOBJ_vUnlockObject(POBJ pobj);
+BOOL GDIOBJ_bLockMultipleObjects(ULONG ulCount, HGDIOBJ *ahObj, PVOID *apObj, UCHAR objt);
+#define GDIOBJ_vSetObjectAttr(pobj, pvObjAttr) ((void)0)
+BOOL GreDeleteObject(HGDIOBJ hobj);
+#define GreIsHandleValid(hobj) TRUE
+#define GreGetObjectOwner(hobj) 0
+#define GreSetObjectOwner(hobj, ulOwner) TRUE
+
+typedef struct _PROCESSINFO
+{
+    PVOID pPoolRgnAttr;
+} PROCESSINFO, *PPROCESSINFO;
+
+extern PROCESSINFO HostProcessInfo;
+#define PsGetCurrentProcessWin32Process() (&HostProcessInfo)
+#define GdiPoolAllocate(pPool) NULL
+#define GdiPoolFree(pPool, pvAlloc) ((void)0)
+
+/* The user mode entry points are compiled, but never called */
+#define _SEH2_TRY {
+#define _SEH2_EXCEPT(x) } if (0) {
+#define _SEH2_END }
+#define _SEH2_GetExceptionCode() STATUS_INVALID_PARAMETER
+#define _SEH2_YIELD(x) x
+#define ProbeForRead(Address, Length, Alignment) ((void)0)
+#define ProbeForWrite(Address, Length, Alignment) ((void)0)
+#define EngSetLastError(e) ((void)0)
+#define SetLastNtError(s) ((void)0)
+
+VOID FASTCALL RECTL_vMakeWellOrdered(RECTL *prcl);
+BOOL FASTCALL RECTL_bUnionRect(RECTL *prclDst, const RECTL *prcl1, const RECTL *prcl2);
+#define RECTL_vSetEmptyRect(prcl) memset(prcl, 0, sizeof(RECTL))
+
+#include <region.h>
+
+HRGN APIENTRY NtGdiCreateRoundRectRgn(INT Left, INT Top, INT Right, INT Bottom, INT Width, INT Height);
@@ -0,0 +1,673 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Replay clipping sequences against the win32k region code
+ *
+ * A trace is a text file with one region operation per line:
+ *
+ *   set  <rgn> <left> <top> <right> <bottom>     REGION_SetRectRgn
+ *   comb <dst> <src1> <src2> <and|or|xor|diff|copy>
+ *   off  <rgn> <dx> <dy>                        REGION_bOffsetRgn
+ *   pt   <rgn> <x> <y>                          REGION_PtInRegion
+ *   rect <rgn> <left> <top> <right> <bottom>    REGION_RectInRegion
+ *
+ * Regions are numbered from 0 to MAX_REGIONS - 1 and start out empty.
+ * Without a trace file, a sequence modelled on the window manager is
+ * generated: visible regions of overlapping top level and child windows
+ * while one of them is dragged around, hit tests and paint clipping.
+ * Every run prints a digest of all results, so the output of a changed
+ * region implementation can be compared with the previous one.
+ */
+
+#include <win32k.h>
+#include <time.h>
+
+#define MAX_REGIONS     64
+#define MAX_LINE        256
+
+#define SCREEN_WIDTH    1024
+#define SCREEN_HEIGHT   768
+
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+typedef enum _OP_TYPE
+{
+    OpSet,
+    OpCombine,
+    OpOffset,
+    OpPoint,
+    OpRect
+} OP_TYPE;
+
+typedef struct _OP
+{
+    UCHAR Type;
+    UCHAR Region;
+    UCHAR Src1;
+    UCHAR Src2;
+    LONG Args[4];
+} OP, *POP;
+
+typedef struct _TRACE
+{
+    POP Ops;
+    ULONG Count;
+    ULONG Size;
+} TRACE, *PTRACE;
+
+static const char *CombineNames[] = { NULL, "and", "or", "xor", "diff", "copy" };
+
+PROCESSINFO HostProcessInfo;
+
+static PREGION Regions[MAX_REGIONS];
+static ULONG Seed = 0x2545F491;
+
+/* Minimal GDI object manager, handles are plain pointers *********************/
+
+PVOID
+GDIOBJ_AllocateObject(UCHAR objt, ULONG cjSize, FLONG fl)
+{
+    return calloc(1, cjSize);
+}
+
+HGDIOBJ
+GDIOBJ_hInsertObject(POBJ pobj, ULONG ulOwner)
+{
+    pobj->hHmgr = pobj;
+    return pobj;
+}
+
+VOID
+GDIOBJ_vFreeObject(POBJ pobj)
+{
+    REGION_vCleanup(pobj);
+    free(pobj);
+}
+
+VOID
+GDIOBJ_vDeleteObject(POBJ pobj)
+{
+    GDIOBJ_vFreeObject(pobj);
+}
+
+PVOID
+GDIOBJ_LockObject(HGDIOBJ hobj, UCHAR objt)
+{
+    return hobj;
+}
+
+VOID
+GDIOBJ_vUnlockObject(POBJ pobj)
+{
+}
+
+BOOL
+GDIOBJ_bLockMultipleObjects(ULONG ulCount, HGDIOBJ *ahObj, PVOID *apObj, UCHAR objt)
+{
+    ULONG i;
+
+    for (i = 0; i < ulCount; i++)
+        apObj[i] = ahObj[i];
+
+    return TRUE;
+}
+
+BOOL
+GreDeleteObject(HGDIOBJ hobj)
+{
+    GDIOBJ_vFreeObject(hobj);
+    return TRUE;
+}
+
+VOID
+FASTCALL
+RECTL_vMakeWellOrdered(RECTL *prcl)
+{
+    LONG lTmp;
+
+    if (prcl->left > prcl->right)
+    {
+        lTmp = prcl->left;
+        prcl->left = prcl->right;
+        prcl->right = lTmp;
+    }
+    if (prcl->top > prcl->bottom)
+    {
+        lTmp = prcl->top;
+        prcl->top = prcl->bottom;
+        prcl->bottom = lTmp;
+    }
+}
+
+BOOL
+FASTCALL
+RECTL_bUnionRect(RECTL *prclDst, const RECTL *prcl1, const RECTL *prcl2)
+{
+    prclDst->left = min(prcl1->left, prcl2->left);
+    prclDst->top = min(prcl1->top, prcl2->top);
+    prclDst->right = max(prcl1->right, prcl2->right);
+    prclDst->bottom = max(prcl1->bottom, prcl2->bottom);
+    return TRUE;
+}
+
+/* Traces *********************************************************************/
+
+static
+ULONG
+Random(ULONG Range)
+{
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 8) % Range;
+}
+
+static
+POP
+AddOp(PTRACE Trace, OP_TYPE Type, ULONG Region)
+{
+    POP Op;
+
+    if (Trace->Count == Trace->Size)
+    {
+        Trace->Size = Trace->Size ? Trace->Size * 2 : 4096;
+        Trace->Ops = realloc(Trace->Ops, Trace->Size * sizeof(OP));
+        if (!Trace->Ops)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+
+    Op = &Trace->Ops[Trace->Count++];
+    memset(Op, 0, sizeof(*Op));
+    Op->Type = (UCHAR)Type;
+    Op->Region = (UCHAR)Region;
+    return Op;
+}
+
+static
+VOID
+AddRectOp(PTRACE Trace, OP_TYPE Type, ULONG Region, const RECTL *Rect)
+{
+    POP Op = AddOp(Trace, Type, Region);
+
+    Op->Args[0] = Rect->left;
+    Op->Args[1] = Rect->top;
+    Op->Args[2] = Rect->right;
+    Op->Args[3] = Rect->bottom;
+}
+
+static
+VOID
+AddCombineOp(PTRACE Trace, ULONG Dest, ULONG Src1, ULONG Src2, INT Mode)
+{
+    POP Op = AddOp(Trace, OpCombine, Dest);
+
+    Op->Src1 = (UCHAR)Src1;
+    Op->Src2 = (UCHAR)Src2;
+    Op->Args[0] = Mode;
+}
+
+#define WINDOWS         24
+#define CHILDREN        3
+#define FRAMES          200
+
+#define RGN_VIS         0   /* Visible region being computed */
+#define RGN_TEMP        1   /* Rect to combine with */
+#define RGN_CLIP        2   /* Paint clipping */
+#define RGN_PARENT      3   /* First parent visible region */
+
+/*
+ * Windows are ordered from top to bottom. For every frame, the visible
+ * region of each window is its rect minus the rects of the windows above,
+ * the one of each child is clipped to the parent and the siblings above.
+ */
+static
+VOID
+GenerateTrace(PTRACE Trace)
+{
+    RECTL Windows[WINDOWS], Children[WINDOWS][CHILDREN], Rect;
+    ULONG Frame, i, j, k, Query;
+    LONG Width, Height;
+
+    for (i = 0; i < WINDOWS; i++)
+    {
+        Width = 160 + Random(400);
+        Height = 120 + Random(300);
+        Windows[i].left = Random(SCREEN_WIDTH - Width);
+        Windows[i].top = Random(SCREEN_HEIGHT - Height);
+        Windows[i].right = Windows[i].left + Width;
+        Windows[i].bottom = Windows[i].top + Height;
+
+        for (j = 0; j < CHILDREN; j++)
+        {
+            Children[i][j].left = Windows[i].left + 4 + Random(Width / 2);
+            Children[i][j].top = Windows[i].top + 24 + Random(Height / 2);
+            Children[i][j].right = min(Children[i][j].left + 40 + (LONG)Random(Width / 2), Windows[i].right - 4);
+            Children[i][j].bottom = min(Children[i][j].top + 20 + (LONG)Random(Height / 2), Windows[i].bottom - 4);
+        }
+    }
+
+    for (Frame = 0; Frame < FRAMES; Frame++)
+    {
+        /* Drag the window in the middle of the stack diagonally */
+        Windows[WINDOWS / 2].left = (Frame * 5) % (SCREEN_WIDTH - 200);
+        Windows[WINDOWS / 2].top = (Frame * 3) % (SCREEN_HEIGHT - 150);
+        Windows[WINDOWS / 2].right = Windows[WINDOWS / 2].left + 200;
+        Windows[WINDOWS / 2].bottom = Windows[WINDOWS / 2].top + 150;
+
+        for (i = 0; i < WINDOWS; i++)
+        {
+            AddRectOp(Trace, OpSet, RGN_VIS, &Windows[i]);
+            for (k = 0; k < i; k++)
+            {
+                AddRectOp(Trace, OpSet, RGN_TEMP, &Windows[k]);
+                AddCombineOp(Trace, RGN_VIS, RGN_VIS, RGN_TEMP, RGN_DIFF);
+            }
+
+            if (i + RGN_PARENT < MAX_REGIONS)
+                AddCombineOp(Trace, RGN_PARENT + i, RGN_VIS, 0, RGN_COPY);
+
+            /* Children, clipped to the parent and the siblings above */
+            for (j = 0; j < CHILDREN; j++)
+            {
+                AddRectOp(Trace, OpSet, RGN_VIS, &Children[i][j]);
+                AddCombineOp(Trace, RGN_VIS, RGN_VIS, RGN_PARENT + i, RGN_AND);
+                for (k = 0; k < j; k++)
+                {
+                    AddRectOp(Trace, OpSet, RGN_TEMP, &Children[i][k]);
+                    AddCombineOp(Trace, RGN_VIS, RGN_VIS, RGN_TEMP, RGN_DIFF);
+                }
+            }
+
+            /* Paint: clip to an update rect, hit test the window */
+            Rect.left = Windows[i].left + Random(100);
+            Rect.top = Windows[i].top + Random(100);
+            Rect.right = Rect.left + 1 + Random(200);
+            Rect.bottom = Rect.top + 1 + Random(200);
+            AddRectOp(Trace, OpSet, RGN_TEMP, &Rect);
+            AddCombineOp(Trace, RGN_CLIP, RGN_PARENT + i, RGN_TEMP, RGN_AND);
+            AddCombineOp(Trace, RGN_CLIP, RGN_CLIP, RGN_PARENT + i, RGN_OR);
+            AddCombineOp(Trace, RGN_CLIP, RGN_CLIP, RGN_TEMP, RGN_XOR);
+
+            for (Query = 0; Query < 16; Query++)
+            {
+                Rect.left = Random(SCREEN_WIDTH);
+                Rect.top = Random(SCREEN_HEIGHT);
+                Rect.right = Rect.left + 1 + Random(64);
+                Rect.bottom = Rect.top + 1 + Random(64);
+                AddRectOp(Trace, OpPoint, RGN_PARENT + i, &Rect);
+                AddRectOp(Trace, OpRect, RGN_PARENT + i, &Rect);
+            }
+        }
+
+        /* Rebuild the screen one band at a time, as ExtCreateRegion does */
+        AddRectOp(Trace, OpSet, RGN_CLIP, &Windows[0]);
+        for (i = 1; i < WINDOWS; i++)
+        {
+            Rect = Windows[i];
+            Rect.top = Windows[0].bottom + (LONG)i * 4;
+            Rect.bottom = Rect.top + 4;
+            AddRectOp(Trace, OpSet, RGN_TEMP, &Rect);
+            AddCombineOp(Trace, RGN_CLIP, RGN_CLIP, RGN_TEMP, RGN_OR);
+        }
+
+        AddCombineOp(Trace, RGN_TEMP, RGN_PARENT, 0, RGN_COPY);
+        AddOp(Trace, OpOffset, RGN_TEMP)->Args[0] = 1;
+    }
+}
+
+static
+BOOL
+ReadTrace(const char *FileName, PTRACE Trace)
+{
+    char Line[MAX_LINE], Name[16], Mode[16];
+    ULONG LineNumber = 0, Region, Src1, Src2, i;
+    LONG a, b, c, d;
+    POP Op;
+    FILE *File;
+
+    File = fopen(FileName, "r");
+    if (!File)
+    {
+        fprintf(stderr, "Could not open '%s'\n", FileName);
+        return FALSE;
+    }
+
+    while (fgets(Line, sizeof(Line), File))
+    {
+        LineNumber++;
+        if (sscanf(Line, "%15s", Name) != 1 || Name[0] == '#')
+            continue;
+
+        if (!strcmp(Name, "comb") &&
+            sscanf(Line, "%*s %u %u %u %15s", &Region, &Src1, &Src2, Mode) == 4 &&
+            Region < MAX_REGIONS && Src1 < MAX_REGIONS && Src2 < MAX_REGIONS)
+        {
+            for (i = 1; i < ARRAYSIZE(CombineNames); i++)
+            {
+                if (!strcmp(Mode, CombineNames[i]))
+                {
+                    AddCombineOp(Trace, Region, Src1, Src2, (INT)i);
+                    break;
+                }
+            }
+            if (i < ARRAYSIZE(CombineNames))
+                continue;
+        }
+        else if ((!strcmp(Name, "set") || !strcmp(Name, "rect")) &&
+                 sscanf(Line, "%*s %u %d %d %d %d", &Region, &a, &b, &c, &d) == 5 &&
+                 Region < MAX_REGIONS)
+        {
+            Op = AddOp(Trace, !strcmp(Name, "set") ? OpSet : OpRect, Region);
+            Op->Args[0] = a;
+            Op->Args[1] = b;
+            Op->Args[2] = c;
+            Op->Args[3] = d;
+            continue;
+        }
+        else if ((!strcmp(Name, "off") || !strcmp(Name, "pt")) &&
+                 sscanf(Line, "%*s %u %d %d", &Region, &a, &b) == 3 &&
+                 Region < MAX_REGIONS)
+        {
+            Op = AddOp(Trace, !strcmp(Name, "off") ? OpOffset : OpPoint, Region);
+            Op->Args[0] = a;
+            Op->Args[1] = b;
+            continue;
+        }
+
+        fprintf(stderr, "%s(%u): invalid operation\n", FileName, LineNumber);
+        fclose(File);
+        return FALSE;
+    }
+
+    fclose(File);
+    return TRUE;
+}
+
+static
+BOOL
+WriteTrace(const char *FileName, PTRACE Trace)
+{
+    FILE *File;
+    POP Op;
+    ULONG i;
+
+    File = fopen(FileName, "w");
+    if (!File)
+    {
+        fprintf(stderr, "Could not create '%s'\n", FileName);
+        return FALSE;
+    }
+
+    for (i = 0; i < Trace->Count; i++)
+    {
+        Op = &Trace->Ops[i];
+        switch (Op->Type)
+        {
+            case OpSet:
+            case OpRect:
+                fprintf(File, "%s %u %d %d %d %d\n", Op->Type == OpSet ? "set" : "rect",
+                        Op->Region, Op->Args[0], Op->Args[1], Op->Args[2], Op->Args[3]);
+                break;
+            case OpCombine:
+                fprintf(File, "comb %u %u %u %s\n", Op->Region, Op->Src1, Op->Src2,
+                        CombineNames[Op->Args[0]]);
+                break;
+            case OpOffset:
+            case OpPoint:
+                fprintf(File, "%s %u %d %d\n", Op->Type == OpOffset ? "off" : "pt",
+                        Op->Region, Op->Args[0], Op->Args[1]);
+                break;
+        }
+    }
+
+    fclose(File);
+    return TRUE;
+}
+
+/* Replay *********************************************************************/
+
+static
+ULONG
+HashRegion(ULONG Hash, PREGION Region)
+{
+    const UCHAR *Bytes = (const UCHAR*)Region->Buffer;
+    ULONG i;
+
+    Hash = (Hash ^ Region->rdh.nCount) * 16777619;
+    for (i = 0; i < Region->rdh.nCount * sizeof(RECTL); i++)
+        Hash = (Hash ^ Bytes[i]) * 16777619;
+
+    return Hash;
+}
+
+static
+BOOL
+SameSpans(const RECTL *Band1, const RECTL *Band2, ULONG Count)
+{
+    ULONG i;
+
+    for (i = 0; i < Count; i++)
+    {
+        if (Band1[i].left != Band2[i].left || Band1[i].right != Band2[i].right)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Check the y-x banding and coalescing REGION_RegionOp guarantees */
+static
+BOOL
+CheckRegion(PREGION Region)
+{
+    RECTL Bound = { 0, 0, 0, 0 };
+    PRECTL Rect, Band = NULL, PrevBand = NULL;
+    ULONG i, BandSize = 0, PrevBandSize = 0;
+
+    for (i = 0; i <= Region->rdh.nCount; i++)
+    {
+        Rect = &Region->Buffer[i];
+
+        /* End of a band, it must not be possible to merge it with the previous one */
+        if (i == Region->rdh.nCount || (Band && Rect->top != Band->top))
+        {
+            if (PrevBand && PrevBandSize == BandSize && PrevBand->bottom == Band->top &&
+                SameSpans(PrevBand, Band, BandSize))
+            {
+                return FALSE;
+            }
+
+            if (i == Region->rdh.nCount)
+                break;
+
+            if (Rect->top < Band->bottom)
+                return FALSE;
+
+            PrevBand = Band;
+            PrevBandSize = BandSize;
+            Band = NULL;
+        }
+
+        if (Rect->left >= Rect->right || Rect->top >= Rect->bottom)
+            return FALSE;
+
+        if (Band == NULL)
+        {
+            Band = Rect;
+            BandSize = 0;
+        }
+        else if (Rect->bottom != Band->bottom || Rect->left <= (Rect - 1)->right)
+        {
+            /* Rects of a band have the same height and don't touch */
+            return FALSE;
+        }
+        BandSize++;
+
+        if (i == 0)
+            Bound = *Rect;
+        else
+            RECTL_bUnionRect(&Bound, &Bound, Rect);
+    }
+
+    return memcmp(&Bound, &Region->rdh.rcBound, sizeof(RECTL)) == 0;
+}
+
+/* Replay a trace, computing a digest of the results only if asked for */
+static
+ULONG
+Replay(PTRACE Trace, BOOL Digest, BOOL Check)
+{
+    ULONG Hash = 2166136261u, i;
+    PREGION Region;
+    RECTL Rect;
+    POP Op;
+
+    for (i = 0; i < MAX_REGIONS; i++)
+        REGION_SetRectRgn(Regions[i], 0, 0, 0, 0);
+
+    for (i = 0; i < Trace->Count; i++)
+    {
+        Op = &Trace->Ops[i];
+        Region = Regions[Op->Region];
+
+        switch (Op->Type)
+        {
+            case OpSet:
+                REGION_SetRectRgn(Region, Op->Args[0], Op->Args[1], Op->Args[2], Op->Args[3]);
+                break;
+
+            case OpCombine:
+                IntGdiCombineRgn(Region, Regions[Op->Src1], Regions[Op->Src2], Op->Args[0]);
+                if (Digest)
+                    Hash = HashRegion(Hash, Region);
+                if (Check && !CheckRegion(Region))
+                {
+                    fprintf(stderr, "Operation %u: malformed region\n", i);
+                    exit(1);
+                }
+                break;
+
+            case OpOffset:
+                REGION_bOffsetRgn(Region, Op->Args[0], Op->Args[1]);
+                if (Digest)
+                    Hash = HashRegion(Hash, Region);
+                break;
+
+            case OpPoint:
+                Hash = (Hash ^ REGION_PtInRegion(Region, Op->Args[0], Op->Args[1])) * 16777619;
+                break;
+
+            case OpRect:
+                Rect.left = Op->Args[0];
+                Rect.top = Op->Args[1];
+                Rect.right = Op->Args[2];
+                Rect.bottom = Op->Args[3];
+                Hash = (Hash ^ REGION_RectInRegion(Region, &Rect)) * 16777619;
+                break;
+        }
+    }
+
+    return Hash;
+}
+
+static
+double
+Now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static
+VOID
+RunTrace(const char *Name, PTRACE Trace, ULONG Runs, BOOL Check)
+{
+    ULONG Hash, Run;
+    double Start, Best = 1e30;
+
+    Hash = Replay(Trace, TRUE, Check);
+    for (Run = 0; Run < Runs; Run++)
+    {
+        Start = Now();
+        Replay(Trace, FALSE, FALSE);
+        Best = min(Best, Now() - Start);
+    }
+
+    printf("%-24s %9u ops %9.3f ms %7.1f ns/op  digest %08X\n",
+           Name, Trace->Count, Best * 1e3, Best * 1e9 / max(Trace->Count, 1), Hash);
+}
+
+static
+VOID
+Usage(void)
+{
+    printf("Usage: rgnbench [-c] [-r runs] [-w file] [trace...]\n"
+           "  -c       Check the structure of every region produced\n"
+           "  -r runs  Number of timed runs, the best one is reported (default 5)\n"
+           "  -w file  Write the generated trace to a file\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *WriteFile = NULL;
+    ULONG Runs = 5, i;
+    TRACE Trace;
+    BOOL Check = FALSE;
+    int Arg;
+
+    for (Arg = 1; Arg < argc && argv[Arg][0] == '-'; Arg++)
+    {
+        if (!strcmp(argv[Arg], "-c"))
+        {
+            Check = TRUE;
+        }
+        else if (!strcmp(argv[Arg], "-r") && Arg + 1 < argc)
+        {
+            Runs = strtoul(argv[++Arg], NULL, 0);
+            if (Runs == 0)
+                Runs = 1;
+        }
+        else if (!strcmp(argv[Arg], "-w") && Arg + 1 < argc)
+        {
+            WriteFile = argv[++Arg];
+        }
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (!NT_SUCCESS(InitRegionImpl()))
+        return 1;
+
+    for (i = 0; i < MAX_REGIONS; i++)
+        Regions[i] = IntSysCreateRectpRgn(0, 0, 0, 0);
+
+    if (Arg == argc)
+    {
+        memset(&Trace, 0, sizeof(Trace));
+        GenerateTrace(&Trace);
+        if (WriteFile && !WriteTrace(WriteFile, &Trace))
+            return 1;
+
+        RunTrace("(generated)", &Trace, Runs, Check);
+        free(Trace.Ops);
+    }
+
+    for (; Arg < argc; Arg++)
+    {
+        memset(&Trace, 0, sizeof(Trace));
+        if (!ReadTrace(argv[Arg], &Trace))
+            return 1;
+
+        RunTrace(argv[Arg], &Trace, Runs, Check);
+        free(Trace.Ops);
+    }
+
+    return 0;
+}
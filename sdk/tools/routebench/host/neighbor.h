@@ -0,0 +1,17 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Neighbor cache entries, as far as the router uses them
+ */
+
+#pragma once
+
+typedef struct NEIGHBOR_CACHE_ENTRY {
+    UCHAR State;
+    PIP_INTERFACE Interface;
+    IP_ADDRESS Address;
+} NEIGHBOR_CACHE_ENTRY, *PNEIGHBOR_CACHE_ENTRY;
+
+#define NUD_INCOMPLETE 0x01
+#define NUD_PERMANENT  0x02
+#define NUD_STALE      0x04
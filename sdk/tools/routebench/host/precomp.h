@@ -0,0 +1,71 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Minimal TCP/IP driver environment to build the router on the host
+ */
+
+#pragma once
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#define STATUS_SUCCESS      ((NTSTATUS)0x00000000L)
+#define STATUS_UNSUCCESSFUL ((NTSTATUS)0xC0000001L)
+
+typedef UCHAR KIRQL, *PKIRQL;
+typedef ULONG_PTR KSPIN_LOCK, *PKSPIN_LOCK;
+
+#define NonPagedPool 0
+#define FIB_TAG 0
+
+#define ExAllocatePoolWithTag(Type, Size, Tag) malloc(Size)
+#define ExFreePoolWithTag(Ptr, Tag) free(Ptr)
+
+/* The benchmark is single threaded */
+#define TcpipInitializeSpinLock(Lock) (*(Lock) = 0)
+#define TcpipAcquireSpinLock(Lock, Irql) (*(Irql) = 0)
+#define TcpipReleaseSpinLock(Lock, Irql) ((void)(Irql))
+
+#define MIN_TRACE       0x00000001
+#define DEBUG_ROUTER    0x00000000
+#define DEBUG_RCACHE    0x00000000
+#define TI_DbgPrint(Level, Args)
+
+typedef VOID (*OBJECT_FREE_ROUTINE)(PVOID Object);
+
+typedef ULONG IPv4_RAW_ADDRESS;
+typedef USHORT IPv6_RAW_ADDRESS[8];
+
+typedef struct IP_ADDRESS {
+    UCHAR Type;
+    union {
+        IPv4_RAW_ADDRESS IPv4Address;
+        IPv6_RAW_ADDRESS IPv6Address;
+    } Address;
+} IP_ADDRESS, *PIP_ADDRESS;
+
+#define IP_ADDRESS_V4   0x04
+#define IP_ADDRESS_V6   0x06
+
+typedef struct _IP_INTERFACE {
+    UINT MTU;
+} IP_INTERFACE, *PIP_INTERFACE;
+
+#include <neighbor.h>
+#include <router.h>
+
+ULONG IPv4NToHl(ULONG Address);
+UINT AddrCountPrefixBits(PIP_ADDRESS Netmask);
+BOOLEAN AddrIsEqual(PIP_ADDRESS Address1, PIP_ADDRESS Address2);
+PCHAR A2S(PIP_ADDRESS Address);
+PIP_INTERFACE FindOnLinkInterface(PIP_ADDRESS Address);
+PNEIGHBOR_CACHE_ENTRY NBFindOrCreateNeighbor(PIP_INTERFACE Interface,
+                                             PIP_ADDRESS Address,
+                                             BOOLEAN NoTimeout);
+UINT CommonPrefixLength(PIP_ADDRESS Address1, PIP_ADDRESS Address2);
@@ -0,0 +1,339 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Route lookup benchmark for the TCP/IP router
+ *
+ * Fills the forward information base of the router with random IPv4
+ * routes, from 10 to 10000 of them, and times RouterGetRoute against the
+ * linear walk of the route list that it used to do. The destinations
+ * are either drawn at random, so that the route cache rarely helps, or
+ * from a small set of hot addresses, like the peers of a busy server.
+ * Every result of RouterGetRoute is checked against a plain longest
+ * prefix match over all the routes, before and after half of the routes
+ * are removed again.
+ */
+
+#include <precomp.h>
+#include <time.h>
+
+#define DEFAULT_LOOKUPS     2000000
+#define HOT_DESTINATIONS    64
+#define CHECKED_LOOKUPS     10000
+
+extern LIST_ENTRY FIBListHead;
+
+static const ULONG TableSizes[] = { 10, 100, 1000, 10000 };
+
+static IP_INTERFACE BenchInterface = { 1500 };
+
+static ULONG RouteCount;
+
+static ULONG Seed = 1;
+
+static ULONG Random(VOID)
+{
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 16) | ((Seed * 1103515245 + 12345) & 0xFFFF0000);
+}
+
+static double Now(VOID)
+{
+    struct timespec Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+/* Services of the rest of the driver */
+
+ULONG IPv4NToHl(ULONG Address)
+{
+    return ((Address & 0xFF) << 24) | ((Address & 0xFF00) << 8) |
+           ((Address >> 8) & 0xFF00) | ((Address >> 24) & 0xFF);
+}
+
+UINT AddrCountPrefixBits(PIP_ADDRESS Netmask)
+{
+    ULONG Mask = IPv4NToHl(Netmask->Address.IPv4Address);
+    UINT Prefix = 0;
+
+    while (Prefix < 32 && (Mask & (0x80000000 >> Prefix)))
+        Prefix++;
+
+    return Prefix;
+}
+
+BOOLEAN AddrIsEqual(PIP_ADDRESS Address1, PIP_ADDRESS Address2)
+{
+    return Address1->Type == Address2->Type &&
+           Address1->Address.IPv4Address == Address2->Address.IPv4Address;
+}
+
+PCHAR A2S(PIP_ADDRESS Address)
+{
+    static CHAR Buffer[16];
+    ULONG Host = IPv4NToHl(Address->Address.IPv4Address);
+
+    sprintf(Buffer, "%u.%u.%u.%u", Host >> 24, (Host >> 16) & 0xFF,
+            (Host >> 8) & 0xFF, Host & 0xFF);
+    return Buffer;
+}
+
+PIP_INTERFACE FindOnLinkInterface(PIP_ADDRESS Address)
+{
+    return NULL;
+}
+
+PNEIGHBOR_CACHE_ENTRY NBFindOrCreateNeighbor(PIP_INTERFACE Interface,
+                                             PIP_ADDRESS Address,
+                                             BOOLEAN NoTimeout)
+{
+    PNEIGHBOR_CACHE_ENTRY NCE = calloc(1, sizeof(*NCE));
+
+    if (NCE) {
+        NCE->Interface = Interface;
+        NCE->Address = *Address;
+    }
+    return NCE;
+}
+
+static VOID SetAddress(PIP_ADDRESS Address, ULONG Host)
+{
+    Address->Type = IP_ADDRESS_V4;
+    Address->Address.IPv4Address = IPv4NToHl(Host);
+}
+
+/* The route lookup before the prefix trie */
+static PNEIGHBOR_CACHE_ENTRY LinearGetRoute(PIP_ADDRESS Destination)
+{
+    PLIST_ENTRY CurrentEntry;
+    PFIB_ENTRY Current;
+    UCHAR State;
+    UINT Length, BestLength = 0, MaskLength;
+    PNEIGHBOR_CACHE_ENTRY NCE, BestNCE = NULL;
+
+    for (CurrentEntry = FIBListHead.Flink;
+         CurrentEntry != &FIBListHead;
+         CurrentEntry = CurrentEntry->Flink) {
+        Current = CONTAINING_RECORD(CurrentEntry, FIB_ENTRY, ListEntry);
+
+        NCE   = Current->Router;
+        State = NCE->State;
+
+        Length = CommonPrefixLength(Destination, &Current->NetworkAddress);
+        MaskLength = AddrCountPrefixBits(&Current->Netmask);
+
+        if (Length >= MaskLength && (Length > BestLength || !BestNCE) &&
+            ((!(State & NUD_STALE) && !(State & NUD_INCOMPLETE)) || !BestNCE)) {
+            BestNCE    = NCE;
+            BestLength = Length;
+        }
+    }
+
+    return BestNCE;
+}
+
+/* What RouterGetRoute must return: longest prefix, reachable, lowest metric */
+static PNEIGHBOR_CACHE_ENTRY ReferenceGetRoute(ULONG Destination)
+{
+    PLIST_ENTRY CurrentEntry;
+    PFIB_ENTRY Current, Best = NULL;
+    UINT Length, BestLength = 0;
+    ULONG Mask;
+    BOOLEAN Reachable, BestReachable = FALSE;
+
+    for (CurrentEntry = FIBListHead.Flink;
+         CurrentEntry != &FIBListHead;
+         CurrentEntry = CurrentEntry->Flink) {
+        Current = CONTAINING_RECORD(CurrentEntry, FIB_ENTRY, ListEntry);
+
+        Length = AddrCountPrefixBits(&Current->Netmask);
+        Mask = Length ? 0xFFFFFFFF << (32 - Length) : 0;
+        if ((Destination & Mask) !=
+            (IPv4NToHl(Current->NetworkAddress.Address.IPv4Address) & Mask))
+            continue;
+
+        Reachable = !(Current->Router->State & (NUD_STALE | NUD_INCOMPLETE));
+        if (!Best || Length > BestLength ||
+            (Length == BestLength &&
+             ((Reachable && !BestReachable) ||
+              (Reachable == BestReachable && Current->Metric < Best->Metric)))) {
+            Best = Current;
+            BestLength = Length;
+            BestReachable = Reachable;
+        }
+    }
+
+    return Best ? Best->Router : NULL;
+}
+
+static VOID AddRoutes(ULONG Count)
+{
+    ULONG Length, Mask;
+    IP_ADDRESS Network, Netmask, RouterAddress;
+    PFIB_ENTRY FIBE;
+
+    RouteCount = 0;
+
+    /* A default route, and random ones from /8 to /32 */
+    while (RouteCount < Count) {
+        Length = RouteCount ? 8 + Random() % 25 : 0;
+        Mask = Length ? 0xFFFFFFFF << (32 - Length) : 0;
+
+        SetAddress(&Network, Random() & Mask);
+        SetAddress(&Netmask, Mask);
+        SetAddress(&RouterAddress, 0x0A000001 + RouteCount);
+
+        /* Duplicates are refused, like by the driver */
+        FIBE = RouterCreateRoute(&Network, &Netmask, &RouterAddress,
+                                 &BenchInterface, Random() % 4);
+        if (!FIBE)
+            continue;
+
+        /* Some routers don't answer */
+        if (Random() % 8 == 0)
+            FIBE->Router->State = NUD_STALE;
+
+        RouteCount++;
+    }
+}
+
+static VOID RemoveRoutes(VOID)
+{
+    PLIST_ENTRY CurrentEntry, NextEntry;
+    PFIB_ENTRY Current;
+    ULONG Index = 0;
+
+    /* Remove every other route, but keep the default one */
+    for (CurrentEntry = FIBListHead.Flink;
+         CurrentEntry != &FIBListHead;
+         CurrentEntry = NextEntry, Index++) {
+        NextEntry = CurrentEntry->Flink;
+        Current = CONTAINING_RECORD(CurrentEntry, FIB_ENTRY, ListEntry);
+
+        if (Index % 2) {
+            if (RouterRemoveRoute(&Current->NetworkAddress, &Current->Router->Address) != STATUS_SUCCESS)
+                printf("Failed to remove route %lu\n", Index);
+        }
+    }
+}
+
+static VOID MakeDestinations(PIP_ADDRESS Destinations, ULONG Count, BOOLEAN Hot)
+{
+    PFIB_ENTRY *Routes;
+    PLIST_ENTRY CurrentEntry;
+    PFIB_ENTRY Route;
+    ULONG i, Host, Total = 0;
+
+    Routes = malloc(RouteCount * sizeof(PFIB_ENTRY));
+    if (!Routes) {
+        printf("Out of memory\n");
+        exit(1);
+    }
+    for (CurrentEntry = FIBListHead.Flink;
+         CurrentEntry != &FIBListHead;
+         CurrentEntry = CurrentEntry->Flink)
+        Routes[Total++] = CONTAINING_RECORD(CurrentEntry, FIB_ENTRY, ListEntry);
+
+    for (i = 0; i < Count; i++) {
+        if (Hot && i >= HOT_DESTINATIONS) {
+            Destinations[i] = Destinations[Random() % HOT_DESTINATIONS];
+            continue;
+        }
+
+        /* Half of them inside a random route */
+        Host = Random();
+        if (i % 2) {
+            Route = Routes[Random() % Total];
+            Host = IPv4NToHl(Route->NetworkAddress.Address.IPv4Address) |
+                   (Host & ~IPv4NToHl(Route->Netmask.Address.IPv4Address));
+        }
+        SetAddress(&Destinations[i], Host);
+    }
+
+    free(Routes);
+}
+
+static ULONG CheckRoutes(PIP_ADDRESS Destinations, ULONG Count)
+{
+    ULONG i, Errors = 0;
+
+    for (i = 0; i < Count; i++) {
+        /* Twice, the second answer comes from the route cache */
+        if (RouterGetRoute(&Destinations[i]) !=
+            ReferenceGetRoute(IPv4NToHl(Destinations[i].Address.IPv4Address)) ||
+            RouterGetRoute(&Destinations[i]) !=
+            ReferenceGetRoute(IPv4NToHl(Destinations[i].Address.IPv4Address)))
+            Errors++;
+    }
+
+    return Errors;
+}
+
+static double TimeLookups(PIP_ADDRESS Destinations, ULONG Count, BOOLEAN Linear)
+{
+    volatile PNEIGHBOR_CACHE_ENTRY NCE;
+    double Start;
+    ULONG i;
+
+    Start = Now();
+    for (i = 0; i < Count; i++)
+        NCE = Linear ? LinearGetRoute(&Destinations[i]) : RouterGetRoute(&Destinations[i]);
+
+    (void)NCE;
+    return (Now() - Start) * 1e9 / Count;
+}
+
+int main(int argc, char **argv)
+{
+    PIP_ADDRESS Destinations;
+    ULONG Lookups = DEFAULT_LOOKUPS;
+    ULONG LinearLookups, Size, Errors, Hot;
+    double Linear, Trie;
+
+    if (argc > 1)
+        Lookups = strtoul(argv[1], NULL, 0);
+    if (Lookups == 0) {
+        printf("Usage: %s [lookups]\n", argv[0]);
+        return 1;
+    }
+
+    Destinations = malloc(Lookups * sizeof(IP_ADDRESS));
+    if (!Destinations) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    printf("%-8s %-8s %14s %14s %8s\n", "routes", "dests", "linear ns/op", "trie ns/op", "speedup");
+
+    Errors = 0;
+    for (Size = 0; Size < sizeof(TableSizes) / sizeof(TableSizes[0]); Size++) {
+        RouterStartup();
+        AddRoutes(TableSizes[Size]);
+
+        for (Hot = 0; Hot < 2; Hot++) {
+            MakeDestinations(Destinations, Lookups, (BOOLEAN)Hot);
+            Errors += CheckRoutes(Destinations, min(Lookups, CHECKED_LOOKUPS));
+
+            /* The linear walk gets a share of the lookups that keeps it short */
+            LinearLookups = min(Lookups, 2000000 / TableSizes[Size] * 10);
+            Linear = TimeLookups(Destinations, LinearLookups, TRUE);
+            Trie = TimeLookups(Destinations, Lookups, FALSE);
+
+            printf("%-8lu %-8s %14.1f %14.1f %7.1fx\n",
+                   RouteCount, Hot ? "hot" : "random", Linear, Trie, Linear / Trie);
+        }
+
+        /* Check the trie after removals too */
+        RemoveRoutes();
+        MakeDestinations(Destinations, min(Lookups, CHECKED_LOOKUPS), FALSE);
+        Errors += CheckRoutes(Destinations, min(Lookups, CHECKED_LOOKUPS));
+
+        RouterShutdown();
+    }
+
+    printf("%lu lookups did not find the expected route\n", Errors);
+
+    free(Destinations);
+    return Errors != 0;
+}
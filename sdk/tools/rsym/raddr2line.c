@@ -1,5 +1,6 @@
 /*
- * Usage: raddr2line input-file address/offset
+ * Usage: raddr2line input-file address/offset [address/offset ...]
+ *        raddr2line input-file - (addresses/offsets on stdin)
  *
  * This is a tool and is compiled using the host compiler,
  * i.e. on Linux gcc and not mingw-gcc (cross-compiler).
@@ -76,32 +77,21 @@ find_and_print_offset (
 	PROSSYM_ENTRY Entries = (PROSSYM_ENTRY)((char*)data + RosSymHeader->SymbolsOffset);
 	char* Strings = (char*)data + RosSymHeader->StringsOffset;
 	size_t symbols = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
-	size_t i;
+	PROSSYM_ENTRY e;
 
-	//if ( RosSymHeader->SymbolsOffset )
+	e = find_rossym_entry ( Entries, symbols, offset );
+	if ( !e )
+		return 1;
 
-	for ( i = 0; i < symbols; i++ )
-	{
-		if ( Entries[i].Address > offset )
-		{
-			if ( !i-- )
-				return 1;
-			else
-			{
-				PROSSYM_ENTRY e = &Entries[i];
-				printf ( "%s:%u (%s)\n",
-					&Strings[e->FileOffset],
-					(unsigned int)e->SourceLine,
-					&Strings[e->FunctionOffset] );
-				return 0;
-			}
-		}
-	}
-	return 1;
+	printf ( "%s:%u (%s)\n",
+		&Strings[e->FileOffset],
+		(unsigned int)e->SourceLine,
+		&Strings[e->FunctionOffset] );
+	return 0;
 }
 
 int
-process_data ( const void* FileData, size_t offset )
+process_data ( const void* FileData, const char** offsets, int count )
 {
 	PIMAGE_DOS_HEADER PEDosHeader;
 	PIMAGE_FILE_HEADER PEFileHeader;
@@ -109,7 +99,9 @@ process_data ( const void* FileData, size_t offset )
 	PIMAGE_SECTION_HEADER PESectionHeaders;
 	PIMAGE_SECTION_HEADER PERosSymSectionHeader;
 	size_t ImageBase;
-	int res;
+	char* RosSymData;
+	char Line[256];
+	int i, res = 0;
 
 	/* Check if MZ header exists  */
 	PEDosHeader = (PIMAGE_DOS_HEADER)FileData;
@@ -130,9 +122,6 @@ process_data ( const void* FileData, size_t offset )
 	/* Locate PE section headers  */
 	PESectionHeaders = (PIMAGE_SECTION_HEADER)((char *) PEOptHeader + PEFileHeader->SizeOfOptionalHeader);
 
-	/* make sure offset is what we want */
-	offset = fixup_offset ( ImageBase, offset );
-
 	/* find rossym section */
 	PERosSymSectionHeader = find_rossym_section (
 		PEFileHeader, PESectionHeaders );
@@ -141,29 +130,53 @@ process_data ( const void* FileData, size_t offset )
 		fprintf ( stderr, "Couldn't find rossym section in executable\n" );
 		return 1;
 	}
-	res = find_and_print_offset ( (char*)FileData + PERosSymSectionHeader->PointerToRawData,
-		offset );
-	if ( res )
-		printf ( "??:0\n" );
+	RosSymData = (char*)FileData + PERosSymSectionHeader->PointerToRawData;
+
+	/* "-" reads the offsets from stdin, one per line, in a single pass */
+	if ( count == 1 && strcmp ( offsets[0], "-" ) == 0 )
+	{
+		while ( fgets ( Line, sizeof(Line), stdin ) )
+		{
+			/* make sure offset is what we want */
+			if ( find_and_print_offset ( RosSymData,
+				fixup_offset ( ImageBase, my_atoi ( Line ) ) ) )
+			{
+				printf ( "??:0\n" );
+				res = 1;
+			}
+		}
+		return res;
+	}
+
+	for ( i = 0; i < count; i++ )
+	{
+		/* make sure offset is what we want */
+		if ( find_and_print_offset ( RosSymData,
+			fixup_offset ( ImageBase, my_atoi ( offsets[i] ) ) ) )
+		{
+			printf ( "??:0\n" );
+			res = 1;
+		}
+	}
 	return res;
 }
 
 int
-process_file ( const char* file_name, size_t offset )
+process_file ( const char* file_name, const char** offsets, int count )
 {
 	void* FileData;
 	size_t FileSize;
 	int res = 1;
 
-	FileData = load_file ( file_name, &FileSize );
+	FileData = map_file ( file_name, &FileSize );
 	if ( !FileData )
 	{
 		fprintf ( stderr, "An error occured loading '%s'\n", file_name );
 	}
 	else
 	{
-		res = process_data ( FileData, offset );
-		free ( FileData );
+		res = process_data ( FileData, offsets, count );
+		unmap_file ( FileData, FileSize );
 	}
 
 	return res;
@@ -172,19 +185,18 @@ process_file ( const char* file_name, size_t offset )
 int main ( int argc, const char** argv )
 {
 	char* path;
-	size_t offset;
 	int res;
 
-	if ( argc != 3 )
+	if ( argc < 3 )
 	{
-		fprintf(stderr, "Usage: raddr2line <exefile> <offset>\n");
+		fprintf(stderr, "Usage: raddr2line <exefile> <offset> [<offset> ...]\n");
+		fprintf(stderr, "       raddr2line <exefile> - (reads the offsets from stdin)\n");
 		exit(1);
 	}
 
 	path = convert_path ( argv[1] );
-	offset = my_atoi ( argv[2] );
 
-	res = process_file ( path, offset );
+	res = process_file ( path, argv + 2, argc - 2 );
 
 	free ( path );
 
@@ -4,6 +4,13 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "rsym.h"
 
 char*
@@ -60,3 +67,70 @@ load_file ( const char* file_name, size_t* file_size )
 	}
 	return FileData;
 }
+
+/* Map a file read-only, the tools translating many addresses keep it mapped */
+void*
+map_file ( const char* file_name, size_t* file_size )
+{
+#ifdef _WIN32
+	return load_file ( file_name, file_size );
+#else
+	struct stat st;
+	void* FileData;
+	int fd;
+
+	fd = open ( file_name, O_RDONLY );
+	if ( fd < 0 )
+		return NULL;
+
+	if ( fstat ( fd, &st ) != 0 || st.st_size == 0 )
+	{
+		close ( fd );
+		return NULL;
+	}
+
+	FileData = mmap ( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close ( fd );
+	if ( FileData == MAP_FAILED )
+		return NULL;
+
+	*file_size = st.st_size;
+	return FileData;
+#endif
+}
+
+void
+unmap_file ( void* file_data, size_t file_size )
+{
+#ifdef _WIN32
+	free ( file_data );
+#else
+	munmap ( file_data, file_size );
+#endif
+}
+
+/*
+ * The entries are sorted by address, rsym sorts them. Return the last one
+ * at or below the offset, or NULL when the offset is before the first entry
+ * or past the last one, like the linear scan that this replaces.
+ */
+PROSSYM_ENTRY
+find_rossym_entry ( PROSSYM_ENTRY Entries, size_t Count, size_t offset )
+{
+	size_t low = 0, high = Count, mid;
+
+	/* Find the first entry above the offset */
+	while ( low < high )
+	{
+		mid = low + ( high - low ) / 2;
+		if ( Entries[mid].Address > offset )
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	if ( low == 0 || low == Count )
+		return NULL;
+
+	return &Entries[low - 1];
+}
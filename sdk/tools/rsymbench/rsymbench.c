@@ -0,0 +1,261 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL - See COPYING in the top level directory
+ * PURPOSE:     Symbol lookup benchmark for log2lines and raddr2line
+ *
+ * Writes an image with a .rossym section the size of the one of ntoskrnl,
+ * and a debug log of a million lines with backtrace addresses in it, so
+ * that the whole translation can be timed with log2lines -d <directory>.
+ * Then times find_rossym_entry against the linear scan of the symbols
+ * that both tools used to do, for the addresses of the log, and checks
+ * that both find the same symbol every time.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "rsym.h"
+
+#define DEFAULT_SYMBOLS     200000
+#define DEFAULT_LINES       1000000
+#define LINEAR_LINES        10000
+#define SYMBOLS_PER_FUNC    16
+#define FUNCS_PER_FILE      24
+#define IMAGE_NAME          "rsymbench.exe"
+#define LOG_NAME            "rsymbench.log"
+#define IMAGE_BASE          0x00400000
+
+static ULONG Seed = 1;
+
+static ULONG Random(void)
+{
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 16) | ((Seed * 1103515245 + 12345) & 0xFFFF0000);
+}
+
+static double Now(void)
+{
+    struct timespec Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+/* The symbol lookup before the binary search */
+static PROSSYM_ENTRY LinearFindEntry(PROSSYM_ENTRY Entries, size_t Count, size_t offset)
+{
+    size_t i;
+
+    for (i = 0; i < Count; i++)
+    {
+        if (Entries[i].Address > offset)
+        {
+            if (!i--)
+                return NULL;
+            else
+                return &Entries[i];
+        }
+    }
+    return NULL;
+}
+
+/* Build the .rossym section: header, sorted entries and strings */
+static char *MakeRosSym(ULONG Symbols, ULONG *Size)
+{
+    PSYMBOLFILE_HEADER Header;
+    PROSSYM_ENTRY Entries;
+    char *Data, *Strings;
+    ULONG i, StringsLength = 0, FileOffset = 0, FunctionOffset = 0;
+    TARGET_ULONG_PTR Address = 0x1000;
+    size_t StringsMax = (size_t)Symbols * 48 + 64;
+
+    Data = malloc(sizeof(SYMBOLFILE_HEADER) + Symbols * sizeof(ROSSYM_ENTRY) + StringsMax);
+    if (!Data)
+        return NULL;
+
+    Header = (PSYMBOLFILE_HEADER)Data;
+    Entries = (PROSSYM_ENTRY)(Header + 1);
+    Strings = (char *)(Entries + Symbols);
+
+    /* Offset 0 is the empty string */
+    Strings[StringsLength++] = '\0';
+
+    for (i = 0; i < Symbols; i++)
+    {
+        if (i % (SYMBOLS_PER_FUNC * FUNCS_PER_FILE) == 0)
+        {
+            FileOffset = StringsLength;
+            StringsLength += sprintf(Strings + StringsLength, "ntoskrnl/mod%u/file%u.c",
+                                     (unsigned int)(i / 50000), (unsigned int)i) + 1;
+        }
+        if (i % SYMBOLS_PER_FUNC == 0)
+        {
+            FunctionOffset = StringsLength;
+            StringsLength += sprintf(Strings + StringsLength, "Function%u", (unsigned int)i) + 1;
+        }
+
+        Address += 1 + Random() % 32;
+        Entries[i].Address = Address;
+        Entries[i].FunctionOffset = FunctionOffset;
+        Entries[i].FileOffset = FileOffset;
+        Entries[i].SourceLine = 1 + i % 3000;
+    }
+
+    Header->SymbolsOffset = sizeof(SYMBOLFILE_HEADER);
+    Header->SymbolsLength = Symbols * sizeof(ROSSYM_ENTRY);
+    Header->StringsOffset = Header->SymbolsOffset + Header->SymbolsLength;
+    Header->StringsLength = StringsLength;
+
+    *Size = Header->StringsOffset + StringsLength;
+    return Data;
+}
+
+static int WriteImage(const char *Path, const char *RosSym, ULONG RosSymSize)
+{
+    IMAGE_DOS_HEADER DosHeader;
+    IMAGE_FILE_HEADER FileHeader;
+    IMAGE_OPTIONAL_HEADER OptHeader;
+    IMAGE_SECTION_HEADER Section;
+    ULONG Signature = IMAGE_PE_MAGIC;
+    ULONG HeadersSize;
+    FILE *f;
+
+    HeadersSize = sizeof(DosHeader) + sizeof(Signature) + sizeof(FileHeader) +
+                  sizeof(OptHeader) + sizeof(Section);
+
+    memset(&DosHeader, 0, sizeof(DosHeader));
+    DosHeader.e_magic = IMAGE_DOS_MAGIC;
+    DosHeader.e_lfanew = sizeof(DosHeader);
+
+    memset(&FileHeader, 0, sizeof(FileHeader));
+    FileHeader.Machine = IMAGE_FILE_MACHINE_I386;
+    FileHeader.NumberOfSections = 1;
+    FileHeader.SizeOfOptionalHeader = sizeof(OptHeader);
+
+    memset(&OptHeader, 0, sizeof(OptHeader));
+    OptHeader.Magic = IMAGE_NT_OPTIONAL_HDR32_MAGIC;
+    OptHeader.ImageBase = IMAGE_BASE;
+    OptHeader.SizeOfHeaders = HeadersSize;
+
+    memset(&Section, 0, sizeof(Section));
+    strcpy((char *)Section.Name, ".rossym");
+    Section.SizeOfRawData = RosSymSize;
+    Section.PointerToRawData = HeadersSize;
+
+    f = fopen(Path, "wb");
+    if (!f)
+        return 1;
+
+    fwrite(&DosHeader, sizeof(DosHeader), 1, f);
+    fwrite(&Signature, sizeof(Signature), 1, f);
+    fwrite(&FileHeader, sizeof(FileHeader), 1, f);
+    fwrite(&OptHeader, sizeof(OptHeader), 1, f);
+    fwrite(&Section, sizeof(Section), 1, f);
+    fwrite(RosSym, RosSymSize, 1, f);
+
+    return fclose(f) != 0;
+}
+
+/* Three lines out of four have an address, like a log full of backtraces */
+static int WriteLog(const char *Path, size_t *Offsets, ULONG Lines, TARGET_ULONG_PTR Last)
+{
+    ULONG i;
+    FILE *f;
+
+    f = fopen(Path, "w");
+    if (!f)
+        return 1;
+
+    for (i = 0; i < Lines; i++)
+    {
+        Offsets[i] = Random() % (Last + 0x100);
+        if (i % 4 == 3)
+            fprintf(f, "(ntoskrnl/ke/bug.c:%u) Frame %u\n", (unsigned int)(i % 1000), (unsigned int)i);
+        else
+            fprintf(f, "<" IMAGE_NAME ":%x>\n", (unsigned int)Offsets[i]);
+    }
+
+    return fclose(f) != 0;
+}
+
+int main(int argc, const char **argv)
+{
+    const char *Directory = ".";
+    ULONG Symbols = DEFAULT_SYMBOLS, Lines = DEFAULT_LINES;
+    ULONG RosSymSize, i, Errors = 0, LinearLines;
+    char Path[1024];
+    char *RosSym;
+    PSYMBOLFILE_HEADER Header;
+    PROSSYM_ENTRY Entries;
+    size_t *Offsets;
+    volatile PROSSYM_ENTRY Entry;
+    double Start, Linear, Binary;
+
+    if (argc > 1)
+        Directory = argv[1];
+    if (argc > 2)
+        Symbols = strtoul(argv[2], NULL, 0);
+    if (argc > 3)
+        Lines = strtoul(argv[3], NULL, 0);
+    if (argc > 4 || Symbols == 0 || Lines == 0)
+    {
+        printf("Usage: %s [directory] [symbols] [lines]\n", argv[0]);
+        return 1;
+    }
+
+    RosSym = MakeRosSym(Symbols, &RosSymSize);
+    Offsets = malloc(Lines * sizeof(size_t));
+    if (!RosSym || !Offsets)
+    {
+        printf("Out of memory\n");
+        return 1;
+    }
+    Header = (PSYMBOLFILE_HEADER)RosSym;
+    Entries = (PROSSYM_ENTRY)(RosSym + Header->SymbolsOffset);
+
+    snprintf(Path, sizeof(Path), "%s/" IMAGE_NAME, Directory);
+    if (WriteImage(Path, RosSym, RosSymSize))
+    {
+        printf("Cannot write %s\n", Path);
+        return 1;
+    }
+    snprintf(Path, sizeof(Path), "%s/" LOG_NAME, Directory);
+    if (WriteLog(Path, Offsets, Lines, Entries[Symbols - 1].Address))
+    {
+        printf("Cannot write %s\n", Path);
+        return 1;
+    }
+    printf("Wrote %s/%s with %lu symbols and %s with %lu lines\n",
+           Directory, IMAGE_NAME, Symbols, Path, Lines);
+
+    /* The linear scan only gets a share of the lines that keeps it short */
+    LinearLines = Lines < LINEAR_LINES ? Lines : LINEAR_LINES;
+    for (i = 0; i < LinearLines; i++)
+    {
+        if (find_rossym_entry(Entries, Symbols, Offsets[i]) !=
+            LinearFindEntry(Entries, Symbols, Offsets[i]))
+            Errors++;
+    }
+
+    Start = Now();
+    for (i = 0; i < LinearLines; i++)
+        Entry = LinearFindEntry(Entries, Symbols, Offsets[i]);
+    Linear = (Now() - Start) * 1e9 / LinearLines;
+
+    Start = Now();
+    for (i = 0; i < Lines; i++)
+        Entry = find_rossym_entry(Entries, Symbols, Offsets[i]);
+    Binary = (Now() - Start) * 1e9 / Lines;
+    (void)Entry;
+
+    printf("%-10s %14s %14s %8s\n", "symbols", "linear ns/op", "binary ns/op", "speedup");
+    printf("%-10lu %14.1f %14.1f %7.0fx\n", Symbols, Linear, Binary, Linear / Binary);
+    printf("%lu lookups did not find the expected symbol\n", Errors);
+    printf("Translate the whole log with: log2lines -d %s < %s\n", Directory, Path);
+
+    free(Offsets);
+    free(RosSym);
+    return Errors != 0;
+}
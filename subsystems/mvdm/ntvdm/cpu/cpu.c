@@ -37,6 +37,8 @@
 /* PRIVATE VARIABLES **********************************************************/
 
 FAST486_STATE EmulatorContext;
+static FAST486_TLB EmulatorTlb;
+static FAST486_CODE_CACHE EmulatorCodeCache;
 BOOLEAN CpuRunning = FALSE;
 
 /* No more than 'MaxCpuCallLevel' recursive CPU calls are allowed */
@@ -231,7 +233,8 @@ BOOLEAN CpuInitialize(VOID)
                       EmulatorBiosOperation,
                       EmulatorIntAcknowledge,
                       EmulatorFpu,
-                      NULL /* TODO: Use a TLB */);
+                      &EmulatorTlb,
+                      &EmulatorCodeCache);
 
     /* Initialize the software callback system and register the emulator BOPs */
     // RegisterBop(BOP_DEBUGGER  , EmulatorDebugBreakBop);
@@ -185,7 +185,8 @@ VOID FASTCALL EmulatorWriteMemory(PFAST486_STATE State, ULONG Address, PVOID Buf
     ULONG i, Offset, Length;
     ULONG FirstPage, LastPage;
 
-    UNREFERENCED_PARAMETER(State);
+    /* The host also writes here, maybe over code the CPU has already decoded */
+    Fast486InvalidateCodeCache(State, Address, Size);
 
     /* If the A20 line is disabled, mask bit 20 */
     if (!A20Line) Address &= ~(1 << 20);
@@ -271,6 +272,9 @@ VOID FASTCALL EmulatorCopyMemory(PFAST486_STATE State, ULONG DestAddress, ULONG
 
 VOID EmulatorSetA20(BOOLEAN Enabled)
 {
+    /* The code above 1 MB changes */
+    if (A20Line != Enabled) Fast486InvalidateCodeCache(&EmulatorContext, 0, MAXULONG);
+
     A20Line = Enabled;
 }
 
@@ -343,6 +347,9 @@ MemInstallFastMemoryHook(PVOID Address,
     /* Add the hook entry to the page table */
     for (i = FirstPage; i <= LastPage; i++) PageTable[i] = Hook;
 
+    /* The memory there is now a different one */
+    Fast486InvalidateCodeCache(&EmulatorContext, FirstPage << 12, (LastPage - FirstPage + 1) << 12);
+
     return TRUE;
 }
 
@@ -371,6 +378,9 @@ MemRemoveFastMemoryHook(PVOID Address, ULONG Size)
         PageTable[i] = NULL;
     }
 
+    /* The memory there is now a different one */
+    Fast486InvalidateCodeCache(&EmulatorContext, FirstPage << 12, (LastPage - FirstPage + 1) << 12);
+
     return TRUE;
 }
 
@@ -539,6 +549,9 @@ VDDInstallMemoryHook(IN HANDLE hVdd,
     /* Add the hook entry to the page table */
     for (i = FirstPage; i <= LastPage; i++) PageTable[i] = Hook;
 
+    /* The memory there is now a different one */
+    Fast486InvalidateCodeCache(&EmulatorContext, FirstPage << 12, (LastPage - FirstPage + 1) << 12);
+
     return TRUE;
 }
 
@@ -595,6 +608,9 @@ VDDDeInstallMemoryHook(IN HANDLE hVdd,
         PageTable[i] = NULL;
     }
 
+    /* The memory there is now a different one */
+    Fast486InvalidateCodeCache(&EmulatorContext, FirstPage << 12, (LastPage - FirstPage + 1) << 12);
+
     return TRUE;
 }
 
@@ -689,7 +705,12 @@ VDDFreeMem(IN HANDLE hVdd,
                                  &Address,
                                  &RealSize,
                                  MEM_DECOMMIT);
-    return NT_SUCCESS(Status);
+    if (!NT_SUCCESS(Status)) return FALSE;
+
+    /* The memory there is now a different one */
+    Fast486InvalidateCodeCache(&EmulatorContext, FirstPage << 12, (LastPage - FirstPage + 1) << 12);
+
+    return TRUE;
 }
 
 BOOL
@@ -121,3 +121,158 @@ DIB_XXBPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
   return TRUE;
 }
 
+
+/*
+ * Scanline blenders for unstretched 32bpp sources.
+ *
+ * They give exactly the same results as the per-pixel loops, but work on two
+ * 8-bit channels per 32-bit operation and skip transparent and opaque pixels.
+ * We can't use SSE here, the FPU state saved in kernel mode doesn't cover it.
+ */
+
+/* Divide two 16-bit lanes by 255, exact for products of 8-bit values */
+static __inline ULONG
+Div255x2(ULONG val)
+{
+  val += 0x00010001 + ((val >> 8) & 0x00FF00FF);
+  return (val >> 8) & 0x00FF00FF;
+}
+
+/* Multiply every channel of a pixel by alpha / 255 */
+static __inline ULONG
+ScalePixel32(ULONG Pixel, ULONG Alpha)
+{
+  return Div255x2((Pixel & 0x00FF00FF) * Alpha) |
+         (Div255x2(((Pixel >> 8) & 0x00FF00FF) * Alpha) << 8);
+}
+
+/* Add two pixels channel by channel, clamping every channel to 255 */
+static __inline ULONG
+AddSaturate32(ULONG Pixel1, ULONG Pixel2)
+{
+  ULONG rb, ag, Carry;
+
+  rb = (Pixel1 & 0x00FF00FF) + (Pixel2 & 0x00FF00FF);
+  Carry = rb & 0x01000100;
+  rb = (rb | (Carry - (Carry >> 8))) & 0x00FF00FF;
+
+  ag = ((Pixel1 >> 8) & 0x00FF00FF) + ((Pixel2 >> 8) & 0x00FF00FF);
+  Carry = ag & 0x01000100;
+  ag = (ag | (Carry - (Carry >> 8))) & 0x00FF00FF;
+
+  return rb | (ag << 8);
+}
+
+VOID
+DIB_BlendScanline32To32(PULONG Dst, CONST ULONG *Src, ULONG Count,
+                        BLENDFUNCTION BlendFunc)
+{
+  ULONG SrcPixel, Alpha, ConstAlpha = BlendFunc.SourceConstantAlpha;
+
+  if ((BlendFunc.AlphaFormat & AC_SRC_ALPHA) == 0)
+  {
+    /* The destination weight is the same for the whole line */
+    while (Count--)
+    {
+      *Dst = AddSaturate32(ScalePixel32(*Dst, 255 - ConstAlpha),
+                           ScalePixel32(*Src++, ConstAlpha));
+      Dst++;
+    }
+    return;
+  }
+
+  while (Count--)
+  {
+    SrcPixel = *Src++;
+    if (ConstAlpha != 255)
+      SrcPixel = ScalePixel32(SrcPixel, ConstAlpha);
+
+    Alpha = SrcPixel >> 24;
+    if (Alpha == 255)
+      *Dst = SrcPixel;
+    else if (SrcPixel != 0)
+      *Dst = AddSaturate32(ScalePixel32(*Dst, 255 - Alpha), SrcPixel);
+    Dst++;
+  }
+}
+
+VOID
+DIB_BlendScanline32To24(PUCHAR Dst, CONST ULONG *Src, ULONG Count,
+                        BLENDFUNCTION BlendFunc)
+{
+  ULONG SrcPixel, DstPixel, Alpha, ConstAlpha = BlendFunc.SourceConstantAlpha;
+
+  while (Count--)
+  {
+    SrcPixel = *Src++;
+    if (ConstAlpha != 255)
+      SrcPixel = ScalePixel32(SrcPixel, ConstAlpha);
+
+    Alpha = (BlendFunc.AlphaFormat & AC_SRC_ALPHA) ? (SrcPixel >> 24) : ConstAlpha;
+    if (Alpha == 255)
+    {
+      DstPixel = SrcPixel;
+    }
+    else if ((SrcPixel & 0x00FFFFFF) == 0 && Alpha == 0)
+    {
+      Dst += 3;
+      continue;
+    }
+    else
+    {
+      DstPixel = Dst[0] | (Dst[1] << 8) | (Dst[2] << 16);
+      DstPixel = AddSaturate32(ScalePixel32(DstPixel, 255 - Alpha), SrcPixel & 0x00FFFFFF);
+    }
+
+    *Dst++ = (UCHAR)DstPixel;
+    *Dst++ = (UCHAR)(DstPixel >> 8);
+    *Dst++ = (UCHAR)(DstPixel >> 16);
+  }
+}
+
+/* The source is BGR, the destination 5-5-5 or 5-6-5, as in DIB_16BPP_AlphaBlend */
+VOID
+DIB_BlendScanline32To16(PUSHORT Dst, CONST ULONG *Src, ULONG Count,
+                        BLENDFUNCTION BlendFunc, BOOLEAN Is555)
+{
+  ULONG SrcPixel, DstPixel, Alpha, Alpha5, Alpha6, Red, Green, Blue;
+  ULONG ConstAlpha = BlendFunc.SourceConstantAlpha;
+
+  while (Count--)
+  {
+    SrcPixel = *Src++;
+    if (ConstAlpha != 255)
+      SrcPixel = ScalePixel32(SrcPixel, ConstAlpha);
+
+    Alpha = (BlendFunc.AlphaFormat & AC_SRC_ALPHA) ? (SrcPixel >> 24) : ConstAlpha;
+    Alpha5 = Alpha >> 3;
+    Red = (SrcPixel >> 19) & 0x1F;
+    Blue = (SrcPixel >> 3) & 0x1F;
+    DstPixel = *Dst;
+
+    if (Is555)
+    {
+      Green = (SrcPixel >> 11) & 0x1F;
+      if (Alpha5 != 0 || Red != 0 || Green != 0 || Blue != 0)
+      {
+        Red = min(((DstPixel >> 10) & 0x1F) * (31 - Alpha5) / 31 + Red, 31);
+        Green = min(((DstPixel >> 5) & 0x1F) * (31 - Alpha5) / 31 + Green, 31);
+        Blue = min((DstPixel & 0x1F) * (31 - Alpha5) / 31 + Blue, 31);
+        *Dst = (USHORT)((DstPixel & 0x8000) | (Red << 10) | (Green << 5) | Blue);
+      }
+    }
+    else
+    {
+      Alpha6 = Alpha >> 2;
+      Green = (SrcPixel >> 10) & 0x3F;
+      if (Alpha6 != 0 || Red != 0 || Green != 0 || Blue != 0)
+      {
+        Red = min((DstPixel >> 11) * (31 - Alpha5) / 31 + Red, 31);
+        Green = min(((DstPixel >> 5) & 0x3F) * (63 - Alpha6) / 63 + Green, 63);
+        Blue = min((DstPixel & 0x1F) * (31 - Alpha5) / 31 + Blue, 31);
+        *Dst = (USHORT)((Red << 11) | (Green << 5) | Blue);
+      }
+    }
+    Dst++;
+  }
+}
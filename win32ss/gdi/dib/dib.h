@@ -126,6 +126,9 @@ BOOLEAN DIB_32BPP_AlphaBlend(SURFOBJ*, SURFOBJ*, RECTL*, RECTL*, CLIPOBJ*, XLATE
 BOOLEAN DIB_XXBPP_StretchBlt(SURFOBJ*,SURFOBJ*,SURFOBJ*,SURFOBJ*,RECTL*,RECTL*,POINTL*,BRUSHOBJ*,POINTL*,XLATEOBJ*,ROP4);
 BOOLEAN DIB_XXBPP_FloodFillSolid(SURFOBJ*, BRUSHOBJ*, RECTL*, POINTL*, ULONG, UINT);
 BOOLEAN DIB_XXBPP_AlphaBlend(SURFOBJ*, SURFOBJ*, RECTL*, RECTL*, CLIPOBJ*, XLATEOBJ*, BLENDOBJ*);
+VOID DIB_BlendScanline32To32(PULONG, CONST ULONG*, ULONG, BLENDFUNCTION);
+VOID DIB_BlendScanline32To24(PUCHAR, CONST ULONG*, ULONG, BLENDFUNCTION);
+VOID DIB_BlendScanline32To16(PUSHORT, CONST ULONG*, ULONG, BLENDFUNCTION, BOOLEAN);
 
 extern unsigned char notmask[2];
 extern unsigned char altnotmask[2];
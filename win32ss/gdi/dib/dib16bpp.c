@@ -618,6 +618,28 @@ DIB_16BPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
   }
 
   pexlo = CONTAINING_RECORD(ColorTranslation, EXLATEOBJ, xlo);
+
+  /* Blend whole scanlines when the source is plain BGRA and needs no stretching */
+  if (Source->iBitmapFormat == BMF_32BPP &&
+      (pexlo->ppalSrc->flFlags & PAL_BGR) &&
+      SourceRect->right - SourceRect->left == DestRect->right - DestRect->left &&
+      SourceRect->bottom - SourceRect->top == DestRect->bottom - DestRect->top)
+  {
+    PUSHORT Dst = (PUSHORT)((ULONG_PTR)Dest->pvScan0 + (DestRect->top * Dest->lDelta) +
+      (DestRect->left << 1));
+    PULONG Src = (PULONG)((ULONG_PTR)Source->pvScan0 + (SourceRect->top * Source->lDelta) +
+      (SourceRect->left << 2));
+    BOOLEAN Is555 = (pexlo->ppalDst->flFlags & PAL_RGB16_555) != 0;
+
+    for (DstY = DestRect->top; DstY < DestRect->bottom; DstY++)
+    {
+      DIB_BlendScanline32To16(Dst, Src, DestRect->right - DestRect->left, BlendFunc, Is555);
+      Dst = (PUSHORT)((ULONG_PTR)Dst + Dest->lDelta);
+      Src = (PULONG)((ULONG_PTR)Src + Source->lDelta);
+    }
+    return TRUE;
+  }
+
   EXLATEOBJ_vInitialize(&exloSrcRGB, pexlo->ppalSrc, &gpalRGB, 0, 0, 0);
 
   if (pexlo->ppalDst->flFlags & PAL_RGB16_555)
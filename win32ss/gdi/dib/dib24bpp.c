@@ -503,6 +503,24 @@ DIB_24BPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
                              (DestRect->left * 3));
    //SrcBpp = BitsPerFormat(Source->iBitmapFormat);
 
+   /* Blend whole scanlines when the source needs no stretching nor translation */
+   if (Source->iBitmapFormat == BMF_32BPP &&
+       (!ColorTranslation || (ColorTranslation->flXlate & XO_TRIVIAL)) &&
+       SourceRect->right - SourceRect->left == DestRect->right - DestRect->left &&
+       SourceRect->bottom - SourceRect->top == DestRect->bottom - DestRect->top)
+   {
+      PULONG Src = (PULONG)((ULONG_PTR)Source->pvScan0 + (SourceRect->top * Source->lDelta) +
+                            (SourceRect->left << 2));
+
+      for (Rows = DestRect->bottom - DestRect->top; Rows > 0; Rows--)
+      {
+         DIB_BlendScanline32To24(Dst, Src, DestRect->right - DestRect->left, BlendFunc);
+         Dst += Dest->lDelta;
+         Src = (PULONG)((ULONG_PTR)Src + Source->lDelta);
+      }
+      return TRUE;
+   }
+
    Rows = 0;
    SrcY = SourceRect->top;
    while (++Rows <= DestRect->bottom - DestRect->top)
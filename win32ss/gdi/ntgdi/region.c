@@ -405,6 +405,77 @@ typedef struct _SCANLINE_LISTBLOCK
 #define LARGE_COORDINATE  0x7fffffff /* FIXME */
 #define SMALL_COORDINATE  0x80000000
 
+/* Rect buffers up to this size come from a lookaside list. Clipping creates
+   and destroys lots of small regions, most of them fit in there. */
+#define RGN_LOOKASIDE_RECTS 16
+
+static PPAGED_LOOKASIDE_LIST gpRgnBufferLookasideList;
+
+INIT_FUNCTION
+NTSTATUS
+NTAPI
+InitRegionImpl(VOID)
+{
+    gpRgnBufferLookasideList = ExAllocatePoolWithTag(NonPagedPool,
+                                                     sizeof(PAGED_LOOKASIDE_LIST),
+                                                     TAG_REGION);
+    if (gpRgnBufferLookasideList == NULL)
+        return STATUS_NO_MEMORY;
+
+    ExInitializePagedLookasideList(gpRgnBufferLookasideList,
+                                   NULL,
+                                   NULL,
+                                   0,
+                                   RGN_LOOKASIDE_RECTS * sizeof(RECTL),
+                                   TAG_REGION,
+                                   64);
+
+    return STATUS_SUCCESS;
+}
+
+/* Allocate a rect buffer, small sizes are rounded up to the lookaside size */
+static
+PRECTL
+REGION_pAllocRects(
+    _Inout_ PULONG pcjSize)
+{
+    if (*pcjSize <= RGN_LOOKASIDE_RECTS * sizeof(RECTL))
+    {
+        *pcjSize = RGN_LOOKASIDE_RECTS * sizeof(RECTL);
+        return ExAllocateFromPagedLookasideList(gpRgnBufferLookasideList);
+    }
+
+    return ExAllocatePoolWithTag(PagedPool, *pcjSize, TAG_REGION);
+}
+
+/* Free a rect buffer, cjSize is the size returned by REGION_pAllocRects */
+static
+VOID
+REGION_vFreeRects(
+    _In_ PRECTL prcl,
+    _In_ ULONG cjSize)
+{
+    if (cjSize <= RGN_LOOKASIDE_RECTS * sizeof(RECTL))
+    {
+        ExFreeToPagedLookasideList(gpRgnBufferLookasideList, prcl);
+    }
+    else
+    {
+        ExFreePoolWithTag(prcl, TAG_REGION);
+    }
+}
+
+static
+VOID
+REGION_vFreeBuffer(
+    _Inout_ PREGION prgn)
+{
+    if ((prgn->Buffer != NULL) && (prgn->Buffer != &prgn->rdh.rcBound))
+    {
+        REGION_vFreeRects(prgn->Buffer, prgn->rdh.nRgnSize);
+    }
+}
+
 static
 BOOL
 REGION_bGrowBufferSize(
@@ -433,7 +504,7 @@ REGION_bGrowBufferSize(
     }
 
     /* Allocate the new buffer */
-    pvBuffer = ExAllocatePoolWithTag(PagedPool, cjNewSize, TAG_REGION);
+    pvBuffer = REGION_pAllocRects(&cjNewSize);
     if (pvBuffer == NULL)
     {
         return FALSE;
@@ -443,10 +514,7 @@ REGION_bGrowBufferSize(
     COPY_RECTS(pvBuffer, prgn->Buffer, prgn->rdh.nCount);
 
     /* Free the old buffer */
-    if (prgn->Buffer != &prgn->rdh.rcBound)
-    {
-        ExFreePoolWithTag(prgn->Buffer, TAG_REGION);
-    }
+    REGION_vFreeBuffer(prgn);
 
     /* Set the new buffer */
     prgn->Buffer = pvBuffer;
@@ -509,6 +577,68 @@ REGION_bAddRect(
     return TRUE;
 }
 
+/*
+ * The rects of a region are sorted by bands and all rects of a band share
+ * top and bottom, so both the band for a y coordinate and the rect for
+ * an x coordinate inside a band can be found with a binary search.
+ */
+
+/* Returns the first rect whose band ends below y */
+static
+PRECTL
+REGION_pFindBand(
+    _In_ PRECTL prcl,
+    _In_ PRECTL prclEnd,
+    _In_ LONG y)
+{
+    SIZE_T cRects = prclEnd - prcl, cHalf;
+
+    while (cRects > 0)
+    {
+        cHalf = cRects / 2;
+        if (prcl[cHalf].bottom <= y)
+        {
+            prcl += cHalf + 1;
+            cRects -= cHalf + 1;
+        }
+        else
+        {
+            cRects = cHalf;
+        }
+    }
+
+    return prcl;
+}
+
+/* Returns the first rect in the band of prcl that ends right of x,
+   or the first rect of the next band */
+static
+PRECTL
+REGION_pFindRectInBand(
+    _In_ PRECTL prcl,
+    _In_ PRECTL prclEnd,
+    _In_ LONG x)
+{
+    SIZE_T cRects = prclEnd - prcl, cHalf;
+    LONG top = prcl->top;
+
+    while (cRects > 0)
+    {
+        cHalf = cRects / 2;
+        if ((prcl[cHalf].top == top) && (prcl[cHalf].right <= x))
+        {
+            prcl += cHalf + 1;
+            cRects -= cHalf + 1;
+        }
+        else
+        {
+            cRects = cHalf;
+        }
+    }
+
+    return prcl;
+}
+
 typedef VOID (FASTCALL *overlapProcp)(PREGION, PRECT, PRECT, PRECT, PRECT, INT, INT);
 typedef VOID (FASTCALL *nonOverlapProcp)(PREGION, PRECT, PRECT, INT, INT);
 
@@ -587,21 +717,19 @@ REGION_CopyRegion(
         if (dst->rdh.nRgnSize < src->rdh.nCount * sizeof(RECT))
         {
             PRECTL temp;
+            ULONG cjSize = src->rdh.nCount * sizeof(RECT);
 
             /* Allocate a new buffer */
-            temp = ExAllocatePoolWithTag(PagedPool,
-                                         src->rdh.nCount * sizeof(RECT),
-                                         TAG_REGION);
+            temp = REGION_pAllocRects(&cjSize);
             if (temp == NULL)
                 return FALSE;
 
             /* Free the old buffer */
-            if ((dst->Buffer != NULL) && (dst->Buffer != &dst->rdh.rcBound))
-                ExFreePoolWithTag(dst->Buffer, TAG_REGION);
+            REGION_vFreeBuffer(dst);
 
             /* Set the new buffer and the size */
             dst->Buffer = temp;
-            dst->rdh.nRgnSize = src->rdh.nCount * sizeof(RECT);
+            dst->rdh.nRgnSize = cjSize;
         }
 
         dst->rdh.nCount = src->rdh.nCount;
@@ -715,13 +843,12 @@ REGION_CropRegion(
     if ((rgnDst != rgnSrc) && (rgnDst->rdh.nRgnSize < nRgnSize))
     {
         PRECTL temp;
-        temp = ExAllocatePoolWithTag(PagedPool, nRgnSize, TAG_REGION);
+        temp = REGION_pAllocRects(&nRgnSize);
         if (temp == NULL)
             return ERROR;
 
         /* Free the old buffer */
-        if (rgnDst->Buffer && (rgnDst->Buffer != &rgnDst->rdh.rcBound))
-            ExFreePoolWithTag(rgnDst->Buffer, TAG_REGION);
+        REGION_vFreeBuffer(rgnDst);
 
         rgnDst->Buffer = temp;
         rgnDst->rdh.nCount = 0;
@@ -964,6 +1091,7 @@ REGION_RegionOp(
     INT ybot;                          /* Bottom of intersection */
     INT ytop;                          /* Top of intersection */
     RECTL *oldRects;                   /* Old rects for newReg */
+    ULONG oldSize;                     /* Size of the old rects buffer */
     ULONG prevBand;                    /* Index of start of
                                         * Previous band in newReg */
     ULONG curBand;                     /* Index of start of current band in newReg */
@@ -986,6 +1114,7 @@ REGION_RegionOp(
      * note of its rects pointer (so that we can free them later), preserve its
      * extents and simply set numRects to zero. */
     oldRects = newReg->Buffer;
+    oldSize = newReg->rdh.nRgnSize;
     newReg->rdh.nCount = 0;
 
     /* Allocate a reasonable number of rectangles for the new region. The idea
@@ -995,9 +1124,7 @@ REGION_RegionOp(
      * nuke the Xrealloc() at the end of this function eventually. */
     newReg->rdh.nRgnSize = max(reg1->rdh.nCount + 1, reg2->rdh.nCount) * 2 * sizeof(RECT);
 
-    newReg->Buffer = ExAllocatePoolWithTag(PagedPool,
-                                           newReg->rdh.nRgnSize,
-                                           TAG_REGION);
+    newReg->Buffer = REGION_pAllocRects(&newReg->rdh.nRgnSize);
     if (newReg->Buffer == NULL)
     {
         newReg->rdh.nRgnSize = 0;
@@ -1174,48 +1301,33 @@ REGION_RegionOp(
      * rectangles in the region. This never goes to 0, however...
      *
      * Only do this stuff if the number of rectangles allocated is more than
-     * twice the number of rectangles in the region (a simple optimization...). */
+     * twice the number of rectangles in the region (a simple optimization...).
+     * Buffers from the lookaside list are never shrunk, that would only
+     * give us another one of the same size. */
     if ((newReg->rdh.nRgnSize > (2 * newReg->rdh.nCount * sizeof(RECT))) &&
+        (newReg->rdh.nRgnSize > RGN_LOOKASIDE_RECTS * sizeof(RECTL)) &&
         (newReg->rdh.nCount > 2))
     {
-        if (REGION_NOT_EMPTY(newReg))
-        {
-            RECTL *prev_rects = newReg->Buffer;
-            newReg->Buffer = ExAllocatePoolWithTag(PagedPool,
-                                                   newReg->rdh.nCount * sizeof(RECT),
-                                                   TAG_REGION);
+        RECTL *prev_rects = newReg->Buffer;
+        ULONG cjSize = newReg->rdh.nCount * sizeof(RECT);
 
-            if (newReg->Buffer == NULL)
-            {
-                newReg->Buffer = prev_rects;
-            }
-            else
-            {
-                newReg->rdh.nRgnSize = newReg->rdh.nCount*sizeof(RECT);
-                COPY_RECTS(newReg->Buffer, prev_rects, newReg->rdh.nCount);
-                if (prev_rects != &newReg->rdh.rcBound)
-                    ExFreePoolWithTag(prev_rects, TAG_REGION);
-            }
+        newReg->Buffer = REGION_pAllocRects(&cjSize);
+        if (newReg->Buffer == NULL)
+        {
+            newReg->Buffer = prev_rects;
         }
         else
         {
-            /* No point in doing the extra work involved in an Xrealloc if
-             * the region is empty */
-            newReg->rdh.nRgnSize = sizeof(RECT);
-            if (newReg->Buffer != &newReg->rdh.rcBound)
-                ExFreePoolWithTag(newReg->Buffer, TAG_REGION);
-
-            newReg->Buffer = ExAllocatePoolWithTag(PagedPool,
-                                                   sizeof(RECT),
-                                                   TAG_REGION);
-            ASSERT(newReg->Buffer);
+            COPY_RECTS(newReg->Buffer, prev_rects, newReg->rdh.nCount);
+            REGION_vFreeRects(prev_rects, newReg->rdh.nRgnSize);
+            newReg->rdh.nRgnSize = cjSize;
         }
     }
 
     newReg->rdh.iType = RDH_RECTANGLES;
 
-    if (oldRects != &newReg->rdh.rcBound)
-        ExFreePoolWithTag(oldRects, TAG_REGION);
+    if ((oldRects != NULL) && (oldRects != &newReg->rdh.rcBound))
+        REGION_vFreeRects(oldRects, oldSize);
     return;
 }
 
@@ -1287,6 +1399,84 @@ REGION_IntersectO(
     return;
 }
 
+/*!
+ *      Intersect a region with a single rectangle. This gives the same
+ *      result as REGION_RegionOp, but only needs a single pass over the
+ *      bands of the region that overlap the rectangle. newReg may be reg
+ *      or the region the rectangle belongs to.
+ */
+static
+VOID
+FASTCALL
+REGION_IntersectRect(
+    PREGION newReg,
+    PREGION reg,
+    const RECTL *prcl)
+{
+    RECTL rc = *prcl;
+    RECTL *r, *rEnd, *rBandEnd;
+    ULONG prevBand, curBand;
+    LONG top, bottom, left, right;
+
+    /* Nothing is lost when the rect covers the whole region */
+    if ((rc.left <= reg->rdh.rcBound.left) &&
+        (rc.top <= reg->rdh.rcBound.top) &&
+        (rc.right >= reg->rdh.rcBound.right) &&
+        (rc.bottom >= reg->rdh.rcBound.bottom))
+    {
+        REGION_CopyRegion(newReg, reg);
+        return;
+    }
+
+    r = reg->Buffer;
+    rEnd = r + reg->rdh.nCount;
+
+    /* We never produce more rects than we read, so working in place is fine */
+    if (newReg != reg)
+    {
+        newReg->rdh.nCount = 0;
+        if (!REGION_bEnsureBufferSize(newReg, reg->rdh.nCount))
+        {
+            REGION_SetExtents(newReg);
+            return;
+        }
+    }
+
+    newReg->rdh.nCount = 0;
+    prevBand = 0;
+
+    for (r = REGION_pFindBand(r, rEnd, rc.top);
+         (r != rEnd) && (r->top < rc.bottom);
+         r = rBandEnd)
+    {
+        rBandEnd = r;
+        while ((rBandEnd != rEnd) && (rBandEnd->top == r->top))
+        {
+            rBandEnd++;
+        }
+
+        top = max(r->top, rc.top);
+        bottom = min(r->bottom, rc.bottom);
+        curBand = newReg->rdh.nCount;
+
+        for (r = REGION_pFindRectInBand(r, rBandEnd, rc.left);
+             (r != rBandEnd) && (r->left < rc.right);
+             r++)
+        {
+            left = max(r->left, rc.left);
+            right = min(r->right, rc.right);
+            REGION_vAddRect(newReg, left, top, right, bottom);
+        }
+
+        if (newReg->rdh.nCount != curBand)
+        {
+            prevBand = REGION_Coalesce(newReg, prevBand, curBand);
+        }
+    }
+
+    REGION_SetExtents(newReg);
+}
+
 /***********************************************************************
  * REGION_IntersectRegion
  */
@@ -1305,6 +1495,17 @@ REGION_IntersectRegion(
     {
         newReg->rdh.nCount = 0;
     }
+    else if (reg2->rdh.nCount == 1)
+    {
+        /* Clipping to a rectangle is by far the most common case */
+        REGION_IntersectRect(newReg, reg1, &reg2->rdh.rcBound);
+        return;
+    }
+    else if (reg1->rdh.nCount == 1)
+    {
+        REGION_IntersectRect(newReg, reg2, &reg1->rdh.rcBound);
+        return;
+    }
     else
     {
         REGION_RegionOp(newReg,
@@ -1525,6 +1726,44 @@ REGION_UnionRegion(
         return;
     }
 
+    /* Region 2 is completely below region 1, which is how regions get built
+       one rect at a time. Append its bands and merge the first one with
+       the last band of region 1 if possible. */
+    if ((reg2->rdh.rcBound.top >= reg1->rdh.rcBound.bottom) &&
+        (newReg != reg2))
+    {
+        ULONG prevBand, curBand = reg1->rdh.nCount;
+        RECTL rcBound;
+
+        /* newReg may be region 1 and lose its bounds in REGION_CopyRegion */
+        rcBound.left = min(reg1->rdh.rcBound.left, reg2->rdh.rcBound.left);
+        rcBound.top = reg1->rdh.rcBound.top;
+        rcBound.right = max(reg1->rdh.rcBound.right, reg2->rdh.rcBound.right);
+        rcBound.bottom = reg2->rdh.rcBound.bottom;
+
+        if (!REGION_CopyRegion(newReg, reg1) ||
+            !REGION_bEnsureBufferSize(newReg, curBand + reg2->rdh.nCount))
+        {
+            return;
+        }
+
+        COPY_RECTS(newReg->Buffer + curBand, reg2->Buffer, reg2->rdh.nCount);
+        newReg->rdh.nCount += reg2->rdh.nCount;
+
+        /* Find the start of the last band of region 1 */
+        prevBand = curBand - 1;
+        while ((prevBand > 0) &&
+               (newReg->Buffer[prevBand - 1].top == newReg->Buffer[prevBand].top))
+        {
+            prevBand--;
+        }
+
+        (VOID)REGION_Coalesce(newReg, prevBand, curBand);
+        newReg->rdh.rcBound = rcBound;
+        newReg->rdh.iType = RDH_RECTANGLES;
+        return;
+    }
+
     REGION_RegionOp(newReg,
                     reg1,
                     reg2,
@@ -1727,6 +1966,18 @@ REGION_SubtractRegion(
         return;
     }
 
+    /* A window covering the whole area leaves nothing */
+    if ((regS->rdh.nCount == 1) &&
+        (regS->rdh.rcBound.left <= regM->rdh.rcBound.left) &&
+        (regS->rdh.rcBound.top <= regM->rdh.rcBound.top) &&
+        (regS->rdh.rcBound.right >= regM->rdh.rcBound.right) &&
+        (regS->rdh.rcBound.bottom >= regM->rdh.rcBound.bottom))
+    {
+        regD->rdh.nCount = 0;
+        REGION_SetExtents(regD);
+        return;
+    }
+
     REGION_RegionOp(regD,
                     regM,
                     regS,
@@ -1896,9 +2147,7 @@ REGION_bMakeSimpleFrameRgn(
         NT_ASSERT(prgn->rdh.nCount > 1);
         prgn->rdh.nRgnSize = prgn->rdh.nCount * sizeof(RECT);
         NT_ASSERT(prgn->Buffer == &prgn->rdh.rcBound);
-        prgn->Buffer = ExAllocatePoolWithTag(PagedPool,
-                                            prgn->rdh.nRgnSize,
-                                            TAG_REGION);
+        prgn->Buffer = REGION_pAllocRects(&prgn->rdh.nRgnSize);
         if (prgn->Buffer == NULL)
         {
             prgn->rdh.nRgnSize = 0;
@@ -2181,6 +2430,7 @@ REGION_AllocRgnWithHandle(
 {
     //HRGN hReg;
     PREGION pReg;
+    ULONG cjSize = nReg * sizeof(RECT);
 
     pReg = (PREGION)GDIOBJ_AllocateObject(GDIObjType_RGN_TYPE,
                                           sizeof(REGION),
@@ -2201,9 +2451,8 @@ REGION_AllocRgnWithHandle(
     }
     else
     {
-        pReg->Buffer = ExAllocatePoolWithTag(PagedPool,
-                                             nReg * sizeof(RECT),
-                                             TAG_REGION);
+        cjSize = nReg * sizeof(RECT);
+        pReg->Buffer = REGION_pAllocRects(&cjSize);
         if (pReg->Buffer == NULL)
         {
             DPRINT1("Could not allocate region buffer\n");
@@ -2215,7 +2464,7 @@ REGION_AllocRgnWithHandle(
     EMPTY_REGION(pReg);
     pReg->rdh.dwSize = sizeof(RGNDATAHEADER);
     pReg->rdh.nCount = nReg;
-    pReg->rdh.nRgnSize = nReg * sizeof(RECT);
+    pReg->rdh.nRgnSize = cjSize;
     pReg->prgnattr = &pReg->rgnattr;
 
     /* Initialize the region attribute */
@@ -2419,8 +2668,7 @@ REGION_vCleanup(PVOID ObjectBody)
     if (pRgn->prgnattr != &pRgn->rgnattr)
         GdiPoolFree(ppi->pPoolRgnAttr, pRgn->prgnattr);
 
-    if (pRgn->Buffer && pRgn->Buffer != &pRgn->rdh.rcBound)
-        ExFreePoolWithTag(pRgn->Buffer, TAG_REGION);
+    REGION_vFreeBuffer(pRgn);
 }
 
 VOID
@@ -2563,17 +2811,18 @@ REGION_PtInRegion(
     INT X,
     INT Y)
 {
-    ULONG i;
-    PRECT r;
+    PRECTL prcl, prclEnd;
 
     if (prgn->rdh.nCount > 0 && INRECT(prgn->rdh.rcBound, X, Y))
     {
-        r =  prgn->Buffer;
-        for (i = 0; i < prgn->rdh.nCount; i++)
-        {
-            if (INRECT(r[i], X, Y))
-                return TRUE;
-        }
+        prclEnd = prgn->Buffer + prgn->rdh.nCount;
+        prcl = REGION_pFindBand(prgn->Buffer, prclEnd, Y);
+        if ((prcl == prclEnd) || (prcl->top > Y))
+            return FALSE;
+
+        prcl = REGION_pFindRectInBand(prcl, prclEnd, X);
+        if ((prcl != prclEnd) && INRECT(*prcl, X, Y))
+            return TRUE;
     }
 
     return FALSE;
@@ -2586,6 +2835,7 @@ REGION_RectInRegion(
     const RECTL *rect)
 {
     PRECTL pCurRect, pRectEnd;
+    LONG bandTop;
     RECT rc;
 
     /* Swap the coordinates to make right >= left and bottom >= top */
@@ -2615,24 +2865,23 @@ REGION_RectInRegion(
     /* This is (just) a useful optimization */
     if ((Rgn->rdh.nCount > 0) && EXTENTCHECK(&Rgn->rdh.rcBound, &rc))
     {
-        for (pCurRect = Rgn->Buffer, pRectEnd = pCurRect +
-                                                Rgn->rdh.nCount; pCurRect < pRectEnd; pCurRect++)
-        {
-            if (pCurRect->bottom <= rc.top)
-                continue;             /* Not far enough down yet */
-
-            if (pCurRect->top >= rc.bottom)
-                break;                /* Too far down */
+        pRectEnd = Rgn->Buffer + Rgn->rdh.nCount;
 
-            if (pCurRect->right <= rc.left)
-                continue;              /* Not far enough over yet */
-
-            if (pCurRect->left >= rc.right)
+        /* Skip the bands above the rect, then check one band at a time */
+        pCurRect = REGION_pFindBand(Rgn->Buffer, pRectEnd, rc.top);
+        while ((pCurRect != pRectEnd) && (pCurRect->top < rc.bottom))
+        {
+            /* Find the first rect in the band that is not left of the rect */
+            bandTop = pCurRect->top;
+            pCurRect = REGION_pFindRectInBand(pCurRect, pRectEnd, rc.left);
+            if ((pCurRect != pRectEnd) && (pCurRect->top == bandTop))
             {
-                continue;
-            }
+                if (pCurRect->left < rc.right)
+                    return TRUE;
 
-            return TRUE;
+                /* The rest of the band is right of the rect */
+                pCurRect = REGION_pFindBand(pCurRect, pRectEnd, pCurRect->bottom);
+            }
         }
     }
 
@@ -3031,6 +3280,7 @@ REGION_PtsToRegion(
     INT i;
     RECTL *extents, *temp;
     INT numRects;
+    ULONG cjSize;
 
     extents = &reg->rdh.rcBound;
 
@@ -3042,7 +3292,8 @@ REGION_PtsToRegion(
         numRects = 1;
     }
 
-    temp = ExAllocatePoolWithTag(PagedPool, numRects * sizeof(RECT), TAG_REGION);
+    cjSize = numRects * sizeof(RECT);
+    temp = REGION_pAllocRects(&cjSize);
     if (temp == NULL)
     {
         return 0;
@@ -3051,10 +3302,10 @@ REGION_PtsToRegion(
     if (reg->Buffer != NULL)
     {
         COPY_RECTS(temp, reg->Buffer, reg->rdh.nCount);
-        if (reg->Buffer != &reg->rdh.rcBound)
-            ExFreePoolWithTag(reg->Buffer, TAG_REGION);
+        REGION_vFreeBuffer(reg);
     }
     reg->Buffer = temp;
+    reg->rdh.nRgnSize = cjSize;
 
     reg->rdh.nCount = numRects;
     CurPtBlock = FirstPtBlock;
@@ -23,6 +23,11 @@ extern HRGN hrgnDefault;
 
 /* Functions ******************************************************************/
 
+INIT_FUNCTION
+NTSTATUS
+NTAPI
+InitRegionImpl(VOID);
+
 PREGION FASTCALL REGION_AllocRgnWithHandle(INT n);
 PREGION FASTCALL REGION_AllocUserRgnWithHandle(INT n);
 VOID FASTCALL REGION_UnionRectWithRgn(PREGION rgn, const RECTL *rect);
@@ -986,6 +986,7 @@ DriverEntry(
 
     NT_ROF(InitGdiHandleTable());
     NT_ROF(InitPaletteImpl());
+    NT_ROF(InitRegionImpl());
 
     /* Create stock objects, ie. precreated objects commonly
        used by win32 applications */